@@ -0,0 +1,97 @@
+#include "arena.hpp"
+#include "hugepages.hpp"
+
+using namespace std;
+
+namespace {
+	const size_t alignment = alignof(max_align_t);
+	const size_t nr_size_classes = 4096 / alignment;
+
+	size_t round_up(size_t bytes) {
+		if (bytes == 0) bytes = 1;
+		return (bytes + alignment - 1) / alignment * alignment;
+	}
+}
+
+Arena::Arena(size_t chunk_size, bool huge_pages)
+	:chunk_size(round_up(chunk_size)),
+	 huge_pages(huge_pages),
+	 position(nullptr),
+	 end(nullptr),
+	 free_lists(nr_size_classes, nullptr),
+	 nr_allocated(0),
+	 nr_reserved(0)
+{}
+
+Arena::~Arena() {
+	release();
+}
+
+char* Arena::new_chunk(size_t bytes) {
+	// both return memory aligned for any fundamental type
+	char* chunk = static_cast<char*>(this->huge_pages ? HugePages::allocate(bytes) : ::operator new(bytes));
+	this->chunks.push_back(make_pair(chunk, bytes));
+	this->nr_reserved += bytes;
+	return chunk;
+}
+
+void* Arena::allocate(size_t bytes) {
+	size_t size = round_up(bytes);
+	size_t size_class = size / alignment - 1;
+	if ((size_class < nr_size_classes) && (this->free_lists[size_class] != nullptr)) {
+		FreeBlock* block = this->free_lists[size_class];
+		this->free_lists[size_class] = block->next;
+		this->nr_allocated += size;
+		return block;
+	}
+	if (size > (size_t) (this->end - this->position)) {
+		if (size > this->chunk_size / 4) {
+			// large blocks get a chunk of their own, so that the current chunk can still be used
+			this->nr_allocated += size;
+			return new_chunk(size);
+		}
+		this->position = new_chunk(this->chunk_size);
+		this->end = this->position + this->chunk_size;
+	}
+	char* result = this->position;
+	this->position += size;
+	this->nr_allocated += size;
+	return result;
+}
+
+void Arena::deallocate(void* pointer, size_t bytes) {
+	if (pointer == nullptr) return;
+	size_t size = round_up(bytes);
+	size_t size_class = size / alignment - 1;
+	this->nr_allocated -= size;
+	// larger blocks stay unused until the arena is released
+	if (size_class < nr_size_classes) {
+		FreeBlock* block = static_cast<FreeBlock*>(pointer);
+		block->next = this->free_lists[size_class];
+		this->free_lists[size_class] = block;
+	}
+}
+
+void Arena::release() {
+	for (auto& chunk : this->chunks) {
+		if (this->huge_pages) {
+			HugePages::deallocate(chunk.first, chunk.second);
+		} else {
+			::operator delete(chunk.first);
+		}
+	}
+	this->chunks.clear();
+	this->free_lists.assign(nr_size_classes, nullptr);
+	this->position = nullptr;
+	this->end = nullptr;
+	this->nr_allocated = 0;
+	this->nr_reserved = 0;
+}
+
+size_t Arena::allocated_bytes() const {
+	return this->nr_allocated;
+}
+
+size_t Arena::reserved_bytes() const {
+	return this->nr_reserved;
+}
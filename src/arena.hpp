@@ -0,0 +1,129 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <vector>
+#include <map>
+#include <functional>
+#include <utility>
+#include <type_traits>
+#include <cstddef>
+#include <new>
+
+/**
+* Monotonic memory arena. Memory is handed out from large chunks by bumping a pointer and all of it is freed
+* in one operation (release or destruction of the arena), so objects allocated one after another are also stored
+* next to each other. Blocks given back with deallocate are kept in free lists per size class (multiples of 16 bytes
+* up to 4 KB) and reused by later requests of the same size class, so that growing containers do not waste space.
+* An Arena is not thread-safe.
+**/
+
+class Arena {
+public:
+	/**
+	* @param chunk_size number of bytes requested from the system at once
+	* @param huge_pages take the chunks from HugePages
+	**/
+	Arena(size_t chunk_size = 1 << 20, bool huge_pages = false);
+	~Arena();
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+	/** returns a block of at least the given size, suitably aligned for any fundamental type **/
+	void* allocate(size_t bytes);
+	/** gives a block back to the arena so that it can be reused **/
+	void deallocate(void* pointer, size_t bytes);
+	/** construct an object inside of the arena. Its destructor is never run, so all memory it
+	* owns must also come from the arena (i.e. its containers must use ArenaAllocator). **/
+	template <class T, class... Args>
+	T* create(Args&&... args) {
+		static_assert(alignof(T) <= alignof(std::max_align_t), "Arena::create: type is over-aligned.");
+		return new (allocate(sizeof(T))) T(std::forward<Args>(args)...);
+	}
+	/** frees all memory at once, everything allocated in the arena becomes invalid **/
+	void release();
+	/** number of bytes currently handed out **/
+	size_t allocated_bytes() const;
+	/** number of bytes obtained from the system **/
+	size_t reserved_bytes() const;
+
+private:
+	struct FreeBlock {
+		FreeBlock* next;
+	};
+	size_t chunk_size;
+	bool huge_pages;
+	// chunks and their sizes
+	std::vector<std::pair<char*, size_t>> chunks;
+	// free space in the current chunk
+	char* position;
+	char* end;
+	// free_lists[i] holds returned blocks of size (i+1)*alignment
+	std::vector<FreeBlock*> free_lists;
+	size_t nr_allocated;
+	size_t nr_reserved;
+	char* new_chunk(size_t bytes);
+};
+
+/**
+* Allocator for standard containers that takes its memory from an Arena. Without an arena,
+* memory is taken from the heap as for std::allocator.
+**/
+
+template <class T>
+class ArenaAllocator {
+public:
+	typedef T value_type;
+	typedef std::true_type propagate_on_container_copy_assignment;
+	typedef std::true_type propagate_on_container_move_assignment;
+	typedef std::true_type propagate_on_container_swap;
+	template <class U>
+	struct rebind {
+		typedef ArenaAllocator<U> other;
+	};
+
+	explicit ArenaAllocator(Arena* arena = nullptr) noexcept
+		:arena(arena)
+	{}
+
+	template <class U>
+	ArenaAllocator(const ArenaAllocator<U>& other) noexcept
+		:arena(other.get_arena())
+	{}
+
+	T* allocate(size_t n) {
+		if (this->arena == nullptr) return static_cast<T*>(::operator new(n * sizeof(T)));
+		return static_cast<T*>(this->arena->allocate(n * sizeof(T)));
+	}
+
+	void deallocate(T* pointer, size_t n) {
+		if (this->arena == nullptr) {
+			::operator delete(pointer);
+		} else {
+			this->arena->deallocate(pointer, n * sizeof(T));
+		}
+	}
+
+	Arena* get_arena() const {
+		return this->arena;
+	}
+
+private:
+	Arena* arena;
+};
+
+template <class T, class U>
+bool operator== (const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+	return a.get_arena() == b.get_arena();
+}
+
+template <class T, class U>
+bool operator!= (const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+	return a.get_arena() != b.get_arena();
+}
+
+template <class T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+template <class Key, class T>
+using ArenaMap = std::map<Key, T, std::less<Key>, ArenaAllocator<std::pair<const Key, T>>>;
+
+#endif // ARENA_HPP
@@ -0,0 +1,267 @@
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "binarygenotypes.hpp"
+
+using namespace std;
+
+static const char file_magic[8] = {'P', 'G', 'G', 'T', 'B', 'I', 'N', '2'};
+static const char block_magic[8] = {'P', 'G', 'G', 'T', 'B', 'L', 'K', '2'};
+
+// columns start at offsets that are multiples of 8
+static size_t padded(size_t bytes) {
+	return (bytes + 7) / 8 * 8;
+}
+
+BinaryGenotypeWriter::BinaryGenotypeWriter()
+	:site_offsets(1, 0),
+	 likelihood_offsets(1, 0),
+	 allele_kmer_offsets(1, 0)
+{}
+
+void BinaryGenotypeWriter::open(string filename, const string& header) {
+	this->file.open(filename, ios::binary);
+	if (!this->file.is_open()) {
+		throw runtime_error("BinaryGenotypeWriter::open: output file " + filename + " cannot be opened.");
+	}
+	uint64_t header_length = header.size();
+	this->file.write(file_magic, 8);
+	this->file.write((const char*) &header_length, sizeof(uint64_t));
+	write_column(header.data(), header.size());
+}
+
+bool BinaryGenotypeWriter::is_open() const {
+	return this->file.is_open();
+}
+
+void BinaryGenotypeWriter::write_column(const void* data, size_t bytes) {
+	static const char padding[8] = {0};
+	this->file.write((const char*) data, bytes);
+	this->file.write(padding, padded(bytes) - bytes);
+}
+
+void BinaryGenotypeWriter::add_record(uint32_t site_index, size_t position, const string& site_text, size_t kmer_info_offset, size_t unique_kmers, const vector<int>& allele_kmers,
+		pair<int,int> genotype, int genotype_quality, unsigned short coverage, const vector<long double>& likelihoods)
+{
+	if (position > numeric_limits<uint32_t>::max()) {
+		throw runtime_error("BinaryGenotypeWriter::add_record: position " + to_string(position) + " cannot be stored in binary format.");
+	}
+	if (kmer_info_offset > site_text.size()) {
+		throw runtime_error("BinaryGenotypeWriter::add_record: offset of kmer fields exceeds the site text.");
+	}
+	// alleles are stored in a single byte, the largest value marks undefined alleles
+	if ((genotype.first >= undefined_allele) || (genotype.second >= undefined_allele)) {
+		throw runtime_error("BinaryGenotypeWriter::add_record: allele " + to_string(max(genotype.first, genotype.second)) + " cannot be stored in binary format (at most " + to_string(undefined_allele - 1) + ").");
+	}
+	this->site_index.push_back(site_index);
+	this->position.push_back(position);
+	this->sites += site_text;
+	this->site_offsets.push_back(this->sites.size());
+	this->kmer_info_offset.push_back(kmer_info_offset);
+	this->unique_kmers.push_back(unique_kmers);
+	this->allele_kmers.insert(this->allele_kmers.end(), allele_kmers.begin(), allele_kmers.end());
+	this->allele_kmer_offsets.push_back(this->allele_kmers.size());
+	this->genotype_quality.push_back(genotype_quality);
+	this->coverage.push_back(coverage);
+	this->genotypes.push_back((genotype.first < 0) ? undefined_allele : (uint8_t) genotype.first);
+	this->genotypes.push_back((genotype.second < 0) ? undefined_allele : (uint8_t) genotype.second);
+	for (auto l : likelihoods) {
+		// log10 of 0 is -inf
+		this->likelihoods.push_back((float) log10l(l));
+	}
+	this->likelihood_offsets.push_back(this->likelihoods.size());
+}
+
+void BinaryGenotypeWriter::write_block(const string& chromosome) {
+	if (!this->file.is_open()) {
+		throw runtime_error("BinaryGenotypeWriter::write_block: output file needs to be opened before writing.");
+	}
+	size_t n = this->site_index.size();
+	BinaryBlockHeader block;
+	memcpy(block.magic, block_magic, 8);
+	block.nr_records = n;
+	block.nr_likelihoods = this->likelihoods.size();
+	block.nr_allele_kmers = this->allele_kmers.size();
+	block.site_bytes = this->sites.size();
+	block.name_length = chromosome.size();
+	block.block_size = sizeof(BinaryBlockHeader) + padded(chromosome.size()) + 3 * padded((n+1) * sizeof(uint64_t))
+		+ 4 * padded(n * sizeof(uint32_t)) + padded(n * sizeof(int32_t)) + padded(this->allele_kmers.size() * sizeof(int32_t))
+		+ padded(n * sizeof(uint16_t)) + padded(this->likelihoods.size() * sizeof(float)) + padded(2 * n) + padded(this->sites.size());
+
+	this->file.write((const char*) &block, sizeof(BinaryBlockHeader));
+	write_column(chromosome.data(), chromosome.size());
+	write_column(this->site_offsets.data(), this->site_offsets.size() * sizeof(uint64_t));
+	write_column(this->likelihood_offsets.data(), this->likelihood_offsets.size() * sizeof(uint64_t));
+	write_column(this->allele_kmer_offsets.data(), this->allele_kmer_offsets.size() * sizeof(uint64_t));
+	write_column(this->site_index.data(), n * sizeof(uint32_t));
+	write_column(this->position.data(), n * sizeof(uint32_t));
+	write_column(this->kmer_info_offset.data(), n * sizeof(uint32_t));
+	write_column(this->unique_kmers.data(), n * sizeof(uint32_t));
+	write_column(this->genotype_quality.data(), n * sizeof(int32_t));
+	write_column(this->allele_kmers.data(), this->allele_kmers.size() * sizeof(int32_t));
+	write_column(this->coverage.data(), n * sizeof(uint16_t));
+	write_column(this->likelihoods.data(), this->likelihoods.size() * sizeof(float));
+	write_column(this->genotypes.data(), this->genotypes.size());
+	write_column(this->sites.data(), this->sites.size());
+
+	// start a new block
+	this->site_offsets.assign(1, 0);
+	this->likelihood_offsets.assign(1, 0);
+	this->allele_kmer_offsets.assign(1, 0);
+	this->site_index.clear();
+	this->position.clear();
+	this->kmer_info_offset.clear();
+	this->unique_kmers.clear();
+	this->allele_kmers.clear();
+	this->genotype_quality.clear();
+	this->coverage.clear();
+	this->likelihoods.clear();
+	this->genotypes.clear();
+	this->sites.clear();
+}
+
+void BinaryGenotypeWriter::close() {
+	if (!this->site_index.empty()) {
+		throw runtime_error("BinaryGenotypeWriter::close: records were added that have not been written to a block.");
+	}
+	this->file.close();
+}
+
+BinaryGenotypeReader::BinaryGenotypeReader(string filename)
+	:file_descriptor(-1),
+	 data(nullptr),
+	 size(0)
+{
+	this->file_descriptor = ::open(filename.c_str(), O_RDONLY);
+	if (this->file_descriptor < 0) {
+		throw runtime_error("BinaryGenotypeReader::BinaryGenotypeReader: file " + filename + " cannot be opened.");
+	}
+	struct stat file_stats;
+	fstat(this->file_descriptor, &file_stats);
+	this->size = file_stats.st_size;
+	if (this->size < 16) {
+		::close(this->file_descriptor);
+		throw runtime_error("BinaryGenotypeReader::BinaryGenotypeReader: " + filename + " is not a binary genotype file.");
+	}
+	void* mapped = mmap(nullptr, this->size, PROT_READ, MAP_PRIVATE, this->file_descriptor, 0);
+	if (mapped == MAP_FAILED) {
+		::close(this->file_descriptor);
+		throw runtime_error("BinaryGenotypeReader::BinaryGenotypeReader: file " + filename + " cannot be memory-mapped.");
+	}
+	this->data = (const char*) mapped;
+
+	// header
+	uint64_t header_length = *((const uint64_t*) (this->data + 8));
+	if ((memcmp(this->data, file_magic, 8) != 0) || (16 + padded(header_length) > this->size)) {
+		munmap((void*) this->data, this->size);
+		::close(this->file_descriptor);
+		throw runtime_error("BinaryGenotypeReader::BinaryGenotypeReader: " + filename + " is not a binary genotype file.");
+	}
+	this->header.assign(this->data + 16, header_length);
+
+	// locate the columns of each block
+	size_t offset = 16 + padded(header_length);
+	while (offset < this->size) {
+		const BinaryBlockHeader* block = (const BinaryBlockHeader*) (this->data + offset);
+		if ((offset + sizeof(BinaryBlockHeader) > this->size) || (memcmp(block->magic, block_magic, 8) != 0) || (offset + block->block_size > this->size)) {
+			munmap((void*) this->data, this->size);
+			::close(this->file_descriptor);
+			throw runtime_error("BinaryGenotypeReader::BinaryGenotypeReader: " + filename + " is truncated or malformatted.");
+		}
+		size_t n = block->nr_records;
+		const char* column = this->data + offset + sizeof(BinaryBlockHeader);
+		BinaryGenotypeBlock view;
+		view.chromosome.assign(column, block->name_length);
+		view.nr_records = n;
+		column += padded(block->name_length);
+		view.site_offsets = (const uint64_t*) column;
+		column += padded((n+1) * sizeof(uint64_t));
+		view.likelihood_offsets = (const uint64_t*) column;
+		column += padded((n+1) * sizeof(uint64_t));
+		view.allele_kmer_offsets = (const uint64_t*) column;
+		column += padded((n+1) * sizeof(uint64_t));
+		view.site_index = (const uint32_t*) column;
+		column += padded(n * sizeof(uint32_t));
+		view.position = (const uint32_t*) column;
+		column += padded(n * sizeof(uint32_t));
+		view.kmer_info_offset = (const uint32_t*) column;
+		column += padded(n * sizeof(uint32_t));
+		view.unique_kmers = (const uint32_t*) column;
+		column += padded(n * sizeof(uint32_t));
+		view.genotype_quality = (const int32_t*) column;
+		column += padded(n * sizeof(int32_t));
+		view.allele_kmers = (const int32_t*) column;
+		column += padded(block->nr_allele_kmers * sizeof(int32_t));
+		view.coverage = (const uint16_t*) column;
+		column += padded(n * sizeof(uint16_t));
+		view.likelihoods = (const float*) column;
+		column += padded(block->nr_likelihoods * sizeof(float));
+		view.genotypes = (const uint8_t*) column;
+		column += padded(2 * n);
+		view.sites = column;
+		this->blocks.push_back(view);
+		offset += block->block_size;
+	}
+}
+
+BinaryGenotypeReader::~BinaryGenotypeReader() {
+	munmap((void*) this->data, this->size);
+	::close(this->file_descriptor);
+}
+
+const string& BinaryGenotypeReader::get_header() const {
+	return this->header;
+}
+
+size_t BinaryGenotypeReader::nr_of_blocks() const {
+	return this->blocks.size();
+}
+
+const BinaryGenotypeBlock& BinaryGenotypeReader::get_block(size_t index) const {
+	return this->blocks.at(index);
+}
+
+void BinaryGenotypeReader::write_vcf(string filename) const {
+	ofstream outfile(filename);
+	if (!outfile.is_open()) {
+		throw runtime_error("BinaryGenotypeReader::write_vcf: output file " + filename + " cannot be opened.");
+	}
+	outfile << this->header;
+	for (auto& block : this->blocks) {
+		for (size_t i = 0; i < block.nr_records; ++i) {
+			const char* site_text = block.sites + block.site_offsets[i];
+			outfile << block.chromosome << "\t" << block.position[i] << "\t"; // CHROM - POS
+			outfile.write(site_text, block.kmer_info_offset[i]); // ID - INFO
+			outfile << ";UK=" << block.unique_kmers[i] << ";AK="; // UK
+			for (uint64_t a = block.allele_kmer_offsets[i]; a < block.allele_kmer_offsets[i+1]; ++a) {
+				if (a > block.allele_kmer_offsets[i]) outfile << ",";
+				outfile << block.allele_kmers[a]; // AK
+			}
+			outfile.write(site_text + block.kmer_info_offset[i], block.site_offsets[i+1] - block.site_offsets[i] - block.kmer_info_offset[i]); // INFO
+			outfile << "\tGT:GQ:GL:KC\t"; // FORMAT
+			uint8_t allele1 = block.genotypes[2*i];
+			uint8_t allele2 = block.genotypes[2*i+1];
+			if ((allele1 != undefined_allele) && (allele2 != undefined_allele)) {
+				outfile << (unsigned int) allele1 << "/" << (unsigned int) allele2 << ":" << block.genotype_quality[i] << ":"; // GT:GQ
+			} else {
+				outfile << ".:.:"; // GT:GQ
+			}
+			// same precision as in the VCF output of PanGenie
+			ostringstream oss;
+			for (uint64_t l = block.likelihood_offsets[i]; l < block.likelihood_offsets[i+1]; ++l) {
+				if (l > block.likelihood_offsets[i]) oss << "," << setprecision(4);
+				oss << (double) block.likelihoods[l];
+			}
+			outfile << oss.str(); // GL
+			outfile << ":" << block.coverage[i] << "\n"; // KC
+		}
+	}
+}
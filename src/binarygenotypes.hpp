@@ -0,0 +1,113 @@
+#ifndef BINARYGENOTYPES_HPP
+#define BINARYGENOTYPES_HPP
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <utility>
+#include <cstdint>
+
+/**
+* Binary representation of genotyping results. A file starts with the magic string "PGGTBIN2", the length of
+* the VCF header text (uint64) and the header text itself. It is followed by one columnar block per chromosome.
+* All values are stored in native byte order and every column starts at an 8 byte aligned offset, so that a file
+* can be memory-mapped and its columns accessed directly.
+*
+* Block layout: BinaryBlockHeader, chromosome name, site text offsets (uint64, n+1), likelihood offsets (uint64, n+1),
+* allele kmer offsets (uint64, n+1), site index (uint32, n), position (uint32, n), offset of the kmer fields within
+* the site text (uint32, n), unique kmers UK (uint32, n), genotype quality (int32, n), unique kmers per allele AK (int32),
+* local kmer coverage (uint16, n), log10 genotype likelihoods (float, -inf for likelihood 0), genotype alleles (uint8, 2n, undefined_allele if undefined),
+* site text (char).
+*
+* CHROM and POS are not part of the site text, it holds the columns ID - INFO without the sample specific
+* INFO fields UK and AK, which are inserted at the stored offset when converting to VCF.
+**/
+
+/** allele of an undefined genotype **/
+static const uint8_t undefined_allele = 255;
+
+struct BinaryBlockHeader {
+	char magic[8];
+	uint64_t nr_records;
+	uint64_t nr_likelihoods;
+	uint64_t nr_allele_kmers;
+	uint64_t site_bytes;
+	uint64_t name_length;
+	// size of the whole block in bytes (including this header)
+	uint64_t block_size;
+};
+
+/** writes genotyping results chromosome by chromosome **/
+class BinaryGenotypeWriter {
+public:
+	BinaryGenotypeWriter();
+	/** open the output file and write the given VCF header text **/
+	void open(std::string filename, const std::string& header);
+	bool is_open() const;
+	/** add a record to the block of the current chromosome. site_text holds the columns ID - INFO without UK and AK, which belong at position
+	* kmer_info_offset of site_text. Undefined genotypes are given as {-1,-1} and have genotype quality -1.
+	* Alleles must be smaller than undefined_allele. **/
+	void add_record(uint32_t site_index, size_t position, const std::string& site_text, size_t kmer_info_offset, size_t unique_kmers, const std::vector<int>& allele_kmers,
+			std::pair<int,int> genotype, int genotype_quality, unsigned short coverage, const std::vector<long double>& likelihoods);
+	/** write all records added since the last call as the block of the given chromosome **/
+	void write_block(const std::string& chromosome);
+	void close();
+
+private:
+	std::ofstream file;
+	std::vector<uint64_t> site_offsets;
+	std::vector<uint64_t> likelihood_offsets;
+	std::vector<uint64_t> allele_kmer_offsets;
+	std::vector<uint32_t> site_index;
+	std::vector<uint32_t> position;
+	std::vector<uint32_t> kmer_info_offset;
+	std::vector<uint32_t> unique_kmers;
+	std::vector<int32_t> genotype_quality;
+	std::vector<int32_t> allele_kmers;
+	std::vector<uint16_t> coverage;
+	std::vector<float> likelihoods;
+	std::vector<uint8_t> genotypes;
+	std::string sites;
+	void write_column(const void* data, size_t bytes);
+};
+
+/** view of a chromosome block of a memory-mapped file **/
+struct BinaryGenotypeBlock {
+	std::string chromosome;
+	size_t nr_records;
+	const uint64_t* site_offsets;
+	const uint64_t* likelihood_offsets;
+	const uint64_t* allele_kmer_offsets;
+	const uint32_t* site_index;
+	const uint32_t* position;
+	const uint32_t* kmer_info_offset;
+	const uint32_t* unique_kmers;
+	const int32_t* genotype_quality;
+	const int32_t* allele_kmers;
+	const uint16_t* coverage;
+	const float* likelihoods;
+	const uint8_t* genotypes;
+	const char* sites;
+};
+
+/** memory-maps a binary genotype file **/
+class BinaryGenotypeReader {
+public:
+	BinaryGenotypeReader(std::string filename);
+	~BinaryGenotypeReader();
+	/** VCF header text **/
+	const std::string& get_header() const;
+	size_t nr_of_blocks() const;
+	const BinaryGenotypeBlock& get_block(size_t index) const;
+	/** convert to VCF (GT:GQ:GL:KC) **/
+	void write_vcf(std::string filename) const;
+
+private:
+	int file_descriptor;
+	const char* data;
+	size_t size;
+	std::string header;
+	std::vector<BinaryGenotypeBlock> blocks;
+};
+
+#endif // BINARYGENOTYPES_HPP
@@ -0,0 +1,455 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+#include <mutex>
+#include <atomic>
+#include <exception>
+#include <cstring>
+#include <cstdio>
+#include <math.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "bucketkmercounter.hpp"
+#include "referencekmerindex.hpp"
+#include "readparser.hpp"
+#include "threadpool.hpp"
+#include "histogram.hpp"
+#include "kmerextractor.hpp"
+#include "hugepages.hpp"
+
+using namespace std;
+
+static const char counts_magic[8] = {'P', 'G', 'K', 'M', 'B', 'U', 'C', 'K'};
+// at most this many bucket files are open at the same time
+static const size_t max_buckets = 512;
+// approximate number of bytes needed per kmer occurrence when counting a bucket
+static const uint64_t bytes_per_kmer = 20;
+// super-kmers are split after this many kmers (runs of identical minimizers, e.g. in homopolymers, can be long)
+static const size_t max_super_kmer_kmers = 1000;
+
+static int base_code(char base) {
+	switch (base) {
+		case 'A': case 'a': return 0;
+		case 'C': case 'c': return 1;
+		case 'G': case 'g': return 2;
+		case 'T': case 't': return 3;
+		default: return -1;
+	}
+}
+
+// murmur3 finalizer, so that minimizers are not biased towards low complexity sequence like poly-A
+static uint64_t mix(uint64_t key) {
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdULL;
+	key ^= key >> 33;
+	key *= 0xc4ceb9fe1a85ec53ULL;
+	key ^= key >> 33;
+	return key;
+}
+
+// appends a 2-bit packed super-kmer: number of bases (uint16), followed by 4 bases per byte
+static void pack_super_kmer(const char* sequence, size_t length, vector<char>& buffer) {
+	uint16_t nr_bases = length;
+	const char* bytes = (const char*) &nr_bases;
+	buffer.insert(buffer.end(), bytes, bytes + sizeof(uint16_t));
+	size_t start = buffer.size();
+	buffer.resize(start + (length + 3) / 4, 0);
+	for (size_t i = 0; i < length; ++i) {
+		buffer[start + i/4] |= base_code(sequence[i]) << (2 * (i % 4));
+	}
+}
+
+size_t BucketKmerCounter::get_minimizer_size(size_t kmer_size) {
+	return min((size_t) 15, kmer_size / 2 + 1);
+}
+
+uint64_t BucketKmerCounter::minimizer_hash(const string& sequence, size_t start, size_t kmer_size, size_t minimizer_size) {
+	uint64_t mask = (1ULL << (2*minimizer_size)) - 1;
+	size_t shift = 2 * (minimizer_size - 1);
+	uint64_t forward = 0;
+	uint64_t reverse = 0;
+	uint64_t result = UINT64_MAX;
+	for (size_t i = 0; i < kmer_size; ++i) {
+		uint64_t base = base_code(sequence[start + i]);
+		forward = ((forward << 2) | base) & mask;
+		reverse = (reverse >> 2) | ((3 - base) << shift);
+		if (i + 1 >= minimizer_size) result = min(result, mix(min(forward, reverse)));
+	}
+	return result;
+}
+
+BucketKmerCounter::BucketKmerCounter(string readfile, size_t kmer_size, string prefix, uint64_t max_memory, size_t nr_threads)
+	:kmer_size(kmer_size),
+	 minimizer_size(get_minimizer_size(kmer_size)),
+	 counts_filename(prefix + ".counts"),
+	 file_descriptor(-1),
+	 data(nullptr),
+	 data_size(0)
+{
+	if ((kmer_size == 0) || (kmer_size > 31)) {
+		throw runtime_error("BucketKmerCounter::BucketKmerCounter: kmer size must be between 1 and 31.");
+	}
+	nr_threads = max(nr_threads, (size_t) 1);
+	struct stat read_stats;
+	if (stat(readfile.c_str(), &read_stats) != 0) {
+		throw runtime_error("BucketKmerCounter::BucketKmerCounter: read file " + readfile + " cannot be opened.");
+	}
+
+	// the file contains at most as many kmers as characters. Each thread counts one bucket at a time.
+	uint64_t memory_per_thread = max(max_memory / nr_threads, (uint64_t) 1);
+	uint64_t needed_buckets = (read_stats.st_size * bytes_per_kmer + memory_per_thread - 1) / memory_per_thread;
+	this->nr_buckets = max((size_t) 1, min(max_buckets, max((size_t) needed_buckets, nr_threads)));
+	if (needed_buckets > max_buckets) {
+		// each bucket is larger than planned, so the memory limit can be exceeded
+		double expected_memory = (double) read_stats.st_size * bytes_per_kmer / this->nr_buckets * nr_threads / 1e9;
+		cerr << "Warning: BucketKmerCounter: " << needed_buckets << " buckets would be needed to stay within the memory limit of " << max_memory / 1e9
+		     << " GB, but at most " << max_buckets << " are used. Counting may need up to " << expected_memory << " GB (use fewer threads to reduce it)." << endl;
+	}
+	size_t buffer_size = max((uint64_t) 4096, min((uint64_t) 1 << 20, max_memory / 4 / (nr_threads * this->nr_buckets)));
+
+	vector<string> bucket_files;
+	vector<string> result_files;
+	for (size_t b = 0; b < this->nr_buckets; ++b) {
+		bucket_files.push_back(prefix + ".bucket" + to_string(b));
+		result_files.push_back(prefix + ".bucket" + to_string(b) + ".counts");
+	}
+
+	write_buckets(readfile, bucket_files, buffer_size, nr_threads);
+
+	// count the buckets in parallel
+	mutex exception_mutex;
+	exception_ptr bucket_exception = nullptr;
+	{
+		ThreadPool threadPool (nr_threads);
+		for (size_t b = 0; b < this->nr_buckets; ++b) {
+			string bucket_file = bucket_files[b];
+			string result_file = result_files[b];
+			function<void()> f_count = [this, bucket_file, result_file, &exception_mutex, &bucket_exception]() {
+				try {
+					this->count_bucket(bucket_file, result_file);
+				} catch (...) {
+					lock_guard<mutex> lock (exception_mutex);
+					if (!bucket_exception) bucket_exception = current_exception();
+				}
+			};
+			threadPool.submit(f_count);
+		}
+	}
+	if (bucket_exception) {
+		for (size_t b = 0; b < this->nr_buckets; ++b) {
+			remove(bucket_files[b].c_str());
+			remove(result_files[b].c_str());
+		}
+		rethrow_exception(bucket_exception);
+	}
+
+	write_counts(result_files);
+	map_counts();
+}
+
+BucketKmerCounter::~BucketKmerCounter() {
+	if (this->data != nullptr) munmap((void*) this->data, this->data_size);
+	if (this->file_descriptor >= 0) ::close(this->file_descriptor);
+	remove(this->counts_filename.c_str());
+}
+
+void BucketKmerCounter::write_buckets(string readfile, const vector<string>& bucket_files, size_t buffer_size, size_t nr_threads) {
+	vector<FILE*> files;
+	for (auto& bucket_file : bucket_files) {
+		FILE* file = fopen(bucket_file.c_str(), "wb");
+		if (file == nullptr) {
+			for (size_t b = 0; b < files.size(); ++b) {
+				fclose(files[b]);
+				remove(bucket_files[b].c_str());
+			}
+			throw runtime_error("BucketKmerCounter::write_buckets: bucket file " + bucket_file + " cannot be created. Note that the filename must not contain non-existing directories.");
+		}
+		files.push_back(file);
+	}
+	vector<mutex> file_mutexes(files.size());
+	// each thread collects super-kmers per bucket and appends them to the bucket file once its buffer is full
+	vector<vector<vector<char>>> buffers(nr_threads, vector<vector<char>>(files.size()));
+	// canonical m-mers of a read and their positions
+	vector<KmerExtractor> extractors(nr_threads, KmerExtractor(this->minimizer_size));
+	vector<vector<uint64_t>> thread_hashes(nr_threads);
+	vector<vector<uint32_t>> thread_positions(nr_threads);
+	atomic<bool> write_error(false);
+
+	auto flush = [&](size_t thread, size_t bucket) {
+		vector<char>& buffer = buffers[thread][bucket];
+		lock_guard<mutex> lock (file_mutexes[bucket]);
+		if (fwrite(buffer.data(), 1, buffer.size(), files[bucket]) != buffer.size()) write_error = true;
+		buffer.clear();
+	};
+
+	size_t k = this->kmer_size;
+	size_t m = this->minimizer_size;
+	size_t window = k - m + 1;
+	size_t nr_buckets = files.size();
+	auto distribute = [&](const ReadBatch& batch, size_t thread) {
+		vector<uint64_t>& hashes = thread_hashes[thread];
+		vector<uint32_t>& positions = thread_positions[thread];
+		for (size_t r = 0; r < batch.nr_of_reads(); ++r) {
+			size_t length = 0;
+			const char* read = batch.get_sequence(r, length);
+			hashes.clear();
+			positions.clear();
+			extractors[thread].extract(read, length, hashes, &positions);
+			// process maximal stretches of A,C,G,T, i.e. runs of consecutive m-mers
+			size_t run_start = 0;
+			while (run_start < hashes.size()) {
+				size_t run_end = run_start + 1;
+				while ((run_end < hashes.size()) && (positions[run_end] == positions[run_end-1] + 1)) ++run_end;
+				if (run_end - run_start >= window) {
+					const char* sequence = read + positions[run_start];
+					uint64_t* h = hashes.data() + run_start;
+					for (size_t j = 0; j < run_end - run_start; ++j) h[j] = mix(h[j]);
+					size_t nr_kmers = run_end - run_start - window + 1;
+					size_t minimum = 0;
+					size_t super_start = 0;
+					uint64_t super_hash = 0;
+					for (size_t i = 0; i < nr_kmers; ++i) {
+						// minimizer of the window of m-mers i, ..., i + window - 1
+						if ((i == 0) || (minimum < i)) {
+							minimum = i;
+							for (size_t j = i + 1; j < i + window; ++j) {
+								if (h[j] < h[minimum]) minimum = j;
+							}
+						} else if (h[i + window - 1] < h[minimum]) {
+							minimum = i + window - 1;
+						}
+						if (i == 0) {
+							super_hash = h[minimum];
+						} else if ((h[minimum] != super_hash) || (i - super_start == max_super_kmer_kmers)) {
+							size_t bucket = super_hash % nr_buckets;
+							pack_super_kmer(sequence + super_start, i - super_start + k - 1, buffers[thread][bucket]);
+							if (buffers[thread][bucket].size() >= buffer_size) flush(thread, bucket);
+							super_start = i;
+							super_hash = h[minimum];
+						}
+					}
+					size_t bucket = super_hash % nr_buckets;
+					pack_super_kmer(sequence + super_start, nr_kmers - super_start + k - 1, buffers[thread][bucket]);
+					if (buffers[thread][bucket].size() >= buffer_size) flush(thread, bucket);
+				}
+				run_start = run_end;
+			}
+		}
+	};
+	try {
+		ReadParser parser (readfile);
+		parser.parse(nr_threads, distribute);
+	} catch (...) {
+		for (size_t b = 0; b < files.size(); ++b) {
+			fclose(files[b]);
+			remove(bucket_files[b].c_str());
+		}
+		throw;
+	}
+
+	for (size_t t = 0; t < nr_threads; ++t) {
+		for (size_t b = 0; b < nr_buckets; ++b) {
+			if (!buffers[t][b].empty()) flush(t, b);
+		}
+	}
+	for (auto file : files) {
+		if (fclose(file) != 0) write_error = true;
+	}
+	if (write_error) {
+		for (auto& bucket_file : bucket_files) remove(bucket_file.c_str());
+		throw runtime_error("BucketKmerCounter::write_buckets: error while writing bucket files (disk full?).");
+	}
+}
+
+void BucketKmerCounter::count_bucket(string bucket_file, string result_file) const {
+	vector<char> packed;
+	{
+		ifstream file(bucket_file, ios::binary | ios::ate);
+		if (!file.is_open()) {
+			throw runtime_error("BucketKmerCounter::count_bucket: bucket file " + bucket_file + " cannot be opened.");
+		}
+		packed.resize(file.tellg());
+		file.seekg(0);
+		file.read(packed.data(), packed.size());
+	}
+	remove(bucket_file.c_str());
+
+	// determine the number of kmer occurrences first, so that memory is allocated only once
+	size_t nr_kmers = 0;
+	size_t position = 0;
+	while (position + sizeof(uint16_t) <= packed.size()) {
+		uint16_t nr_bases;
+		memcpy(&nr_bases, packed.data() + position, sizeof(uint16_t));
+		nr_kmers += nr_bases - this->kmer_size + 1;
+		position += sizeof(uint16_t) + (nr_bases + 3) / 4;
+	}
+	vector<uint64_t> kmers;
+	kmers.reserve(nr_kmers);
+	uint64_t mask = (1ULL << (2*this->kmer_size)) - 1;
+	size_t shift = 2 * (this->kmer_size - 1);
+	position = 0;
+	while (position + sizeof(uint16_t) <= packed.size()) {
+		uint16_t nr_bases;
+		memcpy(&nr_bases, packed.data() + position, sizeof(uint16_t));
+		const unsigned char* bases = (const unsigned char*) packed.data() + position + sizeof(uint16_t);
+		uint64_t forward = 0;
+		uint64_t reverse = 0;
+		for (size_t i = 0; i < nr_bases; ++i) {
+			uint64_t base = (bases[i/4] >> (2 * (i % 4))) & 3;
+			forward = ((forward << 2) | base) & mask;
+			reverse = (reverse >> 2) | ((3 - base) << shift);
+			if (i + 1 >= this->kmer_size) kmers.push_back(min(forward, reverse));
+		}
+		position += sizeof(uint16_t) + (nr_bases + 3) / 4;
+	}
+	vector<char>().swap(packed);
+
+	// count by sorting, collapse runs of identical codes in place
+	sort(kmers.begin(), kmers.end());
+	vector<uint32_t> counts;
+	size_t nr_distinct = 0;
+	size_t i = 0;
+	while (i < kmers.size()) {
+		size_t j = i + 1;
+		while ((j < kmers.size()) && (kmers[j] == kmers[i])) ++j;
+		kmers[nr_distinct++] = kmers[i];
+		counts.push_back(min(j - i, (size_t) UINT32_MAX));
+		i = j;
+	}
+
+	ofstream result(result_file, ios::binary);
+	uint64_t n = nr_distinct;
+	result.write((const char*) &n, sizeof(uint64_t));
+	result.write((const char*) kmers.data(), nr_distinct * sizeof(uint64_t));
+	result.write((const char*) counts.data(), nr_distinct * sizeof(uint32_t));
+	if (!result.good()) {
+		throw runtime_error("BucketKmerCounter::count_bucket: error while writing " + result_file + ".");
+	}
+}
+
+void BucketKmerCounter::write_counts(const vector<string>& result_files) const {
+	// offsets of the buckets
+	vector<uint64_t> offsets(1, 0);
+	for (auto& result_file : result_files) {
+		ifstream result(result_file, ios::binary);
+		uint64_t n = 0;
+		result.read((char*) &n, sizeof(uint64_t));
+		if (!result.good()) {
+			throw runtime_error("BucketKmerCounter::write_counts: counted bucket " + result_file + " cannot be read.");
+		}
+		offsets.push_back(offsets.back() + n);
+	}
+
+	ofstream outfile(this->counts_filename, ios::binary);
+	if (!outfile.is_open()) {
+		throw runtime_error("BucketKmerCounter::write_counts: file " + this->counts_filename + " cannot be created. Note that the filename must not contain non-existing directories.");
+	}
+	BucketCountsHeader header;
+	memcpy(header.magic, counts_magic, 8);
+	header.kmer_size = this->kmer_size;
+	header.minimizer_size = this->minimizer_size;
+	header.nr_buckets = this->nr_buckets;
+	header.nr_entries = offsets.back();
+	outfile.write((const char*) &header, sizeof(BucketCountsHeader));
+	outfile.write((const char*) offsets.data(), offsets.size() * sizeof(uint64_t));
+
+	// all codes first, then all counts
+	vector<char> buffer(1 << 20);
+	for (size_t section = 0; section < 2; ++section) {
+		for (size_t b = 0; b < result_files.size(); ++b) {
+			uint64_t n = offsets[b+1] - offsets[b];
+			ifstream result(result_files[b], ios::binary);
+			uint64_t skip = sizeof(uint64_t) + ((section == 0) ? 0 : n * sizeof(uint64_t));
+			uint64_t left = n * ((section == 0) ? sizeof(uint64_t) : sizeof(uint32_t));
+			result.seekg(skip);
+			while (left > 0) {
+				size_t chunk = min((uint64_t) buffer.size(), left);
+				result.read(buffer.data(), chunk);
+				if ((size_t) result.gcount() != chunk) {
+					throw runtime_error("BucketKmerCounter::write_counts: counted bucket " + result_files[b] + " is truncated.");
+				}
+				outfile.write(buffer.data(), chunk);
+				left -= chunk;
+			}
+		}
+	}
+	for (auto& result_file : result_files) {
+		remove(result_file.c_str());
+	}
+	if (!outfile.good()) {
+		throw runtime_error("BucketKmerCounter::write_counts: error while writing " + this->counts_filename + ".");
+	}
+}
+
+void BucketKmerCounter::map_counts() {
+	this->file_descriptor = ::open(this->counts_filename.c_str(), O_RDONLY);
+	if (this->file_descriptor < 0) {
+		throw runtime_error("BucketKmerCounter::map_counts: counts file " + this->counts_filename + " cannot be opened.");
+	}
+	struct stat file_stats;
+	fstat(this->file_descriptor, &file_stats);
+	this->data_size = file_stats.st_size;
+	void* mapped = mmap(nullptr, this->data_size, PROT_READ, MAP_SHARED, this->file_descriptor, 0);
+	if (mapped == MAP_FAILED) {
+		::close(this->file_descriptor);
+		remove(this->counts_filename.c_str());
+		throw runtime_error("BucketKmerCounter::map_counts: counts file " + this->counts_filename + " cannot be memory-mapped.");
+	}
+	this->data = (const char*) mapped;
+	// lookups are spread over the whole table (only effective if the kernel supports huge pages for file mappings)
+	if (HugePages::get_mode() != HugePages::NONE) HugePages::advise(mapped, this->data_size);
+	const BucketCountsHeader* header = (const BucketCountsHeader*) this->data;
+	this->nr_entries = header->nr_entries;
+	this->offsets = (const uint64_t*) (this->data + sizeof(BucketCountsHeader));
+	this->codes = this->offsets + this->nr_buckets + 1;
+	this->counts = (const uint32_t*) (this->codes + this->nr_entries);
+}
+
+size_t BucketKmerCounter::getKmerAbundance(string kmer) {
+	uint64_t code;
+	if ((kmer.size() != this->kmer_size) || !ReferenceKmerIndex::encode_canonical(kmer, 0, this->kmer_size, code)) return 0;
+	size_t bucket = minimizer_hash(kmer, 0, this->kmer_size, this->minimizer_size) % this->nr_buckets;
+	const uint64_t* first = this->codes + this->offsets[bucket];
+	const uint64_t* last = this->codes + this->offsets[bucket + 1];
+	const uint64_t* it = lower_bound(first, last, code);
+	if ((it == last) || (*it != code)) return 0;
+	return this->counts[it - this->codes];
+}
+
+size_t BucketKmerCounter::getKmerAbundance(jellyfish::mer_dna jelly_kmer) {
+	return getKmerAbundance(jelly_kmer.to_str());
+}
+
+size_t BucketKmerCounter::computeKmerCoverage(size_t genome_kmers) {
+	long double result = 0.0L;
+	for (size_t i = 0; i < this->nr_entries; ++i) {
+		long double count = 1.0L * this->counts[i];
+		long double genome = 1.0L * genome_kmers;
+		result += (count/genome);
+	}
+	return (size_t) ceil(result);
+}
+
+size_t BucketKmerCounter::computeHistogram(size_t max_count, bool largest_peak, string filename) {
+	Histogram histogram(max_count);
+	for (size_t i = 0; i < this->nr_entries; ++i) {
+		histogram.add_value(this->counts[i]);
+	}
+	return histogram.compute_abundance_peak(largest_peak, filename);
+}
+
+size_t BucketKmerCounter::size() const {
+	return this->nr_entries;
+}
+
+size_t BucketKmerCounter::get_nr_buckets() const {
+	return this->nr_buckets;
+}
+
+string BucketKmerCounter::get_counts_filename() const {
+	return this->counts_filename;
+}
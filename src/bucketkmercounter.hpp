@@ -0,0 +1,87 @@
+#ifndef BUCKETKMERCOUNTER_HPP
+#define BUCKETKMERCOUNTER_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "kmercounter.hpp"
+
+/**
+* Counts all canonical kmers (k <= 31) of a read file within a given memory limit, using the disk instead of
+* a single in-memory hash table.
+*
+* In the first pass, reads are cut into super-kmers (maximal stretches of consecutive kmers sharing the same
+* canonical minimizer), which are 2-bit packed and appended to one of several bucket files on disk, chosen by
+* the hash of the minimizer. All occurrences of a kmer (and its reverse complement) therefore end up in the same
+* bucket. In the second pass, the buckets are counted independently (in parallel) by sorting their kmers. The
+* number of buckets is chosen such that the kmers of one bucket per thread fit into the memory limit.
+*
+* The counts are written to a file holding, for each bucket, the sorted codes of its kmers and their counts.
+* Abundances are looked up by computing the bucket of a kmer and searching its (memory-mapped) range.
+* Kmers containing other characters than A,C,G,T are skipped.
+**/
+
+struct BucketCountsHeader {
+	char magic[8];
+	uint64_t kmer_size;
+	uint64_t minimizer_size;
+	uint64_t nr_buckets;
+	uint64_t nr_entries;
+};
+
+class BucketKmerCounter : public KmerCounter {
+public:
+	/**
+	* @param readfile reads in FASTA or FASTQ format
+	* @param kmer_size kmer size (at most 31)
+	* @param prefix prefix of the temporary bucket files and of the counts file (<prefix>.counts)
+	* @param max_memory approximate number of bytes used for counting
+	* @param nr_threads number of threads
+	**/
+	BucketKmerCounter(std::string readfile, size_t kmer_size, std::string prefix, uint64_t max_memory, size_t nr_threads = 1);
+	~BucketKmerCounter();
+
+	size_t getKmerAbundance(std::string kmer);
+	size_t getKmerAbundance(jellyfish::mer_dna jelly_kmer);
+
+	/** compute the kmer coverage relative to the number of kmers in the genome **/
+	size_t computeKmerCoverage(size_t genome_kmers);
+
+	/** computes kmer abundance histogram and returns the three highest peaks **/
+	size_t computeHistogram(size_t max_count, bool largest_peak, std::string filename = "");
+
+	/** number of distinct kmers **/
+	size_t size() const;
+	/** number of buckets used **/
+	size_t get_nr_buckets() const;
+	/** name of the file holding the counts (removed by the destructor) **/
+	std::string get_counts_filename() const;
+
+	/** hash of the canonical minimizer of the kmer starting at position start (which must consist of A,C,G,T only) **/
+	static uint64_t minimizer_hash(const std::string& sequence, size_t start, size_t kmer_size, size_t minimizer_size);
+	/** minimizer size used for the given kmer size **/
+	static size_t get_minimizer_size(size_t kmer_size);
+
+private:
+	size_t kmer_size;
+	size_t minimizer_size;
+	size_t nr_buckets;
+	std::string counts_filename;
+	int file_descriptor;
+	const char* data;
+	size_t data_size;
+	size_t nr_entries;
+	const uint64_t* offsets;
+	const uint64_t* codes;
+	const uint32_t* counts;
+
+	/** first pass: distribute the super-kmers of all reads to the bucket files **/
+	void write_buckets(std::string readfile, const std::vector<std::string>& bucket_files, size_t buffer_size, size_t nr_threads);
+	/** second pass: count the kmers of one bucket and write the sorted codes and counts to result_file **/
+	void count_bucket(std::string bucket_file, std::string result_file) const;
+	/** concatenate the counted buckets into the counts file **/
+	void write_counts(const std::vector<std::string>& result_files) const;
+	void map_counts();
+};
+
+#endif // BUCKETKMERCOUNTER_HPP
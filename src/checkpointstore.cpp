@@ -0,0 +1,93 @@
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdexcept>
+#include <cerrno>
+#include "checkpointstore.hpp"
+
+using namespace std;
+
+CheckpointStore::CheckpointStore(string directory)
+	:file_size(0),
+	 mapped(nullptr),
+	 mapped_size(0),
+	 last_stored(0)
+{
+	string filename = (directory.empty() ? "." : directory) + "/pangenie-checkpoints-XXXXXX";
+	vector<char> name(filename.begin(), filename.end());
+	name.push_back('\0');
+	this->file_descriptor = mkstemp(name.data());
+	if (this->file_descriptor < 0) {
+		throw runtime_error("CheckpointStore::CheckpointStore: scratch file cannot be created in directory " + directory + ".");
+	}
+	// the file stays accessible through the descriptor until it is closed
+	unlink(name.data());
+}
+
+CheckpointStore::~CheckpointStore() {
+	if (this->mapped != nullptr) munmap(this->mapped, this->mapped_size);
+	close(this->file_descriptor);
+}
+
+void CheckpointStore::write(size_t column_index, const char* data, uint64_t bytes) {
+	if (this->entries.find(column_index) != this->entries.end()) {
+		throw runtime_error("CheckpointStore::write: column " + to_string(column_index) + " was already stored.");
+	}
+	uint64_t offset = this->file_size;
+	uint64_t written = 0;
+	while (written < bytes) {
+		ssize_t result = pwrite(this->file_descriptor, data + written, bytes - written, offset + written);
+		if (result < 0) {
+			if (errno == EINTR) continue;
+			throw runtime_error("CheckpointStore::write: error while writing to the scratch file.");
+		}
+		written += result;
+	}
+#ifdef SYNC_FILE_RANGE_WRITE
+	// start writing back right away, so that the pages can be reclaimed early
+	if (bytes > 0) sync_file_range(this->file_descriptor, offset, bytes, SYNC_FILE_RANGE_WRITE);
+#endif
+	size_t previous = this->entries.empty() ? column_index : this->last_stored;
+	this->entries[column_index] = {offset, bytes, previous};
+	this->last_stored = column_index;
+	this->file_size += bytes;
+}
+
+const char* CheckpointStore::read(size_t column_index, uint64_t& bytes) {
+	auto it = this->entries.find(column_index);
+	if (it == this->entries.end()) {
+		throw runtime_error("CheckpointStore::read: column " + to_string(column_index) + " was not stored.");
+	}
+	bytes = it->second.bytes;
+	if (bytes == 0) return nullptr;
+	if (this->mapped_size < this->file_size) {
+		// columns were written since the file was mapped
+		if (this->mapped != nullptr) munmap(this->mapped, this->mapped_size);
+		this->mapped = nullptr;
+		void* result = mmap(nullptr, this->file_size, PROT_READ, MAP_SHARED, this->file_descriptor, 0);
+		if (result == MAP_FAILED) {
+			this->mapped_size = 0;
+			throw runtime_error("CheckpointStore::read: scratch file cannot be memory-mapped.");
+		}
+		this->mapped = (char*) result;
+		this->mapped_size = this->file_size;
+	}
+	prefetch(this->entries.at(it->second.previous));
+	return this->mapped + it->second.offset;
+}
+
+void CheckpointStore::prefetch(const Entry& entry) {
+	if (entry.bytes == 0) return;
+	// madvise requires the start address to be page-aligned
+	uint64_t page_size = sysconf(_SC_PAGESIZE);
+	uint64_t start = entry.offset / page_size * page_size;
+	madvise(this->mapped + start, entry.offset + entry.bytes - start, MADV_WILLNEED);
+}
+
+bool CheckpointStore::contains(size_t column_index) const {
+	return this->entries.find(column_index) != this->entries.end();
+}
+
+uint64_t CheckpointStore::size() const {
+	return this->file_size;
+}
@@ -0,0 +1,70 @@
+#ifndef CHECKPOINTSTORE_HPP
+#define CHECKPOINTSTORE_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/**
+* Keeps HMM checkpoint columns in a scratch file instead of memory. Columns are appended to the file in the
+* order they are stored (sequential writes) and read back through a memory map of the file. Since the HMM
+* reads them back in reverse order, loading a column also asks the kernel to asynchronously read ahead the
+* column stored right before it (madvise(MADV_WILLNEED)), so that it is in the page cache once it is needed.
+**/
+
+class CheckpointStore {
+public:
+	/** @param directory directory the scratch file is created in. The file is unlinked right away, so that it vanishes with the store. **/
+	CheckpointStore(std::string directory);
+	~CheckpointStore();
+	CheckpointStore(const CheckpointStore&) = delete;
+	CheckpointStore& operator=(const CheckpointStore&) = delete;
+	/** write the column with the given index to the scratch file **/
+	template <class T>
+	void store(size_t column_index, const std::vector<T>& column);
+	/** read back a stored column, ownership of the result is transferred to the caller **/
+	template <class T>
+	std::vector<T>* load(size_t column_index);
+	/** true if a column with the given index was stored **/
+	bool contains(size_t column_index) const;
+	/** number of bytes written to the scratch file **/
+	uint64_t size() const;
+
+private:
+	struct Entry {
+		uint64_t offset;
+		uint64_t bytes;
+		// index of the entry stored before this one (or the entry itself for the first one)
+		size_t previous;
+	};
+	int file_descriptor;
+	uint64_t file_size;
+	char* mapped;
+	uint64_t mapped_size;
+	std::map<size_t, Entry> entries;
+	size_t last_stored;
+	void write(size_t column_index, const char* data, uint64_t bytes);
+	/** returns the stored data of the column and prefetches the column stored before it **/
+	const char* read(size_t column_index, uint64_t& bytes);
+	void prefetch(const Entry& entry);
+};
+
+template <class T>
+void CheckpointStore::store(size_t column_index, const std::vector<T>& column) {
+	static_assert(std::is_trivially_copyable<T>::value, "CheckpointStore::store: columns must be trivially copyable.");
+	write(column_index, reinterpret_cast<const char*>(column.data()), column.size() * sizeof(T));
+}
+
+template <class T>
+std::vector<T>* CheckpointStore::load(size_t column_index) {
+	uint64_t bytes = 0;
+	const char* data = read(column_index, bytes);
+	std::vector<T>* column = new std::vector<T>(bytes / sizeof(T));
+	if (bytes > 0) memcpy(column->data(), data, bytes);
+	return column;
+}
+
+#endif // CHECKPOINTSTORE_HPP
@@ -3,10 +3,17 @@
 
 using namespace std;
 
-ColumnIndexer::ColumnIndexer (size_t variant_id)
-	:variant_id(variant_id)
+ColumnIndexer::ColumnIndexer (size_t variant_id, Arena* arena)
+	:paths(ArenaAllocator<unsigned short>(arena)),
+	 alleles(ArenaAllocator<unsigned char>(arena)),
+	 variant_id(variant_id)
 {}
 
+void ColumnIndexer::reserve (unsigned short nr_paths) {
+	this->paths.reserve(nr_paths);
+	this->alleles.reserve(nr_paths);
+}
+
 void ColumnIndexer::insert_path (unsigned short path, unsigned char allele) {
 	this->paths.push_back(path);
 	this->alleles.push_back(allele);
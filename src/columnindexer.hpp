@@ -3,6 +3,7 @@
 
 #include <utility>
 #include <vector>
+#include "arena.hpp"
 
 /** 
 * Keep track of paths and alleles in a column
@@ -10,7 +11,10 @@
 
 class ColumnIndexer {
 public:
-	ColumnIndexer(size_t variant_id);
+	/** @param arena if given, paths and alleles are stored in this arena **/
+	ColumnIndexer(size_t variant_id, Arena* arena = nullptr);
+	/** reserve space for the given number of paths **/
+	void reserve(unsigned short nr_paths);
 	/** insert a path and the allele it covers **/
 	void insert_path(unsigned short path, unsigned char allele);
 	/** number of paths inserted **/
@@ -25,8 +29,8 @@ public:
 	size_t get_variant_id() const;
 
 private:
-	std::vector<unsigned short> paths;
-	std::vector<unsigned char> alleles;
+	ArenaVector<unsigned short> paths;
+	ArenaVector<unsigned char> alleles;
 	size_t variant_id;
 };
 
@@ -3,6 +3,7 @@
 #include <sstream>
 #include <stdio.h>
 #include <unistd.h>
+#include <getopt.h>
 
 using namespace std;
 
@@ -35,9 +36,27 @@ void CommandLineParser::add_flag_argument(char name, string description) {
 	this->flag_to_parameter[name] = false;
 }
 
+void CommandLineParser::add_long_name(char name, string long_name) {
+	this->long_names[name] = long_name;
+}
+
+string CommandLineParser::option_name(char name) {
+	string result = "-" + string(1, name);
+	auto it = this->long_names.find(name);
+	if (it != this->long_names.end()) result += ", --" + it->second;
+	return result;
+}
+
 void CommandLineParser::parse(int argc, char* argv[]) {
+	// long options are aliases of the single character ones
+	vector<struct option> long_options;
+	for (auto it = this->long_names.begin(); it != this->long_names.end(); ++it) {
+		bool flag = (this->flag_to_parameter.find(it->first) != this->flag_to_parameter.end());
+		long_options.push_back({it->second.c_str(), flag ? no_argument : required_argument, nullptr, it->first});
+	}
+	long_options.push_back({nullptr, 0, nullptr, 0});
 	int c;
-	while ((c = getopt(argc, argv, this->parser_string.c_str())) != -1) {
+	while ((c = getopt_long(argc, argv, this->parser_string.c_str(), long_options.data(), nullptr)) != -1) {
 		// check if option exists
 		if (this->arg_to_string.find(c) != this->arg_to_string.end()) {
 			if (this->flag_to_parameter.find(c) != this->flag_to_parameter.end()) {
@@ -93,15 +112,15 @@ void CommandLineParser::usage() {
 	for (auto it = this->arg_to_string.begin(); it != this->arg_to_string.end(); ++it) {
 		// check if flag
 		if (this->flag_to_parameter.find(it->first) != this->flag_to_parameter.end()) {
-			cerr << "\t-" << it->first << "\t" << it->second << endl;
+			cerr << "\t" << option_name(it->first) << "\t" << it->second << endl;
 			continue;
 		} 
 		// if there is a default value, get it
 		auto d = this->optional.find(it->first);
 		if (d != this->optional.end()) {
-			cerr << "\t-" << it->first << " VAL\t" << it->second << " (default: " << d->second << ")." << endl;
+			cerr << "\t" << option_name(it->first) << " VAL\t" << it->second << " (default: " << d->second << ")." << endl;
 		} else {
-			cerr << "\t-" << it->first << " VAL\t" << it->second << " (required)." << endl;
+			cerr << "\t" << option_name(it->first) << " VAL\t" << it->second << " (required)." << endl;
 		}
 	}
 	cerr << endl;
@@ -12,6 +12,8 @@ public:
 	void add_mandatory_argument(char name, std::string description);
 	void add_optional_argument(char name, std::string default_val, std::string description);
 	void add_flag_argument(char name, std::string description);
+	/** makes an already added option also available as --long_name **/
+	void add_long_name(char name, std::string long_name);
 	void parse(int argc, char* argv[]);
 	std::string get_argument(char name);
 	bool get_flag(char name);
@@ -25,6 +27,8 @@ private:
 	std::map<char, bool> flag_to_parameter;
 	std::vector<char> mandatory;
 	std::map<char,std::string> optional;
+	std::map<char,std::string> long_names;
+	std::string option_name(char name);
 };
 
 #endif // COMMANDLINEPARSER_HPP
@@ -0,0 +1,89 @@
+#include <math.h>
+#include <algorithm>
+#include <stdexcept>
+#include "compressedcolumn.hpp"
+
+using namespace std;
+
+CompressedColumn::CompressedColumn(const vector<long double>& column, Mode mode)
+	:mode(mode),
+	 length(column.size()),
+	 scale(0.0L),
+	 offset(0.0L),
+	 step(0.0L)
+{
+	if (mode == NONE) {
+		this->values = column;
+		return;
+	}
+	if (!column.empty()) this->scale = *max_element(column.begin(), column.end());
+
+	if (mode == FLOAT32) {
+		this->floats.reserve(this->length);
+		for (auto value : column) {
+			this->floats.push_back((value > 0.0L) ? (float) logl(value / this->scale) : -HUGE_VALF);
+		}
+		return;
+	}
+
+	// LOG16: determine the range of logarithms to be represented
+	this->codes.assign(this->length, 0);
+	if (this->scale <= 0.0L) return;
+	long double smallest = this->scale;
+	for (auto value : column) {
+		if ((value > 0.0L) && (value < smallest)) smallest = value;
+	}
+	this->offset = logl(smallest / this->scale);
+	this->step = -this->offset / (UINT16_MAX - 1);
+	for (size_t i = 0; i < this->length; ++i) {
+		if (column[i] <= 0.0L) continue;
+		long double logarithm = logl(column[i] / this->scale);
+		long double code = (this->step > 0.0L) ? roundl((logarithm - this->offset) / this->step) : 0.0L;
+		this->codes[i] = 1 + (uint16_t) min(code, (long double) (UINT16_MAX - 1));
+	}
+}
+
+vector<long double>* CompressedColumn::decompress() const {
+	if (this->mode == NONE) return new vector<long double>(this->values);
+	vector<long double>* column = new vector<long double>(this->length, 0.0L);
+	if (this->mode == FLOAT32) {
+		for (size_t i = 0; i < this->length; ++i) {
+			if (this->floats[i] == -HUGE_VALF) continue;
+			column->at(i) = this->scale * expl(this->floats[i]);
+		}
+	} else {
+		for (size_t i = 0; i < this->length; ++i) {
+			if (this->codes[i] == 0) continue;
+			column->at(i) = this->scale * expl(this->offset + (this->codes[i] - 1) * this->step);
+		}
+	}
+	return column;
+}
+
+size_t CompressedColumn::size() const {
+	return this->length;
+}
+
+size_t CompressedColumn::bytes() const {
+	return this->values.size() * sizeof(long double) + this->floats.size() * sizeof(float) + this->codes.size() * sizeof(uint16_t);
+}
+
+CompressedColumn::Mode CompressedColumn::get_mode() const {
+	return this->mode;
+}
+
+CompressedColumn::Mode CompressedColumn::parse_mode(string name) {
+	if (name == "none") return NONE;
+	if (name == "float32") return FLOAT32;
+	if (name == "log16") return LOG16;
+	throw runtime_error("CompressedColumn::parse_mode: unknown mode " + name + ". Use one of none, float32, log16.");
+}
+
+string CompressedColumn::get_mode_name(Mode mode) {
+	switch (mode) {
+		case NONE: return "none";
+		case FLOAT32: return "float32";
+		case LOG16: return "log16";
+	}
+	return "";
+}
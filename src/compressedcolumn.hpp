@@ -0,0 +1,49 @@
+#ifndef COMPRESSEDCOLUMN_HPP
+#define COMPRESSEDCOLUMN_HPP
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+/**
+* Compact copy of an HMM column that is only needed to recompute other columns. The logarithms of all values
+* relative to the largest one of the column (per-column scale) are stored, so that tiny probabilities do not
+* underflow, either
+*  - as 32 bit floats (mode FLOAT32, 4x smaller than long double on x86-64). The relative error of a value v is
+*    about |log(v/scale)| * 6e-8, or
+*  - as 16 bit codes spaced evenly between the smallest non-zero value and the scale (mode LOG16, 8x smaller). The
+*    relative error of each value is at most log(scale/smallest) / 131068, e.g. 0.2% if the values span 100 orders
+*    of magnitude.
+* Mode NONE keeps the values in full precision.
+**/
+
+class CompressedColumn {
+public:
+	enum Mode {NONE, FLOAT32, LOG16};
+	CompressedColumn(const std::vector<long double>& column, Mode mode);
+	/** column in full precision, ownership of the result is transferred to the caller **/
+	std::vector<long double>* decompress() const;
+	/** number of values **/
+	size_t size() const;
+	/** number of bytes used to store the values **/
+	size_t bytes() const;
+	Mode get_mode() const;
+	/** mode given by its name: none, float32 or log16 **/
+	static Mode parse_mode(std::string name);
+	static std::string get_mode_name(Mode mode);
+
+private:
+	Mode mode;
+	size_t length;
+	// largest value of the column
+	long double scale;
+	// FLOAT32: log(value/scale), -infinity for zeros
+	// LOG16: code c > 0 represents scale * exp(offset + (c-1) * step), code 0 represents zero
+	long double offset;
+	long double step;
+	std::vector<long double> values;
+	std::vector<float> floats;
+	std::vector<uint16_t> codes;
+};
+
+#endif // COMPRESSEDCOLUMN_HPP
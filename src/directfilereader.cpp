@@ -0,0 +1,398 @@
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <atomic>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "directfilereader.hpp"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#define DIRECTFILEREADER_IO_URING
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup 425
+#endif
+#ifndef __NR_io_uring_enter
+#define __NR_io_uring_enter 426
+#endif
+#endif
+#endif
+
+using namespace std;
+
+// alignment of buffers, offsets and lengths required by O_DIRECT
+static const size_t io_alignment = 4096;
+// whether readers may use io_uring (see DirectFileReader::set_io_uring)
+static atomic<bool> io_uring_enabled(true);
+
+#ifdef DIRECTFILEREADER_IO_URING
+// submission and completion queues shared with the kernel (see io_uring_setup(2))
+struct DirectFileReader::Ring {
+	int fd;
+	unsigned* sq_tail;
+	unsigned* sq_mask;
+	unsigned* sq_array;
+	unsigned* cq_head;
+	unsigned* cq_tail;
+	unsigned* cq_mask;
+	struct io_uring_sqe* sqes;
+	struct io_uring_cqe* cqes;
+	void* sq_ring;
+	size_t sq_ring_size;
+	void* cq_ring;
+	size_t cq_ring_size;
+	size_t sqes_size;
+	vector<struct iovec> iovecs;
+
+	/** returns nullptr if io_uring is not available **/
+	static Ring* create(unsigned entries) {
+		struct io_uring_params params;
+		memset(&params, 0, sizeof(params));
+		int fd = (int) syscall(__NR_io_uring_setup, entries, &params);
+		if (fd < 0) return nullptr;
+		Ring* ring = new Ring();
+		ring->fd = fd;
+		ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+		ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+		bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+		if (single_mmap) ring->sq_ring_size = ring->cq_ring_size = max(ring->sq_ring_size, ring->cq_ring_size);
+		ring->sq_ring = mmap(nullptr, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+		ring->cq_ring = single_mmap ? ring->sq_ring : mmap(nullptr, ring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+		ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+		ring->sqes = (struct io_uring_sqe*) mmap(nullptr, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+		if ((ring->sq_ring == MAP_FAILED) || (ring->cq_ring == MAP_FAILED) || (ring->sqes == MAP_FAILED)) {
+			if (ring->sq_ring != MAP_FAILED) munmap(ring->sq_ring, ring->sq_ring_size);
+			if (!single_mmap && (ring->cq_ring != MAP_FAILED)) munmap(ring->cq_ring, ring->cq_ring_size);
+			if (ring->sqes != MAP_FAILED) munmap(ring->sqes, ring->sqes_size);
+			close(fd);
+			delete ring;
+			return nullptr;
+		}
+		char* sq = (char*) ring->sq_ring;
+		char* cq = (char*) ring->cq_ring;
+		ring->sq_tail = (unsigned*) (sq + params.sq_off.tail);
+		ring->sq_mask = (unsigned*) (sq + params.sq_off.ring_mask);
+		ring->sq_array = (unsigned*) (sq + params.sq_off.array);
+		ring->cq_head = (unsigned*) (cq + params.cq_off.head);
+		ring->cq_tail = (unsigned*) (cq + params.cq_off.tail);
+		ring->cq_mask = (unsigned*) (cq + params.cq_off.ring_mask);
+		ring->cqes = (struct io_uring_cqe*) (cq + params.cq_off.cqes);
+		return ring;
+	}
+
+	~Ring() {
+		munmap(this->sqes, this->sqes_size);
+		if (this->cq_ring != this->sq_ring) munmap(this->cq_ring, this->cq_ring_size);
+		munmap(this->sq_ring, this->sq_ring_size);
+		close(this->fd);
+	}
+
+	/** queue a read of length bytes at offset into data, tagged with user_data **/
+	bool submit_read(int file_descriptor, char* data, size_t length, uint64_t offset, uint64_t user_data) {
+		struct iovec& iovec = this->iovecs[user_data];
+		iovec.iov_base = data;
+		iovec.iov_len = length;
+		unsigned tail = *this->sq_tail;
+		unsigned index = tail & *this->sq_mask;
+		struct io_uring_sqe* sqe = &this->sqes[index];
+		memset(sqe, 0, sizeof(struct io_uring_sqe));
+		sqe->opcode = IORING_OP_READV;
+		sqe->fd = file_descriptor;
+		sqe->addr = (uint64_t) &iovec;
+		sqe->len = 1;
+		sqe->off = offset;
+		sqe->user_data = user_data;
+		this->sq_array[index] = index;
+		__atomic_store_n(this->sq_tail, tail + 1, __ATOMIC_RELEASE);
+		int submitted;
+		do {
+			submitted = (int) syscall(__NR_io_uring_enter, this->fd, 1, 0, 0, nullptr, 0);
+		} while ((submitted < 0) && (errno == EINTR));
+		return submitted == 1;
+	}
+
+	/** next completion (returns false if there is none and wait is false) **/
+	bool next_completion(bool wait, uint64_t& user_data, int& result) {
+		for (;;) {
+			unsigned head = *this->cq_head;
+			if (head != __atomic_load_n(this->cq_tail, __ATOMIC_ACQUIRE)) {
+				struct io_uring_cqe* cqe = &this->cqes[head & *this->cq_mask];
+				user_data = cqe->user_data;
+				result = cqe->res;
+				__atomic_store_n(this->cq_head, head + 1, __ATOMIC_RELEASE);
+				return true;
+			}
+			if (!wait) return false;
+			int r = (int) syscall(__NR_io_uring_enter, this->fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+			if ((r < 0) && (errno != EINTR)) {
+				throw runtime_error("DirectFileReader::Ring::next_completion: io_uring_enter failed: " + string(strerror(errno)));
+			}
+		}
+	}
+};
+#else
+struct DirectFileReader::Ring {};
+#endif
+
+DirectFileReader::DirectFileReader(string filename, size_t block_size, size_t queue_depth, bool direct_io, bool io_uring)
+	:file_descriptor(-1),
+	 direct_io(false),
+	 regular_file(true),
+	 file_size(0),
+	 block_size((max(block_size, (size_t) 1) + io_alignment - 1) / io_alignment * io_alignment),
+	 queue_depth(max(queue_depth, (size_t) 1)),
+	 memory(nullptr),
+	 ring(nullptr),
+	 in_flight(0),
+	 next_offset(0),
+	 read_offset(0),
+	 current(0),
+	 current_length(0),
+	 current_position(0),
+	 has_current(false)
+{
+	open_file(filename, direct_io);
+	if (this->file_descriptor < 0) return;
+	void* aligned = nullptr;
+	if (posix_memalign(&aligned, io_alignment, this->block_size * this->queue_depth) != 0) {
+		close(this->file_descriptor);
+		throw runtime_error("DirectFileReader::DirectFileReader: buffers cannot be allocated.");
+	}
+	this->memory = (char*) aligned;
+	this->offsets.assign(this->queue_depth, 0);
+	this->lengths.assign(this->queue_depth, 0);
+	this->finished.assign(this->queue_depth, false);
+	// some filesystems accept O_DIRECT when opening, but not when reading
+	if (this->direct_io && !probe()) {
+		close(this->file_descriptor);
+		open_file(filename, false);
+		if (this->file_descriptor < 0) return;
+	}
+
+#ifdef DIRECTFILEREADER_IO_URING
+	if (io_uring && io_uring_enabled.load() && this->regular_file) this->ring = Ring::create(this->queue_depth);
+	if (this->ring != nullptr) {
+		this->ring->iovecs.resize(this->queue_depth);
+		for (size_t i = 0; (i < this->queue_depth) && (this->next_offset < this->file_size); ++i) {
+			submit(i);
+		}
+	}
+#endif
+}
+
+DirectFileReader::~DirectFileReader() {
+#ifdef DIRECTFILEREADER_IO_URING
+	if (this->ring != nullptr) {
+		// the kernel must not write into freed buffers
+		uint64_t user_data;
+		int result;
+		while (this->in_flight > 0) {
+			try {
+				this->ring->next_completion(true, user_data, result);
+			} catch (const runtime_error&) {
+				break;
+			}
+			this->in_flight -= 1;
+		}
+		delete this->ring;
+	}
+#endif
+	free(this->memory);
+	if (this->file_descriptor >= 0) close(this->file_descriptor);
+}
+
+void DirectFileReader::open_file(const string& filename, bool direct) {
+	this->direct_io = false;
+#ifdef O_DIRECT
+	if (direct) {
+		this->file_descriptor = open(filename.c_str(), O_RDONLY | O_DIRECT);
+		if (this->file_descriptor >= 0) this->direct_io = true;
+	}
+#endif
+	if (!this->direct_io) {
+		this->file_descriptor = open(filename.c_str(), O_RDONLY);
+		if (this->file_descriptor < 0) return;
+		posix_fadvise(this->file_descriptor, 0, 0, POSIX_FADV_SEQUENTIAL);
+	}
+	struct stat file_stats;
+	if ((fstat(this->file_descriptor, &file_stats) != 0) || S_ISDIR(file_stats.st_mode)) {
+		close(this->file_descriptor);
+		this->file_descriptor = -1;
+		return;
+	}
+	this->regular_file = S_ISREG(file_stats.st_mode);
+	this->file_size = this->regular_file ? file_stats.st_size : 0;
+#ifdef O_DIRECT
+	// O_DIRECT turns pipes into packet mode, reopening a named pipe could lose data
+	if (!this->regular_file && this->direct_io) {
+		fcntl(this->file_descriptor, F_SETFL, fcntl(this->file_descriptor, F_GETFL) & ~O_DIRECT);
+		this->direct_io = false;
+	}
+#endif
+}
+
+bool DirectFileReader::probe() {
+	if (!this->regular_file || (this->file_size == 0)) return true;
+	return pread(this->file_descriptor, buffer(0), this->block_size, 0) >= 0;
+}
+
+char* DirectFileReader::buffer(size_t index) const {
+	return this->memory + index * this->block_size;
+}
+
+bool DirectFileReader::is_open() const {
+	return this->file_descriptor >= 0;
+}
+
+uint64_t DirectFileReader::size() const {
+	return this->file_size;
+}
+
+bool DirectFileReader::uses_io_uring() const {
+	return this->ring != nullptr;
+}
+
+bool DirectFileReader::uses_direct_io() const {
+	return this->direct_io;
+}
+
+void DirectFileReader::set_io_uring(bool enabled) {
+	io_uring_enabled.store(enabled);
+}
+
+bool DirectFileReader::get_io_uring() {
+	return io_uring_enabled.load();
+}
+
+void DirectFileReader::submit(size_t index) {
+#ifdef DIRECTFILEREADER_IO_URING
+	this->offsets[index] = this->next_offset;
+	this->lengths[index] = 0;
+	this->finished[index] = false;
+	// whole blocks are requested, the kernel stops at the end of the file
+	if (!this->ring->submit_read(this->file_descriptor, buffer(index), this->block_size, this->next_offset, index)) {
+		throw runtime_error("DirectFileReader::submit: read request cannot be submitted.");
+	}
+	this->in_flight += 1;
+	this->next_offset += this->block_size;
+#endif
+}
+
+void DirectFileReader::wait_for_completion() {
+#ifdef DIRECTFILEREADER_IO_URING
+	uint64_t user_data = 0;
+	int result = 0;
+	bool wait = true;
+	string error = "";
+	// collect all completions that are available
+	while (this->ring->next_completion(wait, user_data, result)) {
+		wait = false;
+		this->in_flight -= 1;
+		this->finished[user_data] = true;
+		this->lengths[user_data] = (result > 0) ? result : 0;
+		if (result < 0) error = strerror(-result);
+	}
+	if (!error.empty()) {
+		throw runtime_error("DirectFileReader::wait_for_completion: error while reading: " + error);
+	}
+#endif
+}
+
+void DirectFileReader::complete(size_t index, size_t done) {
+	uint64_t offset = this->offsets[index];
+	size_t expected = min((uint64_t) this->block_size, this->file_size - offset);
+	while (done < expected) {
+		ssize_t n = pread(this->file_descriptor, buffer(index) + done, this->block_size - done, offset + done);
+		if ((n < 0) && (errno == EINTR)) continue;
+		if (n < 0) {
+			throw runtime_error("DirectFileReader::complete: error while reading: " + string(strerror(errno)));
+		}
+		if (n == 0) break;
+		done += n;
+	}
+	this->lengths[index] = min(done, expected);
+}
+
+void DirectFileReader::read_stream(size_t index) {
+	size_t done = 0;
+	while (done < this->block_size) {
+		ssize_t n = ::read(this->file_descriptor, buffer(index) + done, this->block_size - done);
+		if ((n < 0) && (errno == EINTR)) continue;
+		if (n < 0) {
+			throw runtime_error("DirectFileReader::read_stream: error while reading: " + string(strerror(errno)));
+		}
+		if (n == 0) break;
+		done += n;
+	}
+	this->lengths[index] = done;
+}
+
+bool DirectFileReader::next_block() {
+	if (this->file_descriptor < 0) return false;
+	// the buffer of the consumed block is reused for the next request
+	if (this->has_current && (this->ring != nullptr) && (this->next_offset < this->file_size)) submit(this->current);
+	this->has_current = false;
+	if (this->regular_file && (this->read_offset >= this->file_size)) return false;
+
+	if (!this->regular_file) {
+		read_stream(0);
+		this->current = 0;
+	} else if (this->ring != nullptr) {
+		size_t index = (this->read_offset / this->block_size) % this->queue_depth;
+		while (!this->finished[index]) wait_for_completion();
+		// short reads are completed synchronously
+		complete(index, this->lengths[index]);
+		this->current = index;
+	} else {
+		this->offsets[0] = this->read_offset;
+		complete(0, 0);
+		this->current = 0;
+	}
+	this->current_length = this->lengths[this->current];
+	this->current_position = 0;
+	this->read_offset += this->block_size;
+	this->has_current = (this->current_length > 0);
+	return this->has_current;
+}
+
+size_t DirectFileReader::read(char* data, size_t length) {
+	size_t copied = 0;
+	while (copied < length) {
+		if (!this->has_current || (this->current_position == this->current_length)) {
+			if (!next_block()) break;
+		}
+		size_t n = min(length - copied, this->current_length - this->current_position);
+		memcpy(data + copied, buffer(this->current) + this->current_position, n);
+		this->current_position += n;
+		copied += n;
+	}
+	return copied;
+}
+
+bool DirectFileReader::getline(string& line) {
+	line.clear();
+	bool extracted = false;
+	for (;;) {
+		if (!this->has_current || (this->current_position == this->current_length)) {
+			if (!next_block()) return extracted;
+		}
+		extracted = true;
+		const char* start = buffer(this->current) + this->current_position;
+		size_t available = this->current_length - this->current_position;
+		const char* newline = (const char*) memchr(start, '\n', available);
+		if (newline != nullptr) {
+			line.append(start, newline - start);
+			this->current_position += (newline - start) + 1;
+			return true;
+		}
+		line.append(start, available);
+		this->current_position = this->current_length;
+	}
+}
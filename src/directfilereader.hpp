@@ -0,0 +1,87 @@
+#ifndef DIRECTFILEREADER_HPP
+#define DIRECTFILEREADER_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/**
+* Reads a file sequentially in large blocks while bypassing the page cache (O_DIRECT). A ring of aligned
+* buffers is kept in flight using Linux io_uring, so that the next blocks are already being read while the
+* current one is consumed. On kernels without io_uring (or where it is not permitted), blocks are read one
+* at a time using pread. If the filesystem does not support O_DIRECT, the file is read through the page
+* cache instead. Pipes and other files that are not regular files (e.g. process substitution) are read
+* sequentially in blocks through the page cache.
+* Data can be consumed either in chunks (read) or line by line (getline, same semantics as std::getline).
+**/
+
+class DirectFileReader {
+public:
+	/**
+	* @param filename file to read. Use is_open() to check whether it could be opened.
+	* @param block_size number of bytes read per request (rounded up to a multiple of the alignment required by O_DIRECT)
+	* @param queue_depth number of blocks in flight
+	* @param direct_io bypass the page cache if the filesystem supports it
+	* @param io_uring keep several requests in flight using io_uring if the kernel supports it and it was not disabled (set_io_uring), otherwise read blocks using pread
+	**/
+	DirectFileReader(std::string filename, size_t block_size = 1 << 20, size_t queue_depth = 8, bool direct_io = true, bool io_uring = true);
+	~DirectFileReader();
+	DirectFileReader(const DirectFileReader&) = delete;
+	DirectFileReader& operator=(const DirectFileReader&) = delete;
+	bool is_open() const;
+	/** copies the next (at most) length bytes to data, returns the number of bytes copied (0 at the end of the file) **/
+	size_t read(char* data, size_t length);
+	/** reads the next line (without the newline character), returns false if the end of the file was reached before **/
+	bool getline(std::string& line);
+	/** size of the file in bytes (0 if it is not a regular file) **/
+	uint64_t size() const;
+	bool uses_io_uring() const;
+	bool uses_direct_io() const;
+	/** enable or disable io_uring for all readers created afterwards (enabled by default) **/
+	static void set_io_uring(bool enabled);
+	static bool get_io_uring();
+
+private:
+	struct Ring;
+	int file_descriptor;
+	bool direct_io;
+	// false for pipes and other files that can only be read sequentially
+	bool regular_file;
+	uint64_t file_size;
+	size_t block_size;
+	size_t queue_depth;
+	// aligned memory holding all buffers
+	char* memory;
+	// per buffer: byte offset of the block it holds, number of valid bytes and whether the read finished
+	std::vector<uint64_t> offsets;
+	std::vector<size_t> lengths;
+	std::vector<bool> finished;
+	// io_uring state (nullptr if blocks are read using pread)
+	Ring* ring;
+	size_t in_flight;
+	// offset of the next block to request and of the next block to consume
+	uint64_t next_offset;
+	uint64_t read_offset;
+	// current block: buffer index, number of valid bytes, read position
+	size_t current;
+	size_t current_length;
+	size_t current_position;
+	bool has_current;
+
+	char* buffer(size_t index) const;
+	void open_file(const std::string& filename, bool direct);
+	/** true if a pread of the first block succeeds using the current file descriptor **/
+	bool probe();
+	/** request the next block into the given buffer **/
+	void submit(size_t index);
+	/** wait until at least one request finished **/
+	void wait_for_completion();
+	/** read the remaining bytes of a buffer synchronously **/
+	void complete(size_t index, size_t done);
+	/** read the next block of a file that is not a regular file into the given buffer **/
+	void read_stream(size_t index);
+	/** make the next block the current one, returns false at the end of the file **/
+	bool next_block();
+};
+
+#endif // DIRECTFILEREADER_HPP
@@ -1,6 +1,6 @@
 #include <iostream>
-#include <fstream>
 #include "fastareader.hpp"
+#include "directfilereader.hpp"
 
 using namespace std;
 
@@ -12,13 +12,13 @@ FastaReader::FastaReader(string filename) {
 
 // std::map<std::string, DnaSequence*> name_to_sequence;
 void FastaReader::parse_file(string filename) {
-	ifstream file(filename);
-	if (!file.good()) {
+	DirectFileReader file(filename);
+	if (!file.is_open()) {
 		throw runtime_error("FastaReader::parse_file: reference file cannot be opened.");
 	}
 	string line;
 	DnaSequence* dna_seq = nullptr;
-	while (getline(file, line)) {
+	while (file.getline(line)) {
 		if (line.size() == 0) continue;
 		size_t start = line.find_first_not_of(" \t\r\n");
 		size_t end = line.find_last_not_of(" \t\r\n");
@@ -54,12 +54,12 @@ FastaReader::~FastaReader() {
 	this->name_to_sequence.clear();
 }
 
-bool FastaReader::contains_name(string name) const {
+bool FastaReader::contains_name(const string& name) const {
 	auto it = this->name_to_sequence.find(name);
 	return (it != this->name_to_sequence.end());
 }
 
-size_t FastaReader::get_size_of(string name) const {
+size_t FastaReader::get_size_of(const string& name) const {
 	if (this->contains_name(name)) {
 		return this->name_to_sequence.at(name)->size();
 	} else {
@@ -81,7 +81,7 @@ size_t FastaReader::get_total_kmers(size_t kmer_size) const {
 	return total_kmers;
 }
 
-void FastaReader::get_subsequence(string name, size_t start, size_t end, string& result) const {
+void FastaReader::get_subsequence(const string& name, size_t start, size_t end, string& result) const {
 	if (this->contains_name(name)) {
 		this->name_to_sequence.at(name)->substr(start, end, result);
 	} else {
@@ -89,7 +89,7 @@ void FastaReader::get_subsequence(string name, size_t start, size_t end, string&
 	}
 }
 
-void FastaReader::get_subsequence(std::string name, size_t start, size_t end, DnaSequence& result) const {
+void FastaReader::get_subsequence(const string& name, size_t start, size_t end, DnaSequence& result) const {
 	if (this->contains_name(name)) {
 		this->name_to_sequence.at(name)->substr(start, end, result);
 	} else {
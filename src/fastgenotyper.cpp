@@ -0,0 +1,69 @@
+#include "fastgenotyper.hpp"
+#include "emissionprobabilitycomputer.hpp"
+#include <stdexcept>
+
+using namespace std;
+
+// pseudo frequency added to each allele, so that alleles rare in the panel can still be genotyped
+static const long double pseudo_frequency = 0.01L;
+
+FastGenotyper::FastGenotyper(vector<UniqueKmers*>* unique_kmers, ProbabilityTable* probabilities, const vector<vector<float>>* allele_frequencies)
+	:unique_kmers(unique_kmers),
+	 probabilities(probabilities),
+	 allele_frequencies(allele_frequencies)
+{
+	if (this->unique_kmers->size() != this->allele_frequencies->size()) {
+		throw runtime_error("FastGenotyper::FastGenotyper: number of variant positions and number of allele frequencies differ.");
+	}
+}
+
+void FastGenotyper::compute_genotypes(size_t start, size_t end, vector<GenotypingResult>& result) const {
+	if ((end > this->unique_kmers->size()) || (result.size() < end)) {
+		throw runtime_error("FastGenotyper::compute_genotypes: index out of bounds.");
+	}
+	for (size_t i = start; i < end; ++i) {
+		result[i] = genotype(i);
+	}
+}
+
+vector<GenotypingResult> FastGenotyper::get_genotyping_result() const {
+	vector<GenotypingResult> result(this->unique_kmers->size());
+	compute_genotypes(0, result.size(), result);
+	return result;
+}
+
+GenotypingResult FastGenotyper::genotype(size_t index) const {
+	UniqueKmers* u = this->unique_kmers->at(index);
+	const vector<float>& frequencies = this->allele_frequencies->at(index);
+	EmissionProbabilityComputer emissions(u, this->probabilities);
+
+	vector<unsigned char> alleles;
+	u->get_allele_ids(alleles);
+	long double normalization = 1.0L + pseudo_frequency * alleles.size();
+	vector<long double> priors(alleles.size());
+	for (size_t i = 0; i < alleles.size(); ++i) {
+		priors[i] = (frequencies.at(alleles[i]) + pseudo_frequency) / normalization;
+	}
+
+	GenotypingResult result;
+	long double best_likelihood = -1.0L;
+	pair<unsigned char, unsigned char> best_genotype = {alleles[0], alleles[0]};
+	for (size_t i = 0; i < alleles.size(); ++i) {
+		for (size_t j = i; j < alleles.size(); ++j) {
+			// Hardy-Weinberg prior: heterozygous genotypes can be formed in two ways
+			long double prior = priors[i] * priors[j];
+			if (i != j) prior *= 2.0L;
+			long double likelihood = emissions.get_emission_probability(alleles[i], alleles[j]) * prior;
+			result.add_to_likelihood(alleles[i], alleles[j], likelihood);
+			if (likelihood > best_likelihood) {
+				best_likelihood = likelihood;
+				best_genotype = make_pair(alleles[i], alleles[j]);
+			}
+		}
+	}
+	// haplotypes are not phased, report the likeliest genotype
+	result.add_first_haplotype_allele(best_genotype.first);
+	result.add_second_haplotype_allele(best_genotype.second);
+	result.normalize();
+	return result;
+}
@@ -0,0 +1,35 @@
+#ifndef FASTGENOTYPER_HPP
+#define FASTGENOTYPER_HPP
+
+#include <vector>
+#include "uniquekmers.hpp"
+#include "probabilitytable.hpp"
+#include "genotypingresult.hpp"
+
+/** 
+* Approximate genotyping without an HMM. Genotype likelihoods of each variant position are computed
+* independently from the emission probabilities of all allele pairs, weighted by a Hardy-Weinberg
+* prior based on the allele frequencies in the panel.
+**/
+
+class FastGenotyper {
+public:
+	/**
+	* @param unique_kmers unique kmers of all variant positions
+	* @param probabilities kmer copy number probabilities
+	* @param allele_frequencies for each variant position, the frequency of each allele among the panel paths
+	**/
+	FastGenotyper(std::vector<UniqueKmers*>* unique_kmers, ProbabilityTable* probabilities, const std::vector<std::vector<float>>* allele_frequencies);
+	/** compute normalized genotype likelihoods of the positions in [start, end). Results are stored at the same indices of result. **/
+	void compute_genotypes(size_t start, size_t end, std::vector<GenotypingResult>& result) const;
+	/** compute normalized genotype likelihoods of all positions **/
+	std::vector<GenotypingResult> get_genotyping_result() const;
+
+private:
+	std::vector<UniqueKmers*>* unique_kmers;
+	ProbabilityTable* probabilities;
+	const std::vector<std::vector<float>>* allele_frequencies;
+	GenotypingResult genotype(size_t index) const;
+};
+
+#endif // FASTGENOTYPER_HPP
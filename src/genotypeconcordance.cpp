@@ -0,0 +1,566 @@
+#include <sstream>
+#include <iostream>
+#include <fstream>
+#include <functional>
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "genotypeconcordance.hpp"
+#include "threadpool.hpp"
+#include "variantreader.hpp"
+
+using namespace std;
+
+/** shortest representation of a double that reads back to the same value (same as str() in python) **/
+string format_double(double value) {
+	char buffer[64];
+	int digits = 1;
+	for (; digits < 17; ++digits) {
+		snprintf(buffer, sizeof(buffer), "%.*e", digits-1, value);
+		if (strtod(buffer, nullptr) == value) break;
+	}
+	snprintf(buffer, sizeof(buffer), "%.*e", digits-1, value);
+	int exponent = atoi(strchr(buffer, 'e') + 1);
+	if ((exponent < -4) || (exponent >= 16)) return string(buffer);
+	int decimals = max(digits - 1 - exponent, 1);
+	snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+	return string(buffer);
+}
+
+string variant_type_name(VariantType type) {
+	switch (type) {
+		case SNP: return "snp";
+		case SMALL_INSERTION: return "small-insertion";
+		case SMALL_DELETION: return "small-deletion";
+		case SMALL_COMPLEX: return "small-complex";
+		case MIDSIZE_INSERTION: return "midsize-insertion";
+		case MIDSIZE_DELETION: return "midsize-deletion";
+		case MIDSIZE_COMPLEX: return "midsize-complex";
+		case LARGE_INSERTION: return "large-insertion";
+		case LARGE_DELETION: return "large-deletion";
+		case LARGE_COMPLEX: return "large-complex";
+	}
+	throw runtime_error("variant_type_name: unknown variant type.");
+}
+
+static VariantType size_class(size_t varlen, bool is_insertion, bool is_deletion) {
+	if (varlen < 20) {
+		if (is_insertion) return SMALL_INSERTION;
+		if (is_deletion) return SMALL_DELETION;
+		return SMALL_COMPLEX;
+	}
+	if (varlen < 50) {
+		if (is_insertion) return MIDSIZE_INSERTION;
+		if (is_deletion) return MIDSIZE_DELETION;
+		return MIDSIZE_COMPLEX;
+	}
+	if (is_insertion) return LARGE_INSERTION;
+	if (is_deletion) return LARGE_DELETION;
+	return LARGE_COMPLEX;
+}
+
+/** symbolic ALT alleles and breakends, which PyVCF does not consider as substitutions **/
+static bool is_symbolic(const string& alt) {
+	if (alt.empty()) return false;
+	if ((alt[0] == '<') || (alt.find_first_of("[]") != string::npos)) return true;
+	return (alt.size() > 1) && ((alt[0] == '.') || (alt.back() == '.'));
+}
+
+VariantType determine_variant_type(const string& ref, const vector<string>& alt_alleles, bool is_sv) {
+	size_t varlen = ref.size();
+	for (auto& alt : alt_alleles) {
+		varlen = max(varlen, alt.size());
+	}
+
+	// PyVCF's is_snp: single base REF, all ALT alleles single bases
+	bool is_snp = (ref.size() == 1);
+	for (auto& alt : alt_alleles) {
+		if ((alt.size() != 1) || (string("ACGTN*").find(alt[0]) == string::npos)) is_snp = false;
+	}
+	if (is_snp) return SNP;
+
+	// PyVCF's is_indel (ALT "." stands for a missing allele)
+	bool is_indel = false;
+	if ((ref.size() > 1) && !is_sv) {
+		is_indel = true;
+	} else {
+		for (auto& alt : alt_alleles) {
+			if (alt == ".") {
+				is_indel = true;
+				break;
+			}
+			if (is_symbolic(alt)) break;
+			if (alt.size() != ref.size()) {
+				is_indel = !is_sv;
+				break;
+			}
+		}
+	}
+	if (!is_indel) return size_class(varlen, false, false);
+
+	// PyVCF's var_subtype: "del" for a single ALT allele shorter than REF, "ins" otherwise
+	bool is_deletion = (alt_alleles.size() == 1) && ((alt_alleles[0] == ".") || (ref.size() > alt_alleles[0].size()));
+	return size_class(varlen, !is_deletion, is_deletion);
+}
+
+VariantType determine_variant_type_by_length(const string& ref, const vector<string>& alt_alleles) {
+	size_t varlen = ref.size();
+	bool is_snp = (ref.size() == 1);
+	bool is_insertion = !alt_alleles.empty();
+	bool is_deletion = !alt_alleles.empty();
+	for (auto& alt : alt_alleles) {
+		varlen = max(varlen, alt.size());
+		if (alt.size() != 1) is_snp = false;
+		if (alt.size() <= ref.size()) is_insertion = false;
+		if (alt.size() >= ref.size()) is_deletion = false;
+	}
+	if (is_snp) return SNP;
+	return size_class(varlen, is_insertion, is_deletion);
+}
+
+ConcordanceStatistics::ConcordanceStatistics()
+	:total_baseline(0),
+	 total_baseline_nonref(0),
+	 total_baseline_biallelic(0),
+	 total_intersection(0),
+	 correct_all(0),
+	 correct_nonref(0),
+	 wrong_all(0),
+	 wrong_nonref(0),
+	 not_typed_all(0),
+	 not_typed_nonref(0),
+	 not_in_callset_all(0),
+	 not_in_callset_biallelic(0),
+	 not_in_callset_nonref(0),
+	 absent_truth(0)
+{
+	for (size_t i = 0; i < 4; ++i) {
+		for (size_t j = 0; j < 4; ++j) {
+			this->confusion_matrix[i][j] = 0;
+		}
+	}
+}
+
+void ConcordanceStatistics::add(const ConcordanceStatistics& other) {
+	this->total_baseline += other.total_baseline;
+	this->total_baseline_nonref += other.total_baseline_nonref;
+	this->total_baseline_biallelic += other.total_baseline_biallelic;
+	this->total_intersection += other.total_intersection;
+	this->correct_all += other.correct_all;
+	this->correct_nonref += other.correct_nonref;
+	this->wrong_all += other.wrong_all;
+	this->wrong_nonref += other.wrong_nonref;
+	this->not_typed_all += other.not_typed_all;
+	this->not_typed_nonref += other.not_typed_nonref;
+	this->not_in_callset_all += other.not_in_callset_all;
+	this->not_in_callset_biallelic += other.not_in_callset_biallelic;
+	this->not_in_callset_nonref += other.not_in_callset_nonref;
+	this->absent_truth += other.absent_truth;
+	for (size_t i = 0; i < 4; ++i) {
+		for (size_t j = 0; j < 4; ++j) {
+			this->confusion_matrix[i][j] += other.confusion_matrix[i][j];
+		}
+	}
+}
+
+void ConcordanceStatistics::write_statistics(ostream& tsv_file, const ConcordanceThresholds& thresholds) const {
+	size_t typed_all = max(this->correct_all + this->wrong_all, (size_t) 1);
+	size_t typed_nonref = max(this->correct_nonref + this->wrong_nonref, (size_t) 1);
+	size_t correct_biallelic = this->confusion_matrix[0][0] + this->confusion_matrix[1][1] + this->confusion_matrix[2][2];
+	size_t wrong_biallelic = this->confusion_matrix[0][1] + this->confusion_matrix[0][2] + this->confusion_matrix[1][0] + this->confusion_matrix[1][2] + this->confusion_matrix[2][1] + this->confusion_matrix[2][0];
+	size_t not_typed_biallelic = this->total_baseline_biallelic - correct_biallelic - wrong_biallelic - this->not_in_callset_biallelic;
+	size_t typed_biallelic = max(correct_biallelic + wrong_biallelic, (size_t) 1);
+	double total_baseline = max(this->total_baseline, (size_t) 1);
+	double total_baseline_biallelic = max(this->total_baseline_biallelic, (size_t) 1);
+	double total_baseline_nonref = max(this->total_baseline_nonref, (size_t) 1);
+
+	tsv_file << thresholds.quality << "\t"
+		<< format_double(thresholds.allele_frequency) << "\t"
+		<< thresholds.unique_kmers << "\t"
+		<< thresholds.missing_alleles << "\t"
+		<< this->total_baseline << "\t"
+		<< this->total_baseline_biallelic << "\t"
+		<< this->total_baseline_nonref << "\t"
+		<< this->total_intersection << "\t"
+		<< format_double(this->correct_all / (double) typed_all) << "\t"
+		<< format_double(this->wrong_all / (double) typed_all) << "\t"
+		<< format_double((this->not_typed_all + this->not_in_callset_all) / total_baseline) << "\t"
+		<< format_double(correct_biallelic / (double) typed_biallelic) << "\t"
+		<< format_double(wrong_biallelic / (double) typed_biallelic) << "\t"
+		<< format_double((not_typed_biallelic + this->not_in_callset_biallelic) / total_baseline_biallelic) << "\t"
+		<< format_double(this->correct_nonref / (double) typed_nonref) << "\t"
+		<< format_double(this->wrong_nonref / (double) typed_nonref) << "\t"
+		<< format_double((this->not_typed_nonref + this->not_in_callset_nonref) / total_baseline_nonref) << "\t"
+		<< this->correct_all << "\t"
+		<< this->wrong_all << "\t"
+		<< this->not_typed_all << "\t"
+		<< this->not_in_callset_all << "\t"
+		<< correct_biallelic << "\t"
+		<< wrong_biallelic << "\t"
+		<< not_typed_biallelic << "\t"
+		<< this->not_in_callset_biallelic << "\t"
+		<< this->correct_nonref << "\t"
+		<< this->wrong_nonref << "\t"
+		<< this->not_typed_nonref << "\t"
+		<< this->not_in_callset_nonref << "\n";
+}
+
+void ConcordanceStatistics::write_matrix(ostream& txt_file, const ConcordanceThresholds& thresholds) const {
+	txt_file << "\n###############################################################################################################################################\n";
+	txt_file << "#       Matrix for quality: " << thresholds.quality << ", allele frequency threshold: " << format_double(thresholds.allele_frequency) << " , unique kmer count threshold: " << thresholds.unique_kmers << " and missing alleles threshold: " << thresholds.missing_alleles << "#\n";
+	txt_file << "###############################################################################################################################################\n\n";
+	txt_file << "\t0\t1\t2\t./.\n";
+	for (size_t i = 0; i < 4; ++i) {
+		txt_file << i << "\t";
+		for (size_t j = 0; j < 4; ++j) {
+			txt_file << this->confusion_matrix[i][j] << "\t";
+		}
+		txt_file << "\n";
+	}
+}
+
+GenotypeConcordance::GenotypeConcordance(string baseline_filename, string callset_filename, vector<string> samples, bool use_qual, bool types_by_length)
+	:baseline_filename(baseline_filename),
+	 callset_filename(callset_filename),
+	 samples(samples),
+	 use_qual(use_qual),
+	 types_by_length(types_by_length),
+	 nr_baseline(0),
+	 nr_callset(0)
+{
+	if (samples.empty()) {
+		throw runtime_error("GenotypeConcordance::GenotypeConcordance: no samples given.");
+	}
+	size_t nr_baseline_records = 0;
+	this->index_vcf(baseline_filename, this->baseline_columns, this->baseline_blocks, nr_baseline_records, &this->chromosomes);
+	this->index_vcf(callset_filename, this->callset_columns, this->callset_blocks, this->nr_callset, nullptr);
+	cerr << "Read " << nr_baseline_records << " variants from the baseline VCF (including duplicates)." << endl;
+	cerr << "Read " << this->nr_callset << " variants from the callset VCF (including duplicates)." << endl;
+}
+
+void GenotypeConcordance::index_vcf(string filename, vector<size_t>& columns, map<string, vector<size_t>>& blocks, size_t& nr_records, vector<string>* chromosome_order) {
+	if (filename.size() > 3 && filename.substr(filename.size()-3,3).compare(".gz") == 0) {
+		throw runtime_error("GenotypeConcordance::index_vcf: Uncompressed VCF-file is required (" + filename + ").");
+	}
+	ifstream file(filename);
+	if (!file.good()) {
+		throw runtime_error("GenotypeConcordance::index_vcf: VCF file " + filename + " cannot be opened.");
+	}
+	string line;
+	string previous_chrom = "";
+	size_t offset = 0;
+	bool header_seen = false;
+	while (getline(file, line)) {
+		size_t line_start = offset;
+		offset += line.size() + 1;
+		if (line.size() == 0) continue;
+		if (line.substr(0,2) == "##") continue;
+		if (line[0] == '#') {
+			vector<string> tokens;
+			parse_line(tokens, line, '\t');
+			for (auto& sample : this->samples) {
+				auto it = find(tokens.begin(), tokens.end(), sample);
+				if ((it == tokens.end()) || (it - tokens.begin() < 9)) {
+					throw runtime_error("GenotypeConcordance::index_vcf: sample " + sample + " is not present in " + filename + ".");
+				}
+				columns.push_back(it - tokens.begin());
+			}
+			header_seen = true;
+			continue;
+		}
+		if (!header_seen) {
+			throw runtime_error("GenotypeConcordance::index_vcf: VCF header line is missing in " + filename + ".");
+		}
+		string chromosome = line.substr(0, line.find('\t'));
+		if (chromosome != previous_chrom) {
+			if ((chromosome_order != nullptr) && (blocks.find(chromosome) == blocks.end())) chromosome_order->push_back(chromosome);
+			blocks[chromosome].push_back(line_start);
+			previous_chrom = chromosome;
+		}
+		nr_records += 1;
+	}
+	if (!header_seen) {
+		throw runtime_error("GenotypeConcordance::index_vcf: VCF header line is missing in " + filename + ".");
+	}
+}
+
+void GenotypeConcordance::read_records(string filename, const string& chromosome, const vector<size_t>& blocks, const vector<size_t>& columns, bool read_qualities, vector<ConcordanceRecord>& result) const {
+	ifstream file(filename);
+	if (!file.good()) {
+		throw runtime_error("GenotypeConcordance::read_records: VCF file " + filename + " cannot be opened.");
+	}
+	for (auto offset : blocks) {
+		file.clear();
+		file.seekg(offset);
+		string line;
+		while (getline(file, line)) {
+			if (line.size() == 0) continue;
+			vector<string> tokens;
+			parse_line(tokens, line, '\t');
+			if (tokens[0] != chromosome) break;
+			if (tokens.size() < 10) {
+				throw runtime_error("GenotypeConcordance::read_records: malformed VCF record in " + filename + ": " + line);
+			}
+			ConcordanceRecord record;
+			record.position = stoi(tokens[1]);
+			record.alleles.push_back(tokens[3]);
+			vector<string> alt_alleles;
+			parse_line(alt_alleles, tokens[4], ',');
+			record.alleles.insert(record.alleles.end(), alt_alleles.begin(), alt_alleles.end());
+			record.allele_frequency = 0.0;
+			record.unique_kmers = 0;
+			record.missing_alleles = 0;
+
+			vector<string> info_fields;
+			parse_line(info_fields, tokens[7], ';');
+			if (this->types_by_length) {
+				record.type = determine_variant_type_by_length(tokens[3], alt_alleles);
+			} else {
+				bool is_sv = any_of(info_fields.begin(), info_fields.end(), [](const string& info) { return (info == "SVTYPE") || (info.substr(0,7) == "SVTYPE="); });
+				record.type = determine_variant_type(tokens[3], alt_alleles, is_sv);
+			}
+			for (auto& info : info_fields) {
+				if (info.substr(0,3) == "AF=") {
+					// allele frequency of the least frequent allele (including the reference allele)
+					vector<string> values;
+					parse_line(values, info.substr(3), ',');
+					double sum = 0.0;
+					double minimum = 1.0;
+					for (auto& v : values) {
+						double frequency = stod(v);
+						sum += frequency;
+						minimum = min(minimum, frequency);
+					}
+					record.allele_frequency = max(min(minimum, 1.0 - sum), 0.0);
+				} else if (info.substr(0,3) == "AK=") {
+					// minimum number of unique kmers of alleles covered by paths
+					vector<string> values;
+					parse_line(values, info.substr(3), ',');
+					bool first = true;
+					for (auto& v : values) {
+						int kmers = stoi(v);
+						if (kmers < 0) continue;
+						record.unique_kmers = first ? kmers : min(record.unique_kmers, kmers);
+						first = false;
+					}
+				} else if (info.substr(0,3) == "MA=") {
+					record.missing_alleles = stoi(info.substr(3));
+				}
+			}
+
+			vector<string> format_fields;
+			parse_line(format_fields, tokens[8], ':');
+			auto gt_field = find(format_fields.begin(), format_fields.end(), "GT");
+			if (gt_field == format_fields.end()) {
+				throw runtime_error("GenotypeConcordance::read_records: genotype information missing in " + filename + ".");
+			}
+			size_t gt_index = gt_field - format_fields.begin();
+			auto gq_field = find(format_fields.begin(), format_fields.end(), "GQ");
+			size_t gq_index = gq_field - format_fields.begin();
+
+			for (auto column : columns) {
+				vector<string> sample_fields;
+				parse_line(sample_fields, tokens.at(column), ':');
+				string genotype = (gt_index < sample_fields.size()) ? sample_fields[gt_index] : ".";
+				replace(genotype.begin(), genotype.end(), '/', '|');
+				pair<int,int> alleles = make_pair(-1,-1);
+				int quality = 0;
+				if (!genotype.empty() && (genotype[0] != '.') && (genotype.back() != '.')) {
+					vector<string> genotype_alleles;
+					parse_line(genotype_alleles, genotype, '|');
+					if (genotype_alleles.size() != 2) {
+						throw runtime_error("GenotypeConcordance::read_records: only diploid genotypes are supported (" + chromosome + ":" + tokens[1] + ").");
+					}
+					alleles = make_pair(stoi(genotype_alleles[0]), stoi(genotype_alleles[1]));
+					if ((alleles.first < 0) || (alleles.second < 0) || ((size_t) max(alleles.first, alleles.second) >= record.alleles.size())) {
+						throw runtime_error("GenotypeConcordance::read_records: genotype refers to an undefined allele (" + chromosome + ":" + tokens[1] + ").");
+					}
+					if (read_qualities) {
+						if (this->use_qual) {
+							if (tokens[5] != ".") quality = (int) stod(tokens[5]);
+						} else if ((gq_index < sample_fields.size()) && (sample_fields[gq_index] != ".")) {
+							quality = (int) stod(sample_fields[gq_index]);
+						}
+					}
+				}
+				record.genotypes.push_back(alleles);
+				record.qualities.push_back(quality);
+			}
+			result.push_back(record);
+		}
+	}
+}
+
+void GenotypeConcordance::compare_chromosome(string chromosome, vector< vector< vector<ConcordanceStatistics> > >* result, size_t* nr_positions) const {
+	vector<ConcordanceRecord> baseline;
+	vector<ConcordanceRecord> callset;
+	this->read_records(this->baseline_filename, chromosome, this->baseline_blocks.at(chromosome), this->baseline_columns, false, baseline);
+	auto blocks = this->callset_blocks.find(chromosome);
+	if (blocks != this->callset_blocks.end()) {
+		this->read_records(this->callset_filename, chromosome, blocks->second, this->callset_columns, true, callset);
+	}
+
+	// positions present more than once in the baseline are skipped
+	unordered_map<size_t, size_t> baseline_counts;
+	for (auto& record : baseline) {
+		baseline_counts[record.position] += 1;
+	}
+	*nr_positions = baseline_counts.size();
+	// the first callset record at a position is used
+	unordered_map<size_t, size_t> callset_index;
+	unordered_map<size_t, size_t> callset_counts;
+	for (size_t i = 0; i < callset.size(); ++i) {
+		if (callset_index.find(callset[i].position) == callset_index.end()) callset_index[callset[i].position] = i;
+		callset_counts[callset[i].position] += 1;
+	}
+
+	result->assign(this->samples.size(), vector< vector<ConcordanceStatistics> >(this->thresholds.size(), vector<ConcordanceStatistics>(nr_variant_types)));
+	for (auto& truth : baseline) {
+		if (baseline_counts.at(truth.position) > 1) {
+			cerr << "Warning: position " + chromosome + " " + to_string(truth.position) + " occurs more than once and will be skipped.\n";
+			continue;
+		}
+		const ConcordanceRecord* prediction = nullptr;
+		auto it = callset_index.find(truth.position);
+		if (it != callset_index.end()) {
+			prediction = &callset[it->second];
+			if (callset_counts.at(truth.position) > 1) {
+				cerr << "Warning: multiple predictions for variant at position " + chromosome + " " + to_string(truth.position) + ". Using first.\n";
+			}
+		}
+		bool truth_biallelic = truth.alleles.size() < 3;
+		for (size_t s = 0; s < this->samples.size(); ++s) {
+			pair<int,int> gt = truth.genotypes[s];
+			bool nonref = (gt.first != 0) || (gt.second != 0);
+			int binary_gt = gt.first + gt.second;
+			for (size_t t = 0; t < this->thresholds.size(); ++t) {
+				ConcordanceStatistics& statistics = result->at(s).at(t).at(truth.type);
+				// true genotype unknown
+				if (gt.first == -1) {
+					statistics.absent_truth += 1;
+					continue;
+				}
+				statistics.total_baseline += 1;
+				if (nonref) statistics.total_baseline_nonref += 1;
+				if (truth_biallelic) statistics.total_baseline_biallelic += 1;
+
+				if (prediction == nullptr) {
+					statistics.not_in_callset_all += 1;
+					if (nonref) statistics.not_in_callset_nonref += 1;
+					if (truth_biallelic) {
+						statistics.confusion_matrix[binary_gt][3] += 1;
+						statistics.not_in_callset_biallelic += 1;
+					}
+					continue;
+				}
+
+				statistics.total_intersection += 1;
+				const ConcordanceThresholds& threshold = this->thresholds[t];
+				if ((prediction->qualities[s] < threshold.quality) || (prediction->allele_frequency < threshold.allele_frequency) || (prediction->unique_kmers < threshold.unique_kmers) || (prediction->missing_alleles < threshold.missing_alleles)) {
+					statistics.not_typed_all += 1;
+					if (nonref) statistics.not_typed_nonref += 1;
+					continue;
+				}
+
+				pair<int,int> predicted = prediction->genotypes[s];
+				bool predicted_missing = predicted.first == -1;
+				if (truth_biallelic) {
+					if (predicted_missing) {
+						statistics.confusion_matrix[binary_gt][3] += 1;
+					} else if (prediction->alleles.size() < 3) {
+						statistics.confusion_matrix[binary_gt][predicted.first + predicted.second] += 1;
+					}
+				}
+				if (predicted_missing) {
+					statistics.not_typed_all += 1;
+					if (nonref) statistics.not_typed_nonref += 1;
+					continue;
+				}
+
+				// genotypes are compared as sets of allele sequences
+				const string& true_0 = truth.alleles[gt.first];
+				const string& true_1 = truth.alleles[gt.second];
+				const string& predicted_0 = prediction->alleles[predicted.first];
+				const string& predicted_1 = prediction->alleles[predicted.second];
+				bool same_set = ((true_0 == predicted_0) || (true_0 == predicted_1)) && ((true_1 == predicted_0) || (true_1 == predicted_1))
+					&& ((predicted_0 == true_0) || (predicted_0 == true_1)) && ((predicted_1 == true_0) || (predicted_1 == true_1));
+				if (same_set) {
+					statistics.correct_all += 1;
+					if (nonref) statistics.correct_nonref += 1;
+				} else {
+					statistics.wrong_all += 1;
+					if (nonref) statistics.wrong_nonref += 1;
+				}
+			}
+		}
+	}
+}
+
+void GenotypeConcordance::compute_statistics(const vector<ConcordanceThresholds>& thresholds, size_t nr_threads) {
+	this->thresholds = thresholds;
+	vector< vector< vector< vector<ConcordanceStatistics> > > > results(this->chromosomes.size());
+	vector<size_t> nr_positions(this->chromosomes.size(), 0);
+	{
+		ThreadPool threadPool (max(min(nr_threads, this->chromosomes.size()), (size_t) 1));
+		for (size_t i = 0; i < this->chromosomes.size(); ++i) {
+			function<void()> f_compare = bind(&GenotypeConcordance::compare_chromosome, this, this->chromosomes[i], &results[i], &nr_positions[i]);
+			threadPool.submit(f_compare);
+		}
+	}
+	this->nr_baseline = 0;
+	for (auto n : nr_positions) this->nr_baseline += n;
+	this->statistics.assign(this->samples.size(), vector< vector<ConcordanceStatistics> >(thresholds.size(), vector<ConcordanceStatistics>(nr_variant_types)));
+	for (auto& result : results) {
+		for (size_t s = 0; s < this->samples.size(); ++s) {
+			for (size_t t = 0; t < thresholds.size(); ++t) {
+				for (size_t v = 0; v < nr_variant_types; ++v) {
+					this->statistics[s][t][v].add(result[s][t][v]);
+				}
+			}
+		}
+	}
+}
+
+const ConcordanceStatistics& GenotypeConcordance::get_statistics(const string& sample, size_t threshold_index, VariantType type) const {
+	auto it = find(this->samples.begin(), this->samples.end(), sample);
+	if (it == this->samples.end()) {
+		throw runtime_error("GenotypeConcordance::get_statistics: sample " + sample + " was not evaluated.");
+	}
+	if (this->statistics.empty()) {
+		throw runtime_error("GenotypeConcordance::get_statistics: statistics have not been computed.");
+	}
+	return this->statistics.at(it - this->samples.begin()).at(threshold_index).at(type);
+}
+
+void GenotypeConcordance::write_statistics(string prefix) const {
+	if (this->statistics.empty()) {
+		throw runtime_error("GenotypeConcordance::write_statistics: statistics have not been computed.");
+	}
+	string header = "quality\tallele_frequency\tunique_kmers\tmissing_alleles\ttotal_baseline\ttotal_baseline_biallelic\ttotal_baseline_nonref\ttotal_intersection\tcorrect_all\twrong_all\tnot_typed_all\tcorrect_biallelic\twrong_biallelic\tnot_typed_biallelic\tcorrect_non-ref\twrong_non-ref\tnot_typed_non-ref\tnr_correct_all\tnr_wrong_all\tnr_not_typed_all\tnr_not_in_callset_all\tnr_correct_biallelic\tnr_wrong_biallelic\tnr_not_typed_biallelic\tnr_not_in_callset_biallelic\tnr_correct_non-ref\tnr_wrong_non-ref\tnr_not_typed_non-ref\tnr_not_in_callset_non-ref\n";
+	for (size_t s = 0; s < this->samples.size(); ++s) {
+		for (size_t v = 0; v < nr_variant_types; ++v) {
+			string name = prefix + "_" + this->samples[s] + "_" + variant_type_name((VariantType) v);
+			ofstream tsv_file(name + ".tsv");
+			ofstream txt_file(name + ".txt");
+			if (!tsv_file.good() || !txt_file.good()) {
+				throw runtime_error("GenotypeConcordance::write_statistics: output files " + name + ".tsv/.txt cannot be opened.");
+			}
+			tsv_file << header;
+			for (size_t t = 0; t < this->thresholds.size(); ++t) {
+				this->statistics[s][t][v].write_statistics(tsv_file, this->thresholds[t]);
+				this->statistics[s][t][v].write_matrix(txt_file, this->thresholds[t]);
+			}
+		}
+	}
+}
+
+size_t GenotypeConcordance::nr_baseline_variants() const {
+	return this->nr_baseline;
+}
+
+size_t GenotypeConcordance::nr_callset_variants() const {
+	return this->nr_callset;
+}
@@ -0,0 +1,127 @@
+#ifndef GENOTYPECONCORDANCE_HPP
+#define GENOTYPECONCORDANCE_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <ostream>
+
+enum VariantType { SNP, SMALL_INSERTION, SMALL_DELETION, SMALL_COMPLEX, MIDSIZE_INSERTION, MIDSIZE_DELETION, MIDSIZE_COMPLEX, LARGE_INSERTION, LARGE_DELETION, LARGE_COMPLEX };
+// number of variant types
+const size_t nr_variant_types = 10;
+
+/** name of a variant type as used in the output file names (e.g. "small-insertion") **/
+std::string variant_type_name(VariantType type);
+
+/** determine the variant type of a VCF record the same way as scripts/genotype-concordance.py, i.e. from PyVCF's is_snp
+* and var_subtype: indels are deletions if they have a single ALT allele shorter than REF, all other indels (including MNVs
+* and multi-allelic records) are insertions. Records that are neither SNPs nor indels (e.g. symbolic alleles or records with
+* an SVTYPE in INFO) are complex. The size class is given by the longest allele (< 20, < 50, >= 50 bp). **/
+VariantType determine_variant_type(const std::string& ref, const std::vector<std::string>& alt_alleles, bool is_sv = false);
+
+/** determine the variant type of a VCF record from the lengths of its alleles only: SNPs have REF and ALT alleles of
+* length 1, insertions (deletions) only ALT alleles longer (shorter) than REF, all other records (including MNVs and
+* multi-allelic records mixing insertions and deletions) are complex. Size classes as above. **/
+VariantType determine_variant_type_by_length(const std::string& ref, const std::vector<std::string>& alt_alleles);
+
+/** a variant is evaluated only if the callset record satisfies all thresholds **/
+struct ConcordanceThresholds {
+	int quality;
+	double allele_frequency;
+	int unique_kmers;
+	int missing_alleles;
+};
+
+/** genotype concordance counts of one sample and variant type **/
+struct ConcordanceStatistics {
+	size_t total_baseline;
+	size_t total_baseline_nonref;
+	size_t total_baseline_biallelic;
+	size_t total_intersection;
+	size_t correct_all;
+	size_t correct_nonref;
+	size_t wrong_all;
+	size_t wrong_nonref;
+	size_t not_typed_all;
+	size_t not_typed_nonref;
+	size_t not_in_callset_all;
+	size_t not_in_callset_biallelic;
+	size_t not_in_callset_nonref;
+	size_t absent_truth;
+	// rows: true genotype (0,1,2), columns: predicted genotype (0,1,2,./.) of biallelic variants
+	size_t confusion_matrix[4][4];
+
+	ConcordanceStatistics();
+	void add(const ConcordanceStatistics& other);
+	/** write one line of the tsv table **/
+	void write_statistics(std::ostream& tsv_file, const ConcordanceThresholds& thresholds) const;
+	/** write the confusion matrix **/
+	void write_matrix(std::ostream& txt_file, const ConcordanceThresholds& thresholds) const;
+};
+
+/** what is needed from a VCF record in order to compare genotypes **/
+struct ConcordanceRecord {
+	size_t position;
+	VariantType type;
+	// REF followed by ALT alleles
+	std::vector<std::string> alleles;
+	double allele_frequency;
+	int unique_kmers;
+	int missing_alleles;
+	// genotype alleles (-1 if genotype is missing) and genotype quality of each evaluated sample
+	std::vector< std::pair<int,int> > genotypes;
+	std::vector<int> qualities;
+};
+
+/**
+* Computes genotype concordance between a baseline (ground truth) VCF and a callset VCF for a set of samples,
+* stratified by variant type. Variants are matched by chromosome and position. Chromosomes are processed
+* independently, so that only the records of the chromosomes currently evaluated are kept in memory.
+**/
+
+class GenotypeConcordance {
+public:
+	/**
+	* @param baseline_filename baseline VCF (ground truth)
+	* @param callset_filename callset VCF (genotyped variants)
+	* @param samples samples to evaluate (need to be present in both VCFs)
+	* @param use_qual use qualities in QUAL field instead of GQ fields
+	* @param types_by_length use determine_variant_type_by_length instead of the classification of genotype-concordance.py
+	**/
+	GenotypeConcordance(std::string baseline_filename, std::string callset_filename, std::vector<std::string> samples, bool use_qual = false, bool types_by_length = false);
+	/** compute statistics of all samples for each given set of thresholds, using nr_threads chromosomes in parallel **/
+	void compute_statistics(const std::vector<ConcordanceThresholds>& thresholds, size_t nr_threads = 1);
+	/** get statistics of a sample and variant type for the threshold set with the given index **/
+	const ConcordanceStatistics& get_statistics(const std::string& sample, size_t threshold_index, VariantType type) const;
+	/** write <prefix>_<sample>_<variant type>.tsv and .txt files for all samples **/
+	void write_statistics(std::string prefix) const;
+	/** number of distinct positions of the baseline VCF (positions occurring more than once are counted once, but not evaluated). Available after compute_statistics. **/
+	size_t nr_baseline_variants() const;
+	/** number of records of the callset VCF (including duplicates) **/
+	size_t nr_callset_variants() const;
+
+private:
+	std::string baseline_filename;
+	std::string callset_filename;
+	std::vector<std::string> samples;
+	bool use_qual;
+	bool types_by_length;
+	// sample columns of the evaluated samples in each VCF
+	std::vector<size_t> baseline_columns;
+	std::vector<size_t> callset_columns;
+	// start offsets of the (contiguous) blocks of records of each chromosome
+	std::map< std::string, std::vector<size_t> > baseline_blocks;
+	std::map< std::string, std::vector<size_t> > callset_blocks;
+	// chromosomes in order of the baseline VCF
+	std::vector<std::string> chromosomes;
+	size_t nr_baseline;
+	size_t nr_callset;
+	std::vector<ConcordanceThresholds> thresholds;
+	// statistics indexed by sample, threshold set and variant type
+	std::vector< std::vector< std::vector<ConcordanceStatistics> > > statistics;
+	void index_vcf(std::string filename, std::vector<size_t>& columns, std::map< std::string, std::vector<size_t> >& blocks, size_t& nr_records, std::vector<std::string>* chromosome_order);
+	void read_records(std::string filename, const std::string& chromosome, const std::vector<size_t>& blocks, const std::vector<size_t>& columns, bool read_qualities, std::vector<ConcordanceRecord>& result) const;
+	void compare_chromosome(std::string chromosome, std::vector< std::vector< std::vector<ConcordanceStatistics> > >* result, size_t* nr_positions) const;
+};
+
+#endif // GENOTYPECONCORDANCE_HPP
@@ -65,7 +65,7 @@ vector<long double> GenotypingResult::get_all_likelihoods (size_t nr_alleles) co
 	return result;
 }
 
-GenotypingResult GenotypingResult::get_specific_likelihoods (vector<unsigned char>& alleles) const {
+GenotypingResult GenotypingResult::get_specific_likelihoods (const vector<unsigned char>& alleles) const {
 	GenotypingResult result;
 	size_t nr_alleles = alleles.size();
 	assert (nr_alleles < 256);
@@ -1,6 +1,8 @@
 #include "histogram.hpp"
 #include <fstream>
 #include <iostream>
+#include <sstream>
+#include <stdexcept>
 
 using namespace std;
 
@@ -47,6 +49,71 @@ void Histogram::find_peaks(vector<size_t>& peak_ids, vector<size_t>& peak_values
 	}
 }
 
+size_t Histogram::compute_abundance_peak(bool largest_peak, string filename) {
+	// write histogram values to file
+	if (filename != "") {
+		write_to_file(filename);
+	}
+	// smooth the histogram
+	smooth_histogram();
+	// find peaks
+	vector<size_t> peak_ids;
+	vector<size_t> peak_values;
+	find_peaks(peak_ids, peak_values);
+
+	// identify the largest and second largest (if it exists)
+	if (peak_ids.size() == 0) {
+		throw runtime_error("Histogram::compute_abundance_peak: no peak found in kmer-count histogram.");
+	}
+	size_t kmer_coverage_estimate = -1;
+	if (peak_ids.size() < 2) {
+		cerr << "Histogram peak: " << peak_ids[0] << " (" << peak_values[0] << ")" << endl;
+		kmer_coverage_estimate = peak_ids[0];
+	} else {
+		size_t largest, second, largest_id, second_id;
+		if (peak_values[0] < peak_values[1]){
+			largest = peak_values[1];
+			largest_id = peak_ids[1];
+			second = peak_values[0];
+			second_id = peak_ids[0];
+		} else {
+			largest = peak_values[0];
+			largest_id = peak_ids[0];
+			second = peak_values[1];
+			second_id = peak_ids[1];
+		}
+		for (size_t i = 0; i < peak_values.size(); ++i) {
+			if (peak_values[i] > largest) {
+				second = largest;
+				second_id = largest_id;
+				largest = peak_values[i];
+			} else if ((peak_values[i] > second) && (peak_values[i] != largest)) {
+				second = peak_values[i];
+				second_id = peak_ids[i];
+			}
+		}
+		cerr << "Histogram peaks: " << largest_id << " (" << largest << "), " << second_id << " (" << second << ")" << endl;
+		if (largest_peak) {
+			kmer_coverage_estimate = largest_id;
+		}else {
+			kmer_coverage_estimate = second_id;
+		}
+	}
+	// add expected abundance counts to end of hist file
+	if (filename != "") {
+		ofstream histofile;
+		histofile.open(filename, ios::app);
+		if (!histofile.good()) {
+			stringstream ss;
+			ss << "Histogram::compute_abundance_peak: File " << filename << " cannot be created. Note that the filename must not contain non-existing directories." << endl;
+			throw runtime_error(ss.str());
+		}
+		histofile << "parameters\t" << kmer_coverage_estimate/2.0 << '\t' << kmer_coverage_estimate << endl;
+		histofile.close();
+	}
+	return kmer_coverage_estimate;
+}
+
 ostream& operator<<(ostream& os, const Histogram& hist) {
 	for (size_t i = 0; i < hist.histogram.size(); ++i) {
 		os << i << '\t' << hist.histogram[i] << endl;
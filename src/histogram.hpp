@@ -11,6 +11,9 @@ public:
 	void write_to_file(std::string filename) const;
 	void smooth_histogram();
 	void find_peaks(std::vector<size_t>& peak_ids, std::vector<size_t>& peak_values) const;
+	/** write the histogram to filename (if given), smooth it and return the kmer abundance peak: the largest peak if largest_peak
+	* is set, otherwise the second largest one. The expected abundances are appended to filename. Throws if there is no peak. **/
+	size_t compute_abundance_peak(bool largest_peak, std::string filename = "");
 	friend std::ostream& operator<<(std::ostream& os, const Histogram& hist);
 private:
 	std::vector<size_t> histogram;
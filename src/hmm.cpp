@@ -22,13 +22,18 @@ void print_column(vector<long double>* column, ColumnIndexer* indexer) {
 }
 
 
-HMM::HMM(vector<UniqueKmers*>* unique_kmers, ProbabilityTable* probabilities, bool run_genotyping, bool run_phasing, double recombrate, bool uniform, long double effective_N, vector<unsigned short>* only_paths, bool normalize)
+HMM::HMM(vector<UniqueKmers*>* unique_kmers, ProbabilityTable* probabilities, bool run_genotyping, bool run_phasing, double recombrate, bool uniform, long double effective_N, vector<unsigned short>* only_paths, bool normalize, string spill_directory, CompressedColumn::Mode compression)
 	:unique_kmers(unique_kmers),
 	 probabilities(probabilities),
 	 genotyping_result(unique_kmers->size()),
 	 recombrate(recombrate),
 	 uniform(uniform),
-	 effective_N(effective_N)
+	 effective_N(effective_N),
+	 spill_directory(spill_directory),
+	 forward_store(nullptr),
+	 viterbi_store(nullptr),
+	 backtrace_store(nullptr),
+	 compression(compression)
 {
 	// index all columns with at least one alternative allele
 	index_columns(only_paths);
@@ -59,7 +64,10 @@ HMM::~HMM(){
 	if (this->previous_backward_column != nullptr) delete this->previous_backward_column;
 	init(this->viterbi_columns,0);
 	init(this->viterbi_backtrace_columns,0);
-	init(this->column_indexers, 0);
+	delete this->forward_store;
+	delete this->viterbi_store;
+	delete this->backtrace_store;
+	init(this->compressed_forward_columns,0);
 }
 
 void HMM::index_columns(vector<unsigned short>* only_paths) {
@@ -86,7 +94,8 @@ void HMM::index_columns(vector<unsigned short>* only_paths) {
 
 		if (!all_absent) {
 			// the ColumnIndexer to be filled
-			ColumnIndexer* column_indexer = new ColumnIndexer(column_index);
+			ColumnIndexer* column_indexer = this->column_arena.create<ColumnIndexer>(column_index, &this->column_arena);
+			column_indexer->reserve(nr_paths);
 			for (unsigned short i = 0; i < nr_paths; ++i) {
 				column_indexer->insert_path(current_paths[i], current_alleles[i]);
 			}
@@ -98,15 +107,23 @@ void HMM::index_columns(vector<unsigned short>* only_paths) {
 void HMM::compute_forward_prob() {
 	size_t column_count = this->column_indexers.size();
 	init(this->forward_columns, column_count);
+	init(this->compressed_forward_columns, column_count);
 	
 	// forward pass
 	size_t k = (size_t) sqrt(column_count);
+	if ((k > 1) && !this->spill_directory.empty()) this->forward_store = new CheckpointStore(this->spill_directory);
 	for (size_t column_index = 0; column_index < column_count; ++column_index) {;
 		compute_forward_column(column_index);
 		// sparse table: check whether to delete previous column
 		if ( (k > 1) && (column_index > 0) && (((column_index - 1)%k != 0)) ) {
 			delete this->forward_columns[column_index-1];
 			this->forward_columns[column_index-1] = nullptr;
+		} else if ((this->forward_store != nullptr) && (column_index > 0)) {
+			// checkpoint columns are written to disk
+			spill(this->forward_store, this->forward_columns, column_index-1);
+		} else if ((k > 1) && (this->compression != CompressedColumn::NONE) && (column_index > 0)) {
+			// checkpoint columns are only needed for recomputation
+			compress(this->forward_columns[column_index-1], this->compressed_forward_columns[column_index-1]);
 		}
 	}
 }
@@ -133,6 +150,10 @@ void HMM::compute_viterbi_path() {
 
 	// perform viterbi algorithm
 	size_t k = (size_t) sqrt(column_count);
+	if ((k > 1) && !this->spill_directory.empty()) {
+		this->viterbi_store = new CheckpointStore(this->spill_directory);
+		this->backtrace_store = new CheckpointStore(this->spill_directory);
+	}
 	for (size_t column_index = 0; column_index < column_count; ++column_index) {
 		compute_viterbi_column(column_index);
 		// sparse table: check whether to delete previous column
@@ -141,6 +162,10 @@ void HMM::compute_viterbi_path() {
 			this->viterbi_columns[column_index-1] = nullptr;
 			delete this->viterbi_backtrace_columns[column_index-1];
 			this->viterbi_backtrace_columns[column_index-1] = nullptr;
+		} else if ((this->viterbi_store != nullptr) && (column_index > 0)) {
+			// checkpoint columns are written to disk
+			spill(this->viterbi_store, this->viterbi_columns, column_index-1);
+			spill(this->backtrace_store, this->viterbi_backtrace_columns, column_index-1);
 		}
 	}
 
@@ -167,6 +192,8 @@ void HMM::compute_viterbi_path() {
 		// columns might have to be re-computed
 		if (this->viterbi_backtrace_columns[column_index] == nullptr) {
 			size_t j = column_index / k*k;
+			restore(this->viterbi_store, this->viterbi_columns, j);
+			restore(this->backtrace_store, this->viterbi_backtrace_columns, j);
 			assert (this->viterbi_columns[j] != nullptr);
 			for (j = j+1; j<=column_index; ++j) {
 				compute_viterbi_column(j);
@@ -182,6 +209,11 @@ void HMM::compute_viterbi_path() {
 
 		// update best index 
 		best_index = this->viterbi_backtrace_columns.at(column_index)->at(best_index);
+		// column is not needed any more (blocks are recomputed starting from their first column)
+		delete this->viterbi_columns[column_index];
+		this->viterbi_columns[column_index] = nullptr;
+		delete this->viterbi_backtrace_columns[column_index];
+		this->viterbi_backtrace_columns[column_index] = nullptr;
 		column_index -= 1;
 	}
 }
@@ -325,6 +357,8 @@ void HMM::compute_backward_column(size_t column_index) {
 			// compute index of last column stored
 			size_t k = (size_t)sqrt(column_count);
 			size_t next = min((size_t) ( (column_index / k) * k ), column_count-1);
+			restore(this->forward_store, this->forward_columns, next);
+			decompress(this->forward_columns[next], this->compressed_forward_columns[next]);
 			for (size_t j = next+1; j <= column_index; ++j) {
 				compute_forward_column(j);
 			}
@@ -425,6 +459,22 @@ void HMM::compute_backward_column(size_t column_index) {
 	}
 }
 
+void HMM::compress(vector<long double>*& column, CompressedColumn*& compressed) {
+	assert (column != nullptr);
+	if (compressed != nullptr) delete compressed;
+	compressed = new CompressedColumn(*column, this->compression);
+	delete column;
+	column = nullptr;
+}
+
+void HMM::decompress(vector<long double>*& column, CompressedColumn*& compressed) {
+	if ((column == nullptr) && (compressed != nullptr)) column = compressed->decompress();
+	if (compressed != nullptr) {
+		delete compressed;
+		compressed = nullptr;
+	}
+}
+
 void HMM::compute_viterbi_column(size_t column_index) {
 	assert(column_index < this->column_indexers.size());
 	size_t variant_id = this->column_indexers.at(column_index)->get_variant_id();
@@ -544,3 +594,11 @@ vector<GenotypingResult> HMM::get_genotyping_result() const {
 vector<GenotypingResult> HMM::move_genotyping_result() {
 	return move(this->genotyping_result);
 }
+
+uint64_t HMM::get_spilled_bytes() const {
+	uint64_t bytes = 0;
+	if (this->forward_store != nullptr) bytes += this->forward_store->size();
+	if (this->viterbi_store != nullptr) bytes += this->viterbi_store->size();
+	if (this->backtrace_store != nullptr) bytes += this->backtrace_store->size();
+	return bytes;
+}
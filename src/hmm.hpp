@@ -8,6 +8,8 @@
 #include "variant.hpp"
 #include "genotypingresult.hpp"
 #include "probabilitytable.hpp"
+#include "checkpointstore.hpp"
+#include "compressedcolumn.hpp"
 
 /** Respresents the genotyping HMM. **/
 
@@ -21,14 +23,21 @@ public:
 	* @param uniform use uniform transition probabilities
 	* @param effective_N effective population size
 	* @param only_paths only use these paths and ignore others that might be in unique_kmers.
+	* @param spill_directory if given, checkpoint columns are written to scratch files in this directory instead of being kept in memory.
+	* The columns of the block that is recomputed during the backward pass (up to k) are still kept in memory.
+	* @param compression how forward checkpoint columns are kept in memory (spilled columns are written in full precision).
 	**/
-	HMM(std::vector<UniqueKmers*>* unique_kmers, ProbabilityTable* probabilities, bool run_genotyping, bool run_phasing, double recombrate = 1.26, bool uniform = false, long double effective_N = 25000.0L, std::vector<unsigned short>* only_paths = nullptr, bool normalize = true);
+	HMM(std::vector<UniqueKmers*>* unique_kmers, ProbabilityTable* probabilities, bool run_genotyping, bool run_phasing, double recombrate = 1.26, bool uniform = false, long double effective_N = 25000.0L, std::vector<unsigned short>* only_paths = nullptr, bool normalize = true, std::string spill_directory = "", CompressedColumn::Mode compression = CompressedColumn::NONE);
 	std::vector<GenotypingResult> get_genotyping_result() const;
 	/** moves the GenotypingResults to the caller such that they will no longer be stored in the class. Use with care! **/
 	std::vector<GenotypingResult> move_genotyping_result();
+	/** number of bytes of checkpoint columns written to scratch files **/
+	uint64_t get_spilled_bytes() const;
 	~HMM();
 
 private:
+	// ColumnIndexers are stored in column_arena and freed together with it
+	Arena column_arena;
 	std::vector<ColumnIndexer*> column_indexers;
 	std::vector< std::vector<long double>* > forward_columns;
 	std::vector< long double > forward_normalization_sums;
@@ -41,6 +50,14 @@ private:
 	double recombrate;
 	bool uniform;
 	long double effective_N;
+	// scratch files for checkpoint columns (nullptr if they are kept in memory)
+	std::string spill_directory;
+	CheckpointStore* forward_store;
+	CheckpointStore* viterbi_store;
+	CheckpointStore* backtrace_store;
+	// compressed forward checkpoint columns (only used if compression is not NONE)
+	CompressedColumn::Mode compression;
+	std::vector<CompressedColumn*> compressed_forward_columns;
 	void compute_forward_prob();
 	void compute_backward_prob();
 	void compute_viterbi_path();
@@ -49,6 +66,27 @@ private:
 	void compute_backward_column(size_t column_index);
 	void compute_viterbi_column(size_t column_index);
 
+	/** move a checkpoint column to the scratch file **/
+	template<class T>
+	void spill(CheckpointStore* store, std::vector< std::vector<T>* >& c, size_t column_index) {
+		store->store(column_index, *c[column_index]);
+		delete c[column_index];
+		c[column_index] = nullptr;
+	}
+
+	/** read back a checkpoint column from the scratch file, unless it is still in memory **/
+	template<class T>
+	void restore(CheckpointStore* store, std::vector< std::vector<T>* >& c, size_t column_index) {
+		if ((c[column_index] == nullptr) && (store != nullptr) && store->contains(column_index)) {
+			c[column_index] = store->load<T>(column_index);
+		}
+	}
+
+	/** replace a column by its compressed version **/
+	void compress(std::vector<long double>*& column, CompressedColumn*& compressed);
+	/** replace a compressed column by its decompressed version, unless it is in memory already **/
+	void decompress(std::vector<long double>*& column, CompressedColumn*& compressed);
+
 	template<class T>
 	void init(std::vector< T* >& c, size_t size) {
 		for (size_t i = 0; i < c.size(); ++i) {
@@ -0,0 +1,175 @@
+#include <sys/mman.h>
+#include <unistd.h>
+#include <mutex>
+#include <map>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include "hugepages.hpp"
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+
+using namespace std;
+
+namespace {
+	struct MappedBlock {
+		size_t length;
+		bool explicit_pages;
+		bool advised;
+	};
+
+	atomic<int> configured_mode(HugePages::TRANSPARENT);
+	mutex blocks_mutex;
+	// separately mapped blocks by their address
+	map<void*, MappedBlock> blocks;
+	atomic<uint64_t> mapped_bytes(0);
+	atomic<uint64_t> explicit_bytes(0);
+	atomic<uint64_t> advised_bytes(0);
+	atomic<uint64_t> transparent_bytes(0);
+	atomic<uint64_t> peak_mapped_bytes(0);
+	atomic<uint64_t> peak_explicit_bytes(0);
+	atomic<uint64_t> peak_advised_bytes(0);
+
+	void update_peak(atomic<uint64_t>& peak, uint64_t current) {
+		uint64_t previous = peak.load();
+		while ((current > previous) && !peak.compare_exchange_weak(previous, current)) {}
+	}
+
+	size_t round_up(size_t bytes, size_t page_size) {
+		return (bytes + page_size - 1) / page_size * page_size;
+	}
+
+	/** map a block using explicit huge pages of the given size, returns nullptr if none are available **/
+	void* map_explicit(size_t length, size_t page_size) {
+#ifdef MAP_HUGETLB
+		int page_flag = (page_size == (1UL << 30)) ? (30 << MAP_HUGE_SHIFT) : (21 << MAP_HUGE_SHIFT);
+		void* pointer = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | page_flag, -1, 0);
+		if (pointer != MAP_FAILED) return pointer;
+#endif
+		return nullptr;
+	}
+
+	/** map a block aligned to huge_page_size such that it can be backed by transparent huge pages **/
+	void* map_aligned(size_t length) {
+		size_t alignment = HugePages::huge_page_size;
+		char* pointer = (char*) mmap(nullptr, length + alignment, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (pointer == (char*) MAP_FAILED) return nullptr;
+		// unmap the unaligned parts at both ends
+		char* start = (char*) round_up((uintptr_t) pointer, alignment);
+		if (start > pointer) munmap(pointer, start - pointer);
+		char* end = pointer + length + alignment;
+		if (end > start + length) munmap(start + length, end - (start + length));
+		return start;
+	}
+
+	/** AnonHugePages of the process in bytes, as listed in /proc/self/smaps_rollup (or summed up over /proc/self/smaps) **/
+	uint64_t read_transparent_bytes() {
+		ifstream smaps("/proc/self/smaps_rollup");
+		if (!smaps.good()) smaps.open("/proc/self/smaps");
+		uint64_t total = 0;
+		string line;
+		while (getline(smaps, line)) {
+			if (line.compare(0, 14, "AnonHugePages:") != 0) continue;
+			istringstream iss(line.substr(14));
+			uint64_t kilobytes = 0;
+			if (iss >> kilobytes) total += kilobytes * 1024;
+		}
+		return total;
+	}
+}
+
+const size_t HugePages::huge_page_size;
+
+void HugePages::set_mode(Mode mode) {
+	configured_mode.store(mode);
+}
+
+HugePages::Mode HugePages::get_mode() {
+	return (Mode) configured_mode.load();
+}
+
+HugePages::Mode HugePages::parse_mode(string name) {
+	if (name == "none") return NONE;
+	if (name == "transparent") return TRANSPARENT;
+	if (name == "2M") return EXPLICIT_2M;
+	if (name == "1G") return EXPLICIT_1G;
+	throw runtime_error("HugePages::parse_mode: unknown mode " + name + ". Use one of none, transparent, 2M, 1G.");
+}
+
+string HugePages::get_mode_name(Mode mode) {
+	switch (mode) {
+		case NONE: return "none";
+		case TRANSPARENT: return "transparent";
+		case EXPLICIT_2M: return "2M";
+		case EXPLICIT_1G: return "1G";
+	}
+	return "";
+}
+
+void* HugePages::allocate(size_t bytes) {
+	Mode current_mode = get_mode();
+	if ((bytes < huge_page_size) || (current_mode == NONE)) return ::operator new(bytes);
+
+	MappedBlock block = {0, false, false};
+	void* pointer = nullptr;
+	if ((current_mode == EXPLICIT_2M) || (current_mode == EXPLICIT_1G)) {
+		size_t page_size = (current_mode == EXPLICIT_1G) ? (1UL << 30) : huge_page_size;
+		block.length = round_up(bytes, page_size);
+		pointer = map_explicit(block.length, page_size);
+		block.explicit_pages = (pointer != nullptr);
+	}
+	if (pointer == nullptr) {
+		block.length = round_up(bytes, huge_page_size);
+		pointer = map_aligned(block.length);
+		if (pointer == nullptr) throw bad_alloc();
+		block.advised = advise(pointer, block.length);
+	}
+	update_peak(peak_mapped_bytes, mapped_bytes += block.length);
+	if (block.explicit_pages) update_peak(peak_explicit_bytes, explicit_bytes += block.length);
+	if (block.advised) update_peak(peak_advised_bytes, advised_bytes += block.length);
+	lock_guard<mutex> lock (blocks_mutex);
+	blocks[pointer] = block;
+	return pointer;
+}
+
+void HugePages::deallocate(void* pointer, size_t bytes) {
+	if (pointer == nullptr) return;
+	if (bytes >= huge_page_size) {
+		// the block might also have been allocated on the heap while huge pages were disabled
+		unique_lock<mutex> lock (blocks_mutex);
+		auto it = blocks.find(pointer);
+		if (it != blocks.end()) {
+			MappedBlock block = it->second;
+			blocks.erase(it);
+			lock.unlock();
+			munmap(pointer, block.length);
+			mapped_bytes -= block.length;
+			if (block.explicit_pages) explicit_bytes -= block.length;
+			if (block.advised) advised_bytes -= block.length;
+			return;
+		}
+	}
+	::operator delete(pointer);
+}
+
+bool HugePages::advise(const void* pointer, size_t bytes) {
+#ifdef MADV_HUGEPAGE
+	// madvise requires the start address to be aligned to the (small) page size
+	uintptr_t page_size = sysconf(_SC_PAGESIZE);
+	uintptr_t start = (uintptr_t) pointer / page_size * page_size;
+	return madvise((void*) start, bytes + ((uintptr_t) pointer - start), MADV_HUGEPAGE) == 0;
+#else
+	return false;
+#endif
+}
+
+void HugePages::sample() {
+	update_peak(transparent_bytes, read_transparent_bytes());
+}
+
+HugePageStatistics HugePages::get_statistics() {
+	return {mapped_bytes.load(), explicit_bytes.load(), advised_bytes.load(), peak_mapped_bytes.load(), peak_explicit_bytes.load(), peak_advised_bytes.load(), transparent_bytes.load()};
+}
@@ -0,0 +1,97 @@
+#ifndef HUGEPAGES_HPP
+#define HUGEPAGES_HPP
+
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+/**
+* Allocation of large tables backed by huge pages, which reduces TLB misses when they are accessed randomly or
+* in large strides. Blocks of at least huge_page_size bytes are mapped separately and either
+*  - advised to be backed by transparent huge pages (madvise(MADV_HUGEPAGE), mode TRANSPARENT), or
+*  - backed by explicit huge pages of 2 MiB or 1 GiB from hugetlbfs (modes EXPLICIT_2M and EXPLICIT_1G). These
+*    need to be reserved beforehand (e.g. /proc/sys/vm/nr_hugepages). If none are available, transparent huge
+*    pages are requested instead.
+* Smaller blocks, and all blocks in mode NONE, are allocated on the heap as usual.
+**/
+
+struct HugePageStatistics {
+	/** number of bytes in separately mapped blocks that are currently allocated **/
+	uint64_t mapped_bytes;
+	/** number of bytes of these blocks backed by explicit huge pages **/
+	uint64_t explicit_bytes;
+	/** number of bytes of these blocks advised to be backed by transparent huge pages **/
+	uint64_t advised_bytes;
+	/** largest number of bytes allocated in separately mapped blocks at the same time **/
+	uint64_t peak_mapped_bytes;
+	/** largest number of bytes backed by explicit huge pages at the same time **/
+	uint64_t peak_explicit_bytes;
+	/** largest number of bytes advised to be backed by transparent huge pages at the same time **/
+	uint64_t peak_advised_bytes;
+	/** largest number of bytes of the process seen to be backed by transparent huge pages (see HugePages::sample) **/
+	uint64_t transparent_bytes;
+};
+
+class HugePages {
+public:
+	enum Mode {NONE, TRANSPARENT, EXPLICIT_2M, EXPLICIT_1G};
+	/** blocks of at least this size are mapped separately **/
+	static const size_t huge_page_size = 1 << 21;
+	/** set how large blocks are allocated (only affects blocks allocated afterwards) **/
+	static void set_mode(Mode mode);
+	static Mode get_mode();
+	/** mode given by its name: none, transparent, 2M or 1G **/
+	static Mode parse_mode(std::string name);
+	static std::string get_mode_name(Mode mode);
+	static void* allocate(size_t bytes);
+	static void deallocate(void* pointer, size_t bytes);
+	/** advise the kernel to back an existing mapping (e.g. of a file) by huge pages, returns false if this is not possible **/
+	static bool advise(const void* pointer, size_t bytes);
+	/** record the number of bytes of the process currently backed by transparent huge pages **/
+	static void sample();
+	/** statistics about the blocks currently allocated and the peaks so far **/
+	static HugePageStatistics get_statistics();
+};
+
+/**
+* Allocator for standard containers that takes large blocks from HugePages.
+**/
+
+template <class T>
+class HugePageAllocator {
+public:
+	typedef T value_type;
+	template <class U>
+	struct rebind {
+		typedef HugePageAllocator<U> other;
+	};
+
+	HugePageAllocator() noexcept {}
+
+	template <class U>
+	HugePageAllocator(const HugePageAllocator<U>&) noexcept {}
+
+	T* allocate(size_t n) {
+		return static_cast<T*>(HugePages::allocate(n * sizeof(T)));
+	}
+
+	void deallocate(T* pointer, size_t n) {
+		HugePages::deallocate(pointer, n * sizeof(T));
+	}
+};
+
+template <class T, class U>
+bool operator== (const HugePageAllocator<T>&, const HugePageAllocator<U>&) {
+	return true;
+}
+
+template <class T, class U>
+bool operator!= (const HugePageAllocator<T>&, const HugePageAllocator<U>&) {
+	return false;
+}
+
+template <class T>
+using HugePageVector = std::vector<T, HugePageAllocator<T>>;
+
+#endif // HUGEPAGES_HPP
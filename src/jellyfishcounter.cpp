@@ -3,8 +3,10 @@
 #include <fstream>
 #include <stdexcept>
 #include <math.h>
+#include <limits>
 #include <fstream>
 #include "histogram.hpp"
+#include "referencekmerindex.hpp"
 
 using namespace std;
 
@@ -24,6 +26,7 @@ vector<char*> to_args(string readfile) {
 
 
 JellyfishCounter::JellyfishCounter (string readfile, size_t kmer_size, size_t nr_threads, uint64_t hash)
+	:genomic_counts(false)
 {
 	jellyfish::mer_dna::k(kmer_size); // Set length of mers
 	const uint64_t hash_size    = hash; // Initial size of hash, default = 3000000000.
@@ -48,13 +51,14 @@ JellyfishCounter::JellyfishCounter (string readfile, size_t kmer_size, size_t nr
 
 }
 
-JellyfishCounter::JellyfishCounter (string readfile, string kmerfile, size_t kmer_size, size_t nr_threads, uint64_t hash)
+JellyfishCounter::JellyfishCounter (string readfile, string kmerfile, size_t kmer_size, size_t nr_threads, uint64_t hash, bool genomic_counts)
+	:genomic_counts(genomic_counts)
 {
 	jellyfish::mer_dna::k(kmer_size); // Set length of mers
 	const uint64_t hash_size    = hash; // Initial size of hash.
 	const uint32_t num_reprobes = 126;
 	const uint32_t num_threads  = nr_threads; // Number of concurrent threads
-	const uint32_t counter_len  = 7;  // Minimum length of counting field
+	const uint32_t counter_len  = genomic_counts ? genomic_count_shift + 2 : 7;  // Minimum length of counting field (genomic counts up to 3 fit without overflow)
 	const bool canonical = true; // Use canonical representation
 
 	// create the hash
@@ -66,13 +70,15 @@ JellyfishCounter::JellyfishCounter (string readfile, string kmerfile, size_t kme
 
 	// process input kmers
 	{
-		mer_counter jellyfish_counter(num_threads, (*jellyfish_hash), &kmer_args[0], (&kmer_args[0])+1, canonical, PRIME);
+		mer_counter jellyfish_counter(num_threads, (*jellyfish_hash), &kmer_args[0], (&kmer_args[0])+1, canonical, genomic_counts ? PRIME_GENOMIC : PRIME);
 		jellyfish_counter.exec_join(num_threads);
 	}
 
 	// process read kmers
-	mer_counter jellyfish_counter(num_threads, (*jellyfish_hash), &reads_args[0], (&reads_args[0])+1, canonical, UPDATE);
-	jellyfish_counter.exec_join(num_threads);
+	{
+		mer_counter jellyfish_counter(num_threads, (*jellyfish_hash), &reads_args[0], (&reads_args[0])+1, canonical, genomic_counts ? UPDATE_GENOMIC : UPDATE);
+		jellyfish_counter.exec_join(num_threads);
+	}
 
 	// delete the kmerfile char**
 	for(size_t i = 0; i < kmer_args.size(); i++)
@@ -91,7 +97,7 @@ size_t JellyfishCounter::getKmerAbundance(string kmer){
 	uint64_t val = 0;
 	const auto jf_ary = this->jellyfish_hash->ary();
 	jf_ary->get_val_for_key(jelly_kmer, &val);
-	return val;
+	return read_count(val);
 }
 
 size_t JellyfishCounter::getKmerAbundance(jellyfish::mer_dna jelly_kmer){
@@ -100,7 +106,50 @@ size_t JellyfishCounter::getKmerAbundance(jellyfish::mer_dna jelly_kmer){
 	uint64_t val = 0;
 	const auto jf_ary = this->jellyfish_hash->ary();
 	jf_ary->get_val_for_key(jelly_kmer, &val);
-	return val;
+	return read_count(val);
+}
+
+bool JellyfishCounter::storesGenomicCounts() const {
+	return this->genomic_counts;
+}
+
+void JellyfishCounter::getGenomicAndReadAbundance(jellyfish::mer_dna jelly_kmer, size_t& genomic_count, size_t& read_count) {
+	if (!this->genomic_counts) {
+		throw runtime_error("JellyfishCounter::getGenomicAndReadAbundance: genomic counts were not stored.");
+	}
+	jelly_kmer.canonicalize();
+	uint64_t val = 0;
+	const auto jf_ary = this->jellyfish_hash->ary();
+	jf_ary->get_val_for_key(jelly_kmer, &val);
+	genomic_count = val >> genomic_count_shift;
+	read_count = val & read_count_mask;
+}
+
+uint64_t JellyfishCounter::read_count(uint64_t value) const {
+	return this->genomic_counts ? (value & read_count_mask) : value;
+}
+
+void JellyfishCounter::write_sorted_dump(string filename) {
+	size_t kmer_size = jellyfish::mer_dna::k();
+	if (kmer_size > 31) {
+		throw runtime_error("JellyfishCounter::write_sorted_dump: kmer size must be at most 31.");
+	}
+	const uint64_t max_count = numeric_limits<uint32_t>::max();
+	// entries are sorted in bounded runs that are merged afterwards
+	SortedDumpWriter writer(filename, kmer_size, this->genomic_counts);
+	const auto jf_ary = this->jellyfish_hash->ary();
+	const auto end = jf_ary->end();
+	for (auto it = jf_ary->begin(); it != end; ++it) {
+		auto& key_val = *it;
+		// kmers without any counts are reported as 0 anyway
+		if (key_val.second == 0) continue;
+		SortedKmerEntry entry;
+		ReferenceKmerIndex::encode_canonical(key_val.first.to_str(), 0, kmer_size, entry.code);
+		entry.read_count = min(read_count(key_val.second), max_count);
+		entry.genomic_count = this->genomic_counts ? min(key_val.second >> genomic_count_shift, max_count) : 0;
+		writer.add(entry);
+	}
+	writer.finish();
 }
 
 size_t JellyfishCounter::computeKmerCoverage(size_t genome_kmers) {
@@ -109,7 +158,7 @@ size_t JellyfishCounter::computeKmerCoverage(size_t genome_kmers) {
 	long double result = 0.0L;
 	for (auto it = jf_ary->begin(); it != end; ++it) {
 		auto& key_val = *it;
-		long double count = 1.0L * key_val.second;
+		long double count = 1.0L * read_count(key_val.second);
 		long double genome = 1.0L * genome_kmers;
 		result += (count/genome);
 	}
@@ -122,70 +171,10 @@ size_t JellyfishCounter::computeHistogram(size_t max_count, bool largest_peak, s
 	const auto end = jf_ary->end();
 	for (auto it = jf_ary->begin(); it != end; ++it) {
 		auto& key_val = *it;
-		if (key_val.second > 0) histogram.add_value(key_val.second);
-	}
-	// write histogram values to file
-	if (filename != "") {
-		histogram.write_to_file(filename);
-	}
-	// smooth the histogram
-	histogram.smooth_histogram();
-	// find peaks
-	vector<size_t> peak_ids;
-	vector<size_t> peak_values;
-	histogram.find_peaks(peak_ids, peak_values);
-
-	// identify the largest and second largest (if it exists)
-	if (peak_ids.size() == 0) {
-		throw runtime_error("JellyfishCounter::computeHistogram: no peak found in kmer-count histogram.");
-	}
-	size_t kmer_coverage_estimate = -1;
-	if (peak_ids.size() < 2) {
-		cerr << "Histogram peak: " << peak_ids[0] << " (" << peak_values[0] << ")" << endl;
-		kmer_coverage_estimate = peak_ids[0];
-	} else {
-		size_t largest, second, largest_id, second_id;
-		if (peak_values[0] < peak_values[1]){
-			largest = peak_values[1];
-			largest_id = peak_ids[1];
-			second = peak_values[0];
-			second_id = peak_ids[0];
-		} else {
-			largest = peak_values[0];
-			largest_id = peak_ids[0];
-			second = peak_values[1];
-			second_id = peak_ids[1];
-		}
-		for (size_t i = 0; i < peak_values.size(); ++i) {
-			if (peak_values[i] > largest) {
-				second = largest;
-				second_id = largest_id;
-				largest = peak_values[i];
-			} else if ((peak_values[i] > second) && (peak_values[i] != largest)) {
-				second = peak_values[i];
-				second_id = peak_ids[i];
-			}
-		}
-		cerr << "Histogram peaks: " << largest_id << " (" << largest << "), " << second_id << " (" << second << ")" << endl;
-		if (largest_peak) {
-			kmer_coverage_estimate = largest_id;
-		}else {
-			kmer_coverage_estimate = second_id;
-		}
-	}
-	// add expected abundance counts to end of hist file
-	if (filename != "") {
-		ofstream histofile;
-		histofile.open(filename, ios::app);
-		if (!histofile.good()) {
-			stringstream ss;
-			ss << "JellyfishCounter::computeHistogram: File " << filename << " cannot be created. Note that the filename must not contain non-existing directories." << endl;
-			throw runtime_error(ss.str());
-		}
-		histofile << "parameters\t" << kmer_coverage_estimate/2.0 << '\t' << kmer_coverage_estimate << endl;
-		histofile.close();
+		uint64_t count = read_count(key_val.second);
+		if (count > 0) histogram.add_value(count);
 	}
-	return kmer_coverage_estimate;
+	return histogram.compute_abundance_peak(largest_peak, filename);
 }
 
 JellyfishCounter::~JellyfishCounter() {
@@ -11,13 +11,22 @@
 #include <jellyfish/mer_overlap_sequence_parser.hpp>
 #include <jellyfish/mer_iterator.hpp>
 #include "kmercounter.hpp"
+#include "sortedkmercounter.hpp"
 
 /**
 * Counts Kmers in DNA-sequences (given in FASTQ-format) using jellyfish.
  **/
 
 
-enum OPERATION { COUNT, PRIME, UPDATE };
+enum OPERATION { COUNT, PRIME, PRIME_GENOMIC, UPDATE, UPDATE_GENOMIC };
+
+/** if genomic counts are stored, the value of a kmer is (genomic count << genomic_count_shift) + read count **/
+static const unsigned int genomic_count_shift = 16;
+static const uint64_t read_count_mask = (1ULL << genomic_count_shift) - 1;
+/** read counts stored next to genomic counts saturate at this value, so that they never carry into the genomic count.
+*   The value is read before it is updated, the headroom up to read_count_mask covers concurrent updates of the same kmer.
+**/
+static const uint64_t read_count_limit = read_count_mask >> 1;
 
 // using example from: Jellyfish-2/examples/jf_count_dump/jf_count_dump.cc
 typedef jellyfish::cooperative::hash_counter<jellyfish::mer_dna>	mer_hash_type;
@@ -56,11 +65,29 @@ public:
 					mer_hash_.set(*mers);
 				break;
 
-			case UPDATE:
+			case PRIME_GENOMIC:
+				for( ; mers; ++mers)
+					mer_hash_.add(*mers, 1ULL << genomic_count_shift);
+				break;
+
+			case UPDATE: {
 				jellyfish::mer_dna tmp;
 				for( ; mers; ++mers)
 					mer_hash_.update_add(*mers, 1, tmp);
 				break;
+			}
+
+			case UPDATE_GENOMIC: {
+				jellyfish::mer_dna tmp;
+				const auto ary = mer_hash_.ary();
+				for( ; mers; ++mers) {
+					uint64_t val = 0;
+					if (!ary->get_val_for_key(*mers, &val)) continue;
+					if ((val & read_count_mask) >= read_count_limit) continue;
+					mer_hash_.update_add(*mers, 1, tmp);
+				}
+				break;
+			}
 		}
 
 		mer_hash_.done();
@@ -82,8 +109,10 @@ public:
 	* @param kmerfile only count kmers contained in sequences given in this FASTQ-file
 	* @param *params parameters for GATB-Kmercounter
 	* @param name of the output file
+	* @param genomic_counts additionally store how often each kmer occurs in kmerfile, in the same hash entry as its read count.
+	* Read counts then saturate at read_count_limit.
 	**/
-	JellyfishCounter (std::string readfile, std::string kmerfile, size_t kmer_size, size_t nr_threads = 1, uint64_t hash = 3000000000);
+	JellyfishCounter (std::string readfile, std::string kmerfile, size_t kmer_size, size_t nr_threads = 1, uint64_t hash = 3000000000, bool genomic_counts = false);
 
 	~JellyfishCounter();
 	
@@ -99,7 +128,18 @@ public:
 	/** computes kmer abundance histogram and returns the three highest peaks **/
 	size_t computeHistogram(size_t max_count, bool largest_peak, std::string filename = "");
 
+	bool storesGenomicCounts() const;
+
+	/** get genomic count (occurrences in kmerfile) and read abundance of given kmer **/
+	void getGenomicAndReadAbundance(jellyfish::mer_dna jelly_kmer, size_t& genomic_count, size_t& read_count);
+
+	/** write all counted kmers sorted by their canonical code to a dump that can be used by SortedKmerCounter (k <= 31) **/
+	void write_sorted_dump(std::string filename);
+
 private:
 	mer_hash_type* jellyfish_hash;
+	bool genomic_counts;
+	/** read count stored in a hash value **/
+	uint64_t read_count(uint64_t value) const;
 };
 #endif // JELLYFISHCOUNTER_HPP
@@ -41,16 +41,45 @@ JellyfishReader::JellyfishReader (string readfile, size_t kmersize)
 }
 
 size_t JellyfishReader::getKmerAbundance(string kmer){
-	jellyfish::mer_dna jelly_kmer(kmer);
-	jelly_kmer.canonicalize();
-	return this->db->check(jelly_kmer);
+	return getKmerAbundance(jellyfish::mer_dna(kmer));
 }
 
 size_t JellyfishReader::getKmerAbundance(jellyfish::mer_dna jelly_kmer){
+	if (this->queries) {
+		size_t read_count = 0;
+		size_t genomic_count = 0;
+		this->queries->get_counts(jelly_kmer, read_count, genomic_count);
+		return read_count;
+	}
 	jelly_kmer.canonicalize();
 	return this->db->check(jelly_kmer);
 }
 
+bool JellyfishReader::resolvesQueriesInBatch() const {
+	return true;
+}
+
+void JellyfishReader::resolveQueries(const vector<jellyfish::mer_dna>& kmers) {
+	size_t kmer_size = this->header->key_len() / 2;
+	shared_ptr<ResolvedKmerQueries> resolved (new ResolvedKmerQueries(kmer_size));
+	resolved->set_queries(kmers);
+
+	// the database is ordered by hash position, not by kmer. Stream it sequentially and
+	// look up each entry in the (sorted, in-memory) queries.
+	ifstream database(this->filename, ios::in|ios::binary);
+	jellyfish::file_header database_header(database);
+	if (!database.good()) {
+		throw runtime_error("JellyfishReader::resolveQueries: Failed to parse header of file '" + this->filename + "'");
+	}
+	binary_reader reader (database, &database_header);
+	size_t nr_queries = resolved->size();
+	while (reader.next()) {
+		size_t index = resolved->find(resolved->encode(reader.key()));
+		if (index < nr_queries) resolved->set_counts(index, reader.val(), 0);
+	}
+	this->queries = resolved;
+}
+
 size_t JellyfishReader::computeKmerCoverage(size_t genome_kmers) {
 	binary_reader reader (this->ifs, this->header.get());
 
@@ -76,67 +105,7 @@ size_t JellyfishReader::computeHistogram(size_t max_count, bool largest_peak, st
 		histogram.add_value(reader.val());
 	}
 
-	// write histogram values to file
-	if (filename != "") {
-		histogram.write_to_file(filename);
-	}
-	// smooth the histogram
-	histogram.smooth_histogram();
-	// find peaks
-	vector<size_t> peak_ids;
-	vector<size_t> peak_values;
-	histogram.find_peaks(peak_ids, peak_values);
-
-	// identify the largest and second largest (if it exists)
-	if (peak_ids.size() == 0) {
-		throw runtime_error("JellyfishReader::computeHistogram: no peak found in kmer-count histogram.");
-	}
-	size_t kmer_coverage_estimate = -1;
-	if (peak_ids.size() < 2) {
-		cerr << "Histogram peak: " << peak_ids[0] << " (" << peak_values[0] << ")" << endl;
-		kmer_coverage_estimate = peak_ids[0];
-	} else {
-		size_t largest, second, largest_id, second_id;
-		if (peak_values[0] < peak_values[1]){
-			largest = peak_values[1];
-			largest_id = peak_ids[1];
-			second = peak_values[0];
-			second_id = peak_ids[0];
-		} else {
-			largest = peak_values[0];
-			largest_id = peak_ids[0];
-			second = peak_values[1];
-			second_id = peak_ids[1];
-		}
-		for (size_t i = 0; i < peak_values.size(); ++i) {
-			if (peak_values[i] > largest) {
-				second = largest;
-				second_id = largest_id;
-				largest = peak_values[i];
-			} else if ((peak_values[i] > second) && (peak_values[i] != largest)) {
-				second = peak_values[i];
-				second_id = peak_ids[i];
-			}
-		}
-		cerr << "Histogram peaks: " << largest_id << " (" << largest << "), " << second_id << " (" << second << ")" << endl;
-		if (largest_peak) {
-			kmer_coverage_estimate = largest_id;
-		}else {
-			kmer_coverage_estimate = second_id;
-		}
-	}
-	// add expected abundance counts to end of hist file
-	if (filename != "") {
-		ofstream histofile;
-		histofile.open(filename, ios::app);
-		if (!histofile.good()) {
-			stringstream ss;
-			ss << "JellyfishReader::computeHistogram: File " << filename << " cannot be created. Note that the filename must not contain non-existing directories." << endl;
-			throw runtime_error(ss.str());
-		}
-		histofile << "parameters\t" << kmer_coverage_estimate/2.0 << '\t' << kmer_coverage_estimate << endl;
-		histofile.close();
-	}
+	size_t kmer_coverage_estimate = histogram.compute_abundance_peak(largest_peak, filename);
 
 	// reset ifs
 	this->ifs.clear();
@@ -15,6 +15,7 @@
 #include <jellyfish/jellyfish.hpp>
 #include <memory>
 #include "kmercounter.hpp"
+#include "sortedkmercounter.hpp"
 
 /**
 * Reads a kmer counts from the provided Jellyfish .jf file
@@ -76,6 +77,12 @@ public:
 	/** computes kmer abundance histogram and returns the three highest peaks **/
 	size_t computeHistogram(size_t max_count, bool largest_peak, std::string filename = "");
 
+	/** queries can be resolved in one sequential pass over the database instead of random lookups **/
+	bool resolvesQueriesInBatch() const;
+
+	/** stream the database once and keep the counts of the given kmers (k <= 31). Afterwards, only these kmers can be looked up. **/
+	void resolveQueries(const std::vector<jellyfish::mer_dna>& kmers);
+
 	~JellyfishReader();
 
 private:
@@ -89,6 +96,8 @@ private:
 	std::shared_ptr<binary_query> db;
 	/** infile **/
 	std::ifstream ifs;
+	/** counts of resolved queries (if resolveQueries was called) **/
+	std::shared_ptr<ResolvedKmerQueries> queries;
 	
 };
 #endif // JELLYFISHREADER_HPP
@@ -4,6 +4,7 @@
 #include <map>
 #include <vector>
 #include <string>
+#include <stdexcept>
 #include <jellyfish/mer_dna.hpp>
 
 class KmerCounter {
@@ -20,6 +21,20 @@ public:
 	/** computes kmer abundance histogram and returns the three highest peaks **/
 	virtual size_t computeHistogram(size_t max_count, bool largest_peak, std::string filename = "") = 0;
 
+	/** true if the counter also stores the number of occurrences of each kmer in the path segments (genomic count) **/
+	virtual bool storesGenomicCounts() const { return false; }
+
+	/** get genomic count and read abundance of given kmer with a single lookup (only if storesGenomicCounts()) **/
+	virtual void getGenomicAndReadAbundance(jellyfish::mer_dna, size_t&, size_t&) {
+		throw std::runtime_error("KmerCounter::getGenomicAndReadAbundance: counter does not store genomic counts.");
+	}
+
+	/** true if kmers are looked up faster in a batch: all kmers to be queried are passed to resolveQueries() before any lookup **/
+	virtual bool resolvesQueriesInBatch() const { return false; }
+
+	/** look up the given kmers in one pass. Subsequent lookups of these kmers are answered from memory. **/
+	virtual void resolveQueries(const std::vector<jellyfish::mer_dna>&) {}
+
 	virtual ~KmerCounter() {} ;
 };
 #endif // KMERCOUNTER_HPP
@@ -0,0 +1,146 @@
+#include <stdexcept>
+#include <algorithm>
+#include "kmerextractor.hpp"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define KMEREXTRACTOR_AVX2
+#endif
+
+using namespace std;
+
+// code of each character: 0-3 for A,C,G,T (upper and lower case), 4 otherwise
+struct BaseTable {
+	unsigned char codes[256];
+	BaseTable() {
+		for (size_t c = 0; c < 256; ++c) codes[c] = 4;
+		codes[(unsigned char) 'A'] = codes[(unsigned char) 'a'] = 0;
+		codes[(unsigned char) 'C'] = codes[(unsigned char) 'c'] = 1;
+		codes[(unsigned char) 'G'] = codes[(unsigned char) 'g'] = 2;
+		codes[(unsigned char) 'T'] = codes[(unsigned char) 't'] = 3;
+	}
+};
+
+static const BaseTable base_table;
+
+static size_t encode_bases_scalar(const char* sequence, size_t length, unsigned char* codes) {
+	size_t invalid = 0;
+	for (size_t i = 0; i < length; ++i) {
+		codes[i] = base_table.codes[(unsigned char) sequence[i]];
+		invalid += (codes[i] >> 2);
+	}
+	return invalid;
+}
+
+#ifdef KMEREXTRACTOR_AVX2
+// A,C,G,T differ in the lower 4 bits of their ASCII codes (1, 3, 7, 4). These select the code and the
+// expected (lower case) character with a byte shuffle, a character is valid if it matches the expected one.
+__attribute__((target("avx2")))
+static size_t encode_bases_avx2(const char* sequence, size_t length, unsigned char* codes) {
+	const __m256i code_table = _mm256_setr_epi8(4, 0, 4, 1, 3, 4, 4, 2, 4, 4, 4, 4, 4, 4, 4, 4,
+	                                            4, 0, 4, 1, 3, 4, 4, 2, 4, 4, 4, 4, 4, 4, 4, 4);
+	const __m256i character_table = _mm256_setr_epi8(0, 'a', 0, 'c', 't', 0, 0, 'g', 0, 0, 0, 0, 0, 0, 0, 0,
+	                                                 0, 'a', 0, 'c', 't', 0, 0, 'g', 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m256i low_bits = _mm256_set1_epi8(0x0F);
+	const __m256i lower_case = _mm256_set1_epi8(0x20);
+	const __m256i invalid_code = _mm256_set1_epi8(4);
+	size_t invalid = 0;
+	size_t i = 0;
+	for (; i + 32 <= length; i += 32) {
+		__m256i characters = _mm256_loadu_si256((const __m256i*) (sequence + i));
+		__m256i index = _mm256_and_si256(characters, low_bits);
+		__m256i expected = _mm256_shuffle_epi8(character_table, index);
+		__m256i valid = _mm256_cmpeq_epi8(_mm256_or_si256(characters, lower_case), expected);
+		__m256i block_codes = _mm256_blendv_epi8(invalid_code, _mm256_shuffle_epi8(code_table, index), valid);
+		_mm256_storeu_si256((__m256i*) (codes + i), block_codes);
+		invalid += __builtin_popcount(~((unsigned int) _mm256_movemask_epi8(valid)));
+	}
+	return invalid + encode_bases_scalar(sequence + i, length - i, codes + i);
+}
+
+static bool cpu_supports_avx2() {
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+}
+
+static const bool use_avx2 = cpu_supports_avx2();
+#else
+static const bool use_avx2 = false;
+#endif
+
+KmerExtractor::KmerExtractor(size_t kmer_size, bool canonical)
+	:kmer_size(kmer_size),
+	 canonical(canonical)
+{
+	if ((kmer_size == 0) || (kmer_size > 32)) {
+		throw runtime_error("KmerExtractor::KmerExtractor: kmer size must be between 1 and 32.");
+	}
+	this->mask = (kmer_size == 32) ? ~0ULL : (1ULL << (2*kmer_size)) - 1;
+	this->shift = 2 * (kmer_size - 1);
+}
+
+size_t KmerExtractor::encode_bases(const char* sequence, size_t length, unsigned char* codes) {
+#ifdef KMEREXTRACTOR_AVX2
+	if (use_avx2) return encode_bases_avx2(sequence, length, codes);
+#endif
+	return encode_bases_scalar(sequence, length, codes);
+}
+
+bool KmerExtractor::is_vectorized() {
+	return use_avx2;
+}
+
+size_t KmerExtractor::extract(const char* sequence, size_t length, vector<uint64_t>& kmers, vector<uint32_t>* positions) {
+	if (length < this->kmer_size) return 0;
+	if (this->codes.size() < length) this->codes.resize(length);
+	const unsigned char* c = this->codes.data();
+	size_t invalid = encode_bases(sequence, length, this->codes.data());
+
+	// members are copied to locals, since stores to kmers could otherwise alias them
+	size_t k = this->kmer_size;
+	uint64_t mask = this->mask;
+	size_t shift = this->shift;
+	bool canonical = this->canonical;
+	size_t nr_before = kmers.size();
+	uint64_t forward = 0;
+	uint64_t reverse = 0;
+	if (invalid == 0) {
+		// all windows are valid
+		kmers.resize(nr_before + length - k + 1);
+		uint64_t* result = kmers.data() + nr_before;
+		for (size_t i = 0; i < k - 1; ++i) {
+			forward = (forward << 2) | c[i];
+			reverse = (reverse >> 2) | (((uint64_t) (3 - c[i])) << shift);
+		}
+		for (size_t i = k - 1; i < length; ++i) {
+			forward = ((forward << 2) | c[i]) & mask;
+			reverse = (reverse >> 2) | (((uint64_t) (3 - c[i])) << shift);
+			result[i + 1 - k] = canonical ? min(forward, reverse) : forward;
+		}
+		if (positions != nullptr) {
+			for (size_t i = 0; i <= length - k; ++i) positions->push_back(i);
+		}
+	} else if (invalid < length) {
+		size_t valid = 0;
+		for (size_t i = 0; i < length; ++i) {
+			if (c[i] > 3) {
+				valid = 0;
+				continue;
+			}
+			forward = ((forward << 2) | c[i]) & mask;
+			reverse = (reverse >> 2) | (((uint64_t) (3 - c[i])) << shift);
+			if (++valid < k) continue;
+			kmers.push_back(canonical ? min(forward, reverse) : forward);
+			if (positions != nullptr) positions->push_back(i + 1 - k);
+		}
+	}
+	return kmers.size() - nr_before;
+}
+
+size_t KmerExtractor::extract(const string& sequence, vector<uint64_t>& kmers, vector<uint32_t>* positions) {
+	return extract(sequence.c_str(), sequence.size(), kmers, positions);
+}
+
+size_t KmerExtractor::get_kmer_size() const {
+	return this->kmer_size;
+}
@@ -0,0 +1,48 @@
+#ifndef KMEREXTRACTOR_HPP
+#define KMEREXTRACTOR_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/**
+* Extracts the 2-bit encoded kmers (k <= 32) of a sequence in bulk. Bases are first encoded block-wise
+* (A=0, C=1, G=2, T=3, case-insensitive, 4 for all other characters), using AVX2 byte shuffles if the CPU
+* supports it and a lookup table otherwise. The kmers are then rolled out of the codes, skipping windows
+* that contain other characters than A,C,G,T. If the sequence contains none (detected from the comparison
+* masks while encoding), no per-base validity checks are needed.
+*
+* The first base of a kmer is stored in the highest bits of its code. Canonical codes are the minimum of
+* the codes of a kmer and its reverse complement.
+* An extractor keeps a buffer for the encoded bases, so every thread needs its own instance.
+**/
+
+class KmerExtractor {
+public:
+	/**
+	* @param kmer_size kmer size (between 1 and 32)
+	* @param canonical if true, the canonical codes of the kmers are extracted, otherwise the codes of the kmers as given
+	**/
+	KmerExtractor(size_t kmer_size, bool canonical = true);
+	/** encodes length bases, returns the number of characters other than A,C,G,T **/
+	static size_t encode_bases(const char* sequence, size_t length, unsigned char* codes);
+	/** true if the AVX2 version of encode_bases is used **/
+	static bool is_vectorized();
+	/**
+	* appends the codes of all kmers consisting of A,C,G,T only to kmers (in the order in which they occur)
+	* @param positions if given, the start positions of the kmers are appended
+	* @returns number of kmers appended
+	**/
+	size_t extract(const char* sequence, size_t length, std::vector<uint64_t>& kmers, std::vector<uint32_t>* positions = nullptr);
+	size_t extract(const std::string& sequence, std::vector<uint64_t>& kmers, std::vector<uint32_t>* positions = nullptr);
+	size_t get_kmer_size() const;
+
+private:
+	size_t kmer_size;
+	bool canonical;
+	uint64_t mask;
+	size_t shift;
+	std::vector<unsigned char> codes;
+};
+
+#endif // KMEREXTRACTOR_HPP
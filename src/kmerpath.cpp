@@ -3,8 +3,8 @@
 
 using namespace std;
 
-KmerPath::KmerPath()
-	:kmers({0})
+KmerPath::KmerPath(Arena* arena)
+	:kmers(1, 0, ArenaAllocator<uint32_t>(arena))
 {}
 
 void KmerPath::set_position(size_t index){
@@ -5,12 +5,14 @@
 #include <stdint.h>
 #include  <string>
 #include <iostream>
+#include "arena.hpp"
 
 /** Represents a sequence of kmers. **/
 
 class KmerPath {
 public:
-	KmerPath();
+	/** @param arena if given, kmers are stored in this arena **/
+	explicit KmerPath(Arena* arena = nullptr);
 	/** indicate presence of kmer at index **/
 	void set_position(size_t index);
 	/** check given position **/
@@ -22,7 +24,7 @@ public:
 
 private:
 	/** use one unsigned int to store the assignments of 32 kmers **/
-	std::vector<uint32_t> kmers;
+	ArenaVector<uint32_t> kmers;
 };
 
 #endif // KMERPATH_HPP
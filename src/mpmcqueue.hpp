@@ -0,0 +1,147 @@
+#ifndef MPMCQUEUE_HPP
+#define MPMCQUEUE_HPP
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+
+/**
+* Bounded lock-free multi-producer multi-consumer queue.
+* Based on Dmitry Vyukov's bounded MPMC queue: http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+* push and pop first try the lock-free operation and otherwise block on a condition variable. Every successful
+* push and pop briefly takes a mutex to wake up waiting threads, so the queue is meant for coarse items (e.g. batches).
+**/
+
+template <typename T>
+class MPMCQueue {
+public:
+	/** capacity is rounded up to a power of two **/
+	MPMCQueue(size_t capacity);
+	/** returns false if the queue is full **/
+	bool try_push(T value);
+	/** returns false if the queue is empty **/
+	bool try_pop(T& value);
+	/** waits until there is space in the queue **/
+	void push(T value);
+	/** waits until an element is available. Returns false if the queue was closed and is empty. **/
+	bool pop(T& value);
+	/** no more elements will be pushed, wakes up all threads waiting in pop **/
+	void close();
+
+private:
+	struct Cell {
+		std::atomic<size_t> sequence;
+		T value;
+	};
+	std::unique_ptr<Cell[]> cells;
+	size_t mask;
+	std::mutex mutex;
+	std::condition_variable not_empty;
+	std::condition_variable not_full;
+	bool closed;
+	/** wake up a thread waiting on the given condition. Taking the mutex makes sure a thread that has just
+	* found the queue empty (or full) is already waiting and does not miss the notification. **/
+	void notify(std::condition_variable& condition);
+	// positions are accessed by producers and consumers respectively, keep them on separate cache lines
+	alignas(64) std::atomic<size_t> enqueue_position;
+	alignas(64) std::atomic<size_t> dequeue_position;
+};
+
+template <typename T>
+MPMCQueue<T>::MPMCQueue(size_t capacity)
+	:closed(false),
+	 enqueue_position(0),
+	 dequeue_position(0)
+{
+	size_t size = 2;
+	while (size < capacity) size <<= 1;
+	this->cells.reset(new Cell[size]);
+	this->mask = size - 1;
+	for (size_t i = 0; i < size; ++i) {
+		this->cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+}
+
+template <typename T>
+bool MPMCQueue<T>::try_push(T value) {
+	size_t position = this->enqueue_position.load(std::memory_order_relaxed);
+	for (;;) {
+		Cell* cell = &this->cells[position & this->mask];
+		size_t sequence = cell->sequence.load(std::memory_order_acquire);
+		std::ptrdiff_t difference = (std::ptrdiff_t) sequence - (std::ptrdiff_t) position;
+		if (difference == 0) {
+			if (this->enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+				cell->value = value;
+				cell->sequence.store(position + 1, std::memory_order_release);
+				return true;
+			}
+		} else if (difference < 0) {
+			return false;
+		} else {
+			position = this->enqueue_position.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+template <typename T>
+bool MPMCQueue<T>::try_pop(T& value) {
+	size_t position = this->dequeue_position.load(std::memory_order_relaxed);
+	for (;;) {
+		Cell* cell = &this->cells[position & this->mask];
+		size_t sequence = cell->sequence.load(std::memory_order_acquire);
+		std::ptrdiff_t difference = (std::ptrdiff_t) sequence - (std::ptrdiff_t) (position + 1);
+		if (difference == 0) {
+			if (this->dequeue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+				value = cell->value;
+				cell->sequence.store(position + this->mask + 1, std::memory_order_release);
+				return true;
+			}
+		} else if (difference < 0) {
+			return false;
+		} else {
+			position = this->dequeue_position.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+template <typename T>
+void MPMCQueue<T>::notify(std::condition_variable& condition) {
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+	}
+	condition.notify_one();
+}
+
+template <typename T>
+void MPMCQueue<T>::push(T value) {
+	if (!try_push(value)) {
+		std::unique_lock<std::mutex> lock(this->mutex);
+		this->not_full.wait(lock, [&] { return try_push(value); });
+	}
+	notify(this->not_empty);
+}
+
+template <typename T>
+bool MPMCQueue<T>::pop(T& value) {
+	if (!try_pop(value)) {
+		bool popped = false;
+		std::unique_lock<std::mutex> lock(this->mutex);
+		this->not_empty.wait(lock, [&] { popped = try_pop(value); return popped || this->closed; });
+		if (!popped) return false;
+	}
+	notify(this->not_full);
+	return true;
+}
+
+template <typename T>
+void MPMCQueue<T>::close() {
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->closed = true;
+	}
+	this->not_empty.notify_all();
+}
+
+#endif // MPMCQUEUE_HPP
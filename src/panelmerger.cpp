@@ -0,0 +1,354 @@
+#include <sstream>
+#include <iostream>
+#include <fstream>
+#include <functional>
+#include <algorithm>
+#include <stdexcept>
+#include <map>
+#include <set>
+#include "panelmerger.hpp"
+#include "threadpool.hpp"
+#include "variantreader.hpp"
+
+using namespace std;
+
+static bool is_proper_sequence(const string& sequence) {
+	for (auto c : sequence) {
+		if ((c != 'A') && (c != 'C') && (c != 'G') && (c != 'T') && (c != 'a') && (c != 'c') && (c != 'g') && (c != 't')) return false;
+	}
+	return true;
+}
+
+PanelMerger::PanelMerger(string reference_filename, size_t ploidy, size_t records_per_block)
+	:fasta_reader(reference_filename),
+	 ploidy(ploidy),
+	 records_per_block(max(records_per_block, (size_t) 1)),
+	 nr_input(0),
+	 nr_written(0)
+{
+	if (ploidy == 0) {
+		throw runtime_error("PanelMerger::PanelMerger: ploidy must be at least 1.");
+	}
+}
+
+void PanelMerger::merge(string vcf_filename, string outfile_name, size_t nr_threads, const vector<string>& chromosomes) {
+	if (vcf_filename.size() > 3 && vcf_filename.substr(vcf_filename.size()-3,3).compare(".gz") == 0) {
+		throw runtime_error("PanelMerger::merge: Uncompressed VCF-file is required.");
+	}
+	ifstream file(vcf_filename);
+	if (!file.good()) {
+		throw runtime_error("PanelMerger::merge: input VCF file cannot be opened.");
+	}
+	ofstream outfile(outfile_name);
+	if (!outfile.good()) {
+		throw runtime_error("PanelMerger::merge: output file " + outfile_name + " cannot be opened.");
+	}
+	if (nr_threads == 0) nr_threads = 1;
+	set<string> selected(chromosomes.begin(), chromosomes.end());
+	this->nr_input = 0;
+	this->nr_written = 0;
+	bool header_seen = false;
+
+	// blocks of records currently read. Each block consists of complete clusters of overlapping records
+	// (at least records_per_block records, unless a chromosome ends). Once nr_threads blocks are complete,
+	// they are merged in parallel and written in input order before reading further.
+	vector< vector<string> > batch;
+	vector<string> batch_results;
+	vector<size_t> batch_input;
+	vector<size_t> batch_written;
+	auto process_batch = [&] () {
+		batch_results.assign(batch.size(), "");
+		batch_input.assign(batch.size(), 0);
+		batch_written.assign(batch.size(), 0);
+		{
+			ThreadPool threadPool (min(nr_threads, batch.size()));
+			for (size_t i = 0; i < batch.size(); ++i) {
+				function<void()> f_merge = bind(&PanelMerger::merge_chromosome, this, cref(batch[i]), ref(batch_results[i]), ref(batch_input[i]), ref(batch_written[i]));
+				threadPool.submit(f_merge);
+			}
+		}
+		for (size_t i = 0; i < batch.size(); ++i) {
+			outfile << batch_results[i];
+			this->nr_input += batch_input[i];
+			this->nr_written += batch_written[i];
+		}
+		batch.clear();
+	};
+
+	string line;
+	string previous_chrom("");
+	size_t previous_end = 0;
+	while (getline(file, line)) {
+		if (line.size() == 0) continue;
+		if (line.substr(0,2) == "##") continue;
+		if (line[0] == '#') {
+			vector<string> tokens;
+			parse_line(tokens, line, '\t');
+			if (header_seen || (tokens.size() < 9)) {
+				throw runtime_error("PanelMerger::merge: not a proper VCF-file.");
+			}
+			if (tokens.size() < 10) {
+				throw runtime_error("PanelMerger::merge: VCF-file does not contain any samples.");
+			}
+			outfile << "##fileformat=VCFv4.2" << endl;
+			outfile << "##INFO=<ID=ID,Number=A,Type=String,Description=\"Variant IDs per ALT allele.\">" << endl;
+			outfile << "##FORMAT=<ID=GT,Number=1,Type=String,Description=\"Genotype\">" << endl;
+			outfile << "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT";
+			for (size_t i = 9; i < tokens.size(); ++i) {
+				outfile << "\t" << tokens[i];
+			}
+			outfile << endl;
+			header_seen = true;
+			continue;
+		}
+		if (!header_seen) {
+			throw runtime_error("PanelMerger::merge: VCF header line is missing.");
+		}
+		string chromosome = line.substr(0, line.find('\t'));
+		if (!selected.empty() && (selected.find(chromosome) == selected.end())) continue;
+		// determine start and end of the record (POS and length of REF)
+		vector<string> tokens;
+		istringstream iss (line);
+		string token;
+		while ((tokens.size() < 4) && getline(iss, token, '\t')) tokens.push_back(token);
+		if (tokens.size() < 4) {
+			throw runtime_error("PanelMerger::merge: malformed VCF record: " + line);
+		}
+		size_t start = stoi(tokens[1]);
+		size_t end = start + tokens[3].size();
+		bool same_chromosome = !batch.empty() && (chromosome == previous_chrom);
+		// start a new block between two clusters, once the current one is large enough or the chromosome changes
+		if (batch.empty() || !same_chromosome || ((start >= previous_end) && (batch.back().size() >= this->records_per_block))) {
+			if (batch.size() == nr_threads) process_batch();
+			batch.push_back(vector<string>());
+			previous_chrom = chromosome;
+		}
+		batch.back().push_back(line);
+		previous_end = same_chromosome ? max(end, previous_end) : end;
+	}
+	if (!batch.empty()) process_batch();
+	if (!header_seen) {
+		throw runtime_error("PanelMerger::merge: VCF header line is missing.");
+	}
+}
+
+void PanelMerger::merge_chromosome(const vector<string>& records, string& result, size_t& input_alleles, size_t& written_alleles) const {
+	PanelCluster cluster;
+	size_t previous_end = 0;
+	for (auto& line : records) {
+		vector<string> tokens;
+		parse_line(tokens, line, '\t');
+		if (tokens.size() < 10) {
+			throw runtime_error("PanelMerger::merge_chromosome: malformed VCF record: " + line);
+		}
+		size_t start = stoi(tokens[1]);
+		size_t end = start + tokens[3].size();
+		bool same_chromosome = !cluster.alleles.empty() && (tokens[0] == cluster.chromosome);
+		if (!cluster.alleles.empty() && ((start >= previous_end) || !same_chromosome)) {
+			// record does not overlap the current cluster
+			this->merge_cluster(cluster, result, written_alleles);
+			cluster = PanelCluster();
+		}
+		input_alleles += this->parse_record(tokens, cluster);
+		previous_end = same_chromosome ? max(end, previous_end) : end;
+	}
+	if (!cluster.alleles.empty()) this->merge_cluster(cluster, result, written_alleles);
+}
+
+size_t PanelMerger::parse_record(const vector<string>& tokens, PanelCluster& cluster) const {
+	// variant IDs are given in INFO field ID
+	vector<string> ids;
+	vector<string> info_fields;
+	parse_line(info_fields, tokens[7], ';');
+	bool has_ids = false;
+	for (auto& info : info_fields) {
+		if (info.substr(0,3) == "ID=") {
+			parse_line(ids, info.substr(3), ',');
+			has_ids = true;
+		}
+	}
+	vector<string> alt_alleles;
+	parse_line(alt_alleles, tokens[4], ',');
+	if (!has_ids || (ids.size() != alt_alleles.size())) {
+		throw runtime_error("PanelMerger::parse_record: an ID needs to be provided for each ALT allele in INFO field ID (" + tokens[0] + ":" + tokens[1] + ").");
+	}
+
+	size_t start = stoi(tokens[1]);
+	size_t end = start + tokens[3].size();
+	if (cluster.alleles.empty()) {
+		cluster.chromosome = tokens[0];
+		cluster.start = start;
+		cluster.end = end;
+	}
+	cluster.start = min(cluster.start, start);
+	cluster.end = max(cluster.end, end);
+	cluster.alleles.push_back(vector<PanelAllele>());
+	set<string> distinct_ids;
+	for (size_t i = 0; i < alt_alleles.size(); ++i) {
+		cluster.alleles.back().push_back({alt_alleles[i], start, end, ids[i]});
+		distinct_ids.insert(ids[i]);
+	}
+
+	// genotype alleles of each sample
+	vector<string> format_fields;
+	parse_line(format_fields, tokens[8], ':');
+	auto gt_field = find(format_fields.begin(), format_fields.end(), "GT");
+	if (gt_field == format_fields.end()) {
+		throw runtime_error("PanelMerger::parse_record: genotype information missing from VCF file.");
+	}
+	size_t gt_index = gt_field - format_fields.begin();
+	size_t column = 0;
+	for (size_t i = 9; i < tokens.size(); ++i) {
+		vector<string> sample_fields;
+		parse_line(sample_fields, tokens[i], ':');
+		if (gt_index >= sample_fields.size()) {
+			throw runtime_error("PanelMerger::parse_record: genotype missing for sample column " + to_string(i-8) + " (" + tokens[0] + ":" + tokens[1] + ").");
+		}
+		string genotype = sample_fields[gt_index];
+		if (genotype.find('/') != string::npos) {
+			throw runtime_error("PanelMerger::parse_record: unphased genotype at " + tokens[0] + ":" + tokens[1] + ".");
+		}
+		vector<string> alleles;
+		parse_line(alleles, genotype, '|');
+		for (auto& allele : alleles) {
+			if (cluster.haplotypes.size() <= column) cluster.haplotypes.push_back(vector<int>());
+			cluster.haplotypes[column].push_back((allele == ".") ? -1 : stoi(allele));
+			column += 1;
+		}
+	}
+	return distinct_ids.size();
+}
+
+void PanelMerger::merge_cluster(const PanelCluster& cluster, string& result, size_t& written_alleles) const {
+	// reference sequence of this variant cluster
+	string ref_allele;
+	this->fasta_reader.get_subsequence(cluster.chromosome, cluster.start-1, cluster.end-1, ref_allele);
+
+	// distinct haplotypes in order of first appearance and the columns carrying them
+	vector< vector<int> > haplotypes;
+	vector< vector<size_t> > hap_to_columns;
+	map< vector<int>, size_t > hap_to_index;
+	for (size_t column = 0; column < cluster.haplotypes.size(); ++column) {
+		auto it = hap_to_index.find(cluster.haplotypes[column]);
+		if (it == hap_to_index.end()) {
+			hap_to_index[cluster.haplotypes[column]] = haplotypes.size();
+			haplotypes.push_back(cluster.haplotypes[column]);
+			hap_to_columns.push_back({column});
+		} else {
+			hap_to_columns[it->second].push_back(column);
+		}
+	}
+
+	// construct the haplotype sequences covered by the samples in this region
+	vector<bool> hap_defined(haplotypes.size(), false);
+	vector<string> hap_sequences(haplotypes.size());
+	vector<string> hap_ids(haplotypes.size());
+	for (size_t h = 0; h < haplotypes.size(); ++h) {
+		if (find(haplotypes[h].begin(), haplotypes[h].end(), -1) != haplotypes[h].end()) continue;
+		bool undefined_allele = false;
+		string sequence = ref_allele;
+		long long offset = cluster.start;
+		size_t previous_end = 0;
+		for (size_t row = 0; row < haplotypes[h].size(); ++row) {
+			int allele = haplotypes[h][row];
+			if (allele == 0) continue;
+			if ((row >= cluster.alleles.size()) || ((size_t) allele > cluster.alleles[row].size())) {
+				throw runtime_error("PanelMerger::merge_cluster: genotype refers to an undefined allele at " + cluster.chromosome + ":" + to_string(cluster.start) + ".");
+			}
+			const PanelAllele& alt = cluster.alleles[row][allele-1];
+			if (previous_end > alt.start) {
+				cerr << "Two overlapping variants at same haplotype at " + cluster.chromosome + ":" + to_string(cluster.start) + ", set allele to missing.\n";
+				undefined_allele = true;
+				break;
+			}
+			// insert the allele into the haplotype sequence
+			long long start = alt.start - offset;
+			long long end = alt.end - offset;
+			string included = sequence.substr(0, start) + alt.sequence + sequence.substr(end);
+			offset -= (long long) included.size() - (long long) sequence.size();
+			sequence = included;
+			if (!hap_ids[h].empty()) hap_ids[h] += ":";
+			hap_ids[h] += alt.id;
+			previous_end = alt.end;
+		}
+		if (!undefined_allele) {
+			hap_defined[h] = true;
+			hap_sequences[h] = sequence;
+		}
+	}
+
+	// determine ALT alleles and the genotype of each column
+	vector<int> genotypes(cluster.haplotypes.size(), -1);
+	vector<string> alt_alleles;
+	vector<string> ids;
+	map<string, int> sequence_to_allele;
+	set<string> written_ids;
+	for (size_t h = 0; h < haplotypes.size(); ++h) {
+		if (!hap_defined[h]) continue;
+		int allele = 0;
+		bool is_reference = all_of(haplotypes[h].begin(), haplotypes[h].end(), [](int a) { return a == 0; });
+		if (!is_reference) {
+			auto it = sequence_to_allele.find(hap_sequences[h]);
+			if (it != sequence_to_allele.end()) {
+				allele = it->second;
+				if (find(ids.begin(), ids.end(), hap_ids[h]) == ids.end()) {
+					cerr << "Different allele combinations lead to same sequence at " + cluster.chromosome + ":" + to_string(cluster.start) + ".\n";
+				}
+			} else {
+				alt_alleles.push_back(hap_sequences[h]);
+				ids.push_back(hap_ids[h]);
+				allele = alt_alleles.size();
+				sequence_to_allele[hap_sequences[h]] = allele;
+				vector<string> allele_ids;
+				parse_line(allele_ids, hap_ids[h], ':');
+				written_ids.insert(allele_ids.begin(), allele_ids.end());
+			}
+		}
+		for (auto column : hap_to_columns[h]) {
+			genotypes[column] = allele;
+		}
+	}
+
+	// no ALT alleles left (e.g. because all haplotypes contained missing alleles)
+	if (alt_alleles.empty()) return;
+	// skip records with undefined bases
+	if (!is_proper_sequence(ref_allele)) return;
+	for (auto& alt : alt_alleles) {
+		if (!is_proper_sequence(alt)) return;
+	}
+	if (genotypes.size() % this->ploidy != 0) {
+		throw runtime_error("PanelMerger::merge_cluster: number of haplotypes at " + cluster.chromosome + ":" + to_string(cluster.start) + " is not a multiple of the ploidy.");
+	}
+
+	ostringstream oss;
+	oss << cluster.chromosome << "\t" << cluster.start << "\t.\t" << ref_allele << "\t";
+	for (size_t i = 0; i < alt_alleles.size(); ++i) {
+		if (i > 0) oss << ",";
+		oss << alt_alleles[i];
+	}
+	oss << "\t.\tPASS\tID=";
+	for (size_t i = 0; i < ids.size(); ++i) {
+		if (i > 0) oss << ",";
+		oss << ids[i];
+	}
+	oss << "\tGT";
+	for (size_t i = 0; i < genotypes.size(); ++i) {
+		oss << ((i % this->ploidy == 0) ? "\t" : "|");
+		if (genotypes[i] < 0) {
+			oss << ".";
+		} else {
+			oss << genotypes[i];
+		}
+	}
+	oss << "\n";
+	result += oss.str();
+	written_alleles += written_ids.size();
+}
+
+size_t PanelMerger::nr_input_alleles() const {
+	return this->nr_input;
+}
+
+size_t PanelMerger::nr_written_alleles() const {
+	return this->nr_written;
+}
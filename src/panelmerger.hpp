@@ -0,0 +1,65 @@
+#ifndef PANELMERGER_HPP
+#define PANELMERGER_HPP
+
+#include <string>
+#include <vector>
+#include "fastareader.hpp"
+
+/** ALT allele of a biallelic input record **/
+struct PanelAllele {
+	std::string sequence;
+	size_t start;
+	size_t end;
+	std::string id;
+};
+
+/** biallelic records overlapping each other, which are merged into a single multi-allelic record **/
+struct PanelCluster {
+	std::string chromosome;
+	size_t start;
+	size_t end;
+	// ALT alleles of each record
+	std::vector< std::vector<PanelAllele> > alleles;
+	// allele of each record, per haplotype column (-1 if missing)
+	std::vector< std::vector<int> > haplotypes;
+};
+
+/**
+* Merges overlapping variants of a phased, biallelic multi-sample VCF (variant IDs given in INFO field ID)
+* into non-overlapping, multi-allelic records as expected by PanGenie. Each distinct haplotype sequence
+* of a cluster of overlapping variants becomes one ALT allele, annotated by the IDs of the variants
+* it is composed of (separated by ':').
+**/
+
+class PanelMerger {
+public:
+	/**
+	* @param reference_filename reference genome in FASTA format
+	* @param ploidy ploidy of the samples
+	* @param records_per_block number of records after which merge starts a new block at the next cluster boundary
+	**/
+	PanelMerger(std::string reference_filename, size_t ploidy, size_t records_per_block = 10000);
+	/** merge all records of the given VCF and write the resulting panel VCF to outfile_name. Records are read in
+	* blocks of about records_per_block records consisting of complete clusters of overlapping records.
+	* @param nr_threads number of blocks merged in parallel. About nr_threads * records_per_block records are kept in memory.
+	* @param chromosomes only output variants on these chromosomes (all chromosomes if empty).
+	**/
+	void merge(std::string vcf_filename, std::string outfile_name, size_t nr_threads = 1, const std::vector<std::string>& chromosomes = std::vector<std::string>());
+	/** merge (sorted, biallelic) VCF records consisting of complete clusters and append the merged records to result. **/
+	void merge_chromosome(const std::vector<std::string>& records, std::string& result, size_t& input_alleles, size_t& written_alleles) const;
+	/** number of variant IDs read from the input VCF by the last call to merge **/
+	size_t nr_input_alleles() const;
+	/** number of variant IDs written to the panel VCF by the last call to merge **/
+	size_t nr_written_alleles() const;
+
+private:
+	FastaReader fasta_reader;
+	size_t ploidy;
+	size_t records_per_block;
+	size_t nr_input;
+	size_t nr_written;
+	size_t parse_record(const std::vector<std::string>& tokens, PanelCluster& cluster) const;
+	void merge_cluster(const PanelCluster& cluster, std::string& result, size_t& written_alleles) const;
+};
+
+#endif // PANELMERGER_HPP
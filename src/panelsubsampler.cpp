@@ -0,0 +1,216 @@
+#include <iostream>
+#include <sstream>
+#include <functional>
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include "panelsubsampler.hpp"
+#include "threadpool.hpp"
+
+using namespace std;
+
+// number of records read before they are written to the sub-panels
+static const size_t batch_size = 20000;
+
+PanelSubsampler::PanelSubsampler(vector<string> samples, size_t nr_samples, string outfile_prefix, unsigned int seed)
+	:samples(samples),
+	 nr_samples(nr_samples),
+	 outfile_prefix(outfile_prefix),
+	 seed(seed)
+{
+	if (samples.empty()) {
+		throw runtime_error("PanelSubsampler::PanelSubsampler: no samples given.");
+	}
+	vector<string> sorted_samples = samples;
+	sort(sorted_samples.begin(), sorted_samples.end());
+	if (adjacent_find(sorted_samples.begin(), sorted_samples.end()) != sorted_samples.end()) {
+		throw runtime_error("PanelSubsampler::PanelSubsampler: samples must be unique.");
+	}
+}
+
+PanelSubsampler::~PanelSubsampler() {
+	this->close_files();
+}
+
+void PanelSubsampler::close_files() {
+	for (auto& subpanel : this->subpanels) {
+		if (subpanel.panel_file != nullptr) delete subpanel.panel_file;
+		if (subpanel.truth_file != nullptr) delete subpanel.truth_file;
+		subpanel.panel_file = nullptr;
+		subpanel.truth_file = nullptr;
+	}
+}
+
+void PanelSubsampler::select_samples(const vector<string>& header_fields) {
+	this->header_samples.assign(header_fields.begin() + 9, header_fields.end());
+	mt19937 generator (this->seed);
+	for (auto& subpanel : this->subpanels) {
+		vector<size_t> candidates;
+		subpanel.truth_column = 0;
+		for (size_t i = 9; i < header_fields.size(); ++i) {
+			if (header_fields[i] == subpanel.sample) {
+				subpanel.truth_column = i;
+			} else {
+				candidates.push_back(i);
+			}
+		}
+		size_t nr_selected = (this->nr_samples == 0) ? candidates.size() : this->nr_samples;
+		if (candidates.size() < nr_selected) {
+			throw runtime_error("PanelSubsampler::select_samples: not enough samples given to select " + to_string(nr_selected) + " samples for sub-panel of " + subpanel.sample + ".");
+		}
+		shuffle(candidates.begin(), candidates.end(), generator);
+		subpanel.columns.assign(candidates.begin(), candidates.begin() + nr_selected);
+		sort(subpanel.columns.begin(), subpanel.columns.end());
+		if (subpanel.truth_column == 0) {
+			cerr << "Warning: sample " << subpanel.sample << " is not contained in the input panel, no truth set is written." << endl;
+		}
+	}
+}
+
+void PanelSubsampler::subsample(string vcf_filename, size_t nr_threads) {
+	ifstream file(vcf_filename);
+	if (!file.good()) {
+		throw runtime_error("PanelSubsampler::subsample: input VCF file cannot be opened.");
+	}
+	this->close_files();
+	this->subpanels.clear();
+	for (auto& sample : this->samples) {
+		string name = this->outfile_prefix + "_" + sample;
+		SubPanel subpanel = {sample, {}, 0, new ofstream(name + "_panel.vcf"), new ofstream(name + "_truth.vcf"), 0, 0};
+		this->subpanels.push_back(subpanel);
+		if (!subpanel.panel_file->good() || !subpanel.truth_file->good()) {
+			throw runtime_error("PanelSubsampler::subsample: output files " + name + "_panel.vcf/_truth.vcf cannot be opened.");
+		}
+	}
+	if (nr_threads == 0) nr_threads = 1;
+
+	bool header_seen = false;
+	vector<string> lines;
+	vector< vector<size_t> > field_starts;
+	auto write_batch = [&] () {
+		{
+			ThreadPool threadPool (min(nr_threads, this->subpanels.size()));
+			for (size_t i = 0; i < this->subpanels.size(); ++i) {
+				function<void()> f_write = bind(&PanelSubsampler::write_records, this, i, &lines, &field_starts);
+				threadPool.submit(f_write);
+			}
+		}
+		lines.clear();
+		field_starts.clear();
+	};
+
+	string line;
+	while (getline(file, line)) {
+		if (line.size() == 0) continue;
+		if (line.substr(0,2) == "##") {
+			for (auto& subpanel : this->subpanels) {
+				*subpanel.panel_file << line << '\n';
+				*subpanel.truth_file << line << '\n';
+			}
+			continue;
+		}
+		if (line[0] == '#') {
+			if (header_seen) {
+				throw runtime_error("PanelSubsampler::subsample: malformatted input VCF file.");
+			}
+			vector<string> fields;
+			string field;
+			istringstream iss (line);
+			while (getline(iss, field, '\t')) fields.push_back(field);
+			if (fields.size() < 10) {
+				throw runtime_error("PanelSubsampler::subsample: input VCF file does not contain any samples.");
+			}
+			this->select_samples(fields);
+			string columns = fields[0];
+			for (size_t i = 1; i < 9; ++i) columns += "\t" + fields[i];
+			for (auto& subpanel : this->subpanels) {
+				*subpanel.panel_file << columns;
+				for (auto column : subpanel.columns) {
+					*subpanel.panel_file << '\t' << fields[column];
+				}
+				*subpanel.panel_file << '\n';
+				*subpanel.truth_file << columns << '\t' << subpanel.sample << '\n';
+			}
+			header_seen = true;
+			continue;
+		}
+		if (!header_seen) {
+			throw runtime_error("PanelSubsampler::subsample: malformatted input VCF file.");
+		}
+		// determine where fields start, sub-panels are written from slices of the line
+		vector<size_t> starts = {0};
+		for (size_t i = 0; i < line.size(); ++i) {
+			if (line[i] == '\t') starts.push_back(i+1);
+		}
+		starts.push_back(line.size() + 1);
+		if (starts.size() != this->header_samples.size() + 10) {
+			throw runtime_error("PanelSubsampler::subsample: number of fields does not match the header line: " + line.substr(0, starts[min(starts.size()-1, (size_t) 2)]));
+		}
+		lines.push_back(line);
+		field_starts.push_back(starts);
+		if (lines.size() == batch_size) write_batch();
+	}
+	if (!lines.empty()) write_batch();
+	if (!header_seen) {
+		throw runtime_error("PanelSubsampler::subsample: malformatted input VCF file.");
+	}
+	this->close_files();
+	for (auto& subpanel : this->subpanels) {
+		cerr << "Sub-panel of " << subpanel.sample << ": wrote " << subpanel.nr_written << " records, skipped " << subpanel.nr_skipped << " records since no alternative alleles are present in selected samples." << endl;
+	}
+}
+
+void PanelSubsampler::write_records(size_t subpanel_index, const vector<string>* lines, const vector< vector<size_t> >* field_starts) {
+	SubPanel& subpanel = this->subpanels.at(subpanel_index);
+	for (size_t l = 0; l < lines->size(); ++l) {
+		const string& line = lines->at(l);
+		const vector<size_t>& starts = field_starts->at(l);
+		// skip records not carrying any alternative allele in the selected samples
+		bool all_reference = true;
+		for (auto column : subpanel.columns) {
+			if (line.compare(starts[column], starts[column+1] - starts[column] - 1, "0|0") != 0) {
+				all_reference = false;
+				break;
+			}
+		}
+		if (all_reference) {
+			subpanel.nr_skipped += 1;
+			continue;
+		}
+		subpanel.nr_written += 1;
+		// first 9 fields (CHROM - FORMAT)
+		subpanel.panel_file->write(line.data(), starts[9] - 1);
+		for (auto column : subpanel.columns) {
+			subpanel.panel_file->put('\t');
+			subpanel.panel_file->write(line.data() + starts[column], starts[column+1] - starts[column] - 1);
+		}
+		subpanel.panel_file->put('\n');
+		if (subpanel.truth_column > 0) {
+			subpanel.truth_file->write(line.data(), starts[9] - 1);
+			subpanel.truth_file->put('\t');
+			subpanel.truth_file->write(line.data() + starts[subpanel.truth_column], starts[subpanel.truth_column+1] - starts[subpanel.truth_column] - 1);
+			subpanel.truth_file->put('\n');
+		}
+	}
+}
+
+const SubPanel& PanelSubsampler::get_subpanel(const string& sample) const {
+	for (auto& subpanel : this->subpanels) {
+		if (subpanel.sample == sample) return subpanel;
+	}
+	throw runtime_error("PanelSubsampler::get_subpanel: no sub-panel for sample " + sample + ".");
+}
+
+void PanelSubsampler::get_selected_samples(const string& sample, vector<string>& result) const {
+	for (auto column : this->get_subpanel(sample).columns) {
+		result.push_back(this->header_samples.at(column - 9));
+	}
+}
+
+size_t PanelSubsampler::nr_written_records(const string& sample) const {
+	return this->get_subpanel(sample).nr_written;
+}
+
+size_t PanelSubsampler::nr_skipped_records(const string& sample) const {
+	return this->get_subpanel(sample).nr_skipped;
+}
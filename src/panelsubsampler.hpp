@@ -0,0 +1,60 @@
+#ifndef PANELSUBSAMPLER_HPP
+#define PANELSUBSAMPLER_HPP
+
+#include <string>
+#include <vector>
+#include <fstream>
+
+/** a sub-panel leaving out one sample, whose genotypes are written as ground truth **/
+struct SubPanel {
+	std::string sample;
+	// columns of the selected panel samples (sorted)
+	std::vector<size_t> columns;
+	// column of the left out sample (0 if it is not contained in the input VCF)
+	size_t truth_column;
+	std::ofstream* panel_file;
+	std::ofstream* truth_file;
+	size_t nr_written;
+	size_t nr_skipped;
+};
+
+/**
+* Creates sub-panels of a multi-sample panel VCF for leave-one-out experiments in a single pass over the input.
+* For each left out sample, a given number of the remaining samples is selected at random and
+* <prefix>_<sample>_panel.vcf (selected samples only) and <prefix>_<sample>_truth.vcf (genotypes of the left out
+* sample) are written. Records not carrying any alternative allele in the selected samples are skipped in both files.
+**/
+
+class PanelSubsampler {
+public:
+	/**
+	* @param samples samples to leave out, one sub-panel is generated for each of them
+	* @param nr_samples number of samples to select for each sub-panel (0: all remaining samples)
+	* @param outfile_prefix prefix of the output files
+	* @param seed seed used to select samples
+	**/
+	PanelSubsampler(std::vector<std::string> samples, size_t nr_samples, std::string outfile_prefix, unsigned int seed = 0);
+	~PanelSubsampler();
+	/** read the panel VCF once and write all sub-panels, using nr_threads threads to write them **/
+	void subsample(std::string vcf_filename, size_t nr_threads = 1);
+	/** get the samples selected for the sub-panel of the given left out sample **/
+	void get_selected_samples(const std::string& sample, std::vector<std::string>& result) const;
+	/** number of records written to / skipped for the sub-panel of the given left out sample **/
+	size_t nr_written_records(const std::string& sample) const;
+	size_t nr_skipped_records(const std::string& sample) const;
+
+private:
+	std::vector<std::string> samples;
+	size_t nr_samples;
+	std::string outfile_prefix;
+	unsigned int seed;
+	std::vector<std::string> header_samples;
+	std::vector<SubPanel> subpanels;
+	void select_samples(const std::vector<std::string>& header_fields);
+	const SubPanel& get_subpanel(const std::string& sample) const;
+	void close_files();
+	/** write a batch of records to the files of the given sub-panel. field_starts holds the start of each field of a line (and its size+1). **/
+	void write_records(size_t subpanel_index, const std::vector<std::string>* lines, const std::vector< std::vector<size_t> >* field_starts);
+};
+
+#endif // PANELSUBSAMPLER_HPP
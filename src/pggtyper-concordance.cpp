@@ -0,0 +1,121 @@
+#include <iostream>
+#include <sstream>
+#include <sys/resource.h>
+#include <algorithm>
+#include "genotypeconcordance.hpp"
+#include "commandlineparser.hpp"
+#include "timer.hpp"
+
+
+using namespace std;
+
+template<class T>
+void parse_list(string argument, vector<T>& result) {
+	string token;
+	istringstream iss (argument);
+	while (getline(iss, token, ',')) {
+		if (token.empty()) continue;
+		istringstream value (token);
+		T v;
+		value >> v;
+		result.push_back(v);
+	}
+}
+
+int main (int argc, char* argv[])
+{
+	Timer timer;
+	double time_total;
+
+	cerr << endl;
+	cerr << "program: PanGenie-concordance - compute genotype concordance between a baseline and a callset VCF." << endl;
+	cerr << "author: Jana Ebler" << endl << endl;
+
+	string baseline = "";
+	string callset = "";
+	string outname = "result";
+	vector<string> samples;
+	vector<int> quality_thresholds;
+	vector<double> allele_frequency_thresholds;
+	vector<int> unique_kmer_thresholds;
+	vector<int> missing_thresholds;
+	bool use_qual = false;
+	bool types_by_length = false;
+	size_t nr_threads = 1;
+
+	// parse the command line arguments
+	CommandLineParser argument_parser;
+	argument_parser.add_command("PanGenie-concordance [options]  -b <baseline.vcf> -c <callset.vcf> -s <sample1,sample2,...>");
+	argument_parser.add_mandatory_argument('b', "baseline VCF (ground truth)");
+	argument_parser.add_mandatory_argument('c', "callset VCF (genotyped variants)");
+	argument_parser.add_mandatory_argument('s', "comma separated list of samples to evaluate");
+	argument_parser.add_optional_argument('o', "result", "prefix of the output files (<prefix>_<sample>_<variant type>.tsv/.txt)");
+	argument_parser.add_optional_argument('q', "0", "comma separated list of GQ-thresholds to consider");
+	argument_parser.add_optional_argument('a', "0", "comma separated list of allele frequency thresholds to consider");
+	argument_parser.add_optional_argument('u', "0", "comma separated list of unique kmer count thresholds to consider (INFO field AK)");
+	argument_parser.add_optional_argument('m', "0", "comma separated list of missing allele count thresholds to consider (INFO field MA)");
+	argument_parser.add_optional_argument('t', "1", "number of threads (chromosomes evaluated in parallel)");
+	argument_parser.add_flag_argument('Q', "use qualities in QUAL field instead of GQ fields.");
+	argument_parser.add_flag_argument('l', "determine variant types from allele lengths only: MNVs and multi-allelic records mixing insertions and deletions are complex (default: classify as genotype-concordance.py, which counts them as insertions).");
+
+	try {
+		argument_parser.parse(argc, argv);
+	} catch (const runtime_error& e) {
+		argument_parser.usage();
+		cerr << e.what() << endl;
+		return 1;
+	} catch (const exception& e) {
+		return 0;
+	}
+
+	baseline = argument_parser.get_argument('b');
+	callset = argument_parser.get_argument('c');
+	outname = argument_parser.get_argument('o');
+	parse_list(argument_parser.get_argument('s'), samples);
+	parse_list(argument_parser.get_argument('q'), quality_thresholds);
+	parse_list(argument_parser.get_argument('a'), allele_frequency_thresholds);
+	parse_list(argument_parser.get_argument('u'), unique_kmer_thresholds);
+	parse_list(argument_parser.get_argument('m'), missing_thresholds);
+	nr_threads = stoi(argument_parser.get_argument('t'));
+	use_qual = argument_parser.get_flag('Q');
+	types_by_length = argument_parser.get_flag('l');
+
+	// print info
+	cerr << "Files and parameters used:" << endl;
+	argument_parser.info();
+
+	// all variants regardless of thresholds, then each threshold separately
+	vector<ConcordanceThresholds> thresholds = { {0, 0.0, 0, 0} };
+	for (auto unique_kmers : unique_kmer_thresholds) {
+		for (auto quality : quality_thresholds) {
+			if ((unique_kmers == 0) && (quality == 0)) continue;
+			thresholds.push_back({quality, 0.0, unique_kmers, 0});
+		}
+	}
+	for (auto allele_frequency : allele_frequency_thresholds) {
+		if (allele_frequency == 0) continue;
+		thresholds.push_back({0, allele_frequency, 0, 0});
+	}
+	for (auto missing : missing_thresholds) {
+		if (missing == 0) continue;
+		thresholds.push_back({0, 0.0, 0, missing});
+	}
+
+	cerr << "Compute genotype concordances ..." << endl;
+	GenotypeConcordance concordance (baseline, callset, samples, use_qual, types_by_length);
+	concordance.compute_statistics(thresholds, nr_threads);
+	cerr << "Write statistics to files with prefix: " << outname << " ..." << endl;
+	concordance.write_statistics(outname);
+	time_total = timer.get_total_time();
+
+	cerr << endl << "###### Summary ######" << endl;
+	// output times
+	cerr << "total wallclock time: " << time_total  << " sec" << endl;
+
+	// memory usage
+	struct rusage r_usage;
+	getrusage(RUSAGE_SELF, &r_usage);
+	cerr << "Total maximum memory usage: " << (r_usage.ru_maxrss / 1E6) << " GB" << endl;
+
+	return 0;
+}
@@ -0,0 +1,66 @@
+#include <iostream>
+#include <sstream>
+#include <sys/resource.h>
+#include "binarygenotypes.hpp"
+#include "commandlineparser.hpp"
+#include "timer.hpp"
+
+
+using namespace std;
+
+int main (int argc, char* argv[])
+{
+	Timer timer;
+	double time_total;
+
+	cerr << endl;
+	cerr << "program: PanGenie-convert - convert binary genotyping output of PanGenie (-B) to VCF." << endl;
+	cerr << "author: Jana Ebler" << endl << endl;
+
+	string binfile = "";
+	string outname = "result_genotyping.vcf";
+
+	// parse the command line arguments
+	CommandLineParser argument_parser;
+	argument_parser.add_command("PanGenie-convert [options]  -i <genotyping.bin>");
+	argument_parser.add_mandatory_argument('i', "binary genotyping output of PanGenie (<prefix>_genotyping.bin)");
+	argument_parser.add_optional_argument('o', "result_genotyping.vcf", "name of the output VCF");
+
+	try {
+		argument_parser.parse(argc, argv);
+	} catch (const runtime_error& e) {
+		argument_parser.usage();
+		cerr << e.what() << endl;
+		return 1;
+	} catch (const exception& e) {
+		return 0;
+	}
+
+	binfile = argument_parser.get_argument('i');
+	outname = argument_parser.get_argument('o');
+
+	// print info
+	cerr << "Files and parameters used:" << endl;
+	argument_parser.info();
+
+	cerr << "Convert binary genotypes to VCF ..." << endl;
+	BinaryGenotypeReader reader (binfile);
+	size_t nr_records = 0;
+	for (size_t i = 0; i < reader.nr_of_blocks(); ++i) {
+		nr_records += reader.get_block(i).nr_records;
+	}
+	reader.write_vcf(outname);
+	cerr << "Wrote " << nr_records << " records of " << reader.nr_of_blocks() << " chromosome(s)." << endl;
+	time_total = timer.get_total_time();
+
+	cerr << endl << "###### Summary ######" << endl;
+	// output times
+	cerr << "total wallclock time: " << time_total  << " sec" << endl;
+
+	// memory usage
+	struct rusage r_usage;
+	getrusage(RUSAGE_SELF, &r_usage);
+	cerr << "Total maximum memory usage: " << (r_usage.ru_maxrss / 1E6) << " GB" << endl;
+
+	return 0;
+}
@@ -0,0 +1,80 @@
+#include <iostream>
+#include <sstream>
+#include <sys/resource.h>
+#include <algorithm>
+#include "panelmerger.hpp"
+#include "commandlineparser.hpp"
+#include "timer.hpp"
+
+
+using namespace std;
+
+int main (int argc, char* argv[])
+{
+	Timer timer;
+	double time_total;
+
+	cerr << endl;
+	cerr << "program: PanGenie-prepare - merge overlapping variants of a phased, biallelic callset into a PanGenie input VCF." << endl;
+	cerr << "author: Jana Ebler" << endl << endl;
+
+	string reffile = "";
+	string vcffile = "";
+	string outname = "panel.vcf";
+	size_t ploidy = 2;
+	size_t nr_threads = 1;
+	vector<string> chromosomes;
+
+	// parse the command line arguments
+	CommandLineParser argument_parser;
+	argument_parser.add_command("PanGenie-prepare [options]  -r <reference.fa> -v <callset.vcf>");
+	argument_parser.add_mandatory_argument('r', "reference genome in FASTA format");
+	argument_parser.add_mandatory_argument('v', "phased, biallelic multi-sample VCF with variant IDs given in INFO field ID");
+	argument_parser.add_optional_argument('o', "panel.vcf", "name of the output VCF");
+	argument_parser.add_optional_argument('p', "2", "ploidy of the samples");
+	argument_parser.add_optional_argument('t', "1", "number of threads (blocks of records merged in parallel)");
+	argument_parser.add_optional_argument('c', "", "comma separated list of chromosomes. Only output variants on these chromosomes (default: all)");
+
+	try {
+		argument_parser.parse(argc, argv);
+	} catch (const runtime_error& e) {
+		argument_parser.usage();
+		cerr << e.what() << endl;
+		return 1;
+	} catch (const exception& e) {
+		return 0;
+	}
+
+	reffile = argument_parser.get_argument('r');
+	vcffile = argument_parser.get_argument('v');
+	outname = argument_parser.get_argument('o');
+	ploidy = stoi(argument_parser.get_argument('p'));
+	nr_threads = stoi(argument_parser.get_argument('t'));
+	string chromosome;
+	istringstream iss (argument_parser.get_argument('c'));
+	while (getline(iss, chromosome, ',')) {
+		if (!chromosome.empty()) chromosomes.push_back(chromosome);
+	}
+
+	// print info
+	cerr << "Files and parameters used:" << endl;
+	argument_parser.info();
+
+	cerr << "Merge overlapping variants ..." << endl;
+	PanelMerger panel_merger (reffile, ploidy);
+	panel_merger.merge(vcffile, outname, nr_threads, chromosomes);
+	cerr << "Total number of input alleles: " << panel_merger.nr_input_alleles() << endl;
+	cerr << "Total number of written alleles: " << panel_merger.nr_written_alleles() << endl;
+	time_total = timer.get_total_time();
+
+	cerr << endl << "###### Summary ######" << endl;
+	// output times
+	cerr << "total wallclock time: " << time_total  << " sec" << endl;
+
+	// memory usage
+	struct rusage r_usage;
+	getrusage(RUSAGE_SELF, &r_usage);
+	cerr << "Total maximum memory usage: " << (r_usage.ru_maxrss / 1E6) << " GB" << endl;
+
+	return 0;
+}
@@ -0,0 +1,100 @@
+#include <iostream>
+#include <sstream>
+#include <sys/resource.h>
+#include <vector>
+#include <algorithm>
+#include "readparser.hpp"
+#include "commandlineparser.hpp"
+#include "timer.hpp"
+
+
+using namespace std;
+
+// per thread statistics, padded to avoid false sharing
+struct alignas(64) ParserStatistics {
+	uint64_t nr_reads = 0;
+	uint64_t nr_bases = 0;
+	uint64_t nr_gc = 0;
+};
+
+int main (int argc, char* argv[])
+{
+	Timer timer;
+	double time_total;
+
+	cerr << endl;
+	cerr << "program: PanGenie-readbenchmark - measure the throughput of parsing reads." << endl;
+	cerr << "author: Jana Ebler" << endl << endl;
+
+	string readfile = "";
+	size_t nr_threads = 1;
+	size_t batch_size = 4;
+	size_t nr_rounds = 1;
+
+	// parse the command line arguments
+	CommandLineParser argument_parser;
+	argument_parser.add_command("PanGenie-readbenchmark [options] -i <reads.fa/fq>");
+	argument_parser.add_mandatory_argument('i', "sequencing reads in FASTA/FASTQ format. NOTE: INPUT FASTA/Q FILE MUST NOT BE COMPRESSED.");
+	argument_parser.add_optional_argument('t', "1", "number of threads processing batches of reads");
+	argument_parser.add_optional_argument('b', "4", "batch size in MB");
+	argument_parser.add_optional_argument('r', "1", "number of times the file is parsed");
+
+	try {
+		argument_parser.parse(argc, argv);
+	} catch (const runtime_error& e) {
+		argument_parser.usage();
+		cerr << e.what() << endl;
+		return 1;
+	} catch (const exception& e) {
+		return 0;
+	}
+
+	readfile = argument_parser.get_argument('i');
+	nr_threads = stoi(argument_parser.get_argument('t'));
+	batch_size = stoi(argument_parser.get_argument('b'));
+	nr_rounds = stoi(argument_parser.get_argument('r'));
+
+	// print info
+	cerr << "Files and parameters used:" << endl;
+	argument_parser.info();
+
+	ReadParser parser (readfile, batch_size << 20);
+	for (size_t round = 0; round < nr_rounds; ++round) {
+		// touch every base, as a kmer counter would
+		vector<ParserStatistics> statistics(max(nr_threads, (size_t) 1));
+		timer.get_interval_time();
+		parser.parse(nr_threads, [&](const ReadBatch& batch, size_t thread_index) {
+			ParserStatistics& s = statistics[thread_index];
+			for (size_t i = 0; i < batch.nr_of_reads(); ++i) {
+				size_t length;
+				const char* sequence = batch.get_sequence(i, length);
+				s.nr_reads += 1;
+				s.nr_bases += length;
+				for (size_t j = 0; j < length; ++j) {
+					s.nr_gc += ((sequence[j] == 'C') || (sequence[j] == 'G'));
+				}
+			}
+		});
+		double time_round = timer.get_interval_time();
+		ParserStatistics total;
+		for (auto& s : statistics) {
+			total.nr_reads += s.nr_reads;
+			total.nr_bases += s.nr_bases;
+			total.nr_gc += s.nr_gc;
+		}
+		cerr << "round " << round + 1 << ": parsed " << total.nr_reads << " reads (" << total.nr_bases << " bases, GC content " << (total.nr_bases > 0 ? (double) total.nr_gc / total.nr_bases : 0.0) << ") in " << time_round << " sec: ";
+		cerr << (parser.bytes_read() / 1E6) / time_round << " MB/s, " << (total.nr_reads / 1E6) / time_round << " M reads/s" << endl;
+	}
+	time_total = timer.get_total_time();
+
+	cerr << endl << "###### Summary ######" << endl;
+	// output times
+	cerr << "total wallclock time: " << time_total  << " sec" << endl;
+
+	// memory usage
+	struct rusage r_usage;
+	getrusage(RUSAGE_SELF, &r_usage);
+	cerr << "Total maximum memory usage: " << (r_usage.ru_maxrss / 1E6) << " GB" << endl;
+
+	return 0;
+}
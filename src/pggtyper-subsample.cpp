@@ -0,0 +1,88 @@
+#include <iostream>
+#include <sstream>
+#include <sys/resource.h>
+#include <algorithm>
+#include "panelsubsampler.hpp"
+#include "commandlineparser.hpp"
+#include "timer.hpp"
+
+
+using namespace std;
+
+int main (int argc, char* argv[])
+{
+	Timer timer;
+	double time_total;
+
+	cerr << endl;
+	cerr << "program: PanGenie-subsample - create sub-panels and ground truth VCFs for leave-one-out experiments." << endl;
+	cerr << "author: Jana Ebler" << endl << endl;
+
+	string vcffile = "";
+	string outname = "result";
+	vector<string> samples;
+	size_t nr_samples = 0;
+	unsigned int seed = 0;
+	size_t nr_threads = 1;
+
+	// parse the command line arguments
+	CommandLineParser argument_parser;
+	argument_parser.add_command("PanGenie-subsample [options]  -v <panel.vcf> -s <sample1,sample2,...>");
+	argument_parser.add_mandatory_argument('v', "multi-sample panel VCF");
+	argument_parser.add_mandatory_argument('s', "comma separated list of samples to leave out. One sub-panel and truth VCF is written per sample");
+	argument_parser.add_optional_argument('n', "0", "number of samples to select for each sub-panel (0: all remaining samples)");
+	argument_parser.add_optional_argument('o', "result", "prefix of the output files (<prefix>_<sample>_panel.vcf and <prefix>_<sample>_truth.vcf)");
+	argument_parser.add_optional_argument('x', "0", "seed used to select samples");
+	argument_parser.add_optional_argument('t', "1", "number of threads (sub-panels written in parallel)");
+
+	try {
+		argument_parser.parse(argc, argv);
+	} catch (const runtime_error& e) {
+		argument_parser.usage();
+		cerr << e.what() << endl;
+		return 1;
+	} catch (const exception& e) {
+		return 0;
+	}
+
+	vcffile = argument_parser.get_argument('v');
+	outname = argument_parser.get_argument('o');
+	nr_samples = stoi(argument_parser.get_argument('n'));
+	seed = stoul(argument_parser.get_argument('x'));
+	nr_threads = stoi(argument_parser.get_argument('t'));
+	string sample;
+	istringstream iss (argument_parser.get_argument('s'));
+	while (getline(iss, sample, ',')) {
+		if (!sample.empty()) samples.push_back(sample);
+	}
+
+	// print info
+	cerr << "Files and parameters used:" << endl;
+	argument_parser.info();
+
+	cerr << "Write sub-panels ..." << endl;
+	PanelSubsampler subsampler (samples, nr_samples, outname, seed);
+	subsampler.subsample(vcffile, nr_threads);
+	for (auto& s : samples) {
+		vector<string> selected;
+		subsampler.get_selected_samples(s, selected);
+		cerr << "Selected samples for sub-panel of " << s << ": ";
+		for (size_t i = 0; i < selected.size(); ++i) {
+			if (i > 0) cerr << ",";
+			cerr << selected[i];
+		}
+		cerr << endl;
+	}
+	time_total = timer.get_total_time();
+
+	cerr << endl << "###### Summary ######" << endl;
+	// output times
+	cerr << "total wallclock time: " << time_total  << " sec" << endl;
+
+	// memory usage
+	struct rusage r_usage;
+	getrusage(RUSAGE_SELF, &r_usage);
+	cerr << "Total maximum memory usage: " << (r_usage.ru_maxrss / 1E6) << " GB" << endl;
+
+	return 0;
+}
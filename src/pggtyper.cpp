@@ -7,18 +7,31 @@
 #include <algorithm>
 #include <fstream>
 #include <stdexcept>
+#include <exception>
+#include <memory>
+#include "arena.hpp"
 #include "kmercounter.hpp"
 #include "jellyfishreader.hpp"
 #include "jellyfishcounter.hpp"
+#include "referencekmerindex.hpp"
+#include "bucketkmercounter.hpp"
+#include "sortedkmercounter.hpp"
+#include "readsubsampler.hpp"
 #include "emissionprobabilitycomputer.hpp"
 #include "copynumber.hpp"
 #include "variantreader.hpp"
 #include "uniquekmercomputer.hpp"
 #include "hmm.hpp"
+#include "fastgenotyper.hpp"
 #include "commandlineparser.hpp"
 #include "timer.hpp"
 #include "threadpool.hpp"
 #include "pathsampler.hpp"
+#include "shardmerger.hpp"
+#include "hugepages.hpp"
+#include "compressedcolumn.hpp"
+#include "checkpointstore.hpp"
+#include "directfilereader.hpp"
 
 using namespace std;
 
@@ -47,62 +60,106 @@ void check_input_file(string &filename) {
 	}
 }
 
+/** per-contig storage is indexed by the contig ids of the VariantReader and sized before threads are started **/
 struct UniqueKmersMap {
 	mutex kmers_mutex;
-	map<string, vector<UniqueKmers*>> unique_kmers;
-	map<string, double> runtimes;
+	vector<vector<UniqueKmers*>> unique_kmers;
+	// the UniqueKmers of a contig are stored in its arena and freed at once after the contig was written
+	vector<unique_ptr<Arena>> arenas;
+	vector<double> runtimes;
 };
 
 struct Results {
 	mutex result_mutex;
-	map<string, vector<GenotypingResult>> result;
-	map<string, double> runtimes;
+	vector<vector<GenotypingResult>> result;
+	vector<double> runtimes;
+	// message of the first error raised by a genotyping job (empty if there was none)
+	string error;
 };
 
-void prepare_unique_kmers(string chromosome, KmerCounter* genomic_kmer_counts, KmerCounter* read_kmer_counts, VariantReader* variant_reader, ProbabilityTable* probs, UniqueKmersMap* unique_kmers_map, size_t kmer_coverage) {
+/** kmers whose counts are looked up when determining the unique kmers of the given chromosomes **/
+void collect_query_kmers(const vector<size_t>& chromosomes, KmerCounter* genomic_kmer_counts, KmerCounter* read_kmer_counts, VariantReader* variant_reader, size_t kmer_abundance_peak, vector<jellyfish::mer_dna>& query_kmers) {
+	for (auto chromosome : chromosomes) {
+		UniqueKmerComputer kmer_computer(genomic_kmer_counts, read_kmer_counts, variant_reader, chromosome, kmer_abundance_peak);
+		kmer_computer.collect_query_kmers(query_kmers);
+	}
+}
+
+/** report whether large tables were backed by huge pages **/
+void print_huge_page_statistics() {
+	HugePageStatistics statistics = HugePages::get_statistics();
+	cerr << "huge page mode:\t" << HugePages::get_mode_name(HugePages::get_mode()) << endl;
+	cerr << "maximum memory allocated in large blocks:\t" << (statistics.peak_mapped_bytes / 1E9) << " GB" << endl;
+	cerr << "maximum memory backed by explicit huge pages:\t" << (statistics.peak_explicit_bytes / 1E9) << " GB" << endl;
+	cerr << "maximum memory advised to use transparent huge pages:\t" << (statistics.peak_advised_bytes / 1E9) << " GB" << endl;
+	cerr << "memory still allocated in large blocks:\t" << (statistics.mapped_bytes / 1E9) << " GB" << endl;
+	cerr << "maximum memory backed by transparent huge pages:\t" << (statistics.transparent_bytes / 1E9) << " GB" << endl;
+}
+
+void prepare_unique_kmers(size_t contig_id, KmerCounter* genomic_kmer_counts, KmerCounter* read_kmer_counts, VariantReader* variant_reader, ProbabilityTable* probs, UniqueKmersMap* unique_kmers_map, size_t kmer_coverage, bool release_sequences) {
 	Timer timer;
-	UniqueKmerComputer kmer_computer(genomic_kmer_counts, read_kmer_counts, variant_reader, chromosome, kmer_coverage);
+	UniqueKmerComputer kmer_computer(genomic_kmer_counts, read_kmer_counts, variant_reader, contig_id, kmer_coverage);
 	std::vector<UniqueKmers*> unique_kmers;
-	kmer_computer.compute_unique_kmers(&unique_kmers, probs);
+	unique_ptr<Arena> arena(new Arena());
+	kmer_computer.compute_unique_kmers(&unique_kmers, probs, arena.get());
+	// allele sequences are no longer needed, keep only what is required for writing the output VCFs
+	if (release_sequences) variant_reader->release_sequences(contig_id, &unique_kmers);
 	// store the results
-	{
-		lock_guard<mutex> lock_kmers (unique_kmers_map->kmers_mutex);
-		unique_kmers_map->unique_kmers.insert(pair<string, vector<UniqueKmers*>> (chromosome, move(unique_kmers)));
-	}
-	// store runtime
 	lock_guard<mutex> lock_kmers (unique_kmers_map->kmers_mutex);
-	unique_kmers_map->runtimes.insert(pair<string, double>(chromosome, timer.get_total_time()));
+	unique_kmers_map->unique_kmers.at(contig_id) = move(unique_kmers);
+	unique_kmers_map->arenas.at(contig_id) = move(arena);
+	// store runtime
+	unique_kmers_map->runtimes.at(contig_id) = timer.get_total_time();
 }
 
-void run_genotyping(string chromosome, vector<UniqueKmers*>* unique_kmers, ProbabilityTable* probs, bool only_genotyping, bool only_phasing, long double effective_N, vector<unsigned short>* only_paths, Results* results) {
+void run_genotyping(size_t contig_id, vector<UniqueKmers*>* unique_kmers, ProbabilityTable* probs, bool only_genotyping, bool only_phasing, long double effective_N, vector<unsigned short>* only_paths, string spill_directory, CompressedColumn::Mode compression, Results* results) {
 	Timer timer;
+	{
+		// skip remaining jobs once one of them failed
+		lock_guard<mutex> lock_result (results->result_mutex);
+		if (!results->error.empty()) return;
+	}
 	/* construct HMM and run genotyping/phasing. Genotyping is run without normalizing the final alpha*beta values.
 	These values are first added up across different subsets of paths, and the resulting probabilities are normalized
 	at the end. This is done so that genotyping runs on disjoint sets of paths are better comparable. */
-	HMM hmm(unique_kmers, probs, !only_phasing, !only_genotyping, 1.26, false, effective_N, only_paths, false);
+	unique_ptr<HMM> hmm;
+	try {
+		hmm.reset(new HMM(unique_kmers, probs, !only_phasing, !only_genotyping, 1.26, false, effective_N, only_paths, false, spill_directory, compression));
+	} catch (const exception& e) {
+		// exceptions must not leave the thread pool, they are reported once all jobs are done
+		lock_guard<mutex> lock_result (results->result_mutex);
+		if (results->error.empty()) results->error = e.what();
+		return;
+	}
 	// store the results
 	{
 		lock_guard<mutex> lock_result (results->result_mutex);
 		// combine the new results to the already existing ones (if present)
-		if (results->result.find(chromosome) == results->result.end()) {
-			results->result.insert(pair<string, vector<GenotypingResult>> (chromosome, hmm.move_genotyping_result()));
+		if (results->result.at(contig_id).empty()) {
+			results->result.at(contig_id) = hmm->move_genotyping_result();
 		} else {
 			// combine newly computed likelihoods with already exisiting ones
 			size_t index = 0;
-			vector<GenotypingResult> genotypes = hmm.move_genotyping_result();
+			vector<GenotypingResult> genotypes = hmm->move_genotyping_result();
 			for (auto likelihoods : genotypes) {
-				results->result.at(chromosome).at(index).combine(likelihoods);
+				results->result.at(contig_id).at(index).combine(likelihoods);
 				index += 1;
 			}
 		}
 	}
 	// store runtime
 	lock_guard<mutex> lock_result (results->result_mutex);
-	if (results->runtimes.find(chromosome) == results->runtimes.end()) {
-		results->runtimes.insert(pair<string,double>(chromosome, timer.get_total_time()));
-	} else {
-		results->runtimes[chromosome] += timer.get_total_time();
-	}
+	results->runtimes.at(contig_id) += timer.get_total_time();
+}
+
+void run_fast_genotyping(size_t contig_id, size_t start, size_t end, vector<UniqueKmers*>* unique_kmers, ProbabilityTable* probs, vector<vector<float>>* allele_frequencies, Results* results) {
+	Timer timer;
+	FastGenotyper genotyper(unique_kmers, probs, allele_frequencies);
+	// each block writes to its own, preallocated range of the results
+	genotyper.compute_genotypes(start, end, results->result.at(contig_id));
+	// store runtime
+	lock_guard<mutex> lock_result (results->result_mutex);
+	results->runtimes.at(contig_id) += timer.get_total_time();
 }
 
 bool ends_with (string const &full_string, string const ending) {
@@ -126,12 +183,12 @@ int main (int argc, char* argv[])
 	cerr << endl;
 	cerr << "program: PanGenie - genotyping and phasing based on kmer-counting and known haplotype sequences." << endl;
 	cerr << "author: Jana Ebler" << endl << endl;
-	string readfile = "";
+	vector<string> readfiles;
 	string reffile = "";
 	string vcffile = "";
 	size_t kmersize = 31;
 	string outname = "result";
-	string sample_name = "sample";
+	vector<string> sample_names;
 	size_t nr_jellyfish_threads = 1;
 	size_t nr_core_threads = 1;
 	bool only_genotyping = true;
@@ -142,28 +199,63 @@ int main (int argc, char* argv[])
 	bool ignore_imputed = false;
 	bool add_reference = true;
 	size_t sampling_size = 0;
+	bool release_sequences = false;
+	bool fast_mode = false;
+	bool binary_output = false;
+	string biallelic_panel = "";
+	string reference_index = "";
+	double max_coverage = 0.0;
+	bool sorted_queries = false;
+	double counting_memory = 0.0;
+	string spill_directory = "";
+	CompressedColumn::Mode compression = CompressedColumn::NONE;
+	// scatter-gather mode: all (default), count, genotype or merge
+	string step = "all";
+	vector<string> selected_chromosomes;
+	// number of variants genotyped per job in fast mode
+	size_t fast_block_size = 10000;
 	uint64_t hash_size = 3000000000;
 
 	// parse the command line arguments
 	CommandLineParser argument_parser;
 	argument_parser.add_command("PanGenie [options] -i <reads.fa/fq> -r <reference.fa> -v <variants.vcf>");
-	argument_parser.add_mandatory_argument('i', "sequencing reads in FASTA/FASTQ format or Jellyfish database in jf format. NOTE: INPUT FASTA/Q FILE MUST NOT BE COMPRESSED.");
+	argument_parser.add_mandatory_argument('i', "sequencing reads in FASTA/FASTQ format, Jellyfish database in jf format or kmer counts written by -P count (.sorted). Comma separated list of files (one per sample given by -s) to jointly genotype several samples. NOTE: INPUT FASTA/Q FILE MUST NOT BE COMPRESSED.");
 	argument_parser.add_mandatory_argument('r', "reference genome in FASTA format. NOTE: INPUT FASTA FILE MUST NOT BE COMPRESSED.");
 	argument_parser.add_mandatory_argument('v', "variants in VCF format. NOTE: INPUT VCF FILE MUST NOT BE COMPRESSED.");
 	argument_parser.add_optional_argument('o', "result", "prefix of the output files. NOTE: the given path must not include non-existent folders.");
 	argument_parser.add_optional_argument('k', "31", "kmer size");
-	argument_parser.add_optional_argument('s', "sample", "name of the sample (will be used in the output VCFs)");
+	argument_parser.add_optional_argument('s', "sample", "name of the sample (will be used in the output VCFs). Comma separated list of names if several read files are given");
 	argument_parser.add_optional_argument('j', "1", "number of threads to use for kmer-counting");
 	argument_parser.add_optional_argument('t', "1", "number of threads to use for core algorithm. Largest number of threads possible is the number of chromosomes given in the VCF");
 //	argument_parser.add_optional_argument('n', "0.00001", "effective population size");
 	argument_parser.add_flag_argument('g', "run genotyping (Forward backward algorithm, default behaviour).");
 	argument_parser.add_flag_argument('p', "run phasing (Viterbi algorithm). Experimental feature.");
 //	argument_parser.add_optional_argument('m', "0.001", "regularization constant for copynumber probabilities");
+	argument_parser.add_optional_argument('C', "0", "maximum read coverage. Reads of samples with higher (estimated) coverage are subsampled deterministically to this coverage prior to kmer counting (0: use all reads). Subsampled reads are passed to Jellyfish through a named pipe <prefix>_subsampled_reads.fa, with -M they are written to this file (about as large as the selected sequence). Not applied to Jellyfish databases.");
 	argument_parser.add_flag_argument('c', "count all read kmers instead of only those located in graph.");
+	argument_parser.add_optional_argument('M', "0", "memory limit (in GB) for counting all read kmers (-c). If given, reads are partitioned into buckets on disk (<prefix>_kmerbuckets.*) which are counted separately (kmer size at most 31). 0: count in memory using Jellyfish.");
 	argument_parser.add_flag_argument('u', "output genotype ./. for variants not covered by any unique kmers.");
 	argument_parser.add_flag_argument('d', "do not add reference as additional path.");
 	argument_parser.add_optional_argument('a', "0", "sample subsets of paths of this size.");
+	argument_parser.add_optional_argument('b', "", "biallelic panel VCF with variant IDs (INFO field ID) the input VCF was constructed from. If given, genotypes are additionally written in biallelic representation (one record per ID) to <prefix>_genotyping-biallelic.vcf.");
 	argument_parser.add_optional_argument('e', "3000000000", "size of hash used by jellyfish.");
+	argument_parser.add_flag_argument('f', "fast approximate genotyping: compute likelihoods of each variant separately from its unique kmers and allele frequencies (no HMM). Only genotyping is supported.");
+	argument_parser.add_flag_argument('B', "write genotypes in binary format to <prefix>_genotyping.bin instead of VCF (use PanGenie-convert to convert to VCF).");
+	argument_parser.add_optional_argument('x', "", "reference kmer index (built from the reference genome and written to the given path if it does not exist yet). If given, genomic kmers are looked up in the index and only allele kmers are counted.");
+	argument_parser.add_flag_argument('l', "low memory mode: release allele sequences of a chromosome once its unique kmers are computed.");
+	argument_parser.add_flag_argument('S', "resolve read kmer lookups in one sequential pass: counts are dumped sorted to <prefix>_kmers.sorted (or the Jellyfish database is streamed) and merged with the sorted kmers queried for genotyping (kmer size at most 31).");
+	argument_parser.add_flag_argument('U', "read input files block by block instead of keeping several blocks in flight with io_uring.");
+	argument_parser.add_long_name('U', "no-io-uring");
+	argument_parser.add_optional_argument('P', "all", "step to run. count: count kmers and write the counts needed to genotype the variants to <prefix>_counts.sorted (input for -i). genotype: genotype the chromosomes given by -L and write per-chromosome metrics to <prefix>_metrics.tsv. merge: merge the outputs of genotype steps, given as comma separated list of their prefixes by -i. all: run all steps at once");
+	argument_parser.add_long_name('P', "step");
+	argument_parser.add_optional_argument('L', "", "comma separated list of chromosomes to genotype. If empty, all chromosomes in the VCF are genotyped");
+	argument_parser.add_long_name('L', "chromosomes");
+	argument_parser.add_optional_argument('H', "transparent", "huge pages used for large tables (kmer counts, probabilities). none: regular pages. transparent: request transparent huge pages. 2M, 1G: explicit huge pages of the given size (need to be reserved in /proc/sys/vm/nr_hugepages, transparent huge pages are used if none are available)");
+	argument_parser.add_long_name('H', "huge-pages");
+	argument_parser.add_optional_argument('D', "", "directory for scratch files. If given, HMM checkpoint columns are written to disk instead of being kept in memory (for very large panels).");
+	argument_parser.add_long_name('D', "spill-directory");
+	argument_parser.add_optional_argument('z', "none", "storage of HMM checkpoint columns kept in memory. none: full precision. float32: logarithms as 32 bit floats. log16: 16 bit log-quantized values with a per-column scale. Columns are always computed in full precision");
+	argument_parser.add_long_name('z', "compress-checkpoints");
 
 	try {
 		argument_parser.parse(argc, argv);
@@ -174,12 +266,19 @@ int main (int argc, char* argv[])
 	} catch (const exception& e) {
 		return 0;
 	}
-	readfile = argument_parser.get_argument('i');
+	string field;
+	istringstream iss_reads(argument_parser.get_argument('i'));
+	while (getline(iss_reads, field, ',')) {
+		if (!field.empty()) readfiles.push_back(field);
+	}
 	reffile = argument_parser.get_argument('r');
 	vcffile = argument_parser.get_argument('v');
 	kmersize = stoi(argument_parser.get_argument('k'));
 	outname = argument_parser.get_argument('o');
-	sample_name = argument_parser.get_argument('s');
+	istringstream iss_samples(argument_parser.get_argument('s'));
+	while (getline(iss_samples, field, ',')) {
+		if (!field.empty()) sample_names.push_back(field);
+	}
 	nr_jellyfish_threads = stoi(argument_parser.get_argument('j'));
 	nr_core_threads = stoi(argument_parser.get_argument('t'));
 
@@ -203,6 +302,111 @@ int main (int argc, char* argv[])
 	sampling_size = stoi(argument_parser.get_argument('a'));
 	istringstream iss(argument_parser.get_argument('e'));
 	iss >> hash_size;
+	release_sequences = argument_parser.get_flag('l');
+	fast_mode = argument_parser.get_flag('f');
+	binary_output = argument_parser.get_flag('B');
+	biallelic_panel = argument_parser.get_argument('b');
+	reference_index = argument_parser.get_argument('x');
+	max_coverage = stod(argument_parser.get_argument('C'));
+	sorted_queries = argument_parser.get_flag('S');
+	if (argument_parser.get_flag('U')) DirectFileReader::set_io_uring(false);
+	counting_memory = stod(argument_parser.get_argument('M'));
+	step = argument_parser.get_argument('P');
+	spill_directory = argument_parser.get_argument('D');
+	istringstream iss_chromosomes(argument_parser.get_argument('L'));
+	while (getline(iss_chromosomes, field, ',')) {
+		if (!field.empty()) selected_chromosomes.push_back(field);
+	}
+	if ((step != "all") && (step != "count") && (step != "genotype") && (step != "merge")) {
+		argument_parser.usage();
+		cerr << "Error: step (-P) must be one of all, count, genotype or merge." << endl;
+		return 1;
+	}
+	try {
+		HugePages::set_mode(HugePages::parse_mode(argument_parser.get_argument('H')));
+		compression = CompressedColumn::parse_mode(argument_parser.get_argument('z'));
+	} catch (const runtime_error& e) {
+		argument_parser.usage();
+		cerr << "Error: " << e.what() << endl;
+		return 1;
+	}
+	if (!spill_directory.empty()) {
+		// fail early instead of in the first HMM job if scratch files cannot be written
+		try {
+			CheckpointStore probe(spill_directory);
+			probe.store(0, vector<long double>(1, 0.0L));
+		} catch (const runtime_error& e) {
+			cerr << "Error: spill directory (-D) " << spill_directory << " is not writable: " << e.what() << endl;
+			return 1;
+		}
+	}
+	if ((step == "count") && (kmersize > 31)) {
+		cerr << "Error: writing kmer counts (-P count) requires a kmer size of at most 31." << endl;
+		return 1;
+	}
+	if (step == "merge") {
+		// combine the outputs of genotyping runs on disjoint sets of chromosomes
+		cerr << "Files and parameters used:" << endl;
+		argument_parser.info();
+		try {
+			ShardMerger merger(readfiles);
+			merger.check_chromosomes(vcffile);
+			for (string suffix : {"_genotyping.vcf", "_phasing.vcf", "_genotyping-biallelic.vcf"}) {
+				if (merger.merge_vcfs(suffix, outname + suffix)) cerr << "Merged shards into file: " << outname + suffix << endl;
+			}
+			merger.merge_metrics(outname + "_metrics.tsv");
+			cerr << "Merged metrics into file: " << outname + "_metrics.tsv" << endl;
+		} catch (const runtime_error& e) {
+			cerr << "Error: " << e.what() << endl;
+			return 1;
+		}
+		cerr << "total wallclock time: " << timer.get_total_time() << " sec" << endl;
+		return 0;
+	}
+	if ((step == "genotype") && binary_output) {
+		cerr << "Warning: binary output (-B) cannot be merged across chromosomes, VCF is written." << endl;
+		binary_output = false;
+	}
+	if (sorted_queries && (kmersize > 31)) {
+		cerr << "Warning: sorted kmer queries (-S) require a kmer size of at most 31 and are not used." << endl;
+		sorted_queries = false;
+	}
+	if ((counting_memory > 0.0) && (count_only_graph || (kmersize > 31))) {
+		cerr << "Warning: disk-based kmer counting (-M) is only used when counting all read kmers (-c) with a kmer size of at most 31." << endl;
+		counting_memory = 0.0;
+	}
+	if (fast_mode && !only_genotyping) {
+		cerr << "Warning: phasing is not supported in fast mode, only genotyping is run." << endl;
+		only_genotyping = true;
+		only_phasing = false;
+	}
+	// several samples can be genotyped jointly and are written to a single, multi-sample VCF
+	size_t nr_samples = readfiles.size();
+	if ((nr_samples == 0) || ((nr_samples > 1) && (sample_names.size() != nr_samples))) {
+		argument_parser.usage();
+		cerr << "Error: one sample name (-s) needs to be given per read file (-i)." << endl;
+		return 1;
+	}
+	if (sample_names.empty()) sample_names.push_back("sample");
+	if (nr_samples > 1) {
+		if (!only_genotyping) {
+			cerr << "Warning: phasing is not supported for several samples, only genotyping is run." << endl;
+			only_genotyping = true;
+			only_phasing = false;
+		}
+		if (!biallelic_panel.empty()) {
+			cerr << "Warning: biallelic output (-b) is not supported for several samples and is not written." << endl;
+			biallelic_panel = "";
+		}
+		if (release_sequences) {
+			cerr << "Warning: low memory mode (-l) is not supported for several samples and is not used." << endl;
+			release_sequences = false;
+		}
+		if (binary_output) {
+			cerr << "Warning: binary output (-B) is not supported for several samples, VCF is written." << endl;
+			binary_output = false;
+		}
+	}
 
 	// print info
 	cerr << "Files and parameters used:" << endl;
@@ -211,11 +415,13 @@ int main (int argc, char* argv[])
 	// check if input files exist and are uncompressed
 	check_input_file(reffile);
 	check_input_file(vcffile);
-	check_input_file(readfile);
+	for (auto& readfile : readfiles) {
+		check_input_file(readfile);
+	}
 
 	// read allele sequences and unitigs inbetween, write them into file
 	cerr << "Determine allele sequences ..." << endl;
-	VariantReader variant_reader (vcffile, reffile, kmersize, add_reference, sample_name);
+	VariantReader variant_reader (vcffile, reffile, kmersize, add_reference, sample_names[0]);
 	
 	// TODO: only for analysis
 	struct rusage r_usage00;
@@ -227,9 +433,26 @@ int main (int argc, char* argv[])
 	variant_reader.write_path_segments(segment_file);
 
 	// determine chromosomes present in VCF
-	vector<string> chromosomes;
-	variant_reader.get_chromosomes(&chromosomes);
+	vector<size_t> chromosomes;
+	variant_reader.get_contig_ids(&chromosomes);
+	size_t nr_contigs = variant_reader.nr_of_contigs();
 	cerr << "Found " << chromosomes.size() << " chromosome(s) in the VCF." << endl;
+	if (!selected_chromosomes.empty()) {
+		vector<size_t> selected;
+		for (auto chromosome : chromosomes) {
+			if (find(selected_chromosomes.begin(), selected_chromosomes.end(), variant_reader.get_contig_name(chromosome)) != selected_chromosomes.end()) selected.push_back(chromosome);
+		}
+		if (selected.size() != selected_chromosomes.size()) {
+			cerr << "Error: not all chromosomes given by -L are contained in the VCF." << endl;
+			return 1;
+		}
+		chromosomes = selected;
+		cerr << "Process " << chromosomes.size() << " of these chromosome(s)." << endl;
+	}
+	vector<string> chromosome_names;
+	for (auto chromosome : chromosomes) {
+		chromosome_names.push_back(variant_reader.get_contig_name(chromosome));
+	}
 
 	// TODO: only for analysis
 	struct rusage r_usage0;
@@ -238,76 +461,211 @@ int main (int argc, char* argv[])
 
 	time_preprocessing = timer.get_interval_time();
 
-	// UniqueKmers for each chromosome
-	UniqueKmersMap unique_kmers_list;
-	ProbabilityTable probabilities;
+	// UniqueKmers for each sample and chromosome
+	vector<UniqueKmersMap> unique_kmers_list(nr_samples);
+	vector<ProbabilityTable> probabilities(nr_samples);
+	for (auto& sample_kmers : unique_kmers_list) {
+		sample_kmers.unique_kmers.resize(nr_contigs);
+		sample_kmers.arenas.resize(nr_contigs);
+		sample_kmers.runtimes.assign(nr_contigs, 0.0);
+	}
+	time_kmer_counting = 0.0;
+	// read coverage of each sample after subsampling (-C)
+	vector<double> effective_coverages(nr_samples, 0.0);
+	vector<size_t> abundance_peaks(nr_samples, 0);
+	time_unique_kmers = 0.0;
 
 	{
-		KmerCounter* read_kmer_counts = nullptr;
-		// determine kmer copynumbers in reads
-		if (readfile.substr(std::max(3, (int) readfile.size())-3) == std::string(".jf")) {
-			cerr << "Read pre-computed read kmer counts ..." << endl;
-			jellyfish::mer_dna::k(kmersize);
-			read_kmer_counts = new JellyfishReader(readfile, kmersize);
+		// count kmers in allele + reference sequence (shared by all samples)
+		KmerCounter* genomic_kmer_counts = nullptr;
+		KmerCounter* allele_kmer_counts = nullptr;
+		// when only graph kmers are counted in the reads, genomic counts are stored in the same hash as the read counts
+		bool combined_counts = count_only_graph && reference_index.empty();
+		for (auto& readfile : readfiles) {
+			if (readfile.substr(std::max(3, (int) readfile.size())-3) == std::string(".jf")) combined_counts = false;
+		}
+		if (combined_counts) {
+			cerr << "Genomic kmer counts are determined together with read kmer counts." << endl;
+		} else if (reference_index.empty()) {
+			cerr << "Count kmers in genome ..." << endl;
+			genomic_kmer_counts = new JellyfishCounter(segment_file, kmersize, nr_jellyfish_threads, hash_size);
 		} else {
-			cerr << "Count kmers in reads ..." << endl;
-			if (count_only_graph) {
-				read_kmer_counts = new JellyfishCounter(readfile, segment_file, kmersize, nr_jellyfish_threads, hash_size);
-			} else {
-				read_kmer_counts = new JellyfishCounter(readfile, kmersize, nr_jellyfish_threads, hash_size);
+			// reference kmers are looked up in the index, only the kmers of non-reference alleles need to be counted
+			struct stat index_stats;
+			if (stat(reference_index.c_str(), &index_stats) != 0) {
+				cerr << "Build reference kmer index " << reference_index << " ..." << endl;
+				ReferenceKmerIndex::build(reffile, kmersize, reference_index);
 			}
+			string allele_file = outname + "_allele_segments.fasta";
+			cerr << "Write allele segments to file: " << allele_file << " ..." << endl;
+			variant_reader.write_allele_segments(allele_file);
+			cerr << "Count kmers in alleles ..." << endl;
+			allele_kmer_counts = new JellyfishCounter(allele_file, kmersize, nr_jellyfish_threads, hash_size);
+			genomic_kmer_counts = new ReferenceKmerIndex(reference_index, kmersize, allele_kmer_counts, &variant_reader.get_reference());
 		}
 
-		size_t kmer_abundance_peak = read_kmer_counts->computeHistogram(10000, count_only_graph, outname + "_histogram.histo");
-		cerr << "Computed kmer abundance peak: " << kmer_abundance_peak << endl;
+		// prepare output files
+		if (step == "count") {
+			// only kmer counts are written
+		} else if (nr_samples > 1) {
+			variant_reader.open_multisample_genotyping_outfile(outname + "_genotyping.vcf", sample_names);
+		} else {
+			if (! only_phasing && binary_output) variant_reader.open_binary_genotyping_outfile(outname + "_genotyping.bin");
+			if (! only_phasing && ! binary_output) variant_reader.open_genotyping_outfile(outname + "_genotyping.vcf");
+			if (! only_phasing && ! biallelic_panel.empty()) variant_reader.open_biallelic_outfile(outname + "_genotyping-biallelic.vcf", biallelic_panel);
+			if (! only_genotyping) variant_reader.open_phasing_outfile(outname + "_phasing.vcf");
+		}
 
-		// count kmers in allele + reference sequence
-		cerr << "Count kmers in genome ..." << endl;
-		JellyfishCounter genomic_kmer_counts (segment_file, kmersize, nr_jellyfish_threads, hash_size);
+		for (size_t s = 0; s < nr_samples; ++s) {
+			const string& readfile = readfiles[s];
+			KmerCounter* read_kmer_counts = nullptr;
+			if (nr_samples > 1) cerr << "Process sample " << sample_names[s] << " ..." << endl;
+			// determine kmer copynumbers in reads
+			if (readfile.substr(std::max(3, (int) readfile.size())-3) == std::string(".jf")) {
+				cerr << "Read pre-computed read kmer counts ..." << endl;
+				jellyfish::mer_dna::k(kmersize);
+				read_kmer_counts = new JellyfishReader(readfile, kmersize);
+			} else if (readfile.substr(std::max(7, (int) readfile.size())-7) == std::string(".sorted")) {
+				cerr << "Read pre-computed kmer counts ..." << endl;
+				SortedKmerCounter* sorted_counts = new SortedKmerCounter(readfile, kmersize);
+				read_kmer_counts = sorted_counts;
+				sorted_counts->check_chromosomes(chromosome_names);
+			} else {
+				// cap the read coverage
+				string count_file = readfile;
+				// Jellyfish reads the subsampled reads from a named pipe while they are selected, the bucket counter needs a regular file
+				bool stream_subsample = count_only_graph || (counting_memory <= 0.0);
+				// joins the writer and removes the pipe also if kmer counting fails
+				unique_ptr<SubsamplePipe> subsample_pipe;
+				if (max_coverage > 0.0) {
+					ReadSubsampler subsampler (readfile, variant_reader.get_genome_size());
+					cerr << "Estimated read coverage: " << subsampler.get_estimated_coverage() << endl;
+					if (subsampler.get_fraction(max_coverage) < 1.0) {
+						count_file = (nr_samples > 1) ? outname + "_" + sample_names[s] + "_subsampled_reads.fa" : outname + "_subsampled_reads.fa";
+						if (stream_subsample) {
+							cerr << "Subsample reads to coverage " << max_coverage << " and pass them to kmer counting through named pipe: " << count_file << " ..." << endl;
+							subsample_pipe.reset(new SubsamplePipe(subsampler, max_coverage, count_file));
+						} else {
+							cerr << "Subsample reads to coverage " << max_coverage << " and write them to file: " << count_file << " ..." << endl;
+							effective_coverages[s] = subsampler.write_subsample(max_coverage, count_file);
+						}
+					} else {
+						effective_coverages[s] = subsampler.get_estimated_coverage();
+					}
+				}
+				cerr << "Count kmers in reads ..." << endl;
+				if (count_only_graph) {
+					read_kmer_counts = new JellyfishCounter(count_file, segment_file, kmersize, nr_jellyfish_threads, hash_size, combined_counts);
+				} else if (counting_memory > 0.0) {
+					string bucket_prefix = (nr_samples > 1) ? outname + "_" + sample_names[s] + "_kmerbuckets" : outname + "_kmerbuckets";
+					read_kmer_counts = new BucketKmerCounter(count_file, kmersize, bucket_prefix, (uint64_t) (counting_memory * 1e9), nr_jellyfish_threads);
+				} else {
+					read_kmer_counts = new JellyfishCounter(count_file, kmersize, nr_jellyfish_threads, hash_size);
+				}
+				if (subsample_pipe) {
+					effective_coverages[s] = subsample_pipe->finish();
+					subsample_pipe.reset();
+				}
+				if (count_file != readfile) remove(count_file.c_str());
+			}
 
-		// TODO: only for analysis
-		struct rusage r_usage1;
-		getrusage(RUSAGE_SELF, &r_usage1);
-		cerr << "#### Memory usage until now: " << (r_usage1.ru_maxrss / 1E6) << " GB ####" << endl;
+			string histogram_file = (nr_samples > 1) ? outname + "_" + sample_names[s] + "_histogram.histo" : outname + "_histogram.histo";
+			size_t kmer_abundance_peak = read_kmer_counts->computeHistogram(10000, count_only_graph, histogram_file);
+			cerr << "Computed kmer abundance peak: " << kmer_abundance_peak << endl;
+			abundance_peaks[s] = kmer_abundance_peak;
+
+			// replace random hash lookups by a merge of the sorted queries with sorted counts
+			string dump_file = "";
+			if (sorted_queries) {
+				JellyfishCounter* jellyfish_counts = dynamic_cast<JellyfishCounter*>(read_kmer_counts);
+				if (jellyfish_counts != nullptr) {
+					dump_file = (nr_samples > 1) ? outname + "_" + sample_names[s] + "_kmers.sorted" : outname + "_kmers.sorted";
+					cerr << "Write sorted kmer counts to file: " << dump_file << " ..." << endl;
+					jellyfish_counts->write_sorted_dump(dump_file);
+					delete read_kmer_counts;
+					read_kmer_counts = new SortedKmerCounter(dump_file, kmersize);
+				}
+			}
+			// pre-computed counts written by the count step can only be looked up in batch
+			bool counts_dump = (dynamic_cast<SortedKmerCounter*>(read_kmer_counts) != nullptr);
+			vector<jellyfish::mer_dna> query_kmers;
+			if ((sorted_queries || counts_dump || (step == "count")) && (kmersize <= 31)) {
+				collect_query_kmers(chromosomes, genomic_kmer_counts, read_kmer_counts, &variant_reader, kmer_abundance_peak, query_kmers);
+			}
+			if ((sorted_queries || counts_dump) && read_kmer_counts->resolvesQueriesInBatch()) {
+				cerr << "Resolve kmer queries ..." << endl;
+				read_kmer_counts->resolveQueries(query_kmers);
+			}
 
-		// prepare output files
-		if (! only_phasing) variant_reader.open_genotyping_outfile(outname + "_genotyping.vcf");
-		if (! only_genotyping) variant_reader.open_phasing_outfile(outname + "_phasing.vcf");
+			if (step == "count") {
+				string counts_file = (nr_samples > 1) ? outname + "_" + sample_names[s] + "_counts.sorted" : outname + "_counts.sorted";
+				cerr << "Write kmer counts needed for genotyping to file: " << counts_file << " ..." << endl;
+				SortedKmerCounter::write_query_dump(genomic_kmer_counts, read_kmer_counts, query_kmers, kmersize, kmer_abundance_peak, chromosome_names, counts_file);
+				delete read_kmer_counts;
+				read_kmer_counts = nullptr;
+				if (!dump_file.empty()) remove(dump_file.c_str());
+				time_kmer_counting += timer.get_interval_time();
+				continue;
+			}
 
-		time_kmer_counting = timer.get_interval_time();
+			// TODO: only for analysis
+			struct rusage r_usage1;
+			getrusage(RUSAGE_SELF, &r_usage1);
+			cerr << "#### Memory usage until now: " << (r_usage1.ru_maxrss / 1E6) << " GB ####" << endl;
 
-		cerr << "Determine unique kmers ..." << endl;
-		// determine number of cores to use
-		size_t available_threads_uk = min(thread::hardware_concurrency(), (unsigned int) chromosomes.size());
-		size_t nr_cores_uk = min(nr_core_threads, available_threads_uk);
-		if (nr_cores_uk < nr_core_threads) {
-			cerr << "Warning: using " << nr_cores_uk << " for determining unique kmers." << endl;
-		}
+			time_kmer_counting += timer.get_interval_time();
 
-		// precompute probabilities
-		probabilities = ProbabilityTable(kmer_abundance_peak / 4, kmer_abundance_peak*4, 2*kmer_abundance_peak, regularization);
+			cerr << "Determine unique kmers ..." << endl;
+			// determine number of cores to use
+			size_t available_threads_uk = min(thread::hardware_concurrency(), (unsigned int) chromosomes.size());
+			size_t nr_cores_uk = min(nr_core_threads, available_threads_uk);
+			if (nr_cores_uk < nr_core_threads) {
+				cerr << "Warning: using " << nr_cores_uk << " for determining unique kmers." << endl;
+			}
 
-		{
-			// create thread pool with at most nr_chromosomes threads
-			ThreadPool threadPool (nr_cores_uk);
-			for (auto chromosome : chromosomes) {
-				VariantReader* variants = &variant_reader;
-				UniqueKmersMap* result = &unique_kmers_list;
-				KmerCounter* genomic_counts = &genomic_kmer_counts;
-				ProbabilityTable* probs = &probabilities;
-				function<void()> f_unique_kmers = bind(prepare_unique_kmers, chromosome, genomic_counts, read_kmer_counts, variants, probs, result, kmer_abundance_peak);
-				threadPool.submit(f_unique_kmers);
+			// precompute probabilities
+			probabilities[s] = ProbabilityTable(kmer_abundance_peak / 4, kmer_abundance_peak*4, 2*kmer_abundance_peak, regularization);
+
+			{
+				// create thread pool with at most nr_chromosomes threads
+				ThreadPool threadPool (nr_cores_uk);
+				for (auto chromosome : chromosomes) {
+					VariantReader* variants = &variant_reader;
+					UniqueKmersMap* result = &unique_kmers_list[s];
+					KmerCounter* genomic_counts = genomic_kmer_counts;
+					ProbabilityTable* probs = &probabilities[s];
+					function<void()> f_unique_kmers = bind(prepare_unique_kmers, chromosome, genomic_counts, read_kmer_counts, variants, probs, result, kmer_abundance_peak, release_sequences);
+					threadPool.submit(f_unique_kmers);
+				}
 			}
-		}
 
-		// TODO: only for analysis
-		struct rusage r_usage2;
-		getrusage(RUSAGE_SELF, &r_usage2);
-		cerr << "#### Memory usage until now: " << (r_usage2.ru_maxrss / 1E6) << " GB ####" << endl;
+			// TODO: only for analysis
+			struct rusage r_usage2;
+			getrusage(RUSAGE_SELF, &r_usage2);
+			cerr << "#### Memory usage until now: " << (r_usage2.ru_maxrss / 1E6) << " GB ####" << endl;
+			// kmer counts, unique kmers and probabilities are all allocated at this point
+			HugePages::sample();
+
+			delete read_kmer_counts;
+			read_kmer_counts = nullptr;
+			if (!dump_file.empty()) remove(dump_file.c_str());
+			time_unique_kmers += timer.get_interval_time();
+		}
+		delete genomic_kmer_counts;
+		delete allele_kmer_counts;
+	}
 
-		delete read_kmer_counts;
-		read_kmer_counts = nullptr;
-		time_unique_kmers = timer.get_interval_time();
+	if (step == "count") {
+		cerr << endl << "###### Summary ######" << endl;
+		cerr << "time spent reading input files:\t" << time_preprocessing << " sec" << endl;
+		cerr << "time spent counting kmers: \t" << time_kmer_counting << " sec" << endl;
+		cerr << "total wallclock time: " << timer.get_total_time() << " sec" << endl;
+		for (size_t s = 0; s < nr_samples; ++s) {
+			cerr << "kmer abundance peak of sample " << sample_names[s] << ":\t" << abundance_peaks[s] << endl;
+			if (effective_coverages[s] > 0.0) cerr << "effective read coverage of sample " << sample_names[s] << ":\t" << effective_coverages[s] << endl;
+		}
+		print_huge_page_statistics();
+		return 0;
 	}
 
 	// TODO: only for analysis
@@ -315,86 +673,137 @@ int main (int argc, char* argv[])
 	getrusage(RUSAGE_SELF, &r_usage3);
 	cerr << "#### Memory usage until now: " << (r_usage3.ru_maxrss / 1E6) << " GB ####" << endl;
 
-	// prepare subsets of paths to run on
-	unsigned short nr_paths = variant_reader.nr_of_paths();
-	// TODO: for too large panels, print waring
-	if (nr_paths > 200) cerr << "Warning: panel is large and PanGenie might take a long time genotyping. Try reducing the panel size prior to genotyping." << endl;
-	// handle case when sampling_size is not set
-	if (sampling_size == 0) {
-		if (nr_paths > 25) {
-			sampling_size = 14;
-		} else {
-			sampling_size = nr_paths;		
-		}
+	vector<Results> results(nr_samples);
+	for (auto& sample_results : results) {
+		sample_results.result.resize(nr_contigs);
+		sample_results.runtimes.assign(nr_contigs, 0.0);
 	}
 
-	PathSampler path_sampler(nr_paths);
-	vector<vector<unsigned short>> subsets;
-	path_sampler.partition_samples(subsets, sampling_size);
+	if (fast_mode) {
+		cerr << "Compute genotype likelihoods of each variant (fast mode) ..." << endl;
+		time_path_sampling = timer.get_interval_time();
+		size_t available_threads = thread::hardware_concurrency();
+		if (nr_core_threads > available_threads) {
+			cerr << "Warning: using " << available_threads << " for genotyping." << endl;
+			nr_core_threads = available_threads;
+		}
+		// allele frequencies used as genotype priors
+		vector<vector<vector<float>>> allele_frequencies(nr_contigs);
+		for (auto chromosome : chromosomes) {
+			variant_reader.get_allele_frequencies(chromosome, allele_frequencies[chromosome]);
+			for (size_t s = 0; s < nr_samples; ++s) {
+				results[s].result[chromosome].resize(unique_kmers_list[s].unique_kmers[chromosome].size());
+			}
+		}
+		{
+			// variants are genotyped independently, distribute blocks of variants across threads
+			ThreadPool threadPool (nr_core_threads);
+			for (size_t s = 0; s < nr_samples; ++s) {
+				for (auto chromosome : chromosomes) {
+					size_t nr_variants = unique_kmers_list[s].unique_kmers[chromosome].size();
+					for (size_t start = 0; start < nr_variants; start += fast_block_size) {
+						size_t end = min(start + fast_block_size, nr_variants);
+						vector<UniqueKmers*>* unique_kmers = &unique_kmers_list[s].unique_kmers[chromosome];
+						vector<vector<float>>* frequencies = &allele_frequencies[chromosome];
+						ProbabilityTable* probs = &probabilities[s];
+						Results* r = &results[s];
+						function<void()> f_genotyping = bind(run_fast_genotyping, chromosome, start, end, unique_kmers, probs, frequencies, r);
+						threadPool.submit(f_genotyping);
+					}
+				}
+			}
+		}
+	} else {
+		// prepare subsets of paths to run on
+		unsigned short nr_paths = variant_reader.nr_of_paths();
+		// TODO: for too large panels, print waring
+		if (nr_paths > 200) cerr << "Warning: panel is large and PanGenie might take a long time genotyping. Try reducing the panel size prior to genotyping." << endl;
+		// handle case when sampling_size is not set
+		if (sampling_size == 0) {
+			if (nr_paths > 25) {
+				sampling_size = 14;
+			} else {
+				sampling_size = nr_paths;		
+			}
+		}
+
+		PathSampler path_sampler(nr_paths);
+		vector<vector<unsigned short>> subsets;
+		path_sampler.partition_samples(subsets, sampling_size);
 
-	for (auto s : subsets) {
-		for (auto b : s) {
-			cout << b << endl;
+		for (auto s : subsets) {
+			for (auto b : s) {
+				cout << b << endl;
+			}
+			cout << "-----" << endl;
 		}
-		cout << "-----" << endl;
-	}
 
-	if (!only_phasing) cerr << "Sampled " << subsets.size() << " subset(s) of paths each of size " << sampling_size << " for genotyping." << endl;
+		if (!only_phasing) cerr << "Sampled " << subsets.size() << " subset(s) of paths each of size " << sampling_size << " for genotyping." << endl;
 
-	// for now, run phasing only once on largest set of paths that can still be handled.
-	// in order to use all paths, an iterative stradegie should be considered
-	vector<unsigned short> phasing_paths;
-	unsigned short nr_phasing_paths = min((unsigned short) nr_paths, (unsigned short) 30);
-	path_sampler.select_single_subset(phasing_paths, nr_phasing_paths);
-	if (!only_genotyping) cerr << "Sampled " << phasing_paths.size() << " paths to be used for phasing." << endl;
-	time_path_sampling = timer.get_interval_time();
+		// for now, run phasing only once on largest set of paths that can still be handled.
+		// in order to use all paths, an iterative stradegie should be considered
+		vector<unsigned short> phasing_paths;
+		unsigned short nr_phasing_paths = min((unsigned short) nr_paths, (unsigned short) 30);
+		path_sampler.select_single_subset(phasing_paths, nr_phasing_paths);
+		if (!only_genotyping) cerr << "Sampled " << phasing_paths.size() << " paths to be used for phasing." << endl;
+		time_path_sampling = timer.get_interval_time();
 	
-	// TODO: only for analysis
-	struct rusage r_usage30;
-	getrusage(RUSAGE_SELF, &r_usage30);
-	cerr << "#### Memory usage until now: " << (r_usage30.ru_maxrss / 1E6) << " GB ####" << endl;
-
-	cerr << "Construct HMM and run core algorithm ..." << endl;
+		// TODO: only for analysis
+		struct rusage r_usage30;
+		getrusage(RUSAGE_SELF, &r_usage30);
+		cerr << "#### Memory usage until now: " << (r_usage30.ru_maxrss / 1E6) << " GB ####" << endl;
 
-	// determine max number of available threads for genotyping (at most one thread per chromosome and subsample possible)
-	size_t available_threads = min(thread::hardware_concurrency(), (unsigned int) chromosomes.size() * (unsigned int) subsets.size());
-	if (nr_core_threads > available_threads) {
-		cerr << "Warning: using " << available_threads << " for genotyping." << endl;
-		nr_core_threads = available_threads;
-	}
+		cerr << "Construct HMM and run core algorithm ..." << endl;
 
-	// run genotyping
-	Results results;
-	{
-		// create thread pool
-		ThreadPool threadPool (nr_core_threads);
-		for (auto chromosome : chromosomes) {
-			vector<UniqueKmers*>* unique_kmers = &unique_kmers_list.unique_kmers[chromosome];
-			ProbabilityTable* probs = &probabilities;
-			Results* r = &results;
-			// if requested, run phasing first
-			if (!only_genotyping) {
-				vector<unsigned short>* only_paths = &phasing_paths;
-				function<void()> f_genotyping = bind(run_genotyping, chromosome, unique_kmers, probs, false, true, effective_N, only_paths, r);
-				threadPool.submit(f_genotyping);
-			}
+		// determine max number of available threads for genotyping (at most one thread per sample, chromosome and subsample possible)
+		size_t available_threads = min(thread::hardware_concurrency(), (unsigned int) (nr_samples * chromosomes.size() * subsets.size()));
+		if (nr_core_threads > available_threads) {
+			cerr << "Warning: using " << available_threads << " for genotyping." << endl;
+			nr_core_threads = available_threads;
+		}
 
-			if (!only_phasing) {
-				// if requested, run genotying
-				for (size_t s = 0; s < subsets.size(); ++s){
-					vector<unsigned short>* only_paths = &subsets[s];
-					function<void()> f_genotyping = bind(run_genotyping, chromosome, unique_kmers, probs, true, false, effective_N, only_paths, r);
-					threadPool.submit(f_genotyping);
+		// run genotyping
+		{
+			// create thread pool
+			ThreadPool threadPool (nr_core_threads);
+			for (size_t sample = 0; sample < nr_samples; ++sample) {
+				for (auto chromosome : chromosomes) {
+					vector<UniqueKmers*>* unique_kmers = &unique_kmers_list[sample].unique_kmers[chromosome];
+					ProbabilityTable* probs = &probabilities[sample];
+					Results* r = &results[sample];
+					// if requested, run phasing first
+					if (!only_genotyping) {
+						vector<unsigned short>* only_paths = &phasing_paths;
+						function<void()> f_genotyping = bind(run_genotyping, chromosome, unique_kmers, probs, false, true, effective_N, only_paths, spill_directory, compression, r);
+						threadPool.submit(f_genotyping);
+					}
+
+					if (!only_phasing) {
+						// if requested, run genotying
+						for (size_t s = 0; s < subsets.size(); ++s){
+							vector<unsigned short>* only_paths = &subsets[s];
+							function<void()> f_genotyping = bind(run_genotyping, chromosome, unique_kmers, probs, true, false, effective_N, only_paths, spill_directory, compression, r);
+							threadPool.submit(f_genotyping);
+						}
+					}
 				}
 			}
 		}
-	}
+		for (auto& sample_results : results) {
+			if (!sample_results.error.empty()) {
+				cerr << "Error: genotyping failed: " << sample_results.error << endl;
+				return 1;
+			}
+		}
 
-	// in case genotyping was run, normalize the combined likelihoods
-	if (!only_phasing){
-		for (auto chromosome : chromosomes) {
-			for (size_t i = 0; i < results.result.at(chromosome).size(); ++i) {
-				results.result.at(chromosome).at(i).normalize();
+		// in case genotyping was run, normalize the combined likelihoods
+		if (!only_phasing){
+			for (auto& sample_results : results) {
+				for (auto chromosome : chromosomes) {
+					for (size_t i = 0; i < sample_results.result.at(chromosome).size(); ++i) {
+						sample_results.result.at(chromosome).at(i).normalize();
+					}
+				}
 			}
 		}
 	}
@@ -403,22 +812,62 @@ int main (int argc, char* argv[])
 
 	// output VCF
 	cerr << "Write results to VCF ..." << endl;
-	if (!(only_genotyping && only_phasing)) assert (results.result.size() == chromosomes.size());
+	// write chromosomes in lexicographical order of their names
+	vector<size_t> output_order = chromosomes;
+	sort(output_order.begin(), output_order.end(), [&](size_t a, size_t b) { return variant_reader.get_contig_name(a) < variant_reader.get_contig_name(b); });
 	// write VCF
-	for (auto it = results.result.begin(); it != results.result.end(); ++it) {
-		if (!only_phasing) {
-			// output genotyping results
-			
-			variant_reader.write_genotypes_of(it->first, it->second, &unique_kmers_list.unique_kmers[it->first], ignore_imputed);
+	for (auto contig_id : output_order) {
+		if (nr_samples > 1) {
+			// output genotyping results of all samples
+			vector<const vector<GenotypingResult>*> sample_results;
+			vector<vector<UniqueKmers*>*> sample_kmers;
+			for (size_t s = 0; s < nr_samples; ++s) {
+				sample_results.push_back(&results[s].result[contig_id]);
+				sample_kmers.push_back(&unique_kmers_list[s].unique_kmers[contig_id]);
+			}
+			variant_reader.write_multisample_genotypes_of(contig_id, sample_results, sample_kmers, ignore_imputed, nr_core_threads);
+		} else {
+			if (!only_phasing && binary_output) {
+				// output genotyping results in binary format
+				variant_reader.write_binary_genotypes_of(contig_id, results[0].result[contig_id], &unique_kmers_list[0].unique_kmers[contig_id], ignore_imputed);
+			} else if (!only_phasing) {
+				// output genotyping results
+				variant_reader.write_genotypes_of(contig_id, results[0].result[contig_id], &unique_kmers_list[0].unique_kmers[contig_id], ignore_imputed, nr_core_threads);
+			}
+			if (!only_genotyping) {
+				// output phasing results
+				variant_reader.write_phasing_of(contig_id, results[0].result[contig_id], &unique_kmers_list[0].unique_kmers[contig_id], ignore_imputed);
+			}
 		}
-		if (!only_genotyping) {
-			// output phasing results
-			variant_reader.write_phasing_of(it->first, it->second, &unique_kmers_list.unique_kmers[it->first], ignore_imputed);
+		// destroy the UniqueKmers of this chromosome
+		for (auto& sample_kmers : unique_kmers_list) {
+			sample_kmers.unique_kmers[contig_id].clear();
+			sample_kmers.arenas[contig_id].reset();
 		}
 	}
 
-	if (! only_phasing) variant_reader.close_genotyping_outfile();
-	if (! only_genotyping) variant_reader.close_phasing_outfile();
+	if (nr_samples > 1) {
+		variant_reader.close_multisample_genotyping_outfile();
+	} else {
+		if (! only_phasing && binary_output) variant_reader.close_binary_genotyping_outfile();
+		if (! only_phasing && ! binary_output) variant_reader.close_genotyping_outfile();
+		if (! only_phasing && ! biallelic_panel.empty()) variant_reader.close_biallelic_outfile();
+		if (! only_genotyping) variant_reader.close_phasing_outfile();
+	}
+
+	if (step == "genotype") {
+		vector<ShardMetrics> metrics;
+		for (auto chromosome : output_order) {
+			ShardMetrics m = {variant_reader.get_contig_name(chromosome), variant_reader.variants(chromosome).size(), 0.0, 0.0};
+			for (size_t s = 0; s < nr_samples; ++s) {
+				m.time_unique_kmers += unique_kmers_list[s].runtimes[chromosome];
+				m.time_genotyping += results[s].runtimes[chromosome];
+			}
+			metrics.push_back(m);
+		}
+		cerr << "Write metrics to file: " << outname + "_metrics.tsv" << endl;
+		ShardMerger::write_metrics(metrics, outname + "_metrics.tsv");
+	}
 
 	time_writing = timer.get_interval_time();
 	time_total = timer.get_total_time();
@@ -432,25 +881,26 @@ int main (int argc, char* argv[])
 	// output per chromosome time
 	double time_hmm = time_writing;
 	for (auto chromosome : chromosomes) {
-		double time_chrom = results.runtimes[chromosome] + unique_kmers_list.runtimes[chromosome];
-		cerr << "time spent genotyping chromosome " << chromosome << ":\t" << time_chrom << endl;
+		double time_chrom = 0.0;
+		for (size_t s = 0; s < nr_samples; ++s) {
+			time_chrom += results[s].runtimes[chromosome] + unique_kmers_list[s].runtimes[chromosome];
+		}
+		cerr << "time spent genotyping chromosome " << variant_reader.get_contig_name(chromosome) << ":\t" << time_chrom << endl;
 		time_hmm += time_chrom;
 	}
 	cerr << "total running time:\t" << time_preprocessing + time_kmer_counting + time_path_sampling + time_unique_kmers +  time_hmm + time_writing << " sec"<< endl;
 	cerr << "total wallclock time: " << time_total  << " sec" << endl;
+	// coverage used for genotyping
+	for (size_t s = 0; s < nr_samples; ++s) {
+		cerr << "kmer abundance peak of sample " << sample_names[s] << ":\t" << abundance_peaks[s] << endl;
+		if (effective_coverages[s] > 0.0) cerr << "effective read coverage of sample " << sample_names[s] << ":\t" << effective_coverages[s] << endl;
+	}
 
 	// memory usage
 	struct rusage r_usage;
 	getrusage(RUSAGE_SELF, &r_usage);
 	cerr << "Total maximum memory usage: " << (r_usage.ru_maxrss / 1E6) << " GB" << endl;
-
-	// destroy UniqueKmers
-	for (auto it = unique_kmers_list.unique_kmers.begin(); it != unique_kmers_list.unique_kmers.end(); ++it){
-		for (size_t i = 0; i < it->second.size(); ++i) {
-			delete it->second[i];
-			it->second[i] = nullptr;
-		}
-	}
+	print_huge_page_statistics();
 
 	return 0;
 }
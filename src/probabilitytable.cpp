@@ -32,21 +32,19 @@ ProbabilityTable::ProbabilityTable(unsigned short cov_min, unsigned short cov_ma
 	 regularization_const(regularization_const)
 {
 	// initialize table
-	for (unsigned short i = 0; i < count_max; ++i) {
-		this->probabilities.push_back(vector<CopyNumber>(cov_max-cov_min));
-	}
-
+	size_t row_size = (cov_max > cov_min) ? cov_max - cov_min : 0;
+	this->probabilities.reserve(count_max * row_size);
 	for (unsigned short i = 0; i < this->count_max; ++i) {
 		// precompute probabilities for each read kmer count
 		for (unsigned short j = 0; (j + this->cov_min) < this->cov_max; ++j) {
-			this->probabilities[i][j] = compute_probability(j + this->cov_min, i);
+			this->probabilities.push_back(compute_probability(j + this->cov_min, i));
 		}
 	}
 }
 
 CopyNumber ProbabilityTable::get_probability (unsigned short kmer_coverage, unsigned short read_kmer_count) const {
 	if ((kmer_coverage >= this->cov_min) && (kmer_coverage < this->cov_max) && (read_kmer_count < this->count_max)) {
-		return this->probabilities.at(read_kmer_count).at(kmer_coverage - this->cov_min);
+		return this->probabilities[read_kmer_count * (this->cov_max - this->cov_min) + kmer_coverage - this->cov_min];
 	} else {
 		return compute_probability(kmer_coverage, read_kmer_count);
 	}
@@ -66,7 +64,7 @@ CopyNumber ProbabilityTable::compute_probability(unsigned short kmer_coverage, u
 
 void ProbabilityTable::modify_probability(unsigned short kmer_coverage, unsigned short read_kmer_count, CopyNumber prob) {
 	if ((kmer_coverage >= this->cov_min) && (kmer_coverage < this->cov_max) && (read_kmer_count < this->count_max)) {
-		this->probabilities[read_kmer_count][kmer_coverage - this->cov_min] = prob;
+		this->probabilities[read_kmer_count * (this->cov_max - this->cov_min) + kmer_coverage - this->cov_min] = prob;
 	} else {
 		throw runtime_error("ProbabilityTable::modify_probability: no precomputed values for these parameters.");
 	}
@@ -94,10 +92,11 @@ ostream& operator<<(ostream& os, const ProbabilityTable& var) {
 	for (unsigned short i = 0; i < var.count_max; ++i) {
 		os << i << "\t";
 		for (unsigned short j = 0; (j + var.cov_min) < var.cov_max; ++j) {
+			const CopyNumber& cn = var.probabilities.at(i * (var.cov_max - var.cov_min) + j);
 			if (j > 0) os << "\t";
-			os << var.probabilities.at(i).at(j).get_probability_of(0) << "\t";
-			os << var.probabilities.at(i).at(j).get_probability_of(1) << "\t";
-			os << var.probabilities.at(i).at(j).get_probability_of(2);
+			os << cn.get_probability_of(0) << "\t";
+			os << cn.get_probability_of(1) << "\t";
+			os << cn.get_probability_of(2);
 		}
 		os << "\n";
 	}
@@ -3,6 +3,7 @@
 
 #include <vector>
 #include "copynumber.hpp"
+#include "hugepages.hpp"
 #include <iostream>
 
 /** 
@@ -22,7 +23,8 @@ private:
 	unsigned short cov_max;
 	unsigned short count_max;
 	long double regularization_const;
-	std::vector<std::vector<CopyNumber>> probabilities;
+	// probabilities of read kmer count i and kmer coverage cov_min + j at index i*(cov_max-cov_min) + j
+	HugePageVector<CopyNumber> probabilities;
 	long double poisson(long double mean, unsigned int value) const;
 	long double geometric(long double p, unsigned int value) const;
 	CopyNumber compute_probability (unsigned short kmer_coverage, unsigned short read_kmer_count) const;
@@ -0,0 +1,211 @@
+#include <stdexcept>
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <cstring>
+#include <cctype>
+#include "readparser.hpp"
+#include "mpmcqueue.hpp"
+#include "directfilereader.hpp"
+
+using namespace std;
+
+// position of the next newline at or after pos (or length if there is none)
+static size_t line_end(const char* data, size_t pos, size_t length) {
+	const char* newline = (const char*) memchr(data + pos, '\n', length - pos);
+	return (newline == nullptr) ? length : newline - data;
+}
+
+// length of a line without a trailing carriage return
+static size_t trimmed_length(const char* data, size_t start, size_t end) {
+	if ((end > start) && (data[end-1] == '\r')) return end - start - 1;
+	return end - start;
+}
+
+void ReadBatch::locate_sequences(bool fastq) {
+	this->sequences.clear();
+	char* d = this->data.data();
+	size_t pos = 0;
+	while (pos < this->size) {
+		// skip empty lines
+		if ((d[pos] == '\n') || (d[pos] == '\r')) {
+			pos += 1;
+			continue;
+		}
+		size_t start = min(line_end(d, pos, this->size) + 1, this->size);
+		if (fastq) {
+			// header, sequence, separator and quality line
+			size_t end = line_end(d, start, this->size);
+			this->sequences.push_back(make_pair(start, trimmed_length(d, start, end)));
+			pos = min(end + 1, this->size);
+			pos = min(line_end(d, pos, this->size) + 1, this->size);
+			pos = min(line_end(d, pos, this->size) + 1, this->size);
+		} else {
+			// join the sequence lines up to the next header
+			size_t written = start;
+			pos = start;
+			while ((pos < this->size) && (d[pos] != '>')) {
+				size_t end = line_end(d, pos, this->size);
+				size_t length = trimmed_length(d, pos, end);
+				if (written != pos) memmove(d + written, d + pos, length);
+				written += length;
+				pos = min(end + 1, this->size);
+			}
+			this->sequences.push_back(make_pair(start, written - start));
+		}
+	}
+}
+
+size_t ReadBatch::nr_of_reads() const {
+	return this->sequences.size();
+}
+
+const char* ReadBatch::get_sequence(size_t index, size_t& length) const {
+	length = this->sequences.at(index).second;
+	return this->data.data() + this->sequences[index].first;
+}
+
+ReadParser::ReadParser(string filename, size_t batch_size)
+	:filename(filename),
+	 batch_size(max(batch_size, (size_t) 64)),
+	 nr_bytes(0)
+{}
+
+size_t ReadParser::last_record_end(const char* data, size_t length, bool fastq) {
+	if (fastq) {
+		// the last record starts with the last line beginning with '@', whose second next line starts with '+'
+		// (the line after a quality line starting with '@' is a header, followed by a sequence line)
+		size_t pos = length;
+		while (pos > 0) {
+			const char* header = (const char*) memrchr(data, '@', pos);
+			if (header == nullptr) return 0;
+			pos = header - data;
+			if ((pos > 0) && (data[pos-1] != '\n')) continue;
+			size_t sequence_end = line_end(data, pos, length);
+			if (sequence_end == length) continue;
+			sequence_end = line_end(data, sequence_end + 1, length);
+			if ((sequence_end + 1 < length) && (data[sequence_end + 1] == '+')) return pos;
+		}
+		return 0;
+	}
+	// a FASTA record ends where the last header line starts
+	size_t pos = length;
+	while (pos > 0) {
+		const char* header = (const char*) memrchr(data, '>', pos);
+		if (header == nullptr) return 0;
+		pos = header - data;
+		if ((pos > 0) && (data[pos-1] == '\n')) return pos;
+	}
+	return 0;
+}
+
+void ReadParser::parse(size_t nr_threads, BatchFunction process) {
+	nr_threads = max(nr_threads, (size_t) 1);
+	this->nr_bytes = 0;
+
+	// blocks are read ahead of the parser, bypassing the page cache
+	DirectFileReader reader(this->filename);
+	if (!reader.is_open()) {
+		throw runtime_error("ReadParser::parse: read file " + this->filename + " cannot be opened.");
+	}
+	// determine the file format from the first character. The bytes read are kept for the first
+	// batch, since pipes cannot be read twice.
+	vector<char> carry;
+	char first = 0;
+	while (reader.read(&first, 1) == 1) {
+		carry.push_back(first);
+		this->nr_bytes += 1;
+		if (!isspace(first)) break;
+	}
+	if (carry.empty() || isspace(first)) return;
+	if ((first != '>') && (first != '@')) {
+		throw runtime_error("ReadParser::parse: " + this->filename + " is not in FASTA or FASTQ format.");
+	}
+	bool fastq = (first == '@');
+
+	// batches circulate between the reader and the worker threads
+	size_t nr_batches = 2 * nr_threads + 2;
+	vector<ReadBatch> batches(nr_batches);
+	MPMCQueue<ReadBatch*> free_batches(nr_batches);
+	MPMCQueue<ReadBatch*> full_batches(nr_batches);
+	for (auto& batch : batches) {
+		batch.data.resize(2 * this->batch_size);
+		batch.size = 0;
+		free_batches.push(&batch);
+	}
+
+	exception_ptr worker_exception = nullptr;
+	atomic<bool> failed(false);
+	vector<thread> workers;
+	for (size_t t = 0; t < nr_threads; ++t) {
+		workers.push_back(thread([&, t]() {
+			ReadBatch* batch;
+			while (full_batches.pop(batch)) {
+				if (!failed.load(memory_order_relaxed)) {
+					try {
+						batch->locate_sequences(fastq);
+						process(*batch, t);
+					} catch (...) {
+						if (!failed.exchange(true)) worker_exception = current_exception();
+					}
+				}
+				free_batches.push(batch);
+			}
+		}));
+	}
+
+	// read blocks of batch_size bytes and cut them at record boundaries. The incomplete
+	// record at the end of a block is carried over to the next batch.
+	bool end_of_file = false;
+	string error = "";
+	while (!end_of_file && !failed.load(memory_order_relaxed)) {
+		ReadBatch* batch;
+		free_batches.pop(batch);
+		if (batch->data.size() < carry.size() + this->batch_size) batch->data.resize(carry.size() + this->batch_size);
+		memcpy(batch->data.data(), carry.data(), carry.size());
+		size_t filled = carry.size();
+		size_t target = carry.size() + this->batch_size;
+		size_t end = 0;
+		for (;;) {
+			while (filled < target) {
+				size_t n = 0;
+				try {
+					n = reader.read(batch->data.data() + filled, target - filled);
+				} catch (const runtime_error& e) {
+					error = "ReadParser::parse: error while reading " + this->filename + ": " + e.what();
+					end_of_file = true;
+					break;
+				}
+				if (n == 0) {
+					end_of_file = true;
+					break;
+				}
+				filled += n;
+				this->nr_bytes += n;
+			}
+			end = end_of_file ? filled : last_record_end(batch->data.data(), filled, fastq);
+			if ((end > 0) || end_of_file) break;
+			// a single record does not fit into the batch
+			target = 2 * batch->data.size();
+			batch->data.resize(target);
+		}
+		carry.assign(batch->data.begin() + end, batch->data.begin() + filled);
+		batch->size = end;
+		if (end > 0) {
+			full_batches.push(batch);
+		} else {
+			free_batches.push(batch);
+		}
+	}
+	full_batches.close();
+	for (auto& worker : workers) {
+		worker.join();
+	}
+	if (worker_exception) rethrow_exception(worker_exception);
+	if (!error.empty()) throw runtime_error(error);
+}
+
+uint64_t ReadParser::bytes_read() const {
+	return this->nr_bytes;
+}
@@ -0,0 +1,57 @@
+#ifndef READPARSER_HPP
+#define READPARSER_HPP
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <utility>
+#include <cstdint>
+
+/**
+* Batch of complete FASTA/FASTQ records. The buffers of a batch are reused for subsequent batches,
+* so that no memory is allocated per read.
+**/
+
+struct ReadBatch {
+	// raw records (only the first size bytes are valid)
+	std::vector<char> data;
+	size_t size;
+	// (start, length) of each read sequence in data
+	std::vector<std::pair<size_t,size_t>> sequences;
+	/** locate the read sequences. Lines of multi-line FASTA sequences are joined in place. **/
+	void locate_sequences(bool fastq);
+	size_t nr_of_reads() const;
+	/** pointer to the sequence of the given read **/
+	const char* get_sequence(size_t index, size_t& length) const;
+};
+
+/**
+* Parses uncompressed FASTA/FASTQ files in parallel. One thread reads large blocks from disk and cuts them at
+* the last record boundary (found by searching backwards from the end of the block with memrchr). The resulting
+* batches are handed to the worker threads through a lock-free queue and are returned to the reader through a
+* second queue once processed. Threads waiting for a batch block instead of spinning.
+* FASTQ records must consist of exactly four lines.
+**/
+
+class ReadParser {
+public:
+	using BatchFunction = std::function<void(const ReadBatch&, size_t)>;
+	/**
+	* @param filename reads in FASTA or FASTQ format
+	* @param batch_size number of bytes read per batch (a batch is enlarged if a single record does not fit)
+	**/
+	ReadParser(std::string filename, size_t batch_size = 1 << 22);
+	/** parse the file and call process(batch, thread index) for each batch, using nr_threads worker threads **/
+	void parse(size_t nr_threads, BatchFunction process);
+	/** number of bytes read by the last call to parse **/
+	uint64_t bytes_read() const;
+
+private:
+	std::string filename;
+	size_t batch_size;
+	uint64_t nr_bytes;
+	/** end of the last complete record in the first length bytes of data **/
+	static size_t last_record_end(const char* data, size_t length, bool fastq);
+};
+
+#endif // READPARSER_HPP
@@ -0,0 +1,165 @@
+#include <fstream>
+#include <stdexcept>
+#include <algorithm>
+#include <chrono>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include "readsubsampler.hpp"
+
+using namespace std;
+
+// number of bytes read to estimate the fraction of sequence characters
+static const uint64_t estimation_bytes = 1 << 20;
+
+ReadSubsampler::ReadSubsampler(string readfile, uint64_t genome_size)
+	:readfile(readfile),
+	 genome_size(genome_size),
+	 estimated_bases(0.0)
+{
+	if (genome_size == 0) {
+		throw runtime_error("ReadSubsampler::ReadSubsampler: genome size must be larger than 0.");
+	}
+	struct stat file_stats;
+	ifstream file(readfile);
+	if ((stat(readfile.c_str(), &file_stats) != 0) || !file.good()) {
+		throw runtime_error("ReadSubsampler::ReadSubsampler: read file " + readfile + " cannot be opened.");
+	}
+	// determine the fraction of sequence characters in the first records
+	uint64_t bases = 0;
+	string line;
+	string sequence;
+	while (next_read(file, line, sequence)) {
+		bases += sequence.size();
+		if ((uint64_t) file.tellg() >= estimation_bytes) break;
+	}
+	streamoff consumed = file.eof() ? file_stats.st_size : (streamoff) file.tellg();
+	if (consumed > 0) {
+		this->estimated_bases = (double) bases / consumed * file_stats.st_size;
+	}
+}
+
+bool ReadSubsampler::next_read(ifstream& file, string& line, string& sequence) {
+	sequence.clear();
+	// line holds the header of the next record, if it was already read
+	if (line.empty() || ((line[0] != '>') && (line[0] != '@'))) {
+		while (getline(file, line) && (line.empty() || ((line[0] != '>') && (line[0] != '@'))));
+		if (line.empty() || ((line[0] != '>') && (line[0] != '@'))) return false;
+	}
+	if (line[0] == '@') {
+		// FASTQ: sequence, separator and quality line
+		getline(file, sequence);
+		string skip;
+		getline(file, skip);
+		getline(file, skip);
+		line.clear();
+		return true;
+	}
+	// FASTA: sequence may span several lines
+	line.clear();
+	while (getline(file, line)) {
+		if (!line.empty() && (line[0] == '>')) return true;
+		sequence += line;
+	}
+	line.clear();
+	return true;
+}
+
+double ReadSubsampler::get_estimated_coverage() const {
+	return this->estimated_bases / this->genome_size;
+}
+
+double ReadSubsampler::get_fraction(double max_coverage) const {
+	double coverage = get_estimated_coverage();
+	if ((max_coverage <= 0.0) || (coverage <= max_coverage)) return 1.0;
+	return max_coverage / coverage;
+}
+
+bool ReadSubsampler::keep_read(const string& sequence, double fraction) {
+	if (fraction >= 1.0) return true;
+	// FNV-1a followed by the finalizer of MurmurHash3
+	uint64_t hash = 14695981039346656037ULL;
+	for (char c : sequence) {
+		hash = (hash ^ (unsigned char) c) * 1099511628211ULL;
+	}
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+	return (hash >> 11) < (uint64_t) (fraction * (double) (1ULL << 53));
+}
+
+double ReadSubsampler::write_subsample(double max_coverage, string filename) const {
+	ifstream file(this->readfile);
+	if (!file.good()) {
+		throw runtime_error("ReadSubsampler::write_subsample: read file " + this->readfile + " cannot be opened.");
+	}
+	ofstream outfile(filename);
+	if (!outfile.good()) {
+		throw runtime_error("ReadSubsampler::write_subsample: file " + filename + " cannot be created. Note that the filename must not contain non-existing directories.");
+	}
+	double fraction = get_fraction(max_coverage);
+	uint64_t bases = 0;
+	uint64_t nr_reads = 0;
+	string line;
+	string sequence;
+	while (next_read(file, line, sequence)) {
+		if (!keep_read(sequence, fraction)) continue;
+		outfile << ">" << nr_reads << "\n" << sequence << "\n";
+		bases += sequence.size();
+		nr_reads += 1;
+	}
+	outfile.close();
+	if (outfile.fail()) {
+		throw runtime_error("ReadSubsampler::write_subsample: writing to file " + filename + " failed.");
+	}
+	return (double) bases / this->genome_size;
+}
+
+SubsamplePipe::SubsamplePipe(const ReadSubsampler& subsampler, double max_coverage, string filename)
+	:filename(filename),
+	 done(false),
+	 coverage(0.0),
+	 error(nullptr)
+{
+	remove(filename.c_str());
+	if (mkfifo(filename.c_str(), 0600) != 0) {
+		throw runtime_error("SubsamplePipe::SubsamplePipe: named pipe " + filename + " cannot be created. Note that the filename must not contain non-existing directories.");
+	}
+	// if the reader stops early, writing fails instead of killing the process
+	signal(SIGPIPE, SIG_IGN);
+	this->writer = thread([this, subsampler, max_coverage] () {
+		try {
+			this->coverage = subsampler.write_subsample(max_coverage, this->filename);
+		} catch (...) {
+			this->error = current_exception();
+			// let the reader reach the end of the pipe
+			ofstream unblock(this->filename);
+		}
+		this->done = true;
+	});
+}
+
+SubsamplePipe::~SubsamplePipe() {
+	if (this->writer.joinable()) drain();
+	remove(this->filename.c_str());
+}
+
+double SubsamplePipe::finish() {
+	drain();
+	if (this->error) rethrow_exception(this->error);
+	return this->coverage;
+}
+
+void SubsamplePipe::drain() {
+	// an open read end unblocks a writer waiting to open the pipe, non-blocking so that a finished writer does not block us
+	int read_end = open(this->filename.c_str(), O_RDONLY | O_NONBLOCK);
+	char buffer[65536];
+	while (!this->done) {
+		if ((read_end < 0) || (read(read_end, buffer, sizeof(buffer)) <= 0)) {
+			this_thread::sleep_for(chrono::milliseconds(1));
+		}
+	}
+	if (read_end >= 0) close(read_end);
+	this->writer.join();
+}
@@ -0,0 +1,68 @@
+#ifndef READSUBSAMPLER_HPP
+#define READSUBSAMPLER_HPP
+
+#include <string>
+#include <fstream>
+#include <cstdint>
+#include <thread>
+#include <atomic>
+#include <exception>
+
+/**
+* Caps the read coverage of a sample prior to kmer counting. The coverage is estimated from the size of the
+* (uncompressed) FASTA/FASTQ file and the fraction of sequence characters in its first records. If it exceeds
+* the target, reads are subsampled deterministically: a read is kept if the hash of its sequence falls below
+* the fraction target/estimated coverage. Thus, the same reads are selected in every run, independent of their
+* order in the file.
+**/
+
+class ReadSubsampler {
+public:
+	/**
+	* @param readfile reads in FASTA or FASTQ format
+	* @param genome_size number of bases of the reference genome
+	**/
+	ReadSubsampler(std::string readfile, uint64_t genome_size);
+	/** coverage estimated from the file size **/
+	double get_estimated_coverage() const;
+	/** fraction of reads needed to reach the given coverage (at most 1) **/
+	double get_fraction(double max_coverage) const;
+	/** writes the subsampled reads to a FASTA file and returns their coverage **/
+	double write_subsample(double max_coverage, std::string filename) const;
+	/** decides whether a read is kept when sampling the given fraction of reads **/
+	static bool keep_read(const std::string& sequence, double fraction);
+
+private:
+	std::string readfile;
+	uint64_t genome_size;
+	double estimated_bases;
+	/** reads the next record, returns false at the end of the file **/
+	static bool next_read(std::ifstream& file, std::string& line, std::string& sequence);
+};
+
+/**
+* Passes subsampled reads to a reader (e.g. Jellyfish) through a named pipe, which is written from a separate thread.
+* On destruction, also while an exception of the reader propagates, the pipe is drained until the writer is done,
+* so that the writer never stays blocked. Then the thread is joined and the pipe is removed.
+**/
+
+class SubsamplePipe {
+public:
+	SubsamplePipe(const ReadSubsampler& subsampler, double max_coverage, std::string filename);
+	~SubsamplePipe();
+	SubsamplePipe(const SubsamplePipe&) = delete;
+	SubsamplePipe& operator=(const SubsamplePipe&) = delete;
+	/** waits for the writer once the reader is done and returns the coverage of the subsample. Rethrows errors of the writer. **/
+	double finish();
+
+private:
+	std::string filename;
+	std::atomic<bool> done;
+	double coverage;
+	std::exception_ptr error;
+	std::thread writer;
+	/** reads (and discards) everything left in the pipe until the writer is done, then joins it **/
+	void drain();
+};
+
+#endif // READSUBSAMPLER_HPP
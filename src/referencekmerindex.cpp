@@ -0,0 +1,274 @@
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+#include <queue>
+#include <functional>
+#include <cstring>
+#include <cstdio>
+#include <cctype>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "referencekmerindex.hpp"
+#include "fastareader.hpp"
+#include "kmerextractor.hpp"
+#include "hugepages.hpp"
+#include "runreader.hpp"
+
+using namespace std;
+
+static const char index_magic[8] = {'P', 'G', 'R', 'E', 'F', 'I', 'X', '2'};
+static const size_t max_prefix_bits = 20;
+
+static int base_code(char base) {
+	switch (base) {
+		case 'A': case 'a': return 0;
+		case 'C': case 'c': return 1;
+		case 'G': case 'g': return 2;
+		case 'T': case 't': return 3;
+		default: return -1;
+	}
+}
+
+// sorts the kmer codes of a run, collapses duplicates into entries and writes them to a temporary file
+static void write_run(vector<uint64_t>& codes, string filename) {
+	sort(codes.begin(), codes.end());
+	ofstream run(filename, ios::binary);
+	if (!run.is_open()) {
+		throw runtime_error("ReferenceKmerIndex::build: temporary file " + filename + " cannot be created.");
+	}
+	vector<uint64_t> entries;
+	size_t i = 0;
+	while (i < codes.size()) {
+		size_t j = i + 1;
+		while ((j < codes.size()) && (codes[j] == codes[i])) ++j;
+		entries.push_back((codes[i] << 1) | ((j - i > 1) ? 1 : 0));
+		i = j;
+	}
+	run.write((const char*) entries.data(), entries.size() * sizeof(uint64_t));
+	codes.clear();
+}
+
+// 64 bit FNV-1a hash
+static void fingerprint_update(uint64_t& hash, const char* data, size_t length) {
+	for (size_t i = 0; i < length; ++i) {
+		hash ^= (unsigned char) data[i];
+		hash *= 1099511628211ULL;
+	}
+}
+
+uint64_t ReferenceKmerIndex::reference_fingerprint(const FastaReader& reference) {
+	uint64_t hash = 14695981039346656037ULL;
+	vector<string> chromosomes;
+	reference.get_sequence_names(chromosomes);
+	for (auto& chromosome : chromosomes) {
+		uint64_t length = reference.get_size_of(chromosome);
+		fingerprint_update(hash, chromosome.c_str(), chromosome.size() + 1);
+		fingerprint_update(hash, (const char*) &length, sizeof(uint64_t));
+		string sequence;
+		reference.get_subsequence(chromosome, 0, length, sequence);
+		for (auto& c : sequence) c = toupper(c);
+		fingerprint_update(hash, sequence.c_str(), sequence.size());
+	}
+	return hash;
+}
+
+bool ReferenceKmerIndex::encode_canonical(const string& sequence, size_t start, size_t kmer_size, uint64_t& code) {
+	uint64_t forward = 0;
+	uint64_t reverse = 0;
+	for (size_t i = 0; i < kmer_size; ++i) {
+		int base = base_code(sequence[start + i]);
+		if (base < 0) return false;
+		forward = (forward << 2) | base;
+		reverse |= ((uint64_t) (3 - base)) << (2*i);
+	}
+	code = min(forward, reverse);
+	return true;
+}
+
+void ReferenceKmerIndex::build(string reference_filename, size_t kmer_size, string filename, size_t run_size) {
+	if ((kmer_size == 0) || (kmer_size > 31)) {
+		throw runtime_error("ReferenceKmerIndex::build: kmer size must be between 1 and 31.");
+	}
+	run_size = max(run_size, (size_t) 1);
+	FastaReader fasta_reader(reference_filename);
+	vector<string> chromosomes;
+	fasta_reader.get_sequence_names(chromosomes);
+
+	// collect the canonical kmers of all chromosomes and write them to sorted runs
+	KmerExtractor extractor(kmer_size);
+	vector<uint64_t> codes;
+	vector<string> run_files;
+	for (auto& chromosome : chromosomes) {
+		string sequence;
+		fasta_reader.get_subsequence(chromosome, 0, fasta_reader.get_size_of(chromosome), sequence);
+		// extract the kmers in blocks that fill up the current run (consecutive blocks overlap by kmer_size - 1 bases)
+		size_t start = 0;
+		while (start + kmer_size <= sequence.size()) {
+			size_t nr_kmers = run_size - codes.size();
+			size_t length = min(nr_kmers + kmer_size - 1, sequence.size() - start);
+			extractor.extract(sequence.c_str() + start, length, codes);
+			start += nr_kmers;
+			if (codes.size() >= run_size) {
+				run_files.push_back(filename + ".run" + to_string(run_files.size()));
+				write_run(codes, run_files.back());
+			}
+		}
+	}
+	if (!codes.empty() || run_files.empty()) {
+		run_files.push_back(filename + ".run" + to_string(run_files.size()));
+		write_run(codes, run_files.back());
+	}
+	vector<uint64_t>().swap(codes);
+
+	// merge the runs
+	ofstream outfile(filename, ios::binary);
+	if (!outfile.is_open()) {
+		throw runtime_error("ReferenceKmerIndex::build: index file " + filename + " cannot be created. Note that the filename must not contain non-existing directories.");
+	}
+	ReferenceIndexHeader header;
+	memcpy(header.magic, index_magic, 8);
+	header.kmer_size = kmer_size;
+	header.reference_fingerprint = reference_fingerprint(fasta_reader);
+	header.nr_entries = 0;
+	header.prefix_bits = min(max_prefix_bits, 2*kmer_size);
+	outfile.write((const char*) &header, sizeof(ReferenceIndexHeader));
+
+	size_t prefix_shift = 2*kmer_size - header.prefix_bits;
+	vector<uint64_t> prefix_offsets((1ULL << header.prefix_bits) + 1, 0);
+	vector<RunReader<uint64_t>*> runs;
+	typedef pair<uint64_t, size_t> QueueEntry;
+	priority_queue<QueueEntry, vector<QueueEntry>, greater<QueueEntry>> queue;
+	for (size_t r = 0; r < run_files.size(); ++r) {
+		runs.push_back(new RunReader<uint64_t>(run_files[r]));
+		uint64_t entry;
+		if (runs[r]->next(entry)) queue.push(QueueEntry(entry, r));
+	}
+	vector<uint64_t> buffer;
+	while (!queue.empty()) {
+		uint64_t code = queue.top().first >> 1;
+		bool multiple = false;
+		size_t nr_runs = 0;
+		while (!queue.empty() && ((queue.top().first >> 1) == code)) {
+			QueueEntry top = queue.top();
+			queue.pop();
+			// the same kmer stored in several runs occurs more than once
+			if ((top.first & 1) || (++nr_runs > 1)) multiple = true;
+			uint64_t next;
+			if (runs[top.second]->next(next)) queue.push(QueueEntry(next, top.second));
+		}
+		uint64_t entry = (code << 1) | (multiple ? 1 : 0);
+		buffer.push_back(entry);
+		prefix_offsets[((entry >> 1) >> prefix_shift) + 1] += 1;
+		header.nr_entries += 1;
+		if (buffer.size() >= (1 << 16)) {
+			outfile.write((const char*) buffer.data(), buffer.size() * sizeof(uint64_t));
+			buffer.clear();
+		}
+	}
+	outfile.write((const char*) buffer.data(), buffer.size() * sizeof(uint64_t));
+	for (size_t r = 0; r < runs.size(); ++r) {
+		delete runs[r];
+		remove(run_files[r].c_str());
+	}
+
+	for (size_t p = 1; p < prefix_offsets.size(); ++p) {
+		prefix_offsets[p] += prefix_offsets[p-1];
+	}
+	outfile.write((const char*) prefix_offsets.data(), prefix_offsets.size() * sizeof(uint64_t));
+	outfile.seekp(0);
+	outfile.write((const char*) &header, sizeof(ReferenceIndexHeader));
+	outfile.close();
+}
+
+ReferenceKmerIndex::ReferenceKmerIndex(string filename, size_t kmer_size, KmerCounter* allele_kmers, const FastaReader* reference)
+	:kmer_size(kmer_size),
+	 allele_kmers(allele_kmers),
+	 file_descriptor(-1),
+	 data(nullptr),
+	 data_size(0)
+{
+	this->file_descriptor = ::open(filename.c_str(), O_RDONLY);
+	if (this->file_descriptor < 0) {
+		throw runtime_error("ReferenceKmerIndex::ReferenceKmerIndex: index file " + filename + " cannot be opened.");
+	}
+	struct stat file_stats;
+	fstat(this->file_descriptor, &file_stats);
+	this->data_size = file_stats.st_size;
+	if (this->data_size < sizeof(ReferenceIndexHeader)) {
+		::close(this->file_descriptor);
+		throw runtime_error("ReferenceKmerIndex::ReferenceKmerIndex: " + filename + " is not a reference kmer index.");
+	}
+	void* mapped = mmap(nullptr, this->data_size, PROT_READ, MAP_SHARED, this->file_descriptor, 0);
+	if (mapped == MAP_FAILED) {
+		::close(this->file_descriptor);
+		throw runtime_error("ReferenceKmerIndex::ReferenceKmerIndex: index file " + filename + " cannot be memory-mapped.");
+	}
+	this->data = (const char*) mapped;
+	// lookups are spread over the whole index (only effective if the kernel supports huge pages for file mappings)
+	if (HugePages::get_mode() != HugePages::NONE) HugePages::advise(mapped, this->data_size);
+
+	const ReferenceIndexHeader* header = (const ReferenceIndexHeader*) this->data;
+	size_t expected_size = sizeof(ReferenceIndexHeader) + (header->nr_entries + (1ULL << header->prefix_bits) + 1) * sizeof(uint64_t);
+	if ((memcmp(header->magic, index_magic, 8) != 0) || (header->prefix_bits > max_prefix_bits) || (this->data_size != expected_size)) {
+		munmap((void*) this->data, this->data_size);
+		::close(this->file_descriptor);
+		throw runtime_error("ReferenceKmerIndex::ReferenceKmerIndex: " + filename + " is not a reference kmer index or is truncated (indexes written by older versions need to be rebuilt).");
+	}
+	if (header->kmer_size != kmer_size) {
+		size_t index_kmer_size = header->kmer_size;
+		munmap((void*) this->data, this->data_size);
+		::close(this->file_descriptor);
+		throw runtime_error("ReferenceKmerIndex::ReferenceKmerIndex: index " + filename + " was built for kmer size " + to_string(index_kmer_size) + ", not " + to_string(kmer_size) + ".");
+	}
+	if ((reference != nullptr) && (header->reference_fingerprint != reference_fingerprint(*reference))) {
+		munmap((void*) this->data, this->data_size);
+		::close(this->file_descriptor);
+		throw runtime_error("ReferenceKmerIndex::ReferenceKmerIndex: index " + filename + " was built from a different reference genome. Remove it to rebuild it for the given reference.");
+	}
+	this->nr_entries = header->nr_entries;
+	this->prefix_shift = 2*kmer_size - header->prefix_bits;
+	this->entries = (const uint64_t*) (this->data + sizeof(ReferenceIndexHeader));
+	this->prefix_offsets = this->entries + this->nr_entries;
+}
+
+ReferenceKmerIndex::~ReferenceKmerIndex() {
+	munmap((void*) this->data, this->data_size);
+	::close(this->file_descriptor);
+}
+
+size_t ReferenceKmerIndex::get_reference_multiplicity(uint64_t code) const {
+	uint64_t prefix = code >> this->prefix_shift;
+	const uint64_t* first = this->entries + this->prefix_offsets[prefix];
+	const uint64_t* last = this->entries + this->prefix_offsets[prefix + 1];
+	const uint64_t* it = lower_bound(first, last, code << 1);
+	if ((it == last) || ((*it >> 1) != code)) return 0;
+	return (*it & 1) ? 2 : 1;
+}
+
+size_t ReferenceKmerIndex::size() const {
+	return this->nr_entries;
+}
+
+size_t ReferenceKmerIndex::getKmerAbundance(string kmer) {
+	size_t result = this->allele_kmers ? this->allele_kmers->getKmerAbundance(kmer) : 0;
+	uint64_t code;
+	if ((kmer.size() == this->kmer_size) && encode_canonical(kmer, 0, this->kmer_size, code)) {
+		result += get_reference_multiplicity(code);
+	}
+	return result;
+}
+
+size_t ReferenceKmerIndex::getKmerAbundance(jellyfish::mer_dna jelly_kmer) {
+	return getKmerAbundance(jelly_kmer.to_str());
+}
+
+size_t ReferenceKmerIndex::computeKmerCoverage(size_t genome_kmers) {
+	throw runtime_error("ReferenceKmerIndex::computeKmerCoverage: the index does not store kmer counts.");
+}
+
+size_t ReferenceKmerIndex::computeHistogram(size_t max_count, bool largest_peak, string filename) {
+	throw runtime_error("ReferenceKmerIndex::computeHistogram: the index does not store kmer counts.");
+}
@@ -0,0 +1,76 @@
+#ifndef REFERENCEKMERINDEX_HPP
+#define REFERENCEKMERINDEX_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "kmercounter.hpp"
+#include "fastareader.hpp"
+
+/**
+* Persistent index of the canonical kmers of a reference genome, storing only whether a kmer occurs once or
+* more than once. It is built once per reference and kmer size (k <= 31) and memory-mapped afterwards.
+* Kmers containing other characters than A,C,G,T (case-insensitive) are skipped. The header stores a fingerprint
+* of the reference (names, lengths and sequences of all chromosomes), so that an index is not used with another reference.
+*
+* File layout: ReferenceIndexHeader, sorted entries (uint64, (code << 1) | multiple), offsets of the entries
+* starting with each prefix of prefix_bits bits (uint64, 2^prefix_bits + 1).
+*
+* Optionally, counts of allele kmers can be layered on top. If these are counted from the non-reference alleles
+* (including flanks, see VariantReader::write_allele_segments), getKmerAbundance() agrees with the counts of
+* the path segments on all values 0 and 1 and is larger than 1 whenever they are, which is all UniqueKmerComputer
+* needs to know.
+**/
+
+struct ReferenceIndexHeader {
+	char magic[8];
+	uint64_t kmer_size;
+	uint64_t reference_fingerprint;
+	uint64_t nr_entries;
+	uint64_t prefix_bits;
+};
+
+class ReferenceKmerIndex : public KmerCounter {
+public:
+	/** memory-map an existing index. If given, allele_kmers are added to the reference multiplicities. If reference is given,
+	* it needs to be the genome the index was built from. **/
+	ReferenceKmerIndex(std::string filename, size_t kmer_size, KmerCounter* allele_kmers = nullptr, const FastaReader* reference = nullptr);
+	~ReferenceKmerIndex();
+
+	/** build the index of the given reference. At most run_size kmers are kept in memory, larger genomes are sorted in runs
+	* which are stored in temporary files next to the index and merged afterwards. **/
+	static void build(std::string reference_filename, size_t kmer_size, std::string filename, size_t run_size = 500000000);
+
+	/** hash of the names, lengths and (upper case) sequences of all chromosomes **/
+	static uint64_t reference_fingerprint(const FastaReader& reference);
+
+	/** 2-bit encoding of the canonical version of the kmer starting at position start. Returns false, if it contains characters other than A,C,G,T. **/
+	static bool encode_canonical(const std::string& sequence, size_t start, size_t kmer_size, uint64_t& code);
+
+	/** number of times the kmer with given canonical code occurs in the reference: 0, 1 or 2 (more than once) **/
+	size_t get_reference_multiplicity(uint64_t code) const;
+
+	/** number of distinct kmers in the reference **/
+	size_t size() const;
+
+	/** reference multiplicity plus allele kmer count **/
+	size_t getKmerAbundance(std::string kmer);
+	size_t getKmerAbundance(jellyfish::mer_dna jelly_kmer);
+
+	/** not supported, since the index does not store counts **/
+	size_t computeKmerCoverage(size_t genome_kmers);
+	size_t computeHistogram(size_t max_count, bool largest_peak, std::string filename = "");
+
+private:
+	size_t kmer_size;
+	KmerCounter* allele_kmers;
+	int file_descriptor;
+	const char* data;
+	size_t data_size;
+	size_t nr_entries;
+	size_t prefix_shift;
+	const uint64_t* entries;
+	const uint64_t* prefix_offsets;
+};
+
+#endif // REFERENCEKMERINDEX_HPP
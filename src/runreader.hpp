@@ -0,0 +1,50 @@
+#ifndef RUNREADER_HPP
+#define RUNREADER_HPP
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <stdexcept>
+
+/**
+* Sequential, buffered reader of a temporary file of fixed size records, as written for the sorted runs
+* of an external merge sort.
+**/
+
+template <typename T>
+class RunReader {
+public:
+	RunReader(std::string filename);
+	/** returns false at the end of the file **/
+	bool next(T& record);
+
+private:
+	std::ifstream file;
+	std::vector<T> buffer;
+	size_t position;
+};
+
+template <typename T>
+RunReader<T>::RunReader(std::string filename)
+	:file(filename, std::ios::binary),
+	 position(0)
+{
+	if (!this->file.is_open()) {
+		throw std::runtime_error("RunReader::RunReader: temporary file " + filename + " cannot be opened.");
+	}
+}
+
+template <typename T>
+bool RunReader<T>::next(T& record) {
+	if (this->position == this->buffer.size()) {
+		this->buffer.resize(1 << 16);
+		this->file.read((char*) this->buffer.data(), this->buffer.size() * sizeof(T));
+		this->buffer.resize(this->file.gcount() / sizeof(T));
+		this->position = 0;
+		if (this->buffer.empty()) return false;
+	}
+	record = this->buffer[this->position++];
+	return true;
+}
+
+#endif // RUNREADER_HPP
@@ -0,0 +1,199 @@
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+#include <map>
+#include <set>
+#include "shardmerger.hpp"
+
+using namespace std;
+
+ShardMerger::ShardMerger(vector<string> shard_prefixes)
+	:shard_prefixes(shard_prefixes)
+{
+	if (shard_prefixes.empty()) {
+		throw runtime_error("ShardMerger::ShardMerger: no shards given.");
+	}
+}
+
+bool ShardMerger::merge_vcfs(string suffix, string filename) const {
+	// consecutive records of a chromosome in one of the shards (byte range in its VCF)
+	struct Block {
+		string chromosome;
+		size_t shard;
+		size_t start;
+		size_t end;
+	};
+	vector<Block> blocks;
+	string header = "";
+	string samples = "";
+	size_t nr_present = 0;
+	for (size_t s = 0; s < this->shard_prefixes.size(); ++s) {
+		ifstream file(this->shard_prefixes[s] + suffix);
+		if (!file.good()) continue;
+		nr_present += 1;
+		string shard_samples = "";
+		string line;
+		size_t position = 0;
+		while (getline(file, line)) {
+			size_t start = position;
+			position += line.size() + 1;
+			if (line.empty()) continue;
+			if (line[0] == '#') {
+				if (nr_present == 1) header += line + '\n';
+				if (line.substr(0, 6) == "#CHROM") shard_samples = line;
+				continue;
+			}
+			string chromosome = line.substr(0, line.find('\t'));
+			if (!blocks.empty() && (blocks.back().shard == s) && (blocks.back().chromosome == chromosome)) {
+				blocks.back().end = position;
+			} else {
+				blocks.push_back({chromosome, s, start, position});
+			}
+		}
+		if (nr_present == 1) {
+			samples = shard_samples;
+		} else if (shard_samples != samples) {
+			throw runtime_error("ShardMerger::merge_vcfs: " + this->shard_prefixes[s] + suffix + " contains other samples than the previous shards.");
+		}
+	}
+	if (nr_present == 0) return false;
+	if (nr_present < this->shard_prefixes.size()) {
+		throw runtime_error("ShardMerger::merge_vcfs: not all shards contain a file ending in " + suffix + ".");
+	}
+
+	// every chromosome must come from a single shard
+	map<string, size_t> chromosome_to_shard;
+	for (const Block& block : blocks) {
+		auto it = chromosome_to_shard.find(block.chromosome);
+		if ((it != chromosome_to_shard.end()) && (it->second != block.shard)) {
+			throw runtime_error("ShardMerger::merge_vcfs: chromosome " + block.chromosome + " was genotyped in shards " + this->shard_prefixes[it->second] + " and " + this->shard_prefixes[block.shard] + ".");
+		}
+		chromosome_to_shard[block.chromosome] = block.shard;
+	}
+	stable_sort(blocks.begin(), blocks.end(), [](const Block& a, const Block& b) { return a.chromosome < b.chromosome; });
+
+	ofstream outfile(filename);
+	if (!outfile.is_open()) {
+		throw runtime_error("ShardMerger::merge_vcfs: file " + filename + " cannot be created. Note that the filename must not contain non-existing directories.");
+	}
+	outfile << header;
+	vector<char> buffer(1 << 20);
+	for (const Block& block : blocks) {
+		ifstream file(this->shard_prefixes[block.shard] + suffix, ios::binary);
+		file.seekg(block.start);
+		size_t left = block.end - block.start;
+		char last = '\n';
+		while ((left > 0) && file.good()) {
+			file.read(buffer.data(), min(left, buffer.size()));
+			size_t nr_read = file.gcount();
+			if (nr_read == 0) break;
+			outfile.write(buffer.data(), nr_read);
+			last = buffer[nr_read - 1];
+			left -= nr_read;
+		}
+		// the last line of a shard might not be terminated
+		if (last != '\n') outfile << '\n';
+	}
+	if (!outfile.good()) {
+		throw runtime_error("ShardMerger::merge_vcfs: error while writing " + filename + ".");
+	}
+	return true;
+}
+
+void ShardMerger::merge_metrics(string filename) const {
+	vector<ShardMetrics> metrics;
+	map<string, string> chromosome_to_shard;
+	for (const string& prefix : this->shard_prefixes) {
+		vector<ShardMetrics> shard_metrics;
+		read_metrics(prefix + "_metrics.tsv", shard_metrics);
+		for (const ShardMetrics& m : shard_metrics) {
+			if (chromosome_to_shard.find(m.chromosome) != chromosome_to_shard.end()) {
+				throw runtime_error("ShardMerger::merge_metrics: chromosome " + m.chromosome + " was genotyped in shards " + chromosome_to_shard[m.chromosome] + " and " + prefix + ".");
+			}
+			chromosome_to_shard[m.chromosome] = prefix;
+			metrics.push_back(m);
+		}
+	}
+	stable_sort(metrics.begin(), metrics.end(), [](const ShardMetrics& a, const ShardMetrics& b) { return a.chromosome < b.chromosome; });
+	write_metrics(metrics, filename);
+}
+
+void ShardMerger::check_chromosomes(string vcffile) const {
+	map<string, size_t> nr_shards;
+	for (const string& prefix : this->shard_prefixes) {
+		vector<ShardMetrics> shard_metrics;
+		read_metrics(prefix + "_metrics.tsv", shard_metrics);
+		for (const ShardMetrics& m : shard_metrics) {
+			nr_shards[m.chromosome] += 1;
+		}
+	}
+	ifstream file(vcffile);
+	if (!file.good()) {
+		throw runtime_error("ShardMerger::check_chromosomes: file " + vcffile + " cannot be opened.");
+	}
+	set<string> in_vcf;
+	string line;
+	string previous = "";
+	while (getline(file, line)) {
+		if (line.empty() || (line[0] == '#')) continue;
+		string chromosome = line.substr(0, line.find('\t'));
+		if (chromosome == previous) continue;
+		previous = chromosome;
+		in_vcf.insert(chromosome);
+	}
+	for (const string& chromosome : in_vcf) {
+		auto it = nr_shards.find(chromosome);
+		if (it == nr_shards.end()) {
+			throw runtime_error("ShardMerger::check_chromosomes: chromosome " + chromosome + " was not genotyped in any of the shards.");
+		}
+		if (it->second > 1) {
+			throw runtime_error("ShardMerger::check_chromosomes: chromosome " + chromosome + " was genotyped in several shards.");
+		}
+	}
+	for (auto& chromosome : nr_shards) {
+		if (in_vcf.find(chromosome.first) == in_vcf.end()) {
+			throw runtime_error("ShardMerger::check_chromosomes: chromosome " + chromosome.first + " of the shards is not contained in " + vcffile + ".");
+		}
+	}
+}
+
+void ShardMerger::write_metrics(const vector<ShardMetrics>& metrics, string filename) {
+	ofstream outfile(filename);
+	if (!outfile.is_open()) {
+		throw runtime_error("ShardMerger::write_metrics: file " + filename + " cannot be created. Note that the filename must not contain non-existing directories.");
+	}
+	ShardMetrics total = {"total", 0, 0.0, 0.0};
+	outfile << "chromosome\tvariants\ttime_unique_kmers\ttime_genotyping" << endl;
+	for (const ShardMetrics& m : metrics) {
+		outfile << m.chromosome << '\t' << m.nr_variants << '\t' << m.time_unique_kmers << '\t' << m.time_genotyping << endl;
+		total.nr_variants += m.nr_variants;
+		total.time_unique_kmers += m.time_unique_kmers;
+		total.time_genotyping += m.time_genotyping;
+	}
+	outfile << total.chromosome << '\t' << total.nr_variants << '\t' << total.time_unique_kmers << '\t' << total.time_genotyping << endl;
+}
+
+void ShardMerger::read_metrics(string filename, vector<ShardMetrics>& metrics) {
+	ifstream file(filename);
+	if (!file.good()) {
+		throw runtime_error("ShardMerger::read_metrics: file " + filename + " cannot be opened.");
+	}
+	vector<string> lines;
+	string line;
+	while (getline(file, line)) {
+		if (!line.empty()) lines.push_back(line);
+	}
+	// first line is the header, last line contains the totals
+	if ((lines.size() < 2) || (lines[0].substr(0, 10) != "chromosome")) {
+		throw runtime_error("ShardMerger::read_metrics: " + filename + " is not a metrics file.");
+	}
+	for (size_t i = 1; i < lines.size() - 1; ++i) {
+		istringstream iss(lines[i]);
+		ShardMetrics m;
+		if (!(getline(iss, m.chromosome, '\t') && (iss >> m.nr_variants >> m.time_unique_kmers >> m.time_genotyping))) {
+			throw runtime_error("ShardMerger::read_metrics: malformed line in " + filename + ": " + lines[i]);
+		}
+		metrics.push_back(m);
+	}
+}
@@ -0,0 +1,48 @@
+#ifndef SHARDMERGER_HPP
+#define SHARDMERGER_HPP
+
+#include <string>
+#include <vector>
+
+/**
+* Per-chromosome statistics of a genotyping run, written to <prefix>_metrics.tsv.
+**/
+
+struct ShardMetrics {
+	std::string chromosome;
+	size_t nr_variants;
+	double time_unique_kmers;
+	double time_genotyping;
+};
+
+/**
+* Merges the outputs of genotyping runs on disjoint subsets of chromosomes (shards), all run from the same
+* kmer counts, into the output of a single run. Every shard is given by its output prefix. Records of VCFs are
+* grouped by chromosome and written in lexicographical order of the chromosome names (like a single run does),
+* the header is taken from the first shard.
+**/
+
+class ShardMerger {
+public:
+	ShardMerger(std::vector<std::string> shard_prefixes);
+	/**
+	* merge the VCFs <shard prefix><suffix> into filename.
+	* @returns false if the shards do not have such a VCF. Throws if only some of them do, if their samples differ or if
+	* a chromosome occurs in several shards.
+	**/
+	bool merge_vcfs(std::string suffix, std::string filename) const;
+	/** merge the metrics of all shards (<shard prefix>_metrics.tsv) into filename **/
+	void merge_metrics(std::string filename) const;
+	/** throws if not every chromosome of the given VCF was genotyped in exactly one of the shards (according to their metrics) **/
+	void check_chromosomes(std::string vcffile) const;
+
+	/** write metrics (one line per chromosome, followed by the totals) **/
+	static void write_metrics(const std::vector<ShardMetrics>& metrics, std::string filename);
+	/** read the per-chromosome lines of a metrics file **/
+	static void read_metrics(std::string filename, std::vector<ShardMetrics>& metrics);
+
+private:
+	std::vector<std::string> shard_prefixes;
+};
+
+#endif // SHARDMERGER_HPP
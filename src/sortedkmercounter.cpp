@@ -0,0 +1,380 @@
+#include <fstream>
+#include <stdexcept>
+#include <algorithm>
+#include <limits>
+#include <cstring>
+#include <cstdio>
+#include <queue>
+#include <functional>
+#include <fcntl.h>
+#include <unistd.h>
+#include "sortedkmercounter.hpp"
+#include "referencekmerindex.hpp"
+#include "runreader.hpp"
+
+using namespace std;
+
+static const char dump_magic[8] = {'P', 'G', 'K', 'M', 'S', 'R', 'T', '2'};
+// number of entries read from the dump at once
+static const size_t dump_buffer_entries = 1 << 20;
+
+ResolvedKmerQueries::ResolvedKmerQueries(size_t kmer_size)
+	:kmer_size(kmer_size),
+	 is_resolved(false)
+{
+	if ((kmer_size == 0) || (kmer_size > 31)) {
+		throw runtime_error("ResolvedKmerQueries::ResolvedKmerQueries: kmer size must be between 1 and 31.");
+	}
+}
+
+uint64_t ResolvedKmerQueries::encode(const jellyfish::mer_dna& jelly_kmer) const {
+	uint64_t code = 0;
+	string kmer = jelly_kmer.to_str();
+	if ((kmer.size() != this->kmer_size) || !ReferenceKmerIndex::encode_canonical(kmer, 0, this->kmer_size, code)) {
+		throw runtime_error("ResolvedKmerQueries::encode: invalid kmer " + kmer + ".");
+	}
+	return code;
+}
+
+void ResolvedKmerQueries::set_queries(const vector<jellyfish::mer_dna>& kmers) {
+	this->codes.clear();
+	this->codes.reserve(kmers.size());
+	for (const auto& kmer : kmers) {
+		this->codes.push_back(encode(kmer));
+	}
+	sort(this->codes.begin(), this->codes.end());
+	this->codes.erase(unique(this->codes.begin(), this->codes.end()), this->codes.end());
+	this->codes.shrink_to_fit();
+	this->read_counts.assign(this->codes.size(), 0);
+	this->genomic_counts.assign(this->codes.size(), 0);
+	this->is_resolved = true;
+}
+
+bool ResolvedKmerQueries::resolved() const {
+	return this->is_resolved;
+}
+
+size_t ResolvedKmerQueries::size() const {
+	return this->codes.size();
+}
+
+const HugePageVector<uint64_t>& ResolvedKmerQueries::get_codes() const {
+	return this->codes;
+}
+
+size_t ResolvedKmerQueries::find(uint64_t code) const {
+	auto it = lower_bound(this->codes.begin(), this->codes.end(), code);
+	if ((it == this->codes.end()) || (*it != code)) return this->codes.size();
+	return it - this->codes.begin();
+}
+
+void ResolvedKmerQueries::set_counts(size_t index, uint32_t read_count, uint32_t genomic_count) {
+	this->read_counts.at(index) = read_count;
+	this->genomic_counts.at(index) = genomic_count;
+}
+
+void ResolvedKmerQueries::get_counts(jellyfish::mer_dna jelly_kmer, size_t& read_count, size_t& genomic_count) const {
+	size_t index = find(encode(jelly_kmer));
+	if (index == this->codes.size()) {
+		throw runtime_error("ResolvedKmerQueries::get_counts: kmer " + jelly_kmer.to_str() + " was not part of the resolved queries.");
+	}
+	read_count = this->read_counts[index];
+	genomic_count = this->genomic_counts[index];
+}
+
+SortedKmerCounter::SortedKmerCounter(string filename, size_t kmer_size)
+	:filename(filename),
+	 kmer_size(kmer_size),
+	 queries(kmer_size)
+{
+	ifstream file(filename, ios::binary);
+	if (!file.is_open()) {
+		throw runtime_error("SortedKmerCounter::SortedKmerCounter: kmer dump " + filename + " cannot be opened.");
+	}
+	SortedKmerHeader header;
+	file.read((char*) &header, sizeof(SortedKmerHeader));
+	if ((file.gcount() != sizeof(SortedKmerHeader)) || (memcmp(header.magic, dump_magic, 8) != 0)) {
+		throw runtime_error("SortedKmerCounter::SortedKmerCounter: " + filename + " is not a sorted kmer dump.");
+	}
+	if (header.kmer_size != kmer_size) {
+		throw runtime_error("SortedKmerCounter::SortedKmerCounter: dump " + filename + " contains kmers of size " + to_string(header.kmer_size) + ", not " + to_string(kmer_size) + ".");
+	}
+	this->nr_entries = header.nr_entries;
+	this->genomic_counts = (header.genomic_counts != 0);
+	this->abundance_peak = header.abundance_peak;
+	string names(header.chromosomes_length, '\0');
+	file.read(&names[0], header.chromosomes_length);
+	if ((size_t) file.gcount() != header.chromosomes_length) {
+		throw runtime_error("SortedKmerCounter::SortedKmerCounter: kmer dump " + filename + " is truncated.");
+	}
+	size_t start = 0;
+	for (size_t i = 0; i < names.size(); ++i) {
+		if (names[i] != '\n') continue;
+		this->chromosomes.push_back(names.substr(start, i - start));
+		start = i + 1;
+	}
+	this->entries_offset = sizeof(SortedKmerHeader) + header.chromosomes_length;
+}
+
+static bool smaller_code(const SortedKmerEntry& a, const SortedKmerEntry& b) {
+	return a.code < b.code;
+}
+
+static string chromosome_list(const vector<string>& chromosomes) {
+	string names = "";
+	for (const auto& chromosome : chromosomes) {
+		if (chromosome.empty() || (chromosome.find('\n') != string::npos)) {
+			throw runtime_error("SortedKmerCounter: invalid chromosome name in kmer dump.");
+		}
+		names += chromosome + '\n';
+	}
+	return names;
+}
+
+static SortedKmerHeader dump_header(size_t kmer_size, size_t nr_entries, bool genomic_counts, size_t abundance_peak, const string& chromosomes) {
+	SortedKmerHeader header;
+	memcpy(header.magic, dump_magic, 8);
+	header.kmer_size = kmer_size;
+	header.nr_entries = nr_entries;
+	header.genomic_counts = genomic_counts ? 1 : 0;
+	header.abundance_peak = abundance_peak;
+	header.chromosomes_length = chromosomes.size();
+	return header;
+}
+
+void SortedKmerCounter::write_dump(vector<SortedKmerEntry>& entries, size_t kmer_size, bool genomic_counts, string filename, size_t abundance_peak, const vector<string>& chromosomes) {
+	sort(entries.begin(), entries.end(), smaller_code);
+	ofstream outfile(filename, ios::binary);
+	if (!outfile.is_open()) {
+		throw runtime_error("SortedKmerCounter::write_dump: file " + filename + " cannot be created. Note that the filename must not contain non-existing directories.");
+	}
+	string names = chromosome_list(chromosomes);
+	SortedKmerHeader header = dump_header(kmer_size, entries.size(), genomic_counts, abundance_peak, names);
+	outfile.write((const char*) &header, sizeof(SortedKmerHeader));
+	outfile.write(names.data(), names.size());
+	outfile.write((const char*) entries.data(), entries.size() * sizeof(SortedKmerEntry));
+	if (!outfile.good()) {
+		throw runtime_error("SortedKmerCounter::write_dump: error while writing " + filename + ".");
+	}
+}
+
+SortedDumpWriter::SortedDumpWriter(string filename, size_t kmer_size, bool genomic_counts, size_t run_size)
+	:filename(filename),
+	 kmer_size(kmer_size),
+	 genomic_counts(genomic_counts),
+	 run_size(max(run_size, (size_t) 1))
+{}
+
+void SortedDumpWriter::add(const SortedKmerEntry& entry) {
+	this->entries.push_back(entry);
+	if (this->entries.size() >= this->run_size) write_run();
+}
+
+void SortedDumpWriter::write_run() {
+	sort(this->entries.begin(), this->entries.end(), smaller_code);
+	string run_file = this->filename + ".run" + to_string(this->run_files.size());
+	ofstream run(run_file, ios::binary);
+	if (!run.is_open()) {
+		throw runtime_error("SortedDumpWriter::write_run: temporary file " + run_file + " cannot be created.");
+	}
+	run.write((const char*) this->entries.data(), this->entries.size() * sizeof(SortedKmerEntry));
+	if (!run.good()) {
+		throw runtime_error("SortedDumpWriter::write_run: error while writing " + run_file + ".");
+	}
+	this->run_files.push_back(run_file);
+	this->entries.clear();
+}
+
+void SortedDumpWriter::finish(size_t abundance_peak) {
+	// everything fits into a single run
+	if (this->run_files.empty()) {
+		SortedKmerCounter::write_dump(this->entries, this->kmer_size, this->genomic_counts, this->filename, abundance_peak);
+		vector<SortedKmerEntry>().swap(this->entries);
+		return;
+	}
+	if (!this->entries.empty()) write_run();
+	vector<SortedKmerEntry>().swap(this->entries);
+
+	// merge the runs
+	ofstream outfile(this->filename, ios::binary);
+	if (!outfile.is_open()) {
+		throw runtime_error("SortedDumpWriter::finish: file " + this->filename + " cannot be created. Note that the filename must not contain non-existing directories.");
+	}
+	SortedKmerHeader header = dump_header(this->kmer_size, 0, this->genomic_counts, abundance_peak, "");
+	outfile.write((const char*) &header, sizeof(SortedKmerHeader));
+	vector<RunReader<SortedKmerEntry>*> runs;
+	vector<SortedKmerEntry> current(this->run_files.size());
+	typedef pair<uint64_t, size_t> QueueEntry;
+	priority_queue<QueueEntry, vector<QueueEntry>, greater<QueueEntry>> queue;
+	for (size_t r = 0; r < this->run_files.size(); ++r) {
+		runs.push_back(new RunReader<SortedKmerEntry>(this->run_files[r]));
+		if (runs[r]->next(current[r])) queue.push(QueueEntry(current[r].code, r));
+	}
+	vector<SortedKmerEntry> buffer;
+	while (!queue.empty()) {
+		size_t r = queue.top().second;
+		queue.pop();
+		buffer.push_back(current[r]);
+		header.nr_entries += 1;
+		if (runs[r]->next(current[r])) queue.push(QueueEntry(current[r].code, r));
+		if (buffer.size() >= dump_buffer_entries) {
+			outfile.write((const char*) buffer.data(), buffer.size() * sizeof(SortedKmerEntry));
+			buffer.clear();
+		}
+	}
+	outfile.write((const char*) buffer.data(), buffer.size() * sizeof(SortedKmerEntry));
+	for (size_t r = 0; r < runs.size(); ++r) {
+		delete runs[r];
+		remove(this->run_files[r].c_str());
+	}
+	this->run_files.clear();
+	outfile.seekp(0);
+	outfile.write((const char*) &header, sizeof(SortedKmerHeader));
+	if (!outfile.good()) {
+		throw runtime_error("SortedDumpWriter::finish: error while writing " + this->filename + ".");
+	}
+}
+
+void SortedKmerCounter::write_query_dump(KmerCounter* genomic_kmers, KmerCounter* read_kmers, const vector<jellyfish::mer_dna>& kmers, size_t kmer_size, size_t abundance_peak, const vector<string>& chromosomes, string filename) {
+	if ((genomic_kmers == nullptr) && !read_kmers->storesGenomicCounts()) {
+		throw runtime_error("SortedKmerCounter::write_query_dump: no genomic kmer counts given.");
+	}
+	ResolvedKmerQueries queries(kmer_size);
+	// look up every distinct kmer once
+	vector<pair<uint64_t, size_t>> codes;
+	codes.reserve(kmers.size());
+	for (size_t i = 0; i < kmers.size(); ++i) {
+		codes.push_back(make_pair(queries.encode(kmers[i]), i));
+	}
+	sort(codes.begin(), codes.end());
+	const size_t max_count = numeric_limits<uint32_t>::max();
+	vector<SortedKmerEntry> entries;
+	for (size_t i = 0; i < codes.size(); ++i) {
+		if ((i > 0) && (codes[i].first == codes[i-1].first)) continue;
+		const jellyfish::mer_dna& kmer = kmers[codes[i].second];
+		size_t genomic_count = 0;
+		size_t read_count = 0;
+		if (genomic_kmers == nullptr) {
+			read_kmers->getGenomicAndReadAbundance(kmer, genomic_count, read_count);
+		} else {
+			genomic_count = genomic_kmers->getKmerAbundance(kmer);
+			read_count = read_kmers->getKmerAbundance(kmer);
+		}
+		SortedKmerEntry entry;
+		entry.code = codes[i].first;
+		entry.read_count = min(read_count, max_count);
+		entry.genomic_count = min(genomic_count, max_count);
+		entries.push_back(entry);
+	}
+	write_dump(entries, kmer_size, true, filename, abundance_peak, chromosomes);
+}
+
+bool SortedKmerCounter::resolvesQueriesInBatch() const {
+	return true;
+}
+
+void SortedKmerCounter::resolveQueries(const vector<jellyfish::mer_dna>& kmers) {
+	this->queries.set_queries(kmers);
+	const HugePageVector<uint64_t>& codes = this->queries.get_codes();
+	if (codes.empty()) return;
+
+	int file_descriptor = ::open(this->filename.c_str(), O_RDONLY);
+	if (file_descriptor < 0) {
+		throw runtime_error("SortedKmerCounter::resolveQueries: kmer dump " + this->filename + " cannot be opened.");
+	}
+	posix_fadvise(file_descriptor, 0, 0, POSIX_FADV_SEQUENTIAL);
+	if (lseek(file_descriptor, this->entries_offset, SEEK_SET) < 0) {
+		::close(file_descriptor);
+		throw runtime_error("SortedKmerCounter::resolveQueries: error while reading " + this->filename + ".");
+	}
+
+	// merge the sorted queries with the sorted entries of the dump
+	vector<SortedKmerEntry> buffer(min(dump_buffer_entries, max(this->nr_entries, (size_t) 1)));
+	size_t query = 0;
+	size_t entries_left = this->nr_entries;
+	while ((entries_left > 0) && (query < codes.size())) {
+		size_t to_read = min(entries_left, buffer.size()) * sizeof(SortedKmerEntry);
+		char* position = (char*) buffer.data();
+		size_t bytes = 0;
+		while (bytes < to_read) {
+			ssize_t n = read(file_descriptor, position + bytes, to_read - bytes);
+			if (n <= 0) {
+				::close(file_descriptor);
+				throw runtime_error("SortedKmerCounter::resolveQueries: kmer dump " + this->filename + " is truncated.");
+			}
+			bytes += n;
+		}
+		size_t nr_read = bytes / sizeof(SortedKmerEntry);
+		entries_left -= nr_read;
+		size_t entry = 0;
+		while ((entry < nr_read) && (query < codes.size())) {
+			if (buffer[entry].code < codes[query]) {
+				entry += 1;
+			} else if (codes[query] < buffer[entry].code) {
+				query += 1;
+			} else {
+				this->queries.set_counts(query, buffer[entry].read_count, buffer[entry].genomic_count);
+				entry += 1;
+				query += 1;
+			}
+		}
+	}
+	::close(file_descriptor);
+}
+
+size_t SortedKmerCounter::getKmerAbundance(string kmer) {
+	return getKmerAbundance(jellyfish::mer_dna(kmer));
+}
+
+size_t SortedKmerCounter::getKmerAbundance(jellyfish::mer_dna jelly_kmer) {
+	if (!this->queries.resolved()) {
+		throw runtime_error("SortedKmerCounter::getKmerAbundance: queries need to be resolved before kmers can be looked up.");
+	}
+	size_t read_count = 0;
+	size_t genomic_count = 0;
+	this->queries.get_counts(jelly_kmer, read_count, genomic_count);
+	return read_count;
+}
+
+bool SortedKmerCounter::storesGenomicCounts() const {
+	return this->genomic_counts;
+}
+
+void SortedKmerCounter::getGenomicAndReadAbundance(jellyfish::mer_dna jelly_kmer, size_t& genomic_count, size_t& read_count) {
+	if (!this->genomic_counts) {
+		throw runtime_error("SortedKmerCounter::getGenomicAndReadAbundance: dump does not contain genomic counts.");
+	}
+	if (!this->queries.resolved()) {
+		throw runtime_error("SortedKmerCounter::getGenomicAndReadAbundance: queries need to be resolved before kmers can be looked up.");
+	}
+	this->queries.get_counts(jelly_kmer, read_count, genomic_count);
+}
+
+size_t SortedKmerCounter::computeKmerCoverage(size_t genome_kmers) {
+	throw runtime_error("SortedKmerCounter::computeKmerCoverage: not supported for sorted kmer dumps.");
+}
+
+size_t SortedKmerCounter::computeHistogram(size_t max_count, bool largest_peak, string filename) {
+	if (this->abundance_peak == 0) {
+		throw runtime_error("SortedKmerCounter::computeHistogram: dump " + this->filename + " does not contain a kmer abundance peak.");
+	}
+	return this->abundance_peak;
+}
+
+size_t SortedKmerCounter::size() const {
+	return this->nr_entries;
+}
+
+const vector<string>& SortedKmerCounter::get_chromosomes() const {
+	return this->chromosomes;
+}
+
+void SortedKmerCounter::check_chromosomes(const vector<string>& chromosomes) const {
+	// the dump contains all kmers
+	if (this->chromosomes.empty()) return;
+	for (const auto& chromosome : chromosomes) {
+		if (find(this->chromosomes.begin(), this->chromosomes.end(), chromosome) == this->chromosomes.end()) {
+			throw runtime_error("SortedKmerCounter::check_chromosomes: kmer dump " + this->filename + " does not cover chromosome " + chromosome + ". It was written for a different set of chromosomes.");
+		}
+	}
+}
@@ -0,0 +1,152 @@
+#ifndef SORTEDKMERCOUNTER_HPP
+#define SORTEDKMERCOUNTER_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "kmercounter.hpp"
+#include "hugepages.hpp"
+
+/**
+* Counts of a sorted set of queried kmers (k <= 31). Kmers are identified by the 2-bit encoding of their
+* canonical version (see ReferenceKmerIndex::encode_canonical). Once resolved, the table is only read,
+* so that it can be shared by several threads.
+**/
+
+class ResolvedKmerQueries {
+public:
+	ResolvedKmerQueries(size_t kmer_size);
+	/** set the queries to be resolved (duplicates are removed), all counts are reset to 0 **/
+	void set_queries(const std::vector<jellyfish::mer_dna>& kmers);
+	/** true if queries were set **/
+	bool resolved() const;
+	size_t size() const;
+	/** sorted codes of the queried kmers **/
+	const HugePageVector<uint64_t>& get_codes() const;
+	/** index of the given code in get_codes(), or size() if it was not queried **/
+	size_t find(uint64_t code) const;
+	void set_counts(size_t index, uint32_t read_count, uint32_t genomic_count);
+	/** counts of a queried kmer. Throws if the kmer was not part of the queries. **/
+	void get_counts(jellyfish::mer_dna jelly_kmer, size_t& read_count, size_t& genomic_count) const;
+	/** canonical code of a kmer **/
+	uint64_t encode(const jellyfish::mer_dna& jelly_kmer) const;
+
+private:
+	size_t kmer_size;
+	bool is_resolved;
+	HugePageVector<uint64_t> codes;
+	HugePageVector<uint32_t> read_counts;
+	HugePageVector<uint32_t> genomic_counts;
+};
+
+/**
+* Entry of a sorted kmer count dump.
+**/
+
+struct SortedKmerEntry {
+	uint64_t code;
+	uint32_t read_count;
+	uint32_t genomic_count;
+};
+
+struct SortedKmerHeader {
+	char magic[8];
+	uint64_t kmer_size;
+	uint64_t nr_entries;
+	uint64_t genomic_counts;
+	uint64_t abundance_peak;
+	/** length in bytes of the list of chromosome names that follows the header (each name terminated by a newline) **/
+	uint64_t chromosomes_length;
+};
+
+/**
+* Writes a dump (see SortedKmerCounter) of entries given in any order with distinct codes. At most run_size entries
+* are kept in memory: larger inputs are sorted in runs, which are stored in temporary files next to the dump
+* (<filename>.run<i>) and merged afterwards.
+**/
+
+class SortedDumpWriter {
+public:
+	SortedDumpWriter(std::string filename, size_t kmer_size, bool genomic_counts, size_t run_size = 50000000);
+	void add(const SortedKmerEntry& entry);
+	/** write the dump, no entries can be added afterwards **/
+	void finish(size_t abundance_peak = 0);
+
+private:
+	std::string filename;
+	size_t kmer_size;
+	bool genomic_counts;
+	size_t run_size;
+	std::vector<SortedKmerEntry> entries;
+	std::vector<std::string> run_files;
+	/** sort the entries in memory and write them to a new run **/
+	void write_run();
+};
+
+/**
+* Resolves kmer queries against a dump of kmer counts sorted by canonical code (SortedKmerHeader, the names
+* of the chromosomes whose kmers the dump covers and SortedKmerEntry records). An empty chromosome list means
+* that the dump contains all kmers. Instead of probing a hash table for every kmer, all kmers that will be
+* queried are collected upfront (UniqueKmerComputer::collect_query_kmers), sorted and resolved in a single
+* sequential merge over the dump. Afterwards, getKmerAbundance() answers from the (small) table of resolved
+* queries. Kmers that were not part of the queries cannot be looked up.
+**/
+
+class SortedKmerCounter : public KmerCounter {
+public:
+	/** open an existing dump (only the header is read until queries are resolved) **/
+	SortedKmerCounter(std::string filename, size_t kmer_size);
+
+	/**
+	* sort the entries by code and write them to a dump. genomic_counts indicates whether the genomic counts of the entries are set.
+	* abundance_peak is the kmer abundance peak of the read counts the entries were taken from (0 if unknown).
+	* chromosomes are the chromosomes whose kmers the entries cover (empty if they contain all kmers).
+	**/
+	static void write_dump(std::vector<SortedKmerEntry>& entries, size_t kmer_size, bool genomic_counts, std::string filename, size_t abundance_peak = 0, const std::vector<std::string>& chromosomes = std::vector<std::string>());
+
+	/**
+	* write a dump of the genomic and read counts of the given kmers only (as collected by UniqueKmerComputer::collect_query_kmers),
+	* together with the kmer abundance peak of the reads. Such a dump is all that is needed to genotype the variants
+	* the kmers were collected from, without the reads or the full kmer counts.
+	* @param genomic_kmers genomic counts. If nullptr, they are taken from read_kmers (storesGenomicCounts()).
+	* @param chromosomes names of the chromosomes the kmers were collected from
+	**/
+	static void write_query_dump(KmerCounter* genomic_kmers, KmerCounter* read_kmers, const std::vector<jellyfish::mer_dna>& kmers, size_t kmer_size, size_t abundance_peak, const std::vector<std::string>& chromosomes, std::string filename);
+
+	bool resolvesQueriesInBatch() const;
+
+	/** look up the counts of all given kmers in one pass over the dump **/
+	void resolveQueries(const std::vector<jellyfish::mer_dna>& kmers);
+
+	/** read abundance of a resolved kmer **/
+	size_t getKmerAbundance(std::string kmer);
+	size_t getKmerAbundance(jellyfish::mer_dna jelly_kmer);
+
+	bool storesGenomicCounts() const;
+	void getGenomicAndReadAbundance(jellyfish::mer_dna jelly_kmer, size_t& genomic_count, size_t& read_count);
+
+	/** not supported, since only the queried kmers are kept in memory (compute the histogram before dumping) **/
+	size_t computeKmerCoverage(size_t genome_kmers);
+	/** returns the abundance peak stored in the dump (no histogram is written), throws if there is none **/
+	size_t computeHistogram(size_t max_count, bool largest_peak, std::string filename = "");
+
+	/** number of kmers in the dump **/
+	size_t size() const;
+
+	/** chromosomes covered by the dump (empty if it contains all kmers) **/
+	const std::vector<std::string>& get_chromosomes() const;
+	/** throws if the dump does not cover all given chromosomes **/
+	void check_chromosomes(const std::vector<std::string>& chromosomes) const;
+
+private:
+	std::string filename;
+	size_t kmer_size;
+	size_t nr_entries;
+	bool genomic_counts;
+	size_t abundance_peak;
+	std::vector<std::string> chromosomes;
+	size_t entries_offset;
+	ResolvedKmerQueries queries;
+};
+
+#endif // SORTEDKMERCOUNTER_HPP
@@ -1,21 +1,58 @@
 #include "uniquekmercomputer.hpp"
+#include "kmerextractor.hpp"
 #include <jellyfish/mer_dna.hpp>
 #include <iostream>
+#include <stdexcept>
 #include <cassert>
 #include <map>
+#include <algorithm>
 
 using namespace std;
 
-void unique_kmers(DnaSequence& allele, unsigned char index, size_t kmer_size, map<jellyfish::mer_dna, vector<unsigned char>>& occurences) {
+// enumerates the kmers of an allele that consists of at least kmer_size bases and ends with a kmer without undefined bases (kmer_size <= 32)
+void unique_kmers_extracted(const string& allele, unsigned char index, size_t kmer_size, map<jellyfish::mer_dna, vector<unsigned char>>& occurences, map<jellyfish::mer_dna, size_t>* positions) {
+	KmerExtractor extractor(kmer_size, false);
+	vector<uint64_t> codes;
+	vector<uint32_t> starts;
+	extractor.extract(allele, codes, &starts);
+	// sort the kmers by code and position, so that equal kmers are adjacent and the first one is the leftmost
+	vector<pair<uint64_t, uint32_t>> kmers(codes.size());
+	for (size_t i = 0; i < codes.size(); ++i) {
+		kmers[i] = make_pair(codes[i], starts[i]);
+	}
+	sort(kmers.begin(), kmers.end());
+	size_t i = 0;
+	while (i < kmers.size()) {
+		size_t j = i + 1;
+		while ((j < kmers.size()) && (kmers[j].first == kmers[i].first)) ++j;
+		jellyfish::mer_dna kmer(allele.substr(kmers[i].second, kmer_size));
+		// remember where kmer starts on the allele (first allele it was seen on)
+		if (positions != nullptr) positions->insert(make_pair(kmer, kmers[i].second));
+		// kmer unique to allele
+		if (j - i == 1) occurences[kmer].push_back(index);
+		i = j;
+	}
+}
+
+void unique_kmers(DnaSequence& allele, unsigned char index, size_t kmer_size, map<jellyfish::mer_dna, vector<unsigned char>>& occurences, map<jellyfish::mer_dna, size_t>* positions = nullptr) {
+	jellyfish::mer_dna::k(kmer_size);
+	if ((kmer_size <= 32) && (allele.size() >= kmer_size)) {
+		string sequence = allele.to_string();
+		if (sequence.find_first_not_of("ACGTacgt", sequence.size() - kmer_size) == string::npos) {
+			unique_kmers_extracted(sequence, index, kmer_size, occurences, positions);
+			return;
+		}
+	}
 	//enumerate kmers
 	map<jellyfish::mer_dna, size_t> counts;
 	size_t extra_shifts = kmer_size;
-	jellyfish::mer_dna::k(kmer_size);
 	jellyfish::mer_dna current_kmer("");
 	for (size_t i = 0; i < allele.size(); ++i) {
 		char current_base = allele[i];
 		if (extra_shifts == 0) {
 			counts[current_kmer] += 1;
+			// remember where kmer starts on the allele (first allele it was seen on)
+			if (positions != nullptr) positions->insert(make_pair(current_kmer, i - kmer_size));
 		}
 		if (  ( current_base != 'A') && (current_base != 'C') && (current_base != 'G') && (current_base != 'T') ) {
 			extra_shifts = kmer_size + 1;
@@ -24,6 +61,7 @@ void unique_kmers(DnaSequence& allele, unsigned char index, size_t kmer_size, ma
 		if (extra_shifts > 0) extra_shifts -= 1;
 	}
 	counts[current_kmer] += 1;
+	if ((positions != nullptr) && (allele.size() >= kmer_size)) positions->insert(make_pair(current_kmer, allele.size() - kmer_size));
 
 	// determine kmers unique to allele
 	for (auto const& entry : counts) {
@@ -31,37 +69,94 @@ void unique_kmers(DnaSequence& allele, unsigned char index, size_t kmer_size, ma
 	}
 }
 
-UniqueKmerComputer::UniqueKmerComputer (KmerCounter* genomic_kmers, KmerCounter* read_kmers, VariantReader* variants, string chromosome, size_t kmer_coverage)
+struct KmerCandidate {
+	jellyfish::mer_dna kmer;
+	vector<unsigned char> alleles;
+	// number of paths covering the kmer
+	size_t nr_paths;
+	// allele and kmer-sized window of the allele the kmer starts in
+	pair<unsigned char, size_t> window;
+	// number of better ranked candidates in the same window / on the same allele
+	size_t window_rank;
+	size_t allele_rank;
+};
+
+void rank_kmer_candidates(vector<KmerCandidate>& candidates, size_t nr_paths) {
+	// kmers splitting the paths into two groups of similar size are the most informative
+	auto score = [nr_paths](const KmerCandidate& c) { return min(c.nr_paths, nr_paths - c.nr_paths); };
+	stable_sort(candidates.begin(), candidates.end(), [&score](const KmerCandidate& a, const KmerCandidate& b) {
+		return score(a) > score(b);
+	});
+	// spread kmers along the alleles: first take the best kmer of each window, then the second best, ...
+	map<pair<unsigned char, size_t>, size_t> window_taken;
+	for (auto& candidate : candidates) {
+		candidate.window_rank = window_taken[candidate.window]++;
+	}
+	stable_sort(candidates.begin(), candidates.end(), [&score](const KmerCandidate& a, const KmerCandidate& b) {
+		if (a.window_rank != b.window_rank) return a.window_rank < b.window_rank;
+		if (score(a) != score(b)) return score(a) > score(b);
+		return a.window.second < b.window.second;
+	});
+	// spread kmers over the alleles: every allele gets its next kmer before any allele gets another one
+	map<unsigned char, size_t> allele_taken;
+	for (auto& candidate : candidates) {
+		candidate.allele_rank = allele_taken[candidate.window.first]++;
+	}
+	stable_sort(candidates.begin(), candidates.end(), [](const KmerCandidate& a, const KmerCandidate& b) {
+		return a.allele_rank < b.allele_rank;
+	});
+}
+
+UniqueKmerComputer::UniqueKmerComputer (KmerCounter* genomic_kmers, KmerCounter* read_kmers, VariantReader* variants, size_t contig_id, size_t kmer_coverage, size_t max_kmers)
 	:genomic_kmers(genomic_kmers),
 	 read_kmers(read_kmers),
 	 variants(variants),
-	 chromosome(chromosome),
-	 kmer_coverage(kmer_coverage)
+	 contig_id(contig_id),
+	 kmer_coverage(kmer_coverage),
+	 max_kmers(max_kmers)
 {
+	if ((genomic_kmers == nullptr) && !read_kmers->storesGenomicCounts()) {
+		throw runtime_error("UniqueKmerComputer::UniqueKmerComputer: no genomic kmer counts given.");
+	}
 	jellyfish::mer_dna::k(this->variants->get_kmer_size());
 }
 
+void UniqueKmerComputer::lookup_counts(const jellyfish::mer_dna& kmer, size_t& genomic_count, size_t& read_count, bool& read_count_known) const {
+	if (this->genomic_kmers == nullptr) {
+		// both counts are stored in the same entry
+		this->read_kmers->getGenomicAndReadAbundance(kmer, genomic_count, read_count);
+		read_count_known = true;
+	} else {
+		genomic_count = this->genomic_kmers->getKmerAbundance(kmer);
+		read_count_known = false;
+	}
+}
+
 
-void UniqueKmerComputer::compute_unique_kmers(vector<UniqueKmers*>* result, ProbabilityTable* probabilities) {
-	size_t nr_variants = this->variants->size_of(this->chromosome);
+void UniqueKmerComputer::compute_unique_kmers(vector<UniqueKmers*>* result, ProbabilityTable* probabilities, Arena* arena) {
+	const vector<Variant>& variants = this->variants->variants(this->contig_id);
+	size_t nr_variants = variants.size();
+	size_t kmer_size = this->variants->get_kmer_size();
 	for (size_t v = 0; v < nr_variants; ++v) {
 
 		// set parameters of distributions
-		size_t kmer_size = this->variants->get_kmer_size();
-		double kmer_coverage = compute_local_coverage(this->chromosome, v, 2*kmer_size);
+		double kmer_coverage = compute_local_coverage(this->contig_id, v, 2*kmer_size);
 		
 		map <jellyfish::mer_dna, vector<unsigned char>> occurences;
-		const Variant& variant = this->variants->get_variant(this->chromosome, v);
-		UniqueKmers* u = new UniqueKmers(variant.get_start_position());
+		map <jellyfish::mer_dna, size_t> positions;
+		const Variant& variant = variants[v];
+		UniqueKmers* u = (arena != nullptr) ? arena->create<UniqueKmers>(variant.get_start_position(), arena) : new UniqueKmers(variant.get_start_position());
 		u->set_coverage(kmer_coverage);
 		size_t nr_alleles = variant.nr_of_alleles();
 
 		// insert empty alleles (to also capture paths for which no unique kmers exist)
 		assert(variant.nr_of_paths() < 65535);
+		vector<size_t> paths_per_allele(nr_alleles, 0);
 		for (unsigned short p = 0; p < variant.nr_of_paths(); ++p) {
 			unsigned char a = variant.get_allele_on_path(p);
 			u->insert_empty_allele(a);
 			u->insert_path(p,a);
+			paths_per_allele[a] += 1;
 		}
 
 		for (unsigned char a = 0; a < nr_alleles; ++a) {
@@ -72,37 +167,55 @@ void UniqueKmerComputer::compute_unique_kmers(vector<UniqueKmers*>* result, Prob
 				continue;
 			}
 			DnaSequence allele = variant.get_allele_sequence(a);
-			unique_kmers(allele, a, kmer_size, occurences);
+			unique_kmers(allele, a, kmer_size, occurences, &positions);
+		}
+
+		// determine on how many paths each kmer occurs (no lookups needed)
+		vector<KmerCandidate> candidates;
+		for (auto& kmer : occurences) {
+			size_t nr_paths = 0;
+			for (auto& allele : kmer.second) {
+				nr_paths += paths_per_allele[allele];
+			}
+
+			// skip kmer that does not occur on any path (uncovered allele)
+			if (nr_paths == 0) {
+				continue;
+			}
+
+			// skip kmer that occurs on all paths (they do not give any information about a genotype)
+			if (nr_paths == variant.nr_of_paths()) {
+				continue;
+			}
+
+			KmerCandidate candidate;
+			candidate.kmer = kmer.first;
+			candidate.alleles = kmer.second;
+			candidate.nr_paths = nr_paths;
+			candidate.window = make_pair(kmer.second[0], positions.at(kmer.first) / kmer_size);
+			candidates.push_back(candidate);
+		}
+
+		// if there are more candidates than can be used, look at the most informative ones first
+		if (candidates.size() > this->max_kmers) {
+			rank_kmer_candidates(candidates, variant.nr_of_paths());
 		}
 
 		// check if kmers occur elsewhere in the genome
 		size_t nr_kmers_used = 0;
-		for (auto& kmer : occurences) {
-			if (nr_kmers_used > 300) break;
+		for (auto& candidate : candidates) {
+			if (nr_kmers_used >= this->max_kmers) break;
 
-			size_t genomic_count = this->genomic_kmers->getKmerAbundance(kmer.first);
-			size_t local_count = kmer.second.size();
+			size_t genomic_count = 0;
+			size_t read_kmercount = 0;
+			bool read_count_known = false;
+			lookup_counts(candidate.kmer, genomic_count, read_kmercount, read_count_known);
+			size_t local_count = candidate.alleles.size();
 
 			if ( (genomic_count - local_count) == 0 ) {
 				// kmer unique to this region
 				// determine read kmercount for this kmer
-				size_t read_kmercount = this->read_kmers->getKmerAbundance(kmer.first);
-
-				// determine on which paths kmer occurs
-				vector<size_t> paths;
-				for (auto& allele : kmer.second) {
-					variant.get_paths_of_allele(allele, paths);
-				}
-
-				// skip kmer that does not occur on any path (uncovered allele)
-				if (paths.size() == 0) {
-					continue;
-				}
-
-				// skip kmer that occurs on all paths (they do not give any information about a genotype)
-				if (paths.size() == variant.nr_of_paths()) {
-					continue;
-				}
+				if (!read_count_known) read_kmercount = this->read_kmers->getKmerAbundance(candidate.kmer);
 
 				// skip kmers with "too extreme" counts
 				// TODO: value ok?
@@ -119,7 +232,7 @@ void UniqueKmerComputer::compute_unique_kmers(vector<UniqueKmers*>* result, Prob
 				// skip kmers with only 0 probabilities
 				if ( (p_cn0 > 0) || (p_cn1 > 0) || (p_cn2 > 0) ) {
 					nr_kmers_used += 1;
-					u->insert_kmer(read_kmercount, kmer.second);
+					u->insert_kmer(read_kmercount, candidate.alleles);
 				}
 			}
 		}
@@ -127,12 +240,34 @@ void UniqueKmerComputer::compute_unique_kmers(vector<UniqueKmers*>* result, Prob
 	}
 }
 
+void UniqueKmerComputer::collect_query_kmers(vector<jellyfish::mer_dna>& kmers) const {
+	const vector<Variant>& variants = this->variants->variants(this->contig_id);
+	size_t kmer_size = this->variants->get_kmer_size();
+	for (size_t v = 0; v < variants.size(); ++v) {
+		// enumerate kmers the same way compute_unique_kmers does, so that every kmer looked up there is included
+		map <jellyfish::mer_dna, vector<unsigned char>> occurences;
+		const Variant& variant = variants[v];
+		for (unsigned char a = 0; a < variant.nr_of_alleles(); ++a) {
+			if (variant.is_undefined_allele(a)) continue;
+			DnaSequence allele = variant.get_allele_sequence(a);
+			unique_kmers(allele, a, kmer_size, occurences);
+		}
+		DnaSequence left_overhang;
+		DnaSequence right_overhang;
+		this->variants->get_left_overhang(this->contig_id, v, 2*kmer_size, left_overhang);
+		this->variants->get_right_overhang(this->contig_id, v, 2*kmer_size, right_overhang);
+		unique_kmers(left_overhang, 0, kmer_size, occurences);
+		unique_kmers(right_overhang, 1, kmer_size, occurences);
+		for (auto& kmer : occurences) {
+			kmers.push_back(kmer.first);
+		}
+	}
+}
+
 void UniqueKmerComputer::compute_empty(vector<UniqueKmers*>* result) const {
-	size_t nr_variants = this->variants->size_of(this->chromosome);
-	for (size_t v = 0; v < nr_variants; ++v) {
-		const Variant& variant = this->variants->get_variant(this->chromosome, v);
+	const vector<Variant>& variants = this->variants->variants(this->contig_id);
+	for (const Variant& variant : variants) {
 		UniqueKmers* u = new UniqueKmers(variant.get_start_position());
-		size_t nr_alleles = variant.nr_of_alleles();
 
 		// insert empty alleles and paths
 		assert(variant.nr_of_paths() < 65535);
@@ -145,14 +280,14 @@ void UniqueKmerComputer::compute_empty(vector<UniqueKmers*>* result) const {
 	}
 }
 
-unsigned short UniqueKmerComputer::compute_local_coverage(string chromosome, size_t var_index, size_t length) {
+unsigned short UniqueKmerComputer::compute_local_coverage(size_t contig_id, size_t var_index, size_t length) {
 	DnaSequence left_overhang;
 	DnaSequence right_overhang;
 	size_t total_coverage = 0;
 	size_t total_kmers = 0;
 
-	this->variants->get_left_overhang(chromosome, var_index, length, left_overhang);
-	this->variants->get_right_overhang(chromosome, var_index, length, right_overhang);
+	this->variants->get_left_overhang(contig_id, var_index, length, left_overhang);
+	this->variants->get_right_overhang(contig_id, var_index, length, right_overhang);
 
 	size_t kmer_size = this->variants->get_kmer_size();
 	map <jellyfish::mer_dna, vector<unsigned char>> occurences;
@@ -160,9 +295,12 @@ unsigned short UniqueKmerComputer::compute_local_coverage(string chromosome, siz
 	unique_kmers(right_overhang, 1, kmer_size, occurences);
 
 	for (auto& kmer : occurences) {
-		size_t genomic_count = this->genomic_kmers->getKmerAbundance(kmer.first);
+		size_t genomic_count = 0;
+		size_t read_count = 0;
+		bool read_count_known = false;
+		lookup_counts(kmer.first, genomic_count, read_count, read_count_known);
 		if (genomic_count == 1) {
-			size_t read_count = this->read_kmers->getKmerAbundance(kmer.first);
+			if (!read_count_known) read_count = this->read_kmers->getKmerAbundance(kmer.first);
 			// ignore too extreme counts
 			if ( (read_count < (this->kmer_coverage/4)) || (read_count > (this->kmer_coverage*4)) ) continue;
 			total_coverage += read_count;
@@ -11,14 +11,20 @@
 class UniqueKmerComputer {
 public:
 	/** 
-	* @param genomic_kmers genomic kmer counts
+	* @param genomic_kmers genomic kmer counts. If nullptr, genomic counts are taken from read_kmers (storesGenomicCounts()), which needs one lookup per kmer.
 	* @param read_kmers read kmer counts
 	* @param variants 
+	* @param contig_id contig (chromosome) id as given by the VariantReader
 	* @param kmer_coverage needed to compute kmer copy number probabilities
+	* @param max_kmers maximum number of unique kmers used per variant. If a variant has more candidates, the ones best
+	* separating the paths and spread along the alleles are used and abundances of the remaining ones are never looked up.
 	**/
-	UniqueKmerComputer (KmerCounter* genomic_kmers, KmerCounter* read_kmers, VariantReader* variants, std::string chromosome, size_t kmer_coverage);
-	/** generates UniqueKmers object for each position, ownership of vector is transferred to the caller. **/
-	void compute_unique_kmers(std::vector<UniqueKmers*>* result, ProbabilityTable* probabilities);
+	UniqueKmerComputer (KmerCounter* genomic_kmers, KmerCounter* read_kmers, VariantReader* variants, size_t contig_id, size_t kmer_coverage, size_t max_kmers = 300);
+	/** generates UniqueKmers object for each position, ownership of vector is transferred to the caller. If an arena is given,
+	* the UniqueKmers are allocated in it and must not be deleted, they are freed together with the arena. **/
+	void compute_unique_kmers(std::vector<UniqueKmers*>* result, ProbabilityTable* probabilities, Arena* arena = nullptr);
+	/** appends all kmers whose counts compute_unique_kmers may look up (allele kmers and kmers of the flanking regions used for local coverage) **/
+	void collect_query_kmers(std::vector<jellyfish::mer_dna>& kmers) const;
 	/** generates empty UniwueKmers objects for each position (no kmers, only paths). Ownership of vector is transferred to caller. **/
 	void compute_empty(std::vector<UniqueKmers*>* result) const;
 
@@ -26,15 +32,18 @@ private:
 	KmerCounter* genomic_kmers;
 	KmerCounter* read_kmers;
 	VariantReader* variants;
-	std::string chromosome;
+	size_t contig_id;
 	size_t kmer_coverage;
+	size_t max_kmers;
 	/** compute local coverage in given interval based on unique kmers 
-	* @param chromosome chromosome
+	* @param contig_id contig id
 	* @param var_index variant index
 	* @param length how far to go left and right of the variant
 	* @returns computed coverage
 	**/
-	unsigned short compute_local_coverage(std::string chromosome, size_t var_index, size_t length);
+	unsigned short compute_local_coverage(size_t contig_id, size_t var_index, size_t length);
+	/** determine the genomic count of a kmer and, if available in the same lookup, its read count **/
+	void lookup_counts(const jellyfish::mer_dna& kmer, size_t& genomic_count, size_t& read_count, bool& read_count_known) const;
 };
 
 #endif // UNIQUEKMERCOMPUTER_HPP
@@ -4,9 +4,13 @@
 
 using namespace std;
 
-UniqueKmers::UniqueKmers(size_t variant_position)
+UniqueKmers::UniqueKmers(size_t variant_position, Arena* arena)
 	:variant_pos(variant_position),
 	 current_index(0),
+	 kmer_to_count(ArenaAllocator<unsigned short>(arena)),
+	 alleles(ArenaAllocator<pair<const unsigned char, pair<KmerPath, bool>>>(arena)),
+	 allele_kmer_counts(ArenaAllocator<unsigned short>(arena)),
+	 path_to_allele(ArenaAllocator<pair<const unsigned short, unsigned char>>(arena)),
 	 local_coverage(0)
 {}
 
@@ -14,8 +18,23 @@ size_t UniqueKmers::get_variant_position() {
 	return this->variant_pos;
 }
 
+KmerPath& UniqueKmers::allele_path(unsigned char allele_id) {
+	auto it = this->alleles.find(allele_id);
+	if (it == this->alleles.end()) {
+		// map::operator[] would default-construct a KmerPath on the heap
+		it = this->alleles.emplace(allele_id, make_pair(KmerPath(this->kmer_to_count.get_allocator().get_arena()), false)).first;
+	}
+	return it->second.first;
+}
+
 void UniqueKmers::insert_empty_allele(unsigned char allele_id, bool is_undefined) {
-	this->alleles[allele_id] = make_pair(KmerPath(), is_undefined); 
+	auto it = this->alleles.find(allele_id);
+	if (it == this->alleles.end()) {
+		this->alleles.emplace(allele_id, make_pair(KmerPath(this->kmer_to_count.get_allocator().get_arena()), is_undefined));
+	} else {
+		it->second = make_pair(KmerPath(this->kmer_to_count.get_allocator().get_arena()), is_undefined);
+	}
+	if (allele_id < this->allele_kmer_counts.size()) this->allele_kmer_counts[allele_id] = 0;
 }
 
 void UniqueKmers::insert_path(unsigned short path_id, unsigned char allele_id) {
@@ -26,7 +45,11 @@ void UniqueKmers::insert_kmer(unsigned short readcount,  vector<unsigned char>&
 	size_t index = this->current_index;
 	this->kmer_to_count.push_back(readcount);
 	for (auto const& a: alleles){
-		this->alleles[a].first.set_position(index);
+		KmerPath& path = allele_path(a);
+		if (path.get_position(index) > 0) continue;
+		path.set_position(index);
+		if (a >= this->allele_kmer_counts.size()) this->allele_kmer_counts.resize(a + 1, 0);
+		this->allele_kmer_counts[a] += 1;
 	}
 	current_index += 1;
 }
@@ -126,11 +149,16 @@ unsigned short UniqueKmers::get_coverage() const {
 map<unsigned char, int> UniqueKmers::kmers_on_alleles () const {
 	map<unsigned char, int> result;
 	for (auto it = this->alleles.begin(); it != this->alleles.end(); ++it) {
-		result[it->first] = alleles.at(it->first).first.nr_kmers();
+		result[it->first] = kmers_on_allele(it->first);
 	}
 	return result;
 }
 
+int UniqueKmers::kmers_on_allele (unsigned char allele_id) const {
+	if (allele_id < this->allele_kmer_counts.size()) return this->allele_kmer_counts[allele_id];
+	return 0;
+}
+
 bool UniqueKmers::is_undefined_allele (unsigned char allele_id) const {
 	// check if allele id exists
 	auto it = this->alleles.find(allele_id);
@@ -146,5 +174,5 @@ void UniqueKmers::set_undefined_allele (unsigned char allele_id) {
 	if (it == this->alleles.end()) {
 		throw runtime_error("UniqueKmers::set_undefined_allele: allele_id " + to_string(allele_id) + " does not exist.");
 	}
-	this->alleles[allele_id].second = true;
+	it->second.second = true;
 }
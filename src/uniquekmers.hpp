@@ -7,6 +7,7 @@
 #include <utility>
 #include "copynumber.hpp"
 #include "kmerpath.hpp"
+#include "arena.hpp"
 
 /*
 * Represents the set of unique kmers for a variant position.
@@ -18,8 +19,9 @@ public:
 	/**
 	* @param variant_id variant identifier
 	* @param variant_position genomic variant position
+	* @param arena if given, all data is stored in this arena (see UniqueKmerComputer::compute_unique_kmers)
 	**/
-	UniqueKmers(size_t variant_position);
+	UniqueKmers(size_t variant_position, Arena* arena = nullptr);
 	size_t get_variant_position();
 	/** insert empty allele (no kmers) **/
 	void insert_empty_allele(unsigned char allele_id, bool is_undefined = false);
@@ -50,6 +52,8 @@ public:
 	unsigned short get_coverage() const;
 	/** returns a map which contains the number of unique kmers covering each allele **/
 	std::map<unsigned char, int> kmers_on_alleles () const;
+	/** returns the number of unique kmers covering the given allele (0 if allele does not exist) **/
+	int kmers_on_allele (unsigned char allele_id) const;
 	/** check whether allele is undefined **/
 	bool is_undefined_allele (unsigned char allele_id) const;
 	/** set allele to undefined **/
@@ -58,11 +62,15 @@ public:
 private:
 	size_t variant_pos;
 	size_t current_index;
-	std::vector<unsigned short> kmer_to_count;
+	ArenaVector<unsigned short> kmer_to_count;
 	// stores kmers of each allele and whether the allele is undefined
-	std::map<unsigned char, std::pair<KmerPath, bool>> alleles;
-	std::map<unsigned short, unsigned char> path_to_allele;
+	ArenaMap<unsigned char, std::pair<KmerPath, bool>> alleles;
+	// number of unique kmers on each allele (indexed by allele id), updated while kmers are inserted
+	ArenaVector<unsigned short> allele_kmer_counts;
+	ArenaMap<unsigned short, unsigned char> path_to_allele;
 	unsigned short local_coverage;
+	/** kmers of the given allele, an empty allele is added if it does not exist yet **/
+	KmerPath& allele_path(unsigned char allele_id);
 	friend class EmissionProbabilityComputer;
 	
 };
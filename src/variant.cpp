@@ -56,7 +56,8 @@ Variant::Variant(string left_flank, string right_flank, string chromosome, size_
 	 start_position(start_position),
 	 variant_ids({variant_id}),
 	 paths(paths),
-	 flanks_added(false)
+	 flanks_added(false),
+	 released(false)
 
 {
 	if (alleles.size() > 255) {
@@ -83,7 +84,8 @@ Variant::Variant(DnaSequence& left_flank, DnaSequence& right_flank, string chrom
 	 start_position(start_position),
 	 variant_ids({variant_id}),
 	 paths(paths),
-	 flanks_added(false)
+	 flanks_added(false),
+	 released(false)
 {
 	if (alleles.size() > 255) {
 		throw runtime_error("Variant::Variant: number of alleles per variant exceeds 256. Current implementation does not support higher numbers.");
@@ -157,6 +159,9 @@ size_t Variant::nr_of_paths() const {
 }
 
 string Variant::get_allele_string(size_t index) const {
+	if (this->released) {
+		throw runtime_error("Variant::get_allele_string: allele sequences have been released.");
+	}
 	if (index < this->allele_combinations.size()) {
 		DnaSequence result;
 		if (this->flanks_added) {
@@ -179,6 +184,9 @@ string Variant::get_allele_string(size_t index) const {
 }
 
 DnaSequence Variant::get_allele_sequence(size_t index) const {
+	if (this->released) {
+		throw runtime_error("Variant::get_allele_sequence: allele sequences have been released.");
+	}
 	if (index < this->allele_combinations.size()) {
 		DnaSequence result;
 		if (this->flanks_added) {
@@ -215,7 +223,7 @@ size_t Variant::get_end_position() const {
 	return end_position;
 }
 
-string Variant::get_chromosome() const {
+const string& Variant::get_chromosome() const {
 	return this->chromosome;
 }
 
@@ -306,6 +314,9 @@ void Variant::combine_variants (Variant const &v2){
 }
 
 void Variant::separate_variants (vector<Variant>* resulting_variants, const GenotypingResult* input_genotyping, vector<GenotypingResult>* resulting_genotyping) const {
+	if (this->released) {
+		throw runtime_error("Variant::separate_variants: allele sequences have been released.");
+	}
 	size_t nr_variants = this->allele_sequences.size();
 	assert (this->uncovered_alleles.size() == nr_variants);
 
@@ -347,47 +358,79 @@ void Variant::separate_variants (vector<Variant>* resulting_variants, const Geno
 		Variant v(left, right, this->chromosome, current_start, current_end, alleles, paths_per_variant.at(i), this->variant_ids.at(i));
 
 		resulting_variants->push_back(v);
-		if (input_genotyping != nullptr) {
-			// construct GenotypingResult
-			GenotypingResult g;
-			// precompute alleles
-			vector<unsigned char> precomputed_ids (this->nr_of_alleles());
-			for (size_t a0 = 0; a0 < this->nr_of_alleles(); ++a0) {
-				unsigned char single_allele0 = this->allele_combinations[a0][i];
-				precomputed_ids[a0] = single_allele0;
-			}
-			// iterate through all genotypes and determine the genotype likelihoods for single variant
-			for (size_t a0 = 0; a0 < this->nr_of_alleles(); ++a0) {
-				// determine allele a0 genotype corresponds to
-				unsigned char single_allele0 = precomputed_ids[a0];
-				for (size_t a1 = a0; a1 < this->nr_of_alleles(); ++a1) {
-					// determine allele a1 genotype corresponds to
-					unsigned char single_allele1 = precomputed_ids[a1];
-					// update genotype likelihood
-					long double combined_likelihood = input_genotyping->get_genotype_likelihood(a0, a1);
-					g.add_to_likelihood(single_allele0, single_allele1, combined_likelihood);
-				}
-			}
-			// get the haplotype alleles of the combined variant
-			pair<unsigned char,unsigned char> haplotype = input_genotyping->get_haplotype();
-			// get corresponding alleles for current variant
-			unsigned char single_haplotype0 = precomputed_ids[haplotype.first];
-			unsigned char single_haplotype1 = precomputed_ids[haplotype.second];
-			// update result
-			g.add_first_haplotype_allele(single_haplotype0);
-			g.add_second_haplotype_allele(single_haplotype1);
-			resulting_genotyping->push_back(g);
-		}
 		// update start position
 		current_start = current_end;
 		if (i < (nr_variants-1)) {
 			current_start += this->inner_flanks[i].size();
 		}
 	}
+
+	if (input_genotyping != nullptr) {
+		separate_genotypes(*input_genotyping, *resulting_genotyping);
+	}
+}
+
+void Variant::separate_genotypes (const GenotypingResult& input_genotyping, vector<GenotypingResult>& resulting_genotyping) const {
+	size_t nr_variants = this->nr_of_singleton_variants();
+	size_t nr_alleles = this->nr_of_alleles();
+	vector<unsigned char> precomputed_ids (nr_alleles);
+	for (size_t i = 0; i < nr_variants; ++i) {
+		// construct GenotypingResult
+		GenotypingResult g;
+		// precompute alleles
+		for (size_t a0 = 0; a0 < nr_alleles; ++a0) {
+			precomputed_ids[a0] = this->allele_combinations[a0][i];
+		}
+		// iterate through all genotypes and determine the genotype likelihoods for single variant
+		for (size_t a0 = 0; a0 < nr_alleles; ++a0) {
+			// determine allele a0 genotype corresponds to
+			unsigned char single_allele0 = precomputed_ids[a0];
+			for (size_t a1 = a0; a1 < nr_alleles; ++a1) {
+				// determine allele a1 genotype corresponds to
+				unsigned char single_allele1 = precomputed_ids[a1];
+				// update genotype likelihood
+				long double combined_likelihood = input_genotyping.get_genotype_likelihood(a0, a1);
+				g.add_to_likelihood(single_allele0, single_allele1, combined_likelihood);
+			}
+		}
+		// get the haplotype alleles of the combined variant
+		pair<unsigned char,unsigned char> haplotype = input_genotyping.get_haplotype();
+		// get corresponding alleles for current variant
+		unsigned char single_haplotype0 = precomputed_ids[haplotype.first];
+		unsigned char single_haplotype1 = precomputed_ids[haplotype.second];
+		// update result
+		g.add_first_haplotype_allele(single_haplotype0);
+		g.add_second_haplotype_allele(single_haplotype1);
+		resulting_genotyping.push_back(g);
+	}
+}
+
+size_t Variant::nr_of_singleton_variants() const {
+	return this->allele_combinations.at(0).size();
+}
+
+void Variant::release_sequences() {
+	// allele combinations and start position are all that is needed to separate genotypes.
+	// Allele frequencies must be computed beforehand, since they require the paths.
+	this->left_flank.clear();
+	this->right_flank.clear();
+	vector<DnaSequence>().swap(this->inner_flanks);
+	vector<vector<DnaSequence>>().swap(this->allele_sequences);
+	vector<vector<unsigned char>>().swap(this->uncovered_alleles);
+	vector<string>().swap(this->variant_ids);
+	vector<unsigned char>().swap(this->paths);
+	this->released = true;
+}
+
+bool Variant::sequences_released() const {
+	return this->released;
 }
 
 
 void Variant::variant_statistics (UniqueKmers* unique_kmers, vector<VariantStats>& result) const {
+	if (this->released) {
+		throw runtime_error("Variant::variant_statistics: allele sequences have been released.");
+	}
 	size_t nr_variants = this->allele_sequences.size();
 	assert (this->uncovered_alleles.size() == nr_variants);
 
@@ -404,7 +447,7 @@ void Variant::variant_statistics (UniqueKmers* unique_kmers, vector<VariantStats
 		for (size_t a0 = 0; a0 < this->nr_of_alleles(); ++a0) {
 			unsigned char single_allele0 = precomputed_ids[a0];
 			// update unique kmer counts
-			new_kmer_counts[single_allele0] += unique_kmers->kmers_on_alleles()[a0];
+			new_kmer_counts[single_allele0] += unique_kmers->kmers_on_allele(a0);
 		}
 
 		v.nr_unique_kmers = unique_kmers->size();
@@ -493,6 +536,9 @@ bool operator!=(const Variant& v1, const Variant& v2) {
 }
 
 float Variant::allele_frequency(unsigned char allele_index, bool ignore_ref_path) const {
+	if (this->released) {
+		throw runtime_error("Variant::allele_frequency: paths have been released.");
+	}
 	if (this->paths.size() == 0) {
 		return 0.0;
 	}
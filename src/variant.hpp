@@ -41,6 +41,14 @@ public:
 	void combine_variants (Variant const &v2);
 	/** separate variants that have been combined **/
 	void separate_variants (std::vector<Variant>* resulting_variants, const GenotypingResult* input_genotyping = nullptr, std::vector<GenotypingResult>* resulting_genotyping = nullptr) const;
+	/** separate the genotyping result of a combined variant into results for each individual variant. Also works after sequences were released. **/
+	void separate_genotypes (const GenotypingResult& input_genotyping, std::vector<GenotypingResult>& resulting_genotyping) const;
+	/** number of individual variants this (possibly combined) variant consists of **/
+	size_t nr_of_singleton_variants() const;
+	/** free flanks, allele sequences and paths. Afterwards, only positions and allele combinations are kept (enough to separate genotypes). **/
+	void release_sequences();
+	/** check whether sequences were released **/
+	bool sequences_released() const;
 	/** total number of alleles of the variant **/
 	size_t nr_of_alleles() const;
 	/** total number of paths covering the variant **/
@@ -54,7 +62,7 @@ public:
 	/** get end position of the variant **/
 	size_t get_end_position() const;
 	/** get chromosome **/
-	std::string get_chromosome() const;
+	const std::string& get_chromosome() const;
 	/** check if given allele is covered by the given path **/
 	bool allele_on_path(unsigned char allele_index, size_t path_index) const;
 	/** get index of allele located on given path **/
@@ -98,6 +106,7 @@ private:
 	std::vector<std::vector<unsigned char>> uncovered_alleles;
 	std::vector<unsigned char> paths;
 	bool flanks_added;
+	bool released;
 	void set_values(size_t end_position);
 };
 
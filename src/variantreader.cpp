@@ -2,12 +2,19 @@
 #include <iostream>
 #include <iomanip>
 #include <math.h>
+#include <string.h>
 #include <regex>
+#include <functional>
 #include "variantreader.hpp"
+#include "threadpool.hpp"
+#include "directfilereader.hpp"
 
 
 using namespace std;
 
+// number of variants formatted per job when writing multi-sample VCFs
+static const size_t multisample_block_size = 10000;
+
 void parse_line(vector<DnaSequence>& result, string line, char sep) {
 	string token;
 	istringstream iss (line);
@@ -24,7 +31,7 @@ void parse_line(vector<string>& result, string line, char sep) {
 	}
 }
 
-void VariantReader::insert_ids(string& chromosome, vector<DnaSequence>& alleles, vector<string>& variant_ids, bool reference_added) {
+void VariantReader::insert_ids(size_t contig_id, vector<DnaSequence>& alleles, vector<string>& variant_ids, bool reference_added) {
 	vector<unsigned char> index = construct_index(alleles, reference_added);
 	assert(index.size() < 256);
 	// insert IDs in the lex. order of their corresponding alleles
@@ -32,16 +39,21 @@ void VariantReader::insert_ids(string& chromosome, vector<DnaSequence>& alleles,
 	for (auto id : index) {
 		sorted_ids.push_back(variant_ids[id]);
 	}
-	this->variant_ids[chromosome].push_back(sorted_ids);
+	this->variant_ids.at(contig_id).push_back(sorted_ids);
 }
 
-string VariantReader::get_ids(string chromosome, vector<string>& alleles, size_t variant_index, bool reference_added) {
+void VariantReader::get_allele_ids(size_t contig_id, vector<string>& alleles, size_t variant_index, bool reference_added, vector<string>& result) {
 	vector<unsigned char> index = construct_index(alleles, reference_added);
 	assert(index.size() < 256);
-	vector<string> sorted_ids(index.size());
+	result.assign(index.size(), "");
 	for (unsigned char i = 0; i < index.size(); ++i) {
-		sorted_ids[index[i]] = this->variant_ids.at(chromosome).at(variant_index)[i];
+		result[index[i]] = this->variant_ids.at(contig_id).at(variant_index)[i];
 	}
+}
+
+string VariantReader::get_ids(size_t contig_id, vector<string>& alleles, size_t variant_index, bool reference_added) {
+	vector<string> sorted_ids;
+	get_allele_ids(contig_id, alleles, variant_index, reference_added, sorted_ids);
 
 	string result = "";
 	for (unsigned char i = 0; i < sorted_ids.size(); ++i) {
@@ -86,23 +98,28 @@ VariantReader::VariantReader(string filename, string reference_filename, size_t
 	 nr_variants(0),
 	 add_reference(add_reference),
 	 sample(sample),
+	 nr_multisample_samples(0),
 	 genotyping_outfile_open(false),
-	 phasing_outfile_open(false)
+	 phasing_outfile_open(false),
+	 biallelic_outfile_open(false),
+	 multisample_outfile_open(false),
+	 binary_outfile_open(false)
 {
 	if (filename.substr(filename.size()-3,3).compare(".gz") == 0) {
 		throw runtime_error("VariantReader::VariantReader: Uncompressed VCF-file is required.");
 	}
-	ifstream file(filename);
-	if (!file.good()) {
+	DirectFileReader file(filename);
+	if (!file.is_open()) {
 		throw runtime_error("VariantReader::VariantReader: input VCF file cannot be opened.");
 	}
 	string line;
 	string previous_chrom("");
+	size_t previous_contig = 0;
 	size_t previous_end_pos = 0;
 	map<unsigned int, string> fields = { {0, "#CHROM"}, {1, "POS"}, {2, "ID"}, {3, "REF"}, {4, "ALT"}, {5, "QUAL"}, {6, "FILTER"}, {7, "INFO"}, {8, "FORMAT"} };
 	vector<Variant> variant_cluster;
 	// read VCF-file line by line
-	while (getline(file, line)) {
+	while (file.getline(line)) {
 		if (line.size() == 0) continue;
 		vector<string> tokens;
 		parse_line(tokens, line, '\t');
@@ -146,7 +163,7 @@ VariantReader::VariantReader(string filename, string reference_filename, size_t
 		// if distance to next variant is larger than kmer_size, start a new cluster
 		if ( (previous_chrom != current_chrom) || (current_start_pos - previous_end_pos) >= (kmer_size-1) ) {
 			// merge all variants currently in cluster and store them
-			add_variant_cluster(previous_chrom, &variant_cluster);
+			add_variant_cluster(previous_contig, &variant_cluster);
 			variant_cluster.clear();
 		}
 		// get REF allele
@@ -180,13 +197,16 @@ VariantReader::VariantReader(string filename, string reference_filename, size_t
 			continue;
 		}
 
+		// variant will be kept, make sure its chromosome has a contig id
+		size_t current_contig = register_contig(current_chrom);
+
 		// store mapping of alleles to variant ids
 		vector<string> var_ids;
 		parse_info_fields(var_ids, tokens[7]);
 		if (!var_ids.empty()) {
-			insert_ids(current_chrom, alleles, var_ids, true);
+			insert_ids(current_contig, alleles, var_ids, true);
 		} else {
-			this->variant_ids[current_chrom].push_back(vector<string>());
+			this->variant_ids[current_contig].push_back(vector<string>());
 		}
 
 		// make sure that there are at most 255 paths (including reference path in case it is requested)
@@ -241,11 +261,12 @@ VariantReader::VariantReader(string filename, string reference_filename, size_t
 		Variant variant (left_flank, right_flank, current_chrom, current_start_pos, current_end_pos, alleles, paths);
 		variant_cluster.push_back(variant);
 		previous_chrom = current_chrom;
+		previous_contig = current_contig;
 		previous_end_pos = current_end_pos;
 
 	}
 	// add last cluster to list
-	add_variant_cluster(previous_chrom, &variant_cluster);
+	add_variant_cluster(previous_contig, &variant_cluster);
 	cerr << "Identified " << this->nr_variants << " variants in total from VCF-file." << endl;
 }
 
@@ -253,6 +274,10 @@ size_t VariantReader::get_kmer_size() const {
 	return this->kmer_size;
 }
 
+size_t VariantReader::get_genome_size() const {
+	return this->fasta_reader.get_total_kmers(1);
+}
+
 void VariantReader::write_path_segments(std::string filename) const {
 	ofstream outfile;
 	outfile.open(filename);
@@ -267,9 +292,9 @@ void VariantReader::write_path_segments(std::string filename) const {
 	for (auto element : chromosome_names) {
 		size_t prev_end = 0;
 		// check if chromosome was present in VCF and write allele sequences in this case
-		auto it = this->variants_per_chromosome.find(element);
-		if (it != this->variants_per_chromosome.end()) {
-			for (auto variant : this->variants_per_chromosome.at(element)) {
+		auto it = this->contig_to_id.find(element);
+		if (it != this->contig_to_id.end()) {
+			for (const Variant& variant : this->variants_per_contig[it->second]) {
 				// generate reference unitig and write to file
 				size_t start_pos = variant.get_start_position();
 				outfile << ">" << element << "_reference_" << start_pos << endl;
@@ -294,38 +319,114 @@ void VariantReader::write_path_segments(std::string filename) const {
 	outfile.close();
 }
 
+void VariantReader::write_allele_segments(std::string filename) const {
+	ofstream outfile;
+	outfile.open(filename);
+	if (!outfile.good()) {
+		stringstream ss;
+		ss << "VariantReader::write_allele_segments: File " << filename << " cannot be created. Note that the filename must not contain non-existing directories." << endl;
+		throw runtime_error(ss.str());
+	}
+	for (size_t contig_id = 0; contig_id < this->contig_names.size(); ++contig_id) {
+		const string& element = this->contig_names[contig_id];
+		for (const Variant& variant : this->variants_per_contig[contig_id]) {
+			// allele 0 is the reference allele, its kmers are contained in the reference genome
+			size_t start_pos = variant.get_start_position();
+			for (size_t allele = 1; allele < variant.nr_of_alleles(); ++allele) {
+				outfile << ">" << element << "_" << start_pos << "_" << allele << endl;
+				outfile << variant.get_allele_string(allele) << endl;
+			}
+		}
+	}
+	outfile.close();
+}
+
 void VariantReader::get_chromosomes(vector<string>* result) const {
+	vector<size_t> contig_ids;
+	get_contig_ids(&contig_ids);
+	for (auto contig_id : contig_ids) {
+		result->push_back(this->contig_names[contig_id]);
+	}
+}
+
+size_t VariantReader::nr_of_contigs() const {
+	return this->contig_names.size();
+}
+
+void VariantReader::get_contig_ids(vector<size_t>* result) const {
 
 	// sort the chromosomes by size (decending).
 	vector<pair<size_t,string>> chromosome_sizes;
-	for (auto const& element : this->variants_per_chromosome) {
-		chromosome_sizes.push_back(make_pair(element.second.size(), element.first));
+	for (auto const& element : this->contig_to_id) {
+		chromosome_sizes.push_back(make_pair(this->variants_per_contig[element.second].size(), element.first));
 	}
 	sort(chromosome_sizes.rbegin(), chromosome_sizes.rend());
 
 	// return chromosomes in sorted order
 	for (auto const& element : chromosome_sizes) {
-		result->push_back(element.second);
+		result->push_back(this->contig_to_id.at(element.second));
 	}
 }
 
-size_t VariantReader::size_of(string chromosome) const {
-	if (this->variants_per_chromosome.find(chromosome) != this->variants_per_chromosome.end()) {
-		return this->variants_per_chromosome.at(chromosome).size();
+size_t VariantReader::get_contig_id(const string& chromosome) const {
+	auto it = this->contig_to_id.find(chromosome);
+	if (it == this->contig_to_id.end()) {
+		throw runtime_error("VariantReader::get_contig_id: chromosome " + chromosome + " not present in VCF.");
+	}
+	return it->second;
+}
+
+const FastaReader& VariantReader::get_reference() const {
+	return this->fasta_reader;
+}
+
+const string& VariantReader::get_contig_name(size_t contig_id) const {
+	return this->contig_names.at(contig_id);
+}
+
+size_t VariantReader::register_contig(const string& chromosome) {
+	auto it = this->contig_to_id.find(chromosome);
+	if (it != this->contig_to_id.end()) return it->second;
+	size_t contig_id = this->contig_names.size();
+	this->contig_names.push_back(chromosome);
+	this->contig_to_id.insert(make_pair(chromosome, contig_id));
+	this->variants_per_contig.push_back(vector<Variant>());
+	this->variant_ids.push_back(vector<vector<string>>());
+	this->packed_sites.push_back(PackedSites());
+	this->released_frequencies.push_back(vector<float>());
+	return contig_id;
+}
+
+size_t VariantReader::size_of(size_t contig_id) const {
+	return this->variants_per_contig.at(contig_id).size();
+}
+
+size_t VariantReader::size_of(const string& chromosome) const {
+	auto it = this->contig_to_id.find(chromosome);
+	if (it != this->contig_to_id.end()) {
+		return this->variants_per_contig[it->second].size();
 	} else {
 		return 0;
 	}
 }
 
-const Variant& VariantReader::get_variant(string chromosome, size_t index) const {
+const Variant& VariantReader::get_variant(size_t contig_id, size_t index) const {
+	if (index < size_of(contig_id)) {
+		return this->variants_per_contig[contig_id][index];
+	} else {
+		throw runtime_error("VariantReader::get_variant: index out of bounds.");
+	}
+}
+
+const Variant& VariantReader::get_variant(const string& chromosome, size_t index) const {
 	if (index < size_of(chromosome)) {
-		return this->variants_per_chromosome.at(chromosome)[index];
+		return this->variants_per_contig[this->contig_to_id.at(chromosome)][index];
 	} else {
 		throw runtime_error("VariantReader::get_variant: index out of bounds.");
 	}
 }
 
-void VariantReader::add_variant_cluster(string& chromosome, vector<Variant>* cluster) {
+void VariantReader::add_variant_cluster(size_t contig_id, vector<Variant>* cluster) {
 	if (!cluster->empty()) {
 		// merge all variants in cluster
 		Variant combined = cluster->at(0);
@@ -333,19 +434,41 @@ void VariantReader::add_variant_cluster(string& chromosome, vector<Variant>* clu
 			combined.combine_variants(cluster->at(v));
 		}
 		combined.add_flanking_sequence();
-		this->variants_per_chromosome[chromosome].push_back(combined);
+		this->variants_per_contig.at(contig_id).push_back(combined);
 		this->nr_variants += 1;
 	}
 }
 
-const vector<Variant>& VariantReader::get_variants_on_chromosome(string chromosome) const {
-	if (this->variants_per_chromosome.find(chromosome) != this->variants_per_chromosome.end()) {
-		return this->variants_per_chromosome.at(chromosome);
+const vector<Variant>& VariantReader::variants(size_t contig_id) const {
+	return this->variants_per_contig.at(contig_id);
+}
+
+const vector<Variant>& VariantReader::get_variants_on_chromosome(const string& chromosome) const {
+	auto it = this->contig_to_id.find(chromosome);
+	if (it != this->contig_to_id.end()) {
+		return this->variants_per_contig[it->second];
 	} else {
 		throw runtime_error("VariantReader::get_variants_on_chromosome: chromosome " + chromosome + " not present in VCF.");
 	}
 }
 
+void VariantReader::get_allele_frequencies(size_t contig_id, vector<vector<float>>& result) const {
+	const vector<Variant>& variants = this->variants_per_contig.at(contig_id);
+	// paths of released contigs are gone, use the frequencies stored before the release
+	bool released = sequences_released(contig_id);
+	const vector<float>& stored = this->released_frequencies.at(contig_id);
+	size_t offset = 0;
+	result.clear();
+	result.reserve(variants.size());
+	for (auto& variant : variants) {
+		vector<float> frequencies(variant.nr_of_alleles());
+		for (size_t a = 0; a < frequencies.size(); ++a) {
+			frequencies[a] = released ? stored.at(offset++) : variant.allele_frequency(a, this->add_reference);
+		}
+		result.push_back(frequencies);
+	}
+}
+
 string get_date() {
 	time_t t = time(0);
 	tm* now = localtime(&t);
@@ -354,6 +477,24 @@ string get_date() {
 	return string(oss.str());
 }
 
+string VariantReader::genotyping_header() const {
+	ostringstream header;
+	header << "##fileformat=VCFv4.2" << endl;
+	header << "##fileDate=" << get_date() << endl;
+	// TODO output command line
+	header << "##INFO=<ID=AF,Number=A,Type=Float,Description=\"Allele Frequency\">" << endl;
+	header << "##INFO=<ID=UK,Number=1,Type=Integer,Description=\"Total number of unique kmers.\">" << endl;
+	header << "##INFO=<ID=AK,Number=R,Type=Integer,Description=\"Number of unique kmers per allele. Will be -1 for alleles not covered by any input haplotype path\">" << endl;
+	header << "##INFO=<ID=MA,Number=1,Type=Integer,Description=\"Number of alleles missing in panel haplotypes.\">" << endl;
+	header << "##INFO=<ID=ID,Number=A,Type=String,Description=\"Variant IDs.\">" << endl;
+	header << "##FORMAT=<ID=GT,Number=1,Type=String,Description=\"Genotype\">" << endl;
+	header << "##FORMAT=<ID=GQ,Number=1,Type=Integer,Description=\"Genotype quality: phred scaled probability that the genotype is wrong.\">" << endl;
+	header << "##FORMAT=<ID=GL,Number=G,Type=Float,Description=\"Comma-separated log10-scaled genotype likelihoods for absent, heterozygous, homozygous.\">" << endl;
+	header << "##FORMAT=<ID=KC,Number=1,Type=Float,Description=\"Local kmer coverage.\">" << endl;
+	header << "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\t" << this->sample << endl;
+	return header.str();
+}
+
 void VariantReader::open_genotyping_outfile(string filename) {
 	this->genotyping_outfile.open(filename);
 	if (! this->genotyping_outfile.is_open()) {
@@ -363,19 +504,12 @@ void VariantReader::open_genotyping_outfile(string filename) {
 	this->genotyping_outfile_open = true;
 	
 	// write VCF header lines
-	this->genotyping_outfile << "##fileformat=VCFv4.2" << endl;
-	this->genotyping_outfile << "##fileDate=" << get_date() << endl;
-	// TODO output command line
-	this->genotyping_outfile << "##INFO=<ID=AF,Number=A,Type=Float,Description=\"Allele Frequency\">" << endl;
-	this->genotyping_outfile << "##INFO=<ID=UK,Number=1,Type=Integer,Description=\"Total number of unique kmers.\">" << endl;
-	this->genotyping_outfile << "##INFO=<ID=AK,Number=R,Type=Integer,Description=\"Number of unique kmers per allele. Will be -1 for alleles not covered by any input haplotype path\">" << endl;
-	this->genotyping_outfile << "##INFO=<ID=MA,Number=1,Type=Integer,Description=\"Number of alleles missing in panel haplotypes.\">" << endl;
-	this->genotyping_outfile << "##INFO=<ID=ID,Number=A,Type=String,Description=\"Variant IDs.\">" << endl;
-	this->genotyping_outfile << "##FORMAT=<ID=GT,Number=1,Type=String,Description=\"Genotype\">" << endl;
-	this->genotyping_outfile << "##FORMAT=<ID=GQ,Number=1,Type=Integer,Description=\"Genotype quality: phred scaled probability that the genotype is wrong.\">" << endl;
-	this->genotyping_outfile << "##FORMAT=<ID=GL,Number=G,Type=Float,Description=\"Comma-separated log10-scaled genotype likelihoods for absent, heterozygous, homozygous.\">" << endl;
-	this->genotyping_outfile << "##FORMAT=<ID=KC,Number=1,Type=Float,Description=\"Local kmer coverage.\">" << endl;
-	this->genotyping_outfile << "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\t" << this->sample << endl; 
+	this->genotyping_outfile << genotyping_header();
+}
+
+void VariantReader::open_binary_genotyping_outfile(string filename) {
+	this->binary_outfile.open(filename, genotyping_header());
+	this->binary_outfile_open = true;
 }
 
 void VariantReader::open_phasing_outfile(string filename) { 
@@ -400,232 +534,757 @@ void VariantReader::open_phasing_outfile(string filename) {
 	this->phasing_outfile << "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\t" << this->sample << endl;
 }
 
-void VariantReader::write_genotypes_of(string chromosome, const vector<GenotypingResult>& genotyping_result, vector<UniqueKmers*>* unique_kmers, bool ignore_imputed) {
+void VariantReader::write_genotypes_of(const string& chromosome, const vector<GenotypingResult>& genotyping_result, vector<UniqueKmers*>* unique_kmers, bool ignore_imputed, size_t nr_threads) {
+	auto it = this->contig_to_id.find(chromosome);
+	if (it == this->contig_to_id.end()) {
+		// outfile needs to be open
+		if (!this->genotyping_outfile_open) {
+			throw runtime_error("VariantReader::write_genotypes_of: output file needs to be opened before writing.");
+		}
+		cerr << "VariantReader::write_genotypes_of: no variants for given chromosome were written." << endl;
+		return;
+	}
+	write_genotypes_of(it->second, genotyping_result, unique_kmers, ignore_imputed, nr_threads);
+}
+
+void VariantReader::write_genotypes_of(size_t contig_id, const vector<GenotypingResult>& genotyping_result, vector<UniqueKmers*>* unique_kmers, bool ignore_imputed, size_t nr_threads) {
 	// outfile needs to be open
 	if (!this->genotyping_outfile_open) {
 		throw runtime_error("VariantReader::write_genotypes_of: output file needs to be opened before writing.");
 	}
 
-	if (this->variants_per_chromosome.find(chromosome) == this->variants_per_chromosome.end()) {
-		cerr << "VariantReader::write_genotypes_of: no variants for given chromosome were written." << endl;
-		return;
-	}
+	const vector<Variant>& variants = this->variants_per_contig.at(contig_id);
+	size_t nr_variants = variants.size();
 
-	if (genotyping_result.size() != size_of(chromosome)) {
+	if (genotyping_result.size() != nr_variants) {
 		throw runtime_error("VariantReader::write_genotypes_of: number of variants and number of computed genotypes differ.");
 	}
+	if (nr_threads == 0) nr_threads = 1;
+
+	// format blocks of variants in parallel, they are written in order afterwards
+	size_t nr_blocks = (nr_variants + multisample_block_size - 1) / multisample_block_size;
+	vector<string> blocks(nr_blocks);
+	vector<string> biallelic_blocks(nr_blocks);
+	{
+		ThreadPool threadPool (min(nr_threads, max(nr_blocks, (size_t) 1)));
+		size_t record_index = 0;
+		for (size_t b = 0; b < nr_blocks; ++b) {
+			size_t start = b * multisample_block_size;
+			size_t end = min(start + multisample_block_size, nr_variants);
+			string* biallelic_block = this->biallelic_outfile_open ? &biallelic_blocks[b] : nullptr;
+			function<void()> f_format = bind(&VariantReader::format_genotype_block, this, contig_id, start, end, record_index, &genotyping_result, unique_kmers, ignore_imputed, &blocks[b], biallelic_block);
+			threadPool.submit(f_format);
+			for (size_t i = start; i < end; ++i) {
+				record_index += variants[i].nr_of_singleton_variants();
+			}
+		}
+	}
+	for (size_t b = 0; b < nr_blocks; ++b) {
+		this->genotyping_outfile << blocks[b];
+		if (this->biallelic_outfile_open) this->biallelic_outfile << biallelic_blocks[b];
+	}
+}
 
-	size_t counter = 0;
-	for (size_t i = 0; i < size_of(chromosome); ++i) {
-		Variant variant = this->variants_per_chromosome.at(chromosome)[i];
+void VariantReader::format_genotype_block(size_t contig_id, size_t start, size_t end, size_t record_index, const vector<GenotypingResult>* genotyping_result, vector<UniqueKmers*>* unique_kmers, bool ignore_imputed, string* result, string* biallelic_result) {
+	const vector<Variant>& variants = this->variants_per_contig.at(contig_id);
+	ostringstream oss;
+	ostringstream biallelic;
+	for (size_t i = start; i < end; ++i) {
+		const Variant& variant = variants[i];
 
 		// separate (possibly combined) variant into single variants and print a line for each
-		vector<Variant> singleton_variants;
 		vector<GenotypingResult> singleton_likelihoods;
-		vector<VariantStats> singleton_stats;
-		variant.separate_variants(&singleton_variants, &genotyping_result.at(i), &singleton_likelihoods);
-		variant.variant_statistics(unique_kmers->at(i), singleton_stats);
-
-		for (size_t j = 0; j < singleton_variants.size(); ++j) {
-			Variant v = singleton_variants[j];
-			v.remove_flanking_sequence();
-			this->genotyping_outfile << v.get_chromosome() << "\t"; // CHROM
-			this->genotyping_outfile << (v.get_start_position() + 1) << "\t"; // POS
-			this->genotyping_outfile << v.get_id() << "\t"; // ID
-			this->genotyping_outfile << v.get_allele_string(0) << "\t"; // REF
-
-			// get alternative allele
-			size_t nr_alleles = v.nr_of_alleles();
-			if (nr_alleles < 2) {
-				ostringstream oss;
-				oss << "VariantReader::write_genotypes_of: less than 2 alleles given for variant at position " << v.get_start_position() << endl;
-				throw runtime_error(oss.str());
-			}
+		vector<SiteRecord> records;
+		variant.separate_genotypes(genotyping_result->at(i), singleton_likelihoods);
+		get_site_records(contig_id, i, record_index, unique_kmers->at(i), records);
+
+		for (size_t j = 0; j < records.size(); ++j) {
+			const SiteRecord& record = records[j];
+			oss << record.site_columns << "\t"; // CHROM - INFO
+			oss << "GT:GQ:GL:KC" << "\t"; // FORMAT
+			pair<int,int> genotype;
+			string genotype_quality;
+			oss << format_genotype(record, singleton_likelihoods.at(j), ignore_imputed, genotype, genotype_quality); // GT:GQ:GL
+			oss << ":" << record.coverage << "\n"; // KC
+
+			// same genotype, one record per variant ID
+			if (biallelic_result != nullptr) format_biallelic_records(contig_id, record, genotype, genotype_quality, biallelic);
+		}
+		record_index += records.size();
+	}
+	*result = oss.str();
+	if (biallelic_result != nullptr) *biallelic_result = biallelic.str();
+}
 
-			vector<string> alt_alleles;
-			vector<unsigned char> defined_alleles = {0};
-			for (size_t i = 1; i < nr_alleles; ++i) {
-				DnaSequence allele = v.get_allele_sequence(i);
-				// skip alleles that are undefined
-				if (!v.is_undefined_allele(i)) {
-					alt_alleles.push_back(allele.to_string());
-					defined_alleles.push_back(i);
-				}
-			}
+void VariantReader::compute_genotype(const SiteRecord& record, const GenotypingResult& likelihoods, bool ignore_imputed, pair<int,int>& genotype, int& genotype_quality, vector<long double>& genotype_likelihoods) const {
+	// keep only likelihoods for genotypes with defined alleles
+	GenotypingResult defined_likelihoods = likelihoods;
+	if (record.nr_missing > 0) defined_likelihoods = likelihoods.get_specific_likelihoods(record.defined_alleles);
+	size_t nr_alleles = record.defined_alleles.size();
+
+	// determine computed genotype
+	genotype = defined_likelihoods.get_likeliest_genotype();
+	if (ignore_imputed && (record.nr_unique_kmers == 0)) genotype = {-1,-1};
+	genotype_quality = -1;
+	if ( (genotype.first != -1) && (genotype.second != -1)) {
+		// unique maximum and therefore a likeliest genotype exists
+		genotype_quality = defined_likelihoods.get_genotype_quality(genotype.first, genotype.second);
+	}
 
-			string alt_string = "";
-			for (unsigned char a = 0; a < alt_alleles.size(); ++a) {
-				if (a > 0) alt_string += ',';
-				alt_string += alt_alleles[a];
-			}
+	genotype_likelihoods = defined_likelihoods.get_all_likelihoods(nr_alleles);
+	if (genotype_likelihoods.size() < 3) {
+		ostringstream oss;
+		oss << "VariantReader::compute_genotype: too few likelihoods (" << genotype_likelihoods.size() << ") computed for variant at position " << record.start_position << endl;
+		throw runtime_error(oss.str());
+	}
+}
 
-			this->genotyping_outfile << alt_string << "\t"; // ALT
-			this->genotyping_outfile << ".\t"; // QUAL
-			this->genotyping_outfile << "PASS" << "\t"; // FILTER
-			// output allele frequencies of all alleles
-			ostringstream info;
-			info << "AF="; // AF
-			for (unsigned int a = 1; a < defined_alleles.size(); ++a) {
-				if (a > 1) info << ",";
-				info << setprecision(6) << v.allele_frequency(defined_alleles[a], this->add_reference);				
-			}
+string VariantReader::format_genotype(const SiteRecord& record, const GenotypingResult& likelihoods, bool ignore_imputed, pair<int,int>& genotype, string& genotype_quality) const {
+	ostringstream oss;
+	int quality;
+	vector<long double> all_likelihoods;
+	compute_genotype(record, likelihoods, ignore_imputed, genotype, quality, all_likelihoods);
+	genotype_quality = ".";
+	if ( (genotype.first != -1) && (genotype.second != -1)) {
+		genotype_quality = to_string(quality);
+		oss << genotype.first << "/" << genotype.second << ":"; // GT
+		oss << genotype_quality << ":"; // GQ
+	} else {
+		// genotype could not be determined 
+		oss << ".:.:"; // GT:GQ
+	}
 
-			// keep only likelihoods for genotypes with defined alleles
-			size_t nr_missing = v.nr_missing_alleles();
-			GenotypingResult genotype_likelihoods = singleton_likelihoods.at(j);
-			if (nr_missing > 0) genotype_likelihoods = singleton_likelihoods.at(j).get_specific_likelihoods(defined_alleles);
-			nr_alleles = defined_alleles.size();
-
-			info << ";UK=" << singleton_stats.at(j).nr_unique_kmers; // UK
-			info << ";AK="; // AK
-			for (unsigned int a = 0; a < nr_alleles; ++a) {
-				if (a > 0) info << ",";
-				info << singleton_stats.at(j).kmer_counts[a];
-			}
-			info << ";MA=" << nr_missing;
-	
-			// if IDs were given in input, write them to output as well
-			if (!this->variant_ids[v.get_chromosome()][counter].empty()) info << ";ID=" << get_ids(v.get_chromosome(), alt_alleles, counter, false);
-			this->genotyping_outfile << info.str() << "\t"; // INFO
-			this->genotyping_outfile << "GT:GQ:GL:KC" << "\t"; // FORMAT
+	// output genotype likelihoods
+	oss << log10(all_likelihoods[0]);
+	for (size_t j = 1; j < all_likelihoods.size(); ++j) {
+		oss << "," << setprecision(4) << log10(all_likelihoods[j]);
+	}
+	return oss.str(); // GL
+}
+
+void VariantReader::write_binary_genotypes_of(size_t contig_id, const vector<GenotypingResult>& genotyping_result, vector<UniqueKmers*>* unique_kmers, bool ignore_imputed) {
+	// outfile needs to be open
+	if (!this->binary_outfile_open) {
+		throw runtime_error("VariantReader::write_binary_genotypes_of: output file needs to be opened before writing.");
+	}
 
-			// determine computed genotype
-			pair<int,int> genotype = genotype_likelihoods.get_likeliest_genotype();
-			if (ignore_imputed && (singleton_stats.at(j).nr_unique_kmers == 0)) genotype = {-1,-1};
-			if ( (genotype.first != -1) && (genotype.second != -1)) {
+	const vector<Variant>& variants = this->variants_per_contig.at(contig_id);
+	size_t nr_variants = variants.size();
 
-				// unique maximum and therefore a likeliest genotype exists
-				this->genotyping_outfile << genotype.first << "/" << genotype.second << ":"; // GT
+	if (genotyping_result.size() != nr_variants) {
+		throw runtime_error("VariantReader::write_binary_genotypes_of: number of variants and number of computed genotypes differ.");
+	}
 
-				// output genotype quality
-				this->genotyping_outfile << genotype_likelihoods.get_genotype_quality(genotype.first, genotype.second) << ":"; // GQ
-			} else {
-				// genotype could not be determined 
-				this->genotyping_outfile << ".:.:"; // GT:GQ
-			}
+	// biallelic records of the whole contig are collected and written at once
+	ostringstream biallelic;
+	size_t counter = 0;
+	for (size_t i = 0; i < nr_variants; ++i) {
+		const Variant& variant = variants[i];
 
-			// output genotype likelihoods
-			vector<long double> likelihoods = genotype_likelihoods.get_all_likelihoods(nr_alleles);
-			if (likelihoods.size() < 3) {
-				ostringstream oss;
-				oss << "VariantReader::write_genotypes_of: too few likelihoods (" << likelihoods.size() << ") computed for variant at position " << v.get_start_position() << endl;
-				throw runtime_error(oss.str());
+		// separate (possibly combined) variant into single variants and add a record for each
+		vector<GenotypingResult> singleton_likelihoods;
+		vector<SiteRecord> records;
+		variant.separate_genotypes(genotyping_result.at(i), singleton_likelihoods);
+		get_site_records(contig_id, i, counter, unique_kmers->at(i), records);
+
+		for (size_t j = 0; j < records.size(); ++j) {
+			const SiteRecord& record = records[j];
+			pair<int,int> genotype;
+			int genotype_quality;
+			vector<long double> likelihoods;
+			compute_genotype(record, singleton_likelihoods.at(j), ignore_imputed, genotype, genotype_quality, likelihoods);
+			// CHROM, POS, UK and AK are stored separately
+			size_t text_start = record.site_columns.find('\t', record.site_columns.find('\t') + 1) + 1;
+			string site_text = record.site_columns.substr(text_start, record.kmer_info_start - text_start) + record.site_columns.substr(record.kmer_info_end);
+			this->binary_outfile.add_record(counter + j, record.start_position + 1, site_text, record.kmer_info_start - text_start, record.nr_unique_kmers, record.allele_kmers,
+				genotype, genotype_quality, record.coverage, likelihoods);
+
+			// same genotype, one record per variant ID
+			if (this->biallelic_outfile_open) format_biallelic_records(contig_id, record, genotype, (genotype_quality < 0) ? "." : to_string(genotype_quality), biallelic);
+		}
+		counter += records.size();
+	}
+	this->binary_outfile.write_block(this->contig_names.at(contig_id));
+	if (this->biallelic_outfile_open) this->biallelic_outfile << biallelic.str();
+}
+
+void VariantReader::close_binary_genotyping_outfile() {
+	this->binary_outfile.close();
+	this->binary_outfile_open = false;
+}
+
+void VariantReader::open_multisample_genotyping_outfile(string filename, const vector<string>& samples) {
+	if (samples.empty()) {
+		throw runtime_error("VariantReader::open_multisample_genotyping_outfile: no samples given.");
+	}
+	this->multisample_outfile.open(filename);
+	if (! this->multisample_outfile.is_open()) {
+		throw runtime_error("VariantReader::open_multisample_genotyping_outfile: genotyping output file cannot be opened. Note that the filename must not contain non-existing directories.");
+	}
+
+	this->multisample_outfile_open = true;
+	this->nr_multisample_samples = samples.size();
+
+	// write VCF header lines
+	this->multisample_outfile << "##fileformat=VCFv4.2" << endl;
+	this->multisample_outfile << "##fileDate=" << get_date() << endl;
+	this->multisample_outfile << "##INFO=<ID=AF,Number=A,Type=Float,Description=\"Allele Frequency\">" << endl;
+	this->multisample_outfile << "##INFO=<ID=MA,Number=1,Type=Integer,Description=\"Number of alleles missing in panel haplotypes.\">" << endl;
+	this->multisample_outfile << "##INFO=<ID=ID,Number=A,Type=String,Description=\"Variant IDs.\">" << endl;
+	this->multisample_outfile << "##FORMAT=<ID=GT,Number=1,Type=String,Description=\"Genotype\">" << endl;
+	this->multisample_outfile << "##FORMAT=<ID=GQ,Number=1,Type=Integer,Description=\"Genotype quality: phred scaled probability that the genotype is wrong.\">" << endl;
+	this->multisample_outfile << "##FORMAT=<ID=GL,Number=G,Type=Float,Description=\"Comma-separated log10-scaled genotype likelihoods for absent, heterozygous, homozygous.\">" << endl;
+	this->multisample_outfile << "##FORMAT=<ID=KC,Number=1,Type=Float,Description=\"Local kmer coverage.\">" << endl;
+	this->multisample_outfile << "##FORMAT=<ID=UK,Number=1,Type=Integer,Description=\"Total number of unique kmers.\">" << endl;
+	this->multisample_outfile << "##FORMAT=<ID=AK,Number=R,Type=Integer,Description=\"Number of unique kmers per allele. Will be -1 for alleles not covered by any input haplotype path\">" << endl;
+	this->multisample_outfile << "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT";
+	for (auto& s : samples) {
+		this->multisample_outfile << "\t" << s;
+	}
+	this->multisample_outfile << endl;
+}
+
+void VariantReader::write_multisample_genotypes_of(const string& chromosome, const vector<const vector<GenotypingResult>*>& genotyping_results, const vector<vector<UniqueKmers*>*>& unique_kmers, bool ignore_imputed, size_t nr_threads) {
+	auto it = this->contig_to_id.find(chromosome);
+	if (it == this->contig_to_id.end()) {
+		if (!this->multisample_outfile_open) {
+			throw runtime_error("VariantReader::write_multisample_genotypes_of: output file needs to be opened before writing.");
+		}
+		cerr << "VariantReader::write_multisample_genotypes_of: no variants for given chromosome were written." << endl;
+		return;
+	}
+	write_multisample_genotypes_of(it->second, genotyping_results, unique_kmers, ignore_imputed, nr_threads);
+}
+
+void VariantReader::write_multisample_genotypes_of(size_t contig_id, const vector<const vector<GenotypingResult>*>& genotyping_results, const vector<vector<UniqueKmers*>*>& unique_kmers, bool ignore_imputed, size_t nr_threads) {
+	// outfile needs to be open
+	if (!this->multisample_outfile_open) {
+		throw runtime_error("VariantReader::write_multisample_genotypes_of: output file needs to be opened before writing.");
+	}
+	if ((genotyping_results.size() != this->nr_multisample_samples) || (unique_kmers.size() != this->nr_multisample_samples)) {
+		throw runtime_error("VariantReader::write_multisample_genotypes_of: number of results does not match the number of samples.");
+	}
+	const vector<Variant>& variants = this->variants_per_contig.at(contig_id);
+	size_t nr_variants = variants.size();
+	for (size_t s = 0; s < this->nr_multisample_samples; ++s) {
+		if ((genotyping_results[s]->size() != nr_variants) || (unique_kmers[s]->size() != nr_variants)) {
+			throw runtime_error("VariantReader::write_multisample_genotypes_of: number of variants and number of computed genotypes differ.");
+		}
+	}
+	// released contigs only keep the unique kmer statistics of a single sample
+	if (sequences_released(contig_id) && (this->nr_multisample_samples > 1)) {
+		throw runtime_error("VariantReader::write_multisample_genotypes_of: allele sequences of " + this->contig_names[contig_id] + " have been released.");
+	}
+	if (nr_threads == 0) nr_threads = 1;
+
+	// format blocks of variants in parallel, they are written in order afterwards
+	size_t nr_blocks = (nr_variants + multisample_block_size - 1) / multisample_block_size;
+	vector<string> blocks(nr_blocks);
+	{
+		ThreadPool threadPool (min(nr_threads, max(nr_blocks, (size_t) 1)));
+		size_t record_index = 0;
+		for (size_t b = 0; b < nr_blocks; ++b) {
+			size_t start = b * multisample_block_size;
+			size_t end = min(start + multisample_block_size, nr_variants);
+			function<void()> f_format = bind(&VariantReader::format_multisample_block, this, contig_id, start, end, record_index, &genotyping_results, &unique_kmers, ignore_imputed, &blocks[b]);
+			threadPool.submit(f_format);
+			for (size_t i = start; i < end; ++i) {
+				record_index += variants[i].nr_of_singleton_variants();
 			}
+		}
+	}
+	for (auto& block : blocks) {
+		this->multisample_outfile << block;
+	}
+}
 
-			ostringstream oss;
-			oss << log10(likelihoods[0]);
-			for (size_t j = 1; j < likelihoods.size(); ++j) {
-				oss << "," << setprecision(4) << log10(likelihoods[j]);
+void VariantReader::format_multisample_block(size_t contig_id, size_t start, size_t end, size_t record_index, const vector<const vector<GenotypingResult>*>* genotyping_results, const vector<vector<UniqueKmers*>*>* unique_kmers, bool ignore_imputed, string* result) {
+	const vector<Variant>& variants = this->variants_per_contig.at(contig_id);
+	ostringstream oss;
+	for (size_t i = start; i < end; ++i) {
+		const Variant& variant = variants[i];
+		// site records and separated genotypes of each sample
+		vector<vector<SiteRecord>> records(genotyping_results->size());
+		vector<vector<GenotypingResult>> singleton_likelihoods(genotyping_results->size());
+		for (size_t s = 0; s < genotyping_results->size(); ++s) {
+			variant.separate_genotypes(genotyping_results->at(s)->at(i), singleton_likelihoods[s]);
+			get_site_records(contig_id, i, record_index, unique_kmers->at(s)->at(i), records[s]);
+		}
+
+		for (size_t j = 0; j < records[0].size(); ++j) {
+			// all INFO fields except UK and AK are the same for all samples
+			const SiteRecord& site = records[0][j];
+			oss << site.site_columns.substr(0, site.kmer_info_start) << site.site_columns.substr(site.kmer_info_end) << "\t"; // CHROM - INFO
+			oss << "GT:GQ:GL:KC:UK:AK"; // FORMAT
+			for (size_t s = 0; s < records.size(); ++s) {
+				const SiteRecord& record = records[s][j];
+				pair<int,int> genotype;
+				string genotype_quality;
+				oss << "\t" << format_genotype(record, singleton_likelihoods[s].at(j), ignore_imputed, genotype, genotype_quality); // GT:GQ:GL
+				oss << ":" << record.coverage; // KC
+				oss << ":" << record.nr_unique_kmers; // UK
+				size_t ak_start = record.site_columns.find(";AK=", record.kmer_info_start) + 4;
+				oss << ":" << record.site_columns.substr(ak_start, record.kmer_info_end - ak_start); // AK
 			}
-			this->genotyping_outfile << oss.str(); // GL
-			this->genotyping_outfile << ":" << singleton_stats[j].coverage << endl; // KC
-			counter += 1;
+			oss << "\n";
+		}
+		record_index += records[0].size();
+	}
+	*result = oss.str();
+}
+
+void VariantReader::close_multisample_genotyping_outfile() {
+	this->multisample_outfile.close();
+	this->multisample_outfile_open = false;
+}
+
+void VariantReader::write_phasing_of(const string& chromosome, const vector<GenotypingResult>& genotyping_result, vector<UniqueKmers*>* unique_kmers, bool ignore_imputed) {
+	auto it = this->contig_to_id.find(chromosome);
+	if (it == this->contig_to_id.end()) {
+		if (genotyping_result.size() != 0) {
+			throw runtime_error("VariantReader::write_phasing_of: number of variants and number of computed phasings differ.");
 		}
+		return;
 	}
+	write_phasing_of(it->second, genotyping_result, unique_kmers, ignore_imputed);
 }
 
-void VariantReader::write_phasing_of(string chromosome, const vector<GenotypingResult>& genotyping_result, vector<UniqueKmers*>* unique_kmers, bool ignore_imputed) {
+void VariantReader::write_phasing_of(size_t contig_id, const vector<GenotypingResult>& genotyping_result, vector<UniqueKmers*>* unique_kmers, bool ignore_imputed) {
 	// outfile needs to be open
 	if (! this->phasing_outfile_open) {
 		throw runtime_error("VariantReader::write_phasing_of: output file needs to be opened before writing.");
 	}
-	if (genotyping_result.size() != size_of(chromosome)) {
+
+	const vector<Variant>& variants = this->variants_per_contig.at(contig_id);
+	size_t nr_variants = variants.size();
+
+	if (genotyping_result.size() != nr_variants) {
 		throw runtime_error("VariantReader::write_phasing_of: number of variants and number of computed phasings differ.");
 	}
 
 	size_t counter = 0;
-	for (size_t i = 0; i < size_of(chromosome); ++i) {
-		Variant variant = this->variants_per_chromosome.at(chromosome)[i];
+	for (size_t i = 0; i < nr_variants; ++i) {
+		const Variant& variant = variants[i];
 
 		// separate (possibly combined) variant into single variants and print a line for each
-		vector<Variant> singleton_variants;
 		vector<GenotypingResult> singleton_likelihoods;
-		variant.separate_variants(&singleton_variants, &genotyping_result.at(i), &singleton_likelihoods);
-		vector<VariantStats> singleton_stats;
-		variant.variant_statistics(unique_kmers->at(i), singleton_stats);
-
-		for (size_t j = 0; j < singleton_variants.size(); ++j) {
-			Variant v = singleton_variants[j];
-			v.remove_flanking_sequence();
-			this->phasing_outfile << v.get_chromosome() << "\t"; // CHROM
-			this->phasing_outfile << (v.get_start_position() + 1) << "\t"; // POS
-			this->phasing_outfile << v.get_id() << "\t"; // ID
-			this->phasing_outfile << v.get_allele_string(0) << "\t"; // REF
-
-			// get alternative alleles
-			size_t nr_alleles = v.nr_of_alleles();
-			if (nr_alleles < 2) {
-				ostringstream oss;
-				oss << "VariantReader::write_phasing_of: less than 2 alleles given for variant at position " << v.get_start_position() << endl;
-				throw runtime_error(oss.str());
+		vector<SiteRecord> records;
+		variant.separate_genotypes(genotyping_result.at(i), singleton_likelihoods);
+		get_site_records(contig_id, i, counter, unique_kmers->at(i), records);
+
+		for (size_t j = 0; j < records.size(); ++j) {
+			const SiteRecord& record = records[j];
+			if (record.undefined_allele_kmers.empty()) {
+				this->phasing_outfile << record.site_columns << "\t"; // CHROM - INFO
+			} else {
+				// AK of the phasing output lists all alleles, including undefined ones
+				this->phasing_outfile << record.site_columns.substr(0, record.kmer_info_end) << record.undefined_allele_kmers << record.site_columns.substr(record.kmer_info_end) << "\t"; // CHROM - INFO
 			}
+			this->phasing_outfile << "GT:KC" << "\t"; // FORMAT
 
-			vector<string> alt_alleles;
-			vector<unsigned char> defined_alleles = {0};
-			for (size_t i = 1; i < nr_alleles; ++i) {
-				DnaSequence allele = v.get_allele_sequence(i);
-				// skip alleles that are undefined
-				if (! v.is_undefined_allele(i)) {
-					alt_alleles.push_back(allele.to_string());
-					defined_alleles.push_back(i);
-				}
+			// determine phasing
+			if (ignore_imputed && (record.nr_unique_kmers == 0)){
+				this->phasing_outfile << "./."; // GT (phased)
+			} else {
+				pair<unsigned char,unsigned char> haplotype = singleton_likelihoods.at(j).get_haplotype();
+				this->phasing_outfile << (unsigned int) haplotype.first << "|" << (unsigned int) haplotype.second; // GT (phased)
 			}
+			this->phasing_outfile << ":" << record.coverage << endl; // KC
+		}
+		counter += records.size();
+	}
+}
 
-			string alt_string = "";
-			for (unsigned char a = 0; a < alt_alleles.size(); ++a) {
-				if (a > 0) alt_string += ',';
-				alt_string += alt_alleles[a];
-			}
+void VariantReader::release_sequences(size_t contig_id, vector<UniqueKmers*>* unique_kmers) {
+	vector<Variant>& variants = this->variants_per_contig.at(contig_id);
+	PackedSites& packed = this->packed_sites.at(contig_id);
+	if (!packed.offsets.empty()) return;
+	if (unique_kmers->size() != variants.size()) {
+		throw runtime_error("VariantReader::release_sequences: number of variants and number of UniqueKmers differ.");
+	}
+	// keep everything the VCF writers need before sequences are dropped
+	size_t counter = 0;
+	for (size_t i = 0; i < variants.size(); ++i) {
+		vector<SiteFields> fields;
+		get_site_fields(contig_id, i, counter, unique_kmers->at(i), fields);
+		for (const SiteFields& f : fields) {
+			packed.offsets.push_back(packed.data.size());
+			pack_site_fields(f, packed.data);
+		}
+		counter += fields.size();
+	}
+	packed.offsets.shrink_to_fit();
+	packed.data.shrink_to_fit();
+	vector<float>& frequencies = this->released_frequencies.at(contig_id);
+	for (auto& variant : variants) {
+		for (size_t a = 0; a < variant.nr_of_alleles(); ++a) {
+			frequencies.push_back(variant.allele_frequency(a, this->add_reference));
+		}
+	}
+	frequencies.shrink_to_fit();
+	for (auto& variant : variants) {
+		variant.release_sequences();
+	}
+	vector<vector<string>>().swap(this->variant_ids.at(contig_id));
+}
 
-			size_t nr_missing = v.nr_missing_alleles();
-			GenotypingResult genotype_likelihoods = singleton_likelihoods.at(j);
-			if (nr_missing > 0) genotype_likelihoods = singleton_likelihoods.at(j).get_specific_likelihoods(defined_alleles);
-
-			this->phasing_outfile << alt_string << "\t"; // ALT
-			this->phasing_outfile << ".\t"; // QUAL
-			this->phasing_outfile << "PASS" << "\t"; // FILTER
-			// output allele frequencies of all alleles
-			ostringstream info;
-			info << "AF=";
-			for (unsigned int a = 1; a < defined_alleles.size(); ++a) {
-				if (a > 1) info << ",";
-				info << setprecision(6) << v.allele_frequency(defined_alleles[a], this->add_reference);				
-			}
-			info << ";UK=" << singleton_stats.at(j).nr_unique_kmers; // UK
-			info << ";AK="; // AK
-			for (unsigned int a = 0; a < nr_alleles; ++a) {
-				if (a > 0) info << ",";
-				info << singleton_stats.at(j).kmer_counts[a];
+bool VariantReader::sequences_released(size_t contig_id) const {
+	// every contig holds at least one variant, so records only exist after release
+	return !this->packed_sites.at(contig_id).offsets.empty();
+}
+
+void VariantReader::get_site_records(size_t contig_id, size_t variant_index, size_t record_index, UniqueKmers* unique_kmers, vector<SiteRecord>& result) {
+	vector<SiteFields> fields;
+	if (sequences_released(contig_id)) {
+		const PackedSites& packed = this->packed_sites[contig_id];
+		size_t nr_records = this->variants_per_contig[contig_id].at(variant_index).nr_of_singleton_variants();
+		fields.resize(nr_records);
+		for (size_t j = 0; j < nr_records; ++j) {
+			unpack_site_fields(packed.data.data() + packed.offsets.at(record_index + j), fields[j]);
+		}
+	} else {
+		get_site_fields(contig_id, variant_index, record_index, unique_kmers, fields);
+	}
+	for (const SiteFields& f : fields) {
+		result.push_back(SiteRecord());
+		render_site_record(contig_id, f, result.back());
+	}
+}
+
+void VariantReader::get_site_fields(size_t contig_id, size_t variant_index, size_t record_index, UniqueKmers* unique_kmers, vector<SiteFields>& result) {
+	const Variant& variant = this->variants_per_contig.at(contig_id).at(variant_index);
+	const vector<vector<string>>& ids = this->variant_ids[contig_id];
+
+	vector<Variant> singleton_variants;
+	vector<VariantStats> singleton_stats;
+	variant.separate_variants(&singleton_variants);
+	variant.variant_statistics(unique_kmers, singleton_stats);
+
+	for (size_t j = 0; j < singleton_variants.size(); ++j) {
+		Variant v = singleton_variants[j];
+		v.remove_flanking_sequence();
+
+		// get alternative alleles
+		size_t nr_alleles = v.nr_of_alleles();
+		if (nr_alleles < 2) {
+			ostringstream oss;
+			oss << "VariantReader::get_site_fields: less than 2 alleles given for variant at position " << v.get_start_position() << endl;
+			throw runtime_error(oss.str());
+		}
+
+		SiteFields fields;
+		fields.start_position = v.get_start_position();
+		fields.variant_id = v.get_id();
+		fields.alleles = {v.get_allele_string(0)};
+		fields.defined_alleles = {0};
+		vector<string> alt_alleles;
+		for (size_t i = 1; i < nr_alleles; ++i) {
+			// skip alleles that are undefined
+			if (!v.is_undefined_allele(i)) {
+				alt_alleles.push_back(v.get_allele_string(i));
+				fields.alleles.push_back(alt_alleles.back());
+				fields.defined_alleles.push_back(i);
+				fields.allele_frequencies.push_back(v.allele_frequency(i, this->add_reference));
 			}
+		}
 
-			info << ";MA=" << nr_missing;
+		fields.nr_missing = v.nr_missing_alleles();
+		fields.nr_unique_kmers = singleton_stats.at(j).nr_unique_kmers;
+		fields.coverage = singleton_stats.at(j).coverage;
+		for (size_t a = 0; a < nr_alleles; ++a) {
+			fields.kmer_counts.push_back(singleton_stats.at(j).kmer_counts[a]);
+		}
 
-			// if IDs were given in input, write them to output as well
-			if (!this->variant_ids[v.get_chromosome()][counter].empty()) info << ";ID=" << get_ids(v.get_chromosome(), alt_alleles, counter, false);
+		// if IDs were given in input, write them to output as well
+		if (!ids.at(record_index + j).empty()) {
+			get_allele_ids(contig_id, alt_alleles, record_index + j, false, fields.allele_ids);
+		}
+		result.push_back(fields);
+	}
+}
 
-			this->phasing_outfile << info.str() << "\t"; // INFO
-			this->phasing_outfile << "GT:KC" << "\t"; // FORMAT
+void VariantReader::render_site_record(size_t contig_id, const SiteFields& fields, SiteRecord& result) const {
+	result.start_position = fields.start_position;
+	result.variant_id = fields.variant_id;
+	result.allele_ids = fields.allele_ids;
+	result.defined_alleles = fields.defined_alleles;
+	result.nr_missing = fields.nr_missing;
+	result.nr_unique_kmers = fields.nr_unique_kmers;
+	result.coverage = fields.coverage;
+
+	ostringstream site;
+	site << this->contig_names.at(contig_id) << "\t"; // CHROM
+	site << (fields.start_position + 1) << "\t"; // POS
+	site << fields.variant_id << "\t"; // ID
+	site << fields.alleles.at(0) << "\t"; // REF
+	for (size_t a = 1; a < fields.alleles.size(); ++a) {
+		if (a > 1) site << ",";
+		site << fields.alleles[a]; // ALT
+	}
+	site << "\t";
+	site << ".\t"; // QUAL
+	site << "PASS" << "\t"; // FILTER
+	// output allele frequencies of all alleles
+	site << "AF="; // AF
+	for (size_t a = 0; a < fields.allele_frequencies.size(); ++a) {
+		if (a > 0) site << ",";
+		site << setprecision(6) << fields.allele_frequencies[a];
+	}
+	result.kmer_info_start = site.tellp();
+	site << ";UK=" << fields.nr_unique_kmers; // UK
+	site << ";AK="; // AK
+	for (size_t a = 0; a < fields.defined_alleles.size(); ++a) {
+		if (a > 0) site << ",";
+		site << fields.kmer_counts.at(a);
+		result.allele_kmers.push_back(fields.kmer_counts[a]);
+	}
+	result.kmer_info_end = site.tellp();
+	for (size_t a = fields.defined_alleles.size(); a < fields.kmer_counts.size(); ++a) {
+		result.undefined_allele_kmers += "," + to_string(fields.kmer_counts[a]);
+	}
+	site << ";MA=" << fields.nr_missing;
+	if (!fields.allele_ids.empty()) {
+		site << ";ID=";
+		for (size_t a = 0; a < fields.allele_ids.size(); ++a) {
+			if (a > 0) site << ",";
+			site << fields.allele_ids[a];
+		}
+	}
+	result.site_columns = site.str(); // INFO
+}
 
-			// determine phasing
-			if (ignore_imputed && (singleton_stats.at(j).nr_unique_kmers == 0)){
-				this->phasing_outfile << "./."; // GT (phased)
-			} else {
-				pair<unsigned char,unsigned char> haplotype = singleton_likelihoods.at(j).get_haplotype();
-				// check if the haplotype allele is undefined
-				bool hap1_undefined = v.is_undefined_allele(haplotype.first);
-				bool hap2_undefined = v.is_undefined_allele(haplotype.second);
-				string hap1 (1, haplotype.first);
-				string hap2 (1, haplotype.second);
-				if (hap1_undefined) hap1 = ".";
-				if (hap2_undefined) hap2 = ".";
-				this->phasing_outfile << (unsigned int) haplotype.first << "|" << (unsigned int) haplotype.second; // GT (phased)
+uint32_t VariantReader::get_site_id_index(const string& id) {
+	// contigs are released concurrently
+	lock_guard<mutex> lock(this->site_id_mutex);
+	auto it = this->site_id_index.find(id);
+	if (it != this->site_id_index.end()) return it->second;
+	uint32_t index = this->site_ids.size();
+	it = this->site_id_index.insert(make_pair(id, index)).first;
+	this->site_ids.push_back(&it->first);
+	return index;
+}
+
+const string& VariantReader::get_site_id(uint32_t index) const {
+	lock_guard<mutex> lock(this->site_id_mutex);
+	return *this->site_ids.at(index);
+}
+
+static void pack_number(uint64_t number, vector<unsigned char>& result) {
+	// 7 bits per byte, highest bit set if more bytes follow
+	while (number >= 128) {
+		result.push_back((number & 127) | 128);
+		number >>= 7;
+	}
+	result.push_back(number);
+}
+
+static uint64_t unpack_number(const unsigned char*& data) {
+	uint64_t number = 0;
+	for (size_t shift = 0; ; shift += 7) {
+		unsigned char byte = *data++;
+		number |= (uint64_t) (byte & 127) << shift;
+		if (byte < 128) return number;
+	}
+}
+
+static const string packed_bases = "ACGT";
+
+static void pack_allele(const string& allele, vector<unsigned char>& result) {
+	// alleles consisting of A, C, G and T only are stored with 2 bits per base, all others (e.g. containing N) as text
+	bool acgt = allele.find_first_not_of(packed_bases) == string::npos;
+	pack_number((allele.size() << 1) | (acgt ? 0 : 1), result);
+	if (!acgt) {
+		result.insert(result.end(), allele.begin(), allele.end());
+		return;
+	}
+	for (size_t i = 0; i < allele.size(); i += 4) {
+		unsigned char byte = 0;
+		for (size_t j = i; (j < i + 4) && (j < allele.size()); ++j) {
+			byte |= packed_bases.find(allele[j]) << (2 * (j - i));
+		}
+		result.push_back(byte);
+	}
+}
+
+static void unpack_allele(const unsigned char*& data, string& result) {
+	uint64_t header = unpack_number(data);
+	size_t length = header >> 1;
+	if (header & 1) {
+		result.assign((const char*) data, length);
+		data += length;
+		return;
+	}
+	result.resize(length);
+	for (size_t i = 0; i < length; ++i) {
+		result[i] = packed_bases[(data[i / 4] >> (2 * (i % 4))) & 3];
+	}
+	data += (length + 3) / 4;
+}
+
+void VariantReader::pack_site_fields(const SiteFields& fields, vector<unsigned char>& result) {
+	pack_number(fields.start_position, result);
+	pack_number(get_site_id_index(fields.variant_id), result);
+	pack_number(fields.alleles.size(), result);
+	for (size_t a = 0; a < fields.alleles.size(); ++a) {
+		pack_allele(fields.alleles[a], result);
+		result.push_back(fields.defined_alleles[a]);
+	}
+	for (float frequency : fields.allele_frequencies) {
+		const unsigned char* bytes = (const unsigned char*) &frequency;
+		result.insert(result.end(), bytes, bytes + sizeof(float));
+	}
+	pack_number(fields.allele_ids.size(), result);
+	for (const string& id : fields.allele_ids) {
+		pack_number(get_site_id_index(id), result);
+	}
+	pack_number(fields.nr_missing, result);
+	pack_number(fields.nr_unique_kmers, result);
+	pack_number(fields.coverage, result);
+	pack_number(fields.kmer_counts.size(), result);
+	for (int count : fields.kmer_counts) {
+		// counts of uncovered alleles are -1
+		pack_number(count + 1, result);
+	}
+}
+
+void VariantReader::unpack_site_fields(const unsigned char* data, SiteFields& result) const {
+	result.start_position = unpack_number(data);
+	result.variant_id = get_site_id(unpack_number(data));
+	result.alleles.resize(unpack_number(data));
+	result.defined_alleles.resize(result.alleles.size());
+	for (size_t a = 0; a < result.alleles.size(); ++a) {
+		unpack_allele(data, result.alleles[a]);
+		result.defined_alleles[a] = *data++;
+	}
+	result.allele_frequencies.resize(result.alleles.size() - 1);
+	for (size_t a = 0; a < result.allele_frequencies.size(); ++a) {
+		memcpy(&result.allele_frequencies[a], data, sizeof(float));
+		data += sizeof(float);
+	}
+	result.allele_ids.resize(unpack_number(data));
+	for (size_t a = 0; a < result.allele_ids.size(); ++a) {
+		result.allele_ids[a] = get_site_id(unpack_number(data));
+	}
+	result.nr_missing = unpack_number(data);
+	result.nr_unique_kmers = unpack_number(data);
+	result.coverage = unpack_number(data);
+	result.kmer_counts.resize(unpack_number(data));
+	for (size_t a = 0; a < result.kmer_counts.size(); ++a) {
+		result.kmer_counts[a] = (int) unpack_number(data) - 1;
+	}
+}
+
+void VariantReader::open_biallelic_outfile(string filename, string panel_filename) {
+	// read REF/ALT and position of each variant ID from the biallelic panel VCF
+	ifstream panel(panel_filename);
+	if (! panel.good()) {
+		throw runtime_error("VariantReader::open_biallelic_outfile: biallelic panel VCF " + panel_filename + " cannot be opened.");
+	}
+	this->biallelic_panel.assign(this->contig_names.size(), unordered_map<string, BiallelicRecord>());
+	string line;
+	while (getline(panel, line)) {
+		if (line.size() == 0 || line[0] == '#') continue;
+		vector<string> tokens;
+		parse_line(tokens, line, '\t');
+		if (tokens.size() < 8) {
+			throw runtime_error("VariantReader::open_biallelic_outfile: malformatted line in biallelic panel VCF: " + line);
+		}
+		// only variants on chromosomes present in the genotyped VCF are needed
+		auto contig = this->contig_to_id.find(tokens[0]);
+		if (contig == this->contig_to_id.end()) continue;
+		vector<string> info_fields;
+		parse_line(info_fields, tokens[7], ';');
+		vector<string> ids;
+		for (auto& info : info_fields) {
+			if (info.substr(0, 3) == "ID=") parse_line(ids, info.substr(3), ',');
+		}
+		vector<string> alt_alleles;
+		parse_line(alt_alleles, tokens[4], ',');
+		if (ids.size() != alt_alleles.size()) {
+			throw runtime_error("VariantReader::open_biallelic_outfile: variant IDs (INFO field ID) missing for some alleles in biallelic panel VCF: " + line);
+		}
+		for (size_t i = 0; i < ids.size(); ++i) {
+			BiallelicRecord record = {(size_t) stoi(tokens[1]), tokens[3], alt_alleles[i]};
+			this->biallelic_panel[contig->second][ids[i]] = record;
+		}
+	}
+
+	this->biallelic_outfile.open(filename);
+	if (! this->biallelic_outfile.is_open()) {
+		throw runtime_error("VariantReader::open_biallelic_outfile: biallelic output file cannot be opened. Note that the filename must not contain non-existing directories.");
+	}
+
+	this->biallelic_outfile_open = true;
+
+	// write VCF header lines
+	this->biallelic_outfile << "##fileformat=VCFv4.2" << endl;
+	this->biallelic_outfile << "##fileDate=" << get_date() << endl;
+	this->biallelic_outfile << "##INFO=<ID=UK,Number=1,Type=Integer,Description=\"Total number of unique kmers.\">" << endl;
+	this->biallelic_outfile << "##INFO=<ID=MA,Number=1,Type=Integer,Description=\"Number of alleles missing in panel haplotypes.\">" << endl;
+	this->biallelic_outfile << "##INFO=<ID=ID,Number=A,Type=String,Description=\"Variant IDs.\">" << endl;
+	this->biallelic_outfile << "##FORMAT=<ID=GT,Number=1,Type=String,Description=\"Genotype\">" << endl;
+	this->biallelic_outfile << "##FORMAT=<ID=GQ,Number=1,Type=Integer,Description=\"Genotype quality: phred scaled probability that the genotype is wrong.\">" << endl;
+	this->biallelic_outfile << "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\t" << this->sample << endl;
+}
+
+void VariantReader::format_biallelic_records(size_t contig_id, const SiteRecord& record, pair<int,int> genotype, const string& genotype_quality, ostream& result) const {
+	if (record.allele_ids.empty()) {
+		throw runtime_error("VariantReader::format_biallelic_records: biallelic output requires variant IDs (INFO field ID) in the input VCF.");
+	}
+	const unordered_map<string, BiallelicRecord>& panel = this->biallelic_panel.at(contig_id);
+	const string& chromosome = this->contig_names[contig_id];
+
+	// IDs of the variants each allele is composed of (REF has none)
+	vector<vector<string>> allele_to_ids(1);
+	for (auto& allele_id : record.allele_ids) {
+		allele_to_ids.push_back(vector<string>());
+		parse_line(allele_to_ids.back(), allele_id, ':');
+	}
+
+	// collect all variant IDs of this record, sorted by their position
+	vector<pair<size_t, string>> ids;
+	for (size_t a = 1; a < allele_to_ids.size(); ++a) {
+		for (auto& id : allele_to_ids[a]) {
+			auto it = panel.find(id);
+			if (it == panel.end()) {
+				throw runtime_error("VariantReader::format_biallelic_records: variant ID " + id + " not found in biallelic panel VCF.");
 			}
-			this->phasing_outfile << ":" << singleton_stats[j].coverage << endl; // KC
-			counter += 1;
+			pair<size_t, string> entry = make_pair(it->second.position, id);
+			if (find(ids.begin(), ids.end(), entry) == ids.end()) ids.push_back(entry);
+		}
+	}
+	stable_sort(ids.begin(), ids.end(), [](const pair<size_t,string>& a, const pair<size_t,string>& b) { return a.first < b.first; });
+
+	for (auto& id : ids) {
+		const BiallelicRecord& panel_record = panel.at(id.second);
+		result << chromosome << "\t"; // CHROM
+		result << id.first << "\t"; // POS
+		result << record.variant_id << "\t"; // ID
+		result << panel_record.ref << "\t"; // REF
+		result << panel_record.alt << "\t"; // ALT
+		result << ".\t"; // QUAL
+		result << "PASS" << "\t"; // FILTER
+		result << "ID=" << id.second << ";UK=" << record.nr_unique_kmers << ";MA=" << record.nr_missing << "\t"; // INFO
+		result << "GT:GQ" << "\t"; // FORMAT
+		if ( (genotype.first != -1) && (genotype.second != -1)) {
+			// an allele carries the variant if the variant is part of it
+			const vector<string>& ids_first = allele_to_ids.at(genotype.first);
+			const vector<string>& ids_second = allele_to_ids.at(genotype.second);
+			bool first = find(ids_first.begin(), ids_first.end(), id.second) != ids_first.end();
+			bool second = find(ids_second.begin(), ids_second.end(), id.second) != ids_second.end();
+			result << first << "/" << second; // GT
+		} else {
+			result << "."; // GT
 		}
+		result << ":" << genotype_quality << "\n"; // GQ
 	}
 }
 
+void VariantReader::close_biallelic_outfile() {
+	this->biallelic_outfile.close();
+	this->biallelic_outfile_open = false;
+}
+
 void VariantReader::close_genotyping_outfile() {
 	this->genotyping_outfile.close();
 	this->genotyping_outfile_open = false;
@@ -644,22 +1303,33 @@ size_t VariantReader::nr_of_paths() const {
 	return this->nr_paths;
 }
 
-void VariantReader::get_left_overhang(std::string chromosome, size_t index, size_t length, DnaSequence& result) const {
-	size_t cur_start = this->variants_per_chromosome.at(chromosome).at(index).get_start_position();
+void VariantReader::get_left_overhang(size_t contig_id, size_t index, size_t length, DnaSequence& result) const {
+	const vector<Variant>& variants = this->variants_per_contig.at(contig_id);
+	size_t cur_start = variants.at(index).get_start_position();
 	size_t prev_end = 0;
-	if (index > 0) prev_end = this->variants_per_chromosome.at(chromosome).at(index-1).get_end_position();
+	if (index > 0) prev_end = variants.at(index-1).get_end_position();
 	size_t overhang_start = cur_start - length;
 	if (overhang_start < prev_end) overhang_start = prev_end;
 	size_t overhang_end = cur_start;
-	this->fasta_reader.get_subsequence(chromosome, overhang_start, overhang_end, result);
+	this->fasta_reader.get_subsequence(this->contig_names[contig_id], overhang_start, overhang_end, result);
 }
 
-void VariantReader::get_right_overhang(std::string chromosome, size_t index, size_t length, DnaSequence& result) const {
-	size_t cur_end = this->variants_per_chromosome.at(chromosome).at(index).get_end_position();
+void VariantReader::get_left_overhang(const string& chromosome, size_t index, size_t length, DnaSequence& result) const {
+	get_left_overhang(this->contig_to_id.at(chromosome), index, length, result);
+}
+
+void VariantReader::get_right_overhang(size_t contig_id, size_t index, size_t length, DnaSequence& result) const {
+	const vector<Variant>& variants = this->variants_per_contig.at(contig_id);
+	const string& chromosome = this->contig_names[contig_id];
+	size_t cur_end = variants.at(index).get_end_position();
 	size_t next_start = this->fasta_reader.get_size_of(chromosome);
-	if (index < (this->variants_per_chromosome.at(chromosome).size() - 1)) next_start = this->variants_per_chromosome.at(chromosome).at(index+1).get_start_position();
+	if (index < (variants.size() - 1)) next_start = variants.at(index+1).get_start_position();
 	size_t overhang_end = cur_end + length;
 	if (overhang_end > next_start) overhang_end = next_start;
 	size_t overhang_start = cur_end;
 	this->fasta_reader.get_subsequence(chromosome, overhang_start, overhang_end, result);
 }
+
+void VariantReader::get_right_overhang(const string& chromosome, size_t index, size_t length, DnaSequence& result) const {
+	get_right_overhang(this->contig_to_id.at(chromosome), index, length, result);
+}
@@ -3,15 +3,21 @@
 
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <fstream>
 #include <numeric>
 #include <algorithm>
 #include <cassert>
+#include <mutex>
 #include "fastareader.hpp"
 #include "variant.hpp"
 #include "genotypingresult.hpp"
 #include "uniquekmers.hpp"
+#include "binarygenotypes.hpp"
+
+/** split line at each occurrence of sep **/
+void parse_line(std::vector<std::string>& result, std::string line, char sep);
 
 //std::vector<unsigned char> construct_index(std::vector<DnaSequence>& alleles, bool reference_added);
 //std::vector<unsigned char> construct_index(std::vector<std::string>& alleles, bool reference_added);
@@ -31,6 +37,59 @@ std::vector<unsigned char> construct_index(std::vector<T>& alleles, bool referen
 	return index;
 }
 
+/** everything needed to write one (uncombined) VCF record besides the genotype columns **/
+struct SiteRecord {
+	std::string site_columns;
+	std::string variant_id;
+	// variant IDs of each ALT allele (empty if the input VCF had no IDs)
+	std::vector<std::string> allele_ids;
+	size_t start_position;
+	std::vector<unsigned char> defined_alleles;
+	size_t nr_missing;
+	size_t nr_unique_kmers;
+	unsigned short coverage;
+	// range of the sample specific INFO fields (";UK=...;AK=...") within site_columns
+	size_t kmer_info_start;
+	size_t kmer_info_end;
+	// AK entries of the defined alleles
+	std::vector<int> allele_kmers;
+	// AK entries of the undefined alleles (",count,..."), which are only reported in the phasing output
+	std::string undefined_allele_kmers;
+};
+
+/** the values a SiteRecord is rendered from. Contigs whose sequences were released keep these in packed form only. **/
+struct SiteFields {
+	size_t start_position;
+	std::string variant_id;
+	// REF followed by the defined ALT alleles
+	std::vector<std::string> alleles;
+	// allele index of each entry of alleles
+	std::vector<unsigned char> defined_alleles;
+	// AF of each defined ALT allele
+	std::vector<float> allele_frequencies;
+	// variant IDs of each defined ALT allele (empty if the input VCF had no IDs)
+	std::vector<std::string> allele_ids;
+	size_t nr_missing;
+	size_t nr_unique_kmers;
+	unsigned short coverage;
+	// AK entries of all alleles, those of the defined alleles first
+	std::vector<int> kmer_counts;
+};
+
+/** SiteFields of all records of a contig, serialized back to back (see VariantReader::pack_site_fields) **/
+struct PackedSites {
+	// start of each record within data
+	std::vector<uint64_t> offsets;
+	std::vector<unsigned char> data;
+};
+
+/** position, REF and ALT of a single variant ID of a biallelic panel VCF **/
+struct BiallelicRecord {
+	size_t position;
+	std::string ref;
+	std::string alt;
+};
+
 class VariantReader {
 public:
 	VariantReader (std::string filename, std::string reference_filename, size_t kmer_size, bool add_reference, std::string sample = "sample");
@@ -38,21 +97,71 @@ public:
 	*    to the given file.
 	**/
 	size_t get_kmer_size() const;
+	/** number of bases in the reference genome **/
+	size_t get_genome_size() const;
 	void write_path_segments(std::string filename) const;
+	/** writes all non-reference allele sequences (including flanks) to the given file. Together with the kmers of the
+	*   reference genome, these contain the kmers of the path segments.
+	**/
+	void write_allele_segments(std::string filename) const;
 	void get_chromosomes(std::vector<std::string>* result) const;
-	size_t size_of(std::string chromosome) const;
-	const Variant& get_variant(std::string chromosome, size_t index) const;
-	const std::vector<Variant>& get_variants_on_chromosome(std::string chromosome) const;
+	/** number of contigs (chromosomes) for which variants were read **/
+	size_t nr_of_contigs() const;
+	/** get the contig ids of all chromosomes, sorted by number of variants (descending) **/
+	void get_contig_ids(std::vector<size_t>* result) const;
+	/** get the dense integer id of a chromosome. Throws if no variants exist on the chromosome. **/
+	size_t get_contig_id(const std::string& chromosome) const;
+	/** reference genome the variants were read with **/
+	const FastaReader& get_reference() const;
+	/** get the chromosome name of a contig id **/
+	const std::string& get_contig_name(size_t contig_id) const;
+	size_t size_of(size_t contig_id) const;
+	size_t size_of(const std::string& chromosome) const;
+	const Variant& get_variant(size_t contig_id, size_t index) const;
+	const Variant& get_variant(const std::string& chromosome, size_t index) const;
+	/** all variants on the given contig **/
+	const std::vector<Variant>& variants(size_t contig_id) const;
+	const std::vector<Variant>& get_variants_on_chromosome(const std::string& chromosome) const;
+	/** for each variant on the given contig, get the frequency of each of its alleles among the panel paths (reference path excluded) **/
+	void get_allele_frequencies(size_t contig_id, std::vector<std::vector<float>>& result) const;
 	void open_genotyping_outfile(std::string outfile_name);
 	void open_phasing_outfile(std::string outfile_name);
-	void write_genotypes_of(std::string chromosome, const std::vector<GenotypingResult>& genotyping_result, std::vector<UniqueKmers*>* unique_kmers, bool ignore_imputed = false);
-	void write_phasing_of(std::string chromosome, const std::vector<GenotypingResult>& genotyping_result, std::vector<UniqueKmers*>* unique_kmers, bool ignore_imputed = false);
+	/** write genotypes of a contig (and their biallelic representation, if requested). Blocks of variants are formatted using nr_threads threads. **/
+	void write_genotypes_of(size_t contig_id, const std::vector<GenotypingResult>& genotyping_result, std::vector<UniqueKmers*>* unique_kmers, bool ignore_imputed = false, size_t nr_threads = 1);
+	void write_genotypes_of(const std::string& chromosome, const std::vector<GenotypingResult>& genotyping_result, std::vector<UniqueKmers*>* unique_kmers, bool ignore_imputed = false, size_t nr_threads = 1);
+	/** write genotypes in binary format (see binarygenotypes.hpp) instead of VCF. Each contig is written as a separate block. **/
+	void open_binary_genotyping_outfile(std::string outfile_name);
+	void write_binary_genotypes_of(size_t contig_id, const std::vector<GenotypingResult>& genotyping_result, std::vector<UniqueKmers*>* unique_kmers, bool ignore_imputed = false);
+	void close_binary_genotyping_outfile();
+	/** write genotypes of several samples genotyped against the same panel into a single VCF. Site columns are written once,
+	*   unique kmer statistics (UK, AK) and genotypes are written per sample. Blocks of variants are formatted using nr_threads threads.
+	*   Allele sequences must not be released when writing more than one sample.
+	**/
+	void open_multisample_genotyping_outfile(std::string outfile_name, const std::vector<std::string>& samples);
+	void write_multisample_genotypes_of(size_t contig_id, const std::vector<const std::vector<GenotypingResult>*>& genotyping_results, const std::vector<std::vector<UniqueKmers*>*>& unique_kmers, bool ignore_imputed = false, size_t nr_threads = 1);
+	void write_multisample_genotypes_of(const std::string& chromosome, const std::vector<const std::vector<GenotypingResult>*>& genotyping_results, const std::vector<std::vector<UniqueKmers*>*>& unique_kmers, bool ignore_imputed = false, size_t nr_threads = 1);
+	void close_multisample_genotyping_outfile();
+	void write_phasing_of(size_t contig_id, const std::vector<GenotypingResult>& genotyping_result, std::vector<UniqueKmers*>* unique_kmers, bool ignore_imputed = false);
+	void write_phasing_of(const std::string& chromosome, const std::vector<GenotypingResult>& genotyping_result, std::vector<UniqueKmers*>* unique_kmers, bool ignore_imputed = false);
+	/** drop allele sequences and flanks of all variants on the given contig once their unique kmers were computed.
+	*   Only the values of the fixed VCF columns (CHROM - INFO) are kept for the writers, with REF/ALT packed
+	*   into 2 bits per base and variant IDs stored once per reader. The text is rendered again when writing.
+	**/
+	void release_sequences(size_t contig_id, std::vector<UniqueKmers*>* unique_kmers);
+	bool sequences_released(size_t contig_id) const;
+	/** additionally write genotypes in biallelic representation (one record per variant ID) while writing genotypes.
+	*   REF/ALT of each variant ID are read from the given biallelic panel VCF (as used to construct the input VCF).
+	**/
+	void open_biallelic_outfile(std::string outfile_name, std::string panel_filename);
+	void close_biallelic_outfile();
 	void close_genotyping_outfile();
 	void close_phasing_outfile();
 	size_t nr_of_genomic_kmers() const;
 	size_t nr_of_paths() const;
-	void get_left_overhang(std::string chromosome, size_t index, size_t length, DnaSequence& result) const;
-	void get_right_overhang(std::string chromosome, size_t index, size_t length, DnaSequence& result) const;
+	void get_left_overhang(size_t contig_id, size_t index, size_t length, DnaSequence& result) const;
+	void get_left_overhang(const std::string& chromosome, size_t index, size_t length, DnaSequence& result) const;
+	void get_right_overhang(size_t contig_id, size_t index, size_t length, DnaSequence& result) const;
+	void get_right_overhang(const std::string& chromosome, size_t index, size_t length, DnaSequence& result) const;
 
 private:
 	FastaReader fasta_reader;
@@ -63,13 +172,55 @@ private:
 	std::string sample;
 	std::ofstream genotyping_outfile;
 	std::ofstream phasing_outfile;
+	std::ofstream biallelic_outfile;
+	std::ofstream multisample_outfile;
+	size_t nr_multisample_samples;
+	BinaryGenotypeWriter binary_outfile;
 	bool genotyping_outfile_open;
 	bool phasing_outfile_open;
-	std::map< std::string, std::vector<Variant> > variants_per_chromosome;
-	std::map< std::string, std::vector<std::vector<std::string>>> variant_ids;
-	void add_variant_cluster(std::string& chromosome, std::vector<Variant>* cluster);
-	void insert_ids(std::string& chromosome, std::vector<DnaSequence>& alleles, std::vector<std::string>& variant_ids, bool reference_added);
-	std::string get_ids(std::string chromosome, std::vector<std::string>& alleles, size_t variant_index, bool reference_added);
+	bool biallelic_outfile_open;
+	bool multisample_outfile_open;
+	bool binary_outfile_open;
+	// variant ID -> REF/ALT of the biallelic panel, indexed by contig id
+	std::vector< std::unordered_map<std::string, BiallelicRecord> > biallelic_panel;
+	// contig names, indexed by contig id
+	std::vector<std::string> contig_names;
+	std::map<std::string, size_t> contig_to_id;
+	// variants and variant ids, indexed by contig id
+	std::vector< std::vector<Variant> > variants_per_contig;
+	std::vector< std::vector<std::vector<std::string>> > variant_ids;
+	// VCF records of contigs whose sequences were released, indexed by contig id
+	std::vector<PackedSites> packed_sites;
+	// allele frequencies of all alleles of all variants of released contigs (computed before the paths are dropped), indexed by contig id
+	std::vector< std::vector<float> > released_frequencies;
+	// variant IDs referenced by packed records. Each ID is stored once, as key of site_id_index.
+	std::unordered_map<std::string, uint32_t> site_id_index;
+	std::vector<const std::string*> site_ids;
+	mutable std::mutex site_id_mutex;
+	size_t register_contig(const std::string& chromosome);
+	void add_variant_cluster(size_t contig_id, std::vector<Variant>* cluster);
+	void insert_ids(size_t contig_id, std::vector<DnaSequence>& alleles, std::vector<std::string>& variant_ids, bool reference_added);
+	void get_allele_ids(size_t contig_id, std::vector<std::string>& alleles, size_t variant_index, bool reference_added, std::vector<std::string>& result);
+	std::string get_ids(size_t contig_id, std::vector<std::string>& alleles, size_t variant_index, bool reference_added);
+	/** format the biallelic records (one per variant ID) of a single record **/
+	void format_biallelic_records(size_t contig_id, const SiteRecord& record, std::pair<int,int> genotype, const std::string& genotype_quality, std::ostream& result) const;
+	/** VCF header lines of the genotyping output **/
+	std::string genotyping_header() const;
+	/** determine genotype, genotype quality (-1 if undefined) and genotype likelihoods of a single record **/
+	void compute_genotype(const SiteRecord& record, const GenotypingResult& likelihoods, bool ignore_imputed, std::pair<int,int>& genotype, int& genotype_quality, std::vector<long double>& genotype_likelihoods) const;
+	/** format GT:GQ:GL of a single record and determine its genotype and genotype quality **/
+	std::string format_genotype(const SiteRecord& record, const GenotypingResult& likelihoods, bool ignore_imputed, std::pair<int,int>& genotype, std::string& genotype_quality) const;
+	/** format the records of variants [start, end) of a contig, record_index is the index of the first record. Biallelic records are only formatted if biallelic_result is given. **/
+	void format_genotype_block(size_t contig_id, size_t start, size_t end, size_t record_index, const std::vector<GenotypingResult>* genotyping_result, std::vector<UniqueKmers*>* unique_kmers, bool ignore_imputed, std::string* result, std::string* biallelic_result);
+	/** format the multi-sample records of variants [start, end) of a contig, record_index is the index of the first record **/
+	void format_multisample_block(size_t contig_id, size_t start, size_t end, size_t record_index, const std::vector<const std::vector<GenotypingResult>*>* genotyping_results, const std::vector<std::vector<UniqueKmers*>*>* unique_kmers, bool ignore_imputed, std::string* result);
+	void get_site_records(size_t contig_id, size_t variant_index, size_t record_index, UniqueKmers* unique_kmers, std::vector<SiteRecord>& result);
+	void get_site_fields(size_t contig_id, size_t variant_index, size_t record_index, UniqueKmers* unique_kmers, std::vector<SiteFields>& result);
+	void render_site_record(size_t contig_id, const SiteFields& fields, SiteRecord& result) const;
+	uint32_t get_site_id_index(const std::string& id);
+	const std::string& get_site_id(uint32_t index) const;
+	void pack_site_fields(const SiteFields& fields, std::vector<unsigned char>& result);
+	void unpack_site_fields(const unsigned char* data, SiteFields& result) const;
 };
 
 #endif // VARIANT_READER_HPP
@@ -0,0 +1,100 @@
+#include "catch.hpp"
+#include "../src/arena.hpp"
+#include "../src/uniquekmers.hpp"
+#include <vector>
+#include <string>
+#include <cstdint>
+
+using namespace std;
+
+TEST_CASE("Arena allocate", "[Arena allocate]") {
+	Arena arena(4096);
+	REQUIRE(arena.reserved_bytes() == 0);
+	// blocks are aligned and consecutive
+	char* a = static_cast<char*>(arena.allocate(1));
+	char* b = static_cast<char*>(arena.allocate(20));
+	REQUIRE(((uintptr_t) a) % alignof(max_align_t) == 0);
+	REQUIRE(((uintptr_t) b) % alignof(max_align_t) == 0);
+	REQUIRE(b > a);
+	REQUIRE(arena.reserved_bytes() == 4096);
+	size_t allocated = arena.allocated_bytes();
+	REQUIRE(allocated >= 21);
+
+	// returned blocks are reused for requests of the same size class
+	arena.deallocate(b, 20);
+	REQUIRE(arena.allocated_bytes() < allocated);
+	REQUIRE(arena.allocate(20) == b);
+	REQUIRE(arena.allocated_bytes() == allocated);
+
+	// large blocks get their own chunk
+	char* c = static_cast<char*>(arena.allocate(10000));
+	REQUIRE(arena.reserved_bytes() == 4096 + 10000);
+	c[9999] = 'c';
+	REQUIRE(arena.allocate(16) != nullptr);
+	REQUIRE(arena.reserved_bytes() == 4096 + 10000);
+
+	// chunks are filled before new ones are requested
+	for (size_t i = 0; i < 300; ++i) {
+		int* value = arena.create<int>(i);
+		REQUIRE(*value == (int) i);
+	}
+	REQUIRE(arena.reserved_bytes() == 2*4096 + 10000);
+
+	arena.release();
+	REQUIRE(arena.reserved_bytes() == 0);
+	REQUIRE(arena.allocated_bytes() == 0);
+	REQUIRE(arena.allocate(8) != nullptr);
+}
+
+TEST_CASE("Arena ArenaAllocator", "[Arena ArenaAllocator]") {
+	Arena arena;
+	ArenaVector<unsigned short> numbers((ArenaAllocator<unsigned short>(&arena)));
+	for (unsigned short i = 0; i < 1000; ++i) numbers.push_back(i);
+	for (unsigned short i = 0; i < 1000; ++i) REQUIRE(numbers[i] == i);
+	REQUIRE(numbers.get_allocator().get_arena() == &arena);
+	REQUIRE(arena.allocated_bytes() >= 2000);
+
+	ArenaMap<string, int> names((ArenaAllocator<pair<const string, int>>(&arena)));
+	names["b"] = 2;
+	names["a"] = 1;
+	REQUIRE(names.size() == 2);
+	REQUIRE(names.begin()->first == "a");
+	REQUIRE(names.at("b") == 2);
+
+	// copies keep the arena, containers without an arena use the heap
+	ArenaVector<unsigned short> copy = numbers;
+	REQUIRE(copy.get_allocator().get_arena() == &arena);
+	ArenaVector<unsigned short> heap;
+	REQUIRE(heap.get_allocator().get_arena() == nullptr);
+	heap = numbers;
+	REQUIRE(heap == numbers);
+	REQUIRE(heap.get_allocator().get_arena() == &arena);
+}
+
+TEST_CASE("Arena UniqueKmers", "[Arena UniqueKmers]") {
+	Arena arena(1 << 12);
+	vector<UniqueKmers*> unique_kmers;
+	for (size_t v = 0; v < 100; ++v) {
+		UniqueKmers* u = arena.create<UniqueKmers>(v*100, &arena);
+		u->insert_empty_allele(0);
+		u->insert_empty_allele(1);
+		u->insert_path(0, 0);
+		u->insert_path(1, 1);
+		vector<unsigned char> alleles = {1};
+		for (unsigned short i = 0; i < 40; ++i) u->insert_kmer(i, alleles);
+		unique_kmers.push_back(u);
+	}
+	for (size_t v = 0; v < 100; ++v) {
+		REQUIRE(unique_kmers[v]->get_variant_position() == v*100);
+		REQUIRE(unique_kmers[v]->size() == 40);
+		REQUIRE(unique_kmers[v]->get_readcount_of(39) == 39);
+		REQUIRE(unique_kmers[v]->kmer_on_path(39, 1));
+		REQUIRE_FALSE(unique_kmers[v]->kmer_on_path(39, 0));
+		REQUIRE(unique_kmers[v]->kmers_on_allele(1) == 40);
+	}
+	// all memory was taken from the arena, it is freed at once
+	size_t reserved = arena.reserved_bytes();
+	REQUIRE(reserved > 0);
+	arena.release();
+	REQUIRE(arena.reserved_bytes() == 0);
+}
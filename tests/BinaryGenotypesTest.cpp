@@ -0,0 +1,151 @@
+#include "catch.hpp"
+#include "utils.hpp"
+#include "../src/binarygenotypes.hpp"
+#include "../src/variantreader.hpp"
+#include <vector>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <cmath>
+#include <cstdio>
+
+using namespace std;
+
+TEST_CASE("BinaryGenotypes likelihoods", "[BinaryGenotypes likelihoods]") {
+	string binfile = "../tests/data/binary-likelihoods.bin";
+	vector<long double> likelihoods = {1.0L, 0.0L, 0.5L, 1e-100L, 1e-1000L};
+	BinaryGenotypeWriter writer;
+	writer.open(binfile, "#header\n");
+	writer.add_record(0, 4294967295, "var1\tA\tC,G\t.\tPASS\tAF=0.5;MA=0", 24, 3, {1,0,-1}, {0,2}, 10, 5, likelihoods);
+	writer.add_record(1, 12, "var2\tA\tC\t.\tPASS\tAF=0.5", 22, 0, {0,0}, {-1,-1}, -1, 5, {0.1L, 0.2L, 0.7L});
+	writer.write_block("chr1");
+	writer.close();
+	CHECK_THROWS(writer.add_record(0, 4294967296, "", 0, 0, {}, {0,0}, 0, 0, likelihoods));
+	CHECK_THROWS(writer.add_record(0, 12, "", 0, 0, {}, {0,255}, 0, 0, likelihoods));
+	CHECK_THROWS(writer.add_record(0, 12, "", 0, 0, {}, {300,1}, 0, 0, likelihoods));
+
+	BinaryGenotypeReader reader(binfile);
+	REQUIRE(reader.get_header() == "#header\n");
+	REQUIRE(reader.nr_of_blocks() == 1);
+	const BinaryGenotypeBlock& block = reader.get_block(0);
+	REQUIRE(block.nr_records == 2);
+	REQUIRE(block.position[0] == 4294967295);
+	REQUIRE(block.likelihood_offsets[1] == 5);
+	// likelihoods are not clamped
+	REQUIRE(block.likelihoods[0] == 0.0f);
+	REQUIRE(std::isinf(block.likelihoods[1]));
+	REQUIRE(abs(block.likelihoods[2] - log10(0.5)) < 0.000001);
+	REQUIRE(abs(block.likelihoods[3] + 100.0) < 0.0001);
+	REQUIRE(abs(block.likelihoods[4] + 1000.0) < 0.001);
+
+	reader.write_vcf("../tests/data/binary-likelihoods.vcf");
+	ifstream vcf("../tests/data/binary-likelihoods.vcf");
+	string line;
+	REQUIRE(getline(vcf, line));
+	REQUIRE(line == "#header");
+	REQUIRE(getline(vcf, line));
+	REQUIRE(line == "chr1\t4294967295\tvar1\tA\tC,G\t.\tPASS\tAF=0.5;UK=3;AK=1,0,-1;MA=0\tGT:GQ:GL:KC\t0/2:10:0,-inf,-0.301,-100,-1000:5");
+	REQUIRE(getline(vcf, line));
+	REQUIRE(line == "chr1\t12\tvar2\tA\tC\t.\tPASS\tAF=0.5;UK=0;AK=0,0\tGT:GQ:GL:KC\t.:.:-1,-0.699,-0.1549:5");
+	REQUIRE(!getline(vcf, line));
+	remove(binfile.c_str());
+	remove("../tests/data/binary-likelihoods.vcf");
+}
+
+TEST_CASE("BinaryGenotypes write_binary_genotypes_of", "[BinaryGenotypes write_binary_genotypes_of]") {
+	string vcf = "../tests/data/small1.vcf";
+	string fasta = "../tests/data/small1.fa";
+	string binfile = "../tests/data/small1-binary.bin";
+	VariantReader v(vcf, fasta, 10, true, "HG0");
+
+	vector<vector<GenotypingResult>> genotypes(v.nr_of_contigs());
+	vector<vector<UniqueKmers*>> kmers(v.nr_of_contigs());
+	for (size_t c = 0; c < v.nr_of_contigs(); ++c) {
+		for (size_t i = 0; i < v.size_of(c); ++i) {
+			const Variant& variant = v.get_variant(c, i);
+			GenotypingResult r;
+			for (size_t a0 = 0; a0 < variant.nr_of_alleles(); ++a0) {
+				for (size_t a1 = a0; a1 < variant.nr_of_alleles(); ++a1) {
+					// genotype 0/0 gets likelihood 0 for the first variant
+					if ((i == 0) && (a1 == 0)) continue;
+					r.add_to_likelihood(a0, a1, 0.1 * (a0 + 1) + 0.2 * a1 + 0.01 * i);
+				}
+			}
+			r.normalize();
+			genotypes[c].push_back(r);
+			UniqueKmers* u = new UniqueKmers(variant.get_start_position());
+			for (size_t a = 0; a < variant.nr_of_alleles(); ++a) {
+				u->insert_empty_allele(a);
+			}
+			u->set_coverage(5 + i);
+			kmers[c].push_back(u);
+		}
+	}
+
+	// write text and binary output
+	v.open_genotyping_outfile("../tests/data/small1-binary-expected.vcf");
+	v.open_binary_genotyping_outfile(binfile);
+	for (size_t c = 0; c < v.nr_of_contigs(); ++c) {
+		v.write_genotypes_of(c, genotypes[c], &kmers[c], c == 1);
+		v.write_binary_genotypes_of(c, genotypes[c], &kmers[c], c == 1);
+	}
+	v.close_genotyping_outfile();
+	v.close_binary_genotyping_outfile();
+
+	BinaryGenotypeReader reader(binfile);
+	REQUIRE(reader.nr_of_blocks() == v.nr_of_contigs());
+	for (size_t c = 0; c < v.nr_of_contigs(); ++c) {
+		REQUIRE(reader.get_block(c).chromosome == v.get_contig_name(c));
+		REQUIRE(reader.get_block(c).site_index[0] == 0);
+		REQUIRE(reader.get_block(c).nr_records >= v.size_of(c));
+	}
+	REQUIRE(reader.get_header().find("#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\tHG0\n") != string::npos);
+	reader.write_vcf("../tests/data/small1-binary-converted.vcf");
+
+	// converted VCF matches the text output, up to the precision of the likelihoods
+	ifstream expected_file("../tests/data/small1-binary-expected.vcf");
+	ifstream computed_file("../tests/data/small1-binary-converted.vcf");
+	string expected_line;
+	string computed_line;
+	size_t nr_records = 0;
+	while (getline(expected_file, expected_line)) {
+		REQUIRE(getline(computed_file, computed_line));
+		if (expected_line[0] == '#') {
+			REQUIRE(expected_line == computed_line);
+			continue;
+		}
+		vector<string> expected_fields = split_line(expected_line, '\t');
+		vector<string> computed_fields = split_line(computed_line, '\t');
+		REQUIRE(expected_fields.size() == 10);
+		REQUIRE(computed_fields.size() == 10);
+		for (size_t f = 0; f < 9; ++f) {
+			REQUIRE(expected_fields[f] == computed_fields[f]);
+		}
+		vector<string> expected_values = split_line(expected_fields[9], ':');
+		vector<string> computed_values = split_line(computed_fields[9], ':');
+		REQUIRE(expected_values.size() == 4);
+		REQUIRE(computed_values.size() == 4);
+		REQUIRE(expected_values[0] == computed_values[0]);
+		REQUIRE(expected_values[1] == computed_values[1]);
+		REQUIRE(expected_values[3] == computed_values[3]);
+		vector<string> expected_likelihoods = split_line(expected_values[2], ',');
+		vector<string> computed_likelihoods = split_line(computed_values[2], ',');
+		REQUIRE(expected_likelihoods.size() == computed_likelihoods.size());
+		for (size_t l = 0; l < expected_likelihoods.size(); ++l) {
+			if (expected_likelihoods[l] == "-inf") {
+				REQUIRE(computed_likelihoods[l] == "-inf");
+			} else {
+				REQUIRE(abs(stod(expected_likelihoods[l]) - stod(computed_likelihoods[l])) < 0.0001);
+			}
+		}
+		nr_records += 1;
+	}
+	REQUIRE(!getline(computed_file, computed_line));
+	REQUIRE(nr_records == 10);
+
+	CHECK_THROWS(BinaryGenotypeReader("../tests/data/small1.vcf"));
+
+	for (auto& contig_kmers : kmers) {
+		for (auto u : contig_kmers) delete u;
+	}
+}
@@ -0,0 +1,114 @@
+#include "catch.hpp"
+#include "utils.hpp"
+#include "../src/bucketkmercounter.hpp"
+#include <vector>
+#include <string>
+#include <map>
+#include <fstream>
+#include <cstdio>
+#include <cctype>
+#include <cmath>
+
+using namespace std;
+
+// counts the canonical kmers (without N) of all reads in a FASTA/FASTQ file
+void bucket_count_reads(string filename, size_t kmer_size, map<string, size_t>& counts) {
+	ifstream file(filename);
+	vector<string> sequences;
+	string line;
+	bool fastq = (file.peek() == '@');
+	size_t line_nr = 0;
+	while (getline(file, line)) {
+		if (fastq) {
+			if (line_nr % 4 == 1) sequences.push_back(line);
+		} else if (!line.empty() && (line[0] == '>')) {
+			sequences.push_back("");
+		} else {
+			sequences.back() += line;
+		}
+		line_nr += 1;
+	}
+	for (auto& sequence : sequences) {
+		for (auto& c : sequence) c = toupper(c);
+		if (sequence.size() < kmer_size) continue;
+		for (size_t i = 0; i <= sequence.size() - kmer_size; ++i) {
+			string kmer = sequence.substr(i, kmer_size);
+			if (kmer.find_first_not_of("ACGT") != string::npos) continue;
+			counts[canonical_kmer(kmer)] += 1;
+		}
+	}
+}
+
+void check_bucket_counts(string readfile, size_t kmer_size, uint64_t max_memory, size_t nr_threads) {
+	map<string, size_t> expected;
+	bucket_count_reads(readfile, kmer_size, expected);
+	BucketKmerCounter counter(readfile, kmer_size, "../tests/data/bucketkmercounter", max_memory, nr_threads);
+	REQUIRE(counter.size() == expected.size());
+	for (auto& kmer : expected) {
+		REQUIRE(counter.getKmerAbundance(kmer.first) == kmer.second);
+		REQUIRE(counter.getKmerAbundance(reverse_complement_kmer(kmer.first)) == kmer.second);
+	}
+	// kmers that do not occur, or contain N or have the wrong length
+	REQUIRE(counter.getKmerAbundance(string(kmer_size, 'N')) == 0);
+	REQUIRE(counter.getKmerAbundance(string(kmer_size + 1, 'A')) == 0);
+}
+
+TEST_CASE("BucketKmerCounter getKmerAbundance", "[BucketKmerCounter getKmerAbundance]") {
+	// FASTQ and multi-line FASTA, with a single bucket and with many small buckets
+	for (size_t kmer_size : {5, 11, 31}) {
+		check_bucket_counts("../tests/data/parser-reads.fq", kmer_size, 1 << 30, 1);
+		check_bucket_counts("../tests/data/parser-reads.fq", kmer_size, 1000, 2);
+		check_bucket_counts("../tests/data/subsample-reads.fa", kmer_size, 1000, 3);
+	}
+
+	// lowercase characters, N and long homopolymers (split into several super-kmers)
+	string readfile = "../tests/data/bucketkmercounter-reads.fa";
+	{
+		ofstream reads(readfile);
+		reads << ">read0" << endl << "ACGTNNACGTTGCAacgtgcaGGATCCAN" << endl;
+		reads << ">read1" << endl << string(2500, 'A') << "CCGTA" << string(1200, 'T') << endl;
+		reads << ">read2" << endl << "NNNN" << endl;
+		reads << ">read3" << endl << "GGATCCATTACGGATCCATT" << endl;
+	}
+	check_bucket_counts(readfile, 5, 1 << 30, 1);
+	check_bucket_counts(readfile, 7, 500, 2);
+	{
+		BucketKmerCounter counter(readfile, 7, "../tests/data/bucketkmercounter", 500, 2);
+		REQUIRE(counter.get_nr_buckets() > 1);
+		REQUIRE(counter.getKmerAbundance(string("AAAAAAA")) == 2500 - 7 + 1 + 1200 - 7 + 1);
+		REQUIRE(counter.getKmerAbundance(string("TTTTTTT")) == 2500 - 7 + 1 + 1200 - 7 + 1);
+		REQUIRE(counter.getKmerAbundance(string("GGATCCA")) == 3);
+	}
+	// counts file and buckets are removed
+	REQUIRE_FALSE(ifstream("../tests/data/bucketkmercounter.counts").good());
+	REQUIRE_FALSE(ifstream("../tests/data/bucketkmercounter.bucket0").good());
+	remove(readfile.c_str());
+
+	REQUIRE_THROWS(BucketKmerCounter("../tests/data/parser-reads.fq", 32, "../tests/data/bucketkmercounter", 1 << 30, 1));
+	REQUIRE_THROWS(BucketKmerCounter("../tests/data/missing-reads.fq", 31, "../tests/data/bucketkmercounter", 1 << 30, 1));
+}
+
+TEST_CASE("BucketKmerCounter computeHistogram", "[BucketKmerCounter computeHistogram]") {
+	BucketKmerCounter counter("../tests/data/subsample-reads.fq", 11, "../tests/data/bucketkmercounter", 1000, 2);
+	map<string, size_t> expected;
+	bucket_count_reads("../tests/data/subsample-reads.fq", 11, expected);
+	long double coverage = 0.0L;
+	for (auto& kmer : expected) coverage += 1.0L * kmer.second / 100;
+	REQUIRE(counter.computeKmerCoverage(100) == (size_t) ceil(coverage));
+	string histogram_file = "../tests/data/bucketkmercounter.histo";
+	counter.computeHistogram(100, true, histogram_file);
+	ifstream histogram(histogram_file);
+	string line;
+	size_t nr_lines = 0;
+	size_t total = 0;
+	while (getline(histogram, line)) {
+		if (line.substr(0, 10) == "parameters") continue;
+		size_t tab = line.find('\t');
+		total += stoul(line.substr(tab + 1));
+		nr_lines += 1;
+	}
+	REQUIRE(nr_lines == 101);
+	// all kmers have counts below 100
+	REQUIRE(total == expected.size());
+	remove(histogram_file.c_str());
+}
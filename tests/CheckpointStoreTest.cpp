@@ -0,0 +1,52 @@
+#include "catch.hpp"
+#include "../src/checkpointstore.hpp"
+#include <vector>
+#include <string>
+#include <stdexcept>
+
+using namespace std;
+
+TEST_CASE("CheckpointStore store", "[CheckpointStore store]") {
+	CheckpointStore store("../tests/data");
+	REQUIRE(store.size() == 0);
+	REQUIRE(!store.contains(0));
+
+	// write columns in forward order (of different sizes, so that they are not page-aligned)
+	for (size_t column_index = 0; column_index < 100; column_index += 10) {
+		vector<long double> column (column_index + 1);
+		for (size_t i = 0; i < column.size(); ++i) column[i] = column_index + i / 1000.0L;
+		store.store(column_index, column);
+	}
+	vector<long double> empty;
+	store.store(100, empty);
+	REQUIRE(store.contains(90));
+	REQUIRE(!store.contains(95));
+
+	// read them back in reverse order
+	vector<long double>* last = store.load<long double>(100);
+	REQUIRE(last->empty());
+	delete last;
+	for (int column_index = 90; column_index >= 0; column_index -= 10) {
+		vector<long double>* column = store.load<long double>(column_index);
+		REQUIRE(column->size() == (size_t) column_index + 1);
+		for (size_t i = 0; i < column->size(); ++i) {
+			REQUIRE(column->at(i) == column_index + i / 1000.0L);
+		}
+		delete column;
+	}
+
+	// columns can be stored after others were read
+	vector<unsigned int> backtrace = {1,2,3};
+	store.store(200, backtrace);
+	vector<unsigned int>* loaded = store.load<unsigned int>(200);
+	REQUIRE(*loaded == backtrace);
+	delete loaded;
+
+	// each column can be stored only once
+	CHECK_THROWS(store.store(200, backtrace));
+	CHECK_THROWS(store.load<unsigned int>(5));
+}
+
+TEST_CASE("CheckpointStore directory", "[CheckpointStore directory]") {
+	CHECK_THROWS(CheckpointStore("../tests/data/nonexistent"));
+}
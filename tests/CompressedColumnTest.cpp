@@ -0,0 +1,45 @@
+#include "catch.hpp"
+#include "../src/compressedcolumn.hpp"
+#include <vector>
+#include <string>
+#include <math.h>
+
+using namespace std;
+
+TEST_CASE("CompressedColumn decompress", "[CompressedColumn decompress]") {
+	vector<long double> column = {0.5L, 0.25L, 0.0L, 1e-10L, 0.2499999999L, 1e-100L};
+	for (string name : {"none", "float32", "log16"}) {
+		CompressedColumn::Mode mode = CompressedColumn::parse_mode(name);
+		CompressedColumn compressed (column, mode);
+		REQUIRE(CompressedColumn::get_mode_name(compressed.get_mode()) == name);
+		REQUIRE(compressed.size() == column.size());
+		vector<long double>* decompressed = compressed.decompress();
+		REQUIRE(decompressed->size() == column.size());
+
+		// zeros stay zero, tiny values do not underflow
+		REQUIRE(decompressed->at(2) == 0.0L);
+		long double tolerance = 0.0L;
+		if (mode == CompressedColumn::FLOAT32) tolerance = 1e-7L * fabsl(logl(1e-100L / 0.5L));
+		if (mode == CompressedColumn::LOG16) tolerance = logl(0.5L / 1e-100L) / 131068.0L;
+		for (size_t i = 0; i < column.size(); ++i) {
+			REQUIRE(fabsl(decompressed->at(i) - column[i]) <= tolerance * column[i]);
+		}
+		if (mode == CompressedColumn::NONE) REQUIRE(compressed.bytes() == column.size() * sizeof(long double));
+		if (mode == CompressedColumn::FLOAT32) REQUIRE(compressed.bytes() == column.size() * sizeof(float));
+		if (mode == CompressedColumn::LOG16) REQUIRE(compressed.bytes() == column.size() * sizeof(uint16_t));
+		delete decompressed;
+	}
+	CHECK_THROWS(CompressedColumn::parse_mode("float16"));
+}
+
+TEST_CASE("CompressedColumn special_columns", "[CompressedColumn special_columns]") {
+	vector<vector<long double>> columns = { {}, {0.0L, 0.0L}, {0.5L, 0.5L}, {1.0L}, {0.0L, 1e-4900L} };
+	for (auto mode : {CompressedColumn::FLOAT32, CompressedColumn::LOG16}) {
+		for (auto& column : columns) {
+			CompressedColumn compressed (column, mode);
+			vector<long double>* decompressed = compressed.decompress();
+			REQUIRE(*decompressed == column);
+			delete decompressed;
+		}
+	}
+}
@@ -0,0 +1,109 @@
+#include "catch.hpp"
+#include "../src/directfilereader.hpp"
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <thread>
+#include <sys/stat.h>
+
+using namespace std;
+
+void check_direct_reads(string filename) {
+	ifstream file(filename);
+	stringstream content;
+	content << file.rdbuf();
+	string expected = content.str();
+	vector<string> expected_lines;
+	ifstream lines(filename);
+	string line;
+	while (getline(lines, line)) expected_lines.push_back(line);
+
+	for (size_t block_size : {1, 4096, 10000, 1 << 20}) {
+		for (size_t queue_depth : {1, 3, 8}) {
+			for (bool direct_io : {true, false}) {
+				for (bool io_uring : {true, false}) {
+					// chunks of a size unrelated to the blocks
+					DirectFileReader reader(filename, block_size, queue_depth, direct_io, io_uring);
+					REQUIRE(reader.is_open());
+					REQUIRE(reader.size() == expected.size());
+					string result = "";
+					vector<char> chunk(3001);
+					size_t n;
+					while ((n = reader.read(chunk.data(), chunk.size())) > 0) result.append(chunk.data(), n);
+					REQUIRE(result == expected);
+					REQUIRE(reader.read(chunk.data(), chunk.size()) == 0);
+
+					DirectFileReader line_reader(filename, block_size, queue_depth, direct_io, io_uring);
+					vector<string> result_lines;
+					while (line_reader.getline(line)) result_lines.push_back(line);
+					REQUIRE(result_lines == expected_lines);
+					REQUIRE_FALSE(line_reader.getline(line));
+				}
+			}
+		}
+	}
+	// reading stops early
+	DirectFileReader reader(filename, 4096, 4);
+	REQUIRE(reader.getline(line) == !expected_lines.empty());
+}
+
+TEST_CASE("DirectFileReader read", "[DirectFileReader read]") {
+	check_direct_reads("../tests/data/small1.vcf");
+	check_direct_reads("../tests/data/reads.fa");
+
+	// lines spanning several blocks, empty lines and a last line without newline
+	string filename = "../tests/data/directfilereader.txt";
+	{
+		ofstream file(filename);
+		file << string(10000, 'A') << endl << endl << "ACGT\r" << endl;
+		for (size_t i = 0; i < 5000; ++i) file << "line" << i << endl;
+		file << "last";
+	}
+	check_direct_reads(filename);
+	{
+		ofstream file(filename);
+	}
+	check_direct_reads(filename);
+	remove(filename.c_str());
+
+	DirectFileReader missing("../tests/data/missing.txt");
+	REQUIRE_FALSE(missing.is_open());
+	string line;
+	REQUIRE_FALSE(missing.getline(line));
+}
+
+TEST_CASE("DirectFileReader pipe", "[DirectFileReader pipe]") {
+	string filename = "../tests/data/directfilereader.fifo";
+	remove(filename.c_str());
+	REQUIRE(mkfifo(filename.c_str(), 0600) == 0);
+	vector<string> expected_lines;
+	for (size_t i = 0; i < 20000; ++i) expected_lines.push_back("line" + to_string(i));
+	thread writer([&] () {
+		ofstream file(filename);
+		for (auto& line : expected_lines) file << line << endl;
+	});
+	DirectFileReader reader(filename, 4096, 4);
+	REQUIRE(reader.is_open());
+	REQUIRE_FALSE(reader.uses_io_uring());
+	REQUIRE_FALSE(reader.uses_direct_io());
+	REQUIRE(reader.size() == 0);
+	vector<string> result_lines;
+	string line;
+	while (reader.getline(line)) result_lines.push_back(line);
+	writer.join();
+	REQUIRE(result_lines == expected_lines);
+	remove(filename.c_str());
+}
+
+TEST_CASE("DirectFileReader set_io_uring", "[DirectFileReader set_io_uring]") {
+	REQUIRE(DirectFileReader::get_io_uring());
+	DirectFileReader::set_io_uring(false);
+	DirectFileReader reader("../tests/data/reads.fa", 4096, 4);
+	REQUIRE(reader.is_open());
+	REQUIRE_FALSE(reader.uses_io_uring());
+	DirectFileReader::set_io_uring(true);
+	string line;
+	REQUIRE(reader.getline(line));
+}
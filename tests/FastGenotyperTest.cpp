@@ -0,0 +1,133 @@
+#include "catch.hpp"
+#include "../src/uniquekmers.hpp"
+#include "../src/copynumber.hpp"
+#include "../src/hmm.hpp"
+#include "../src/fastgenotyper.hpp"
+#include "utils.hpp"
+#include <vector>
+#include <string>
+#include <random>
+
+using namespace std;
+
+TEST_CASE("FastGenotyper get_genotyping_result", "[FastGenotyper get_genotyping_result]") {
+	UniqueKmers u1(2000);
+	vector<unsigned char> a1 = {0};
+	vector<unsigned char> a2 = {1};
+	u1.insert_path(0,0);
+	u1.insert_path(1,1);
+	u1.insert_kmer(10, a1);
+	u1.insert_kmer(10, a2);
+	u1.set_coverage(5);
+
+	UniqueKmers u2(3000);
+	u2.insert_path(0,0);
+	u2.insert_path(1,1);
+	u2.insert_kmer(20, a1);
+	u2.insert_kmer(5, a2);
+	u2.set_coverage(5);
+
+	ProbabilityTable probs(5, 10, 30, 0.0L);
+	probs.modify_probability(5, 10, CopyNumber(0.1,0.9,0.1));
+	probs.modify_probability(5, 20, CopyNumber(0.01,0.01,0.9));
+	probs.modify_probability(5, 5, CopyNumber(0.9,0.3,0.1));
+	vector<UniqueKmers*> unique_kmers = {&u1,&u2};
+	vector<vector<float>> allele_frequencies = { {0.5, 0.5}, {0.5, 0.5} };
+
+	FastGenotyper genotyper (&unique_kmers, &probs, &allele_frequencies);
+
+	// expected likelihoods, as computed by hand (emission probability times prior 0.25/0.5/0.25)
+	vector<double> expected_likelihoods = { 0.0060975610, 0.9878048780, 0.0060975610, 0.9914320685, 0.0073439412, 0.0012239902 };
+	vector<double> computed_likelihoods;
+	for (auto result : genotyper.get_genotyping_result()) {
+		computed_likelihoods.push_back(result.get_genotype_likelihood(0,0));
+		computed_likelihoods.push_back(result.get_genotype_likelihood(0,1));
+		computed_likelihoods.push_back(result.get_genotype_likelihood(1,1));
+	}
+	REQUIRE( compare_vectors(expected_likelihoods, computed_likelihoods) );
+
+	vector<GenotypingResult> genotypes = genotyper.get_genotyping_result();
+	REQUIRE(genotypes[0].get_likeliest_genotype() == pair<int,int>(0,1));
+	REQUIRE(genotypes[1].get_likeliest_genotype() == pair<int,int>(0,0));
+	REQUIRE(genotypes[1].get_haplotype() == pair<unsigned char,unsigned char>(0,0));
+
+	// only a range of positions
+	vector<GenotypingResult> range(2);
+	genotyper.compute_genotypes(1, 2, range);
+	REQUIRE(doubles_equal(range[1].get_genotype_likelihood(0,0), genotypes[1].get_genotype_likelihood(0,0)));
+	REQUIRE(range[0].get_all_likelihoods(2) == vector<long double>({0.0L, 0.0L, 0.0L}));
+	CHECK_THROWS(genotyper.compute_genotypes(0, 3, range));
+
+	vector<vector<float>> too_few = { {0.5, 0.5} };
+	CHECK_THROWS(FastGenotyper(&unique_kmers, &probs, &too_few));
+}
+
+TEST_CASE("FastGenotyper concordance", "[FastGenotyper concordance]") {
+	// simulate a panel of biallelic variants, the sample carries the haplotypes of the first two paths
+	size_t nr_variants = 500;
+	size_t nr_paths = 8;
+	size_t kmers_per_allele = 5;
+	unsigned short coverage = 10;
+	default_random_engine generator(123);
+	uniform_int_distribution<int> allele_distribution(0, 1);
+	uniform_int_distribution<int> noise_distribution(-3, 3);
+
+	vector<UniqueKmers*> unique_kmers;
+	vector<vector<float>> allele_frequencies;
+	vector<pair<int,int>> truth;
+	for (size_t v = 0; v < nr_variants; ++v) {
+		UniqueKmers* u = new UniqueKmers(1000 * (v+1));
+		vector<float> frequencies = {0.0, 0.0};
+		vector<unsigned char> path_alleles;
+		for (size_t p = 0; p < nr_paths; ++p) {
+			unsigned char allele = allele_distribution(generator);
+			// make sure both alleles occur in the panel
+			if (p == nr_paths - 2) allele = 0;
+			if (p == nr_paths - 1) allele = 1;
+			u->insert_empty_allele(allele);
+			u->insert_path(p, allele);
+			path_alleles.push_back(allele);
+			frequencies[allele] += 1.0 / nr_paths;
+		}
+		int copies_alt = path_alleles[0] + path_alleles[1];
+		truth.push_back(make_pair(min(path_alleles[0], path_alleles[1]), max(path_alleles[0], path_alleles[1])));
+		for (unsigned char a = 0; a < 2; ++a) {
+			vector<unsigned char> alleles = {a};
+			int copies = (a == 1) ? copies_alt : 2 - copies_alt;
+			for (size_t k = 0; k < kmers_per_allele; ++k) {
+				int count = max(0, copies * (coverage / 2) + noise_distribution(generator));
+				u->insert_kmer(count, alleles);
+			}
+		}
+		u->set_coverage(coverage);
+		unique_kmers.push_back(u);
+		allele_frequencies.push_back(frequencies);
+	}
+
+	ProbabilityTable probs(coverage / 4, coverage * 4, 2 * coverage, 0.0L);
+	HMM hmm (&unique_kmers, &probs, true, false);
+	FastGenotyper genotyper (&unique_kmers, &probs, &allele_frequencies);
+	vector<GenotypingResult> hmm_genotypes = hmm.get_genotyping_result();
+	vector<GenotypingResult> fast_genotypes = genotyper.get_genotyping_result();
+	REQUIRE(hmm_genotypes.size() == nr_variants);
+	REQUIRE(fast_genotypes.size() == nr_variants);
+
+	size_t concordant = 0;
+	size_t hmm_correct = 0;
+	size_t fast_correct = 0;
+	for (size_t v = 0; v < nr_variants; ++v) {
+		pair<int,int> hmm_genotype = hmm_genotypes[v].get_likeliest_genotype();
+		pair<int,int> fast_genotype = fast_genotypes[v].get_likeliest_genotype();
+		if (hmm_genotype == fast_genotype) concordant += 1;
+		if (hmm_genotype == truth[v]) hmm_correct += 1;
+		if (fast_genotype == truth[v]) fast_correct += 1;
+	}
+	double concordance = (double) concordant / nr_variants;
+	REQUIRE(concordance >= 0.95);
+	// the approximation should not call many more genotypes wrong than the HMM
+	REQUIRE(fast_correct + nr_variants / 100 >= hmm_correct);
+
+	for (auto u : unique_kmers) {
+		delete u;
+	}
+}
@@ -0,0 +1,113 @@
+#include "catch.hpp"
+#include "utils.hpp"
+#include "../src/genotypeconcordance.hpp"
+#include <vector>
+#include <string>
+#include <fstream>
+
+using namespace std;
+
+TEST_CASE("GenotypeConcordance determine_variant_type", "[GenotypeConcordance determine_variant_type]") {
+	// same classification as PyVCF's var_subtype in genotype-concordance.py
+	REQUIRE(determine_variant_type("A", {"G"}) == SNP);
+	REQUIRE(determine_variant_type("A", {"G", "T"}) == SNP);
+	REQUIRE(determine_variant_type("A", {"ATTT"}) == SMALL_INSERTION);
+	REQUIRE(determine_variant_type("ACGT", {"A"}) == SMALL_DELETION);
+	REQUIRE(determine_variant_type("AC", {"GT"}) == SMALL_INSERTION);
+	REQUIRE(determine_variant_type("A", {"AT", "C"}) == SMALL_INSERTION);
+	REQUIRE(determine_variant_type("ACGT", {"A", "AC"}) == SMALL_INSERTION);
+	REQUIRE(determine_variant_type("A", {"."}) == SMALL_DELETION);
+	REQUIRE(determine_variant_type("A", {"<DEL>"}) == SMALL_COMPLEX);
+	REQUIRE(determine_variant_type("A", {"a"}) == SMALL_COMPLEX);
+	REQUIRE(determine_variant_type("A", {string(30, 'C')}) == MIDSIZE_INSERTION);
+	REQUIRE(determine_variant_type(string(60, 'C'), {"C"}) == LARGE_DELETION);
+	REQUIRE(determine_variant_type(string(60, 'C'), {"C"}, true) == LARGE_COMPLEX);
+	REQUIRE(determine_variant_type(string(60, 'C'), {"C", string(70, 'A')}) == LARGE_INSERTION);
+	REQUIRE(variant_type_name(MIDSIZE_COMPLEX) == "midsize-complex");
+}
+
+TEST_CASE("GenotypeConcordance determine_variant_type_by_length", "[GenotypeConcordance determine_variant_type_by_length]") {
+	REQUIRE(determine_variant_type_by_length("A", {"G"}) == SNP);
+	REQUIRE(determine_variant_type_by_length("A", {"G", "T"}) == SNP);
+	REQUIRE(determine_variant_type_by_length("A", {"ATTT"}) == SMALL_INSERTION);
+	REQUIRE(determine_variant_type_by_length("ACGT", {"A"}) == SMALL_DELETION);
+	REQUIRE(determine_variant_type_by_length("ACGT", {"A", "AC"}) == SMALL_DELETION);
+	REQUIRE(determine_variant_type_by_length("AC", {"GT"}) == SMALL_COMPLEX);
+	REQUIRE(determine_variant_type_by_length("A", {"AT", "C"}) == SMALL_COMPLEX);
+	REQUIRE(determine_variant_type_by_length("A", {string(30, 'C')}) == MIDSIZE_INSERTION);
+	REQUIRE(determine_variant_type_by_length(string(60, 'C'), {"C"}) == LARGE_DELETION);
+	REQUIRE(determine_variant_type_by_length(string(60, 'C'), {"C", string(70, 'A')}) == LARGE_COMPLEX);
+}
+
+TEST_CASE("GenotypeConcordance compute_statistics", "[GenotypeConcordance compute_statistics]") {
+	vector<ConcordanceThresholds> thresholds = { {0, 0.0, 0, 0}, {10, 0.0, 0, 0} };
+	// result must not depend on the number of threads
+	for (size_t nr_threads = 1; nr_threads < 4; ++nr_threads) {
+		GenotypeConcordance concordance ("../tests/data/concordance-baseline.vcf", "../tests/data/concordance-callset.vcf", {"S1", "S2"});
+		REQUIRE(concordance.nr_callset_variants() == 5);
+		concordance.compute_statistics(thresholds, nr_threads);
+		// the duplicated position chr1:50 is counted once
+		REQUIRE(concordance.nr_baseline_variants() == 6);
+
+		ConcordanceStatistics s1_snp = concordance.get_statistics("S1", 0, SNP);
+		REQUIRE(s1_snp.total_baseline == 3);
+		REQUIRE(s1_snp.total_baseline_nonref == 3);
+		REQUIRE(s1_snp.total_baseline_biallelic == 2);
+		REQUIRE(s1_snp.total_intersection == 2);
+		// multi-allelic genotypes are compared by their allele sequences
+		REQUIRE(s1_snp.correct_all == 2);
+		REQUIRE(s1_snp.correct_nonref == 2);
+		REQUIRE(s1_snp.wrong_all == 0);
+		REQUIRE(s1_snp.not_in_callset_all == 1);
+		REQUIRE(s1_snp.not_in_callset_biallelic == 1);
+		REQUIRE(s1_snp.confusion_matrix[1][1] == 1);
+		REQUIRE(s1_snp.confusion_matrix[2][3] == 1);
+
+		// the genotype at position 10 has GQ 5
+		ConcordanceStatistics s1_snp_gq = concordance.get_statistics("S1", 1, SNP);
+		REQUIRE(s1_snp_gq.total_intersection == 2);
+		REQUIRE(s1_snp_gq.not_typed_all == 1);
+		REQUIRE(s1_snp_gq.correct_all == 1);
+		REQUIRE(s1_snp_gq.confusion_matrix[1][1] == 0);
+
+		ConcordanceStatistics s1_insertion = concordance.get_statistics("S1", 0, SMALL_INSERTION);
+		REQUIRE(s1_insertion.wrong_all == 1);
+		REQUIRE(s1_insertion.wrong_nonref == 1);
+		REQUIRE(s1_insertion.confusion_matrix[1][0] == 1);
+
+		ConcordanceStatistics s1_deletion = concordance.get_statistics("S1", 0, SMALL_DELETION);
+		REQUIRE(s1_deletion.not_typed_all == 1);
+		REQUIRE(s1_deletion.not_typed_nonref == 1);
+		REQUIRE(s1_deletion.confusion_matrix[1][3] == 1);
+
+		ConcordanceStatistics s2_snp = concordance.get_statistics("S2", 0, SNP);
+		REQUIRE(s2_snp.total_baseline == 3);
+		REQUIRE(s2_snp.total_baseline_nonref == 2);
+		REQUIRE(s2_snp.correct_all == 2);
+		REQUIRE(s2_snp.correct_nonref == 1);
+		REQUIRE(s2_snp.not_in_callset_nonref == 1);
+		REQUIRE(s2_snp.confusion_matrix[2][2] == 1);
+
+		// true genotype of S2 is missing
+		ConcordanceStatistics s2_deletion = concordance.get_statistics("S2", 0, SMALL_DELETION);
+		REQUIRE(s2_deletion.total_baseline == 0);
+		REQUIRE(s2_deletion.absent_truth == 1);
+	}
+}
+
+TEST_CASE("GenotypeConcordance write_statistics", "[GenotypeConcordance write_statistics]") {
+	GenotypeConcordance concordance ("../tests/data/concordance-baseline.vcf", "../tests/data/concordance-callset.vcf", {"S1"});
+	vector<ConcordanceThresholds> thresholds = { {0, 0.0, 0, 0} };
+	concordance.compute_statistics(thresholds);
+	concordance.write_statistics("../tests/data/concordance");
+
+	ifstream tsv_file("../tests/data/concordance_S1_snp.tsv");
+	string header;
+	string line;
+	getline(tsv_file, header);
+	getline(tsv_file, line);
+	REQUIRE(header.substr(0, 16) == "quality\tallele_f");
+	REQUIRE(line == "0\t0.0\t0\t0\t3\t2\t3\t2\t1.0\t0.0\t0.3333333333333333\t1.0\t0.0\t0.5\t1.0\t0.0\t0.3333333333333333\t2\t0\t0\t1\t1\t0\t0\t1\t2\t0\t0\t1");
+
+	REQUIRE_THROWS(GenotypeConcordance("../tests/data/concordance-baseline.vcf", "../tests/data/concordance-callset.vcf", {"S3"}));
+}
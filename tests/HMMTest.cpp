@@ -6,6 +6,7 @@
 #include "utils.hpp"
 #include <vector>
 #include <string>
+#include <math.h>
 
 using namespace std;
 
@@ -904,3 +905,86 @@ TEST_CASE("HMM no_only_paths2", "[HMM only_paths2]") {
 
 	REQUIRE( compare_vectors(computed_likelihoods, expected_likelihoods) );
 }
+
+TEST_CASE("HMM spill_directory", "[HMM spill_directory]") {
+	// many columns, such that several checkpoint columns are written to disk
+	vector<UniqueKmers*> unique_kmers;
+	vector<unsigned char> a1 = {0};
+	vector<unsigned char> a2 = {1};
+	for (size_t i = 0; i < 50; ++i) {
+		UniqueKmers* u = new UniqueKmers(1000 * (i+1));
+		u->insert_path(0,0);
+		u->insert_path(1,1);
+		u->insert_path(2, i%2);
+		u->insert_kmer((i%3 == 0) ? 20 : 10, a1);
+		u->insert_kmer((i%5 == 0) ? 0 : 10, a2);
+		u->set_coverage(10);
+		unique_kmers.push_back(u);
+	}
+
+	ProbabilityTable probs (0,1,21,0.0L);
+	probs.modify_probability(0,0,CopyNumber(0.8,0.1,0.1));
+	probs.modify_probability(0,10,CopyNumber(0.1,0.8,0.1));
+	probs.modify_probability(0,20,CopyNumber(0.1,0.1,0.8));
+
+	HMM hmm (&unique_kmers, &probs, true, true, 1.26, false, 0.25);
+	HMM hmm_spilled (&unique_kmers, &probs, true, true, 1.26, false, 0.25, nullptr, true, "../tests/data");
+	vector<GenotypingResult> expected = hmm.get_genotyping_result();
+	vector<GenotypingResult> computed = hmm_spilled.get_genotyping_result();
+	REQUIRE(hmm.get_spilled_bytes() == 0);
+	REQUIRE(hmm_spilled.get_spilled_bytes() > 0);
+	REQUIRE(expected.size() == computed.size());
+	for (size_t i = 0; i < expected.size(); ++i) {
+		for (unsigned char a = 0; a < 2; ++a) {
+			for (unsigned char b = a; b < 2; ++b) {
+				REQUIRE(expected[i].get_genotype_likelihood(a,b) == computed[i].get_genotype_likelihood(a,b));
+			}
+		}
+		REQUIRE(expected[i].get_haplotype() == computed[i].get_haplotype());
+	}
+
+	for (auto u : unique_kmers) delete u;
+}
+
+TEST_CASE("HMM compression", "[HMM compression]") {
+	// many columns, such that forward columns are recomputed from compressed checkpoints
+	vector<UniqueKmers*> unique_kmers;
+	vector<unsigned char> a1 = {0};
+	vector<unsigned char> a2 = {1};
+	for (size_t i = 0; i < 100; ++i) {
+		UniqueKmers* u = new UniqueKmers(1000 * (i+1));
+		u->insert_path(0,0);
+		u->insert_path(1,1);
+		u->insert_path(2, i%2);
+		u->insert_path(3, (i/3)%2);
+		u->insert_kmer((i%3 == 0) ? 20 : 10, a1);
+		u->insert_kmer((i%7 == 0) ? 0 : 10, a2);
+		u->set_coverage(10);
+		unique_kmers.push_back(u);
+	}
+
+	ProbabilityTable probs (0,1,21,0.0L);
+	probs.modify_probability(0,0,CopyNumber(0.8,0.1,0.1));
+	probs.modify_probability(0,10,CopyNumber(0.1,0.8,0.1));
+	probs.modify_probability(0,20,CopyNumber(0.1,0.1,0.8));
+
+	HMM hmm (&unique_kmers, &probs, true, false, 1.26, false, 0.25);
+	vector<GenotypingResult> expected = hmm.get_genotyping_result();
+	vector<pair<CompressedColumn::Mode, double>> modes = { {CompressedColumn::NONE, 0.0}, {CompressedColumn::FLOAT32, 1e-5}, {CompressedColumn::LOG16, 1e-2} };
+	for (auto mode : modes) {
+		HMM hmm_compressed (&unique_kmers, &probs, true, false, 1.26, false, 0.25, nullptr, true, "", mode.first);
+		vector<GenotypingResult> computed = hmm_compressed.get_genotyping_result();
+		REQUIRE(expected.size() == computed.size());
+		for (size_t i = 0; i < expected.size(); ++i) {
+			for (unsigned char a = 0; a < 2; ++a) {
+				for (unsigned char b = a; b < 2; ++b) {
+					long double e = expected[i].get_genotype_likelihood(a,b);
+					long double c = computed[i].get_genotype_likelihood(a,b);
+					REQUIRE(fabsl(e - c) <= mode.second * e);
+				}
+			}
+		}
+	}
+
+	for (auto u : unique_kmers) delete u;
+}
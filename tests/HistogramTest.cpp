@@ -21,3 +21,15 @@ TEST_CASE("Histogram", "[Histogram]") {
 	REQUIRE(peak_ids[0] == 1);
 	REQUIRE(peak_values[0] == 4);
 }
+
+TEST_CASE("Histogram compute_abundance_peak", "[Histogram compute_abundance_peak]") {
+	Histogram histo(10);
+	vector<size_t> values = {0,0,1,1,1,1,2,2,3};
+	for (auto v : values) {
+		histo.add_value(v);
+	}
+	REQUIRE(histo.compute_abundance_peak(true) == 1);
+
+	Histogram empty(10);
+	REQUIRE_THROWS(empty.compute_abundance_peak(true));
+}
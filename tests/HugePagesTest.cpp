@@ -0,0 +1,68 @@
+#include "catch.hpp"
+#include "../src/hugepages.hpp"
+#include "../src/arena.hpp"
+#include <vector>
+#include <string>
+#include <cstdint>
+
+using namespace std;
+
+TEST_CASE("HugePages allocate", "[HugePages allocate]") {
+	HugePages::Mode mode = HugePages::get_mode();
+	for (string name : {"none", "transparent", "2M"}) {
+		HugePages::set_mode(HugePages::parse_mode(name));
+		REQUIRE(HugePages::get_mode_name(HugePages::get_mode()) == name);
+		HugePageStatistics before = HugePages::get_statistics();
+
+		// small blocks are taken from the heap
+		char* small = (char*) HugePages::allocate(100);
+		small[99] = 'a';
+		HugePages::deallocate(small, 100);
+		REQUIRE(HugePages::get_statistics().mapped_bytes == before.mapped_bytes);
+
+		// large blocks are mapped separately and aligned to huge pages, unless huge pages are disabled
+		size_t size = 3 * HugePages::huge_page_size + 10;
+		char* large = (char*) HugePages::allocate(size);
+		for (size_t i = 0; i < size; i += 4096) large[i] = 'b';
+		large[size-1] = 'c';
+		HugePageStatistics after = HugePages::get_statistics();
+		if (name == "none") {
+			REQUIRE(after.mapped_bytes == before.mapped_bytes);
+		} else {
+			REQUIRE(((uintptr_t) large) % HugePages::huge_page_size == 0);
+			REQUIRE(after.mapped_bytes == before.mapped_bytes + 4 * HugePages::huge_page_size);
+			REQUIRE(after.explicit_bytes + after.advised_bytes <= after.mapped_bytes);
+			REQUIRE(after.peak_mapped_bytes >= after.mapped_bytes);
+		}
+		HugePages::deallocate(large, size);
+
+		// unmapped blocks are no longer counted, but the peak is kept
+		HugePageStatistics released = HugePages::get_statistics();
+		REQUIRE(released.mapped_bytes == before.mapped_bytes);
+		REQUIRE(released.explicit_bytes == before.explicit_bytes);
+		REQUIRE(released.advised_bytes == before.advised_bytes);
+		REQUIRE(released.peak_mapped_bytes == after.peak_mapped_bytes);
+	}
+	HugePages::set_mode(mode);
+	HugePages::sample();
+	REQUIRE_THROWS(HugePages::parse_mode("4K"));
+}
+
+TEST_CASE("HugePages HugePageVector", "[HugePages HugePageVector]") {
+	HugePageVector<uint64_t> numbers;
+	for (uint64_t i = 0; i < 1000000; ++i) numbers.push_back(i);
+	for (uint64_t i = 0; i < 1000000; ++i) REQUIRE(numbers[i] == i);
+	HugePageVector<uint64_t> copy = numbers;
+	REQUIRE(copy == numbers);
+	numbers.clear();
+	numbers.shrink_to_fit();
+	REQUIRE(copy.size() == 1000000);
+
+	// arenas can take their chunks from HugePages
+	Arena arena(HugePages::huge_page_size, true);
+	for (size_t i = 0; i < 100000; ++i) {
+		size_t* value = arena.create<size_t>(i);
+		REQUIRE(*value == i);
+	}
+	REQUIRE(arena.reserved_bytes() == 1 * HugePages::huge_page_size);
+}
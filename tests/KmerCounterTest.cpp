@@ -4,6 +4,8 @@
 #include "../src/jellyfishreader.hpp"
 #include <vector>
 #include <string>
+#include <fstream>
+#include <cstdio>
 
 using namespace std;
 
@@ -31,6 +33,33 @@ TEST_CASE("JellyfishCounter_if", "[JellyfishCounter_if]") {
 	}
 }
 
+TEST_CASE("JellyfishCounter high multiplicity", "[JellyfishCounter high multiplicity]") {
+	// a kmer seen more often than the read count field holds must not carry into its genomic count
+	string readfile = "../tests/data/high-multiplicity-reads.fa";
+	string kmerfile = "../tests/data/high-multiplicity-kmers.fa";
+	string kmer = "ATGCTGTAAA";
+	{
+		ofstream reads(readfile);
+		for (size_t i = 0; i < read_count_mask + 10; ++i) {
+			reads << ">" << i << "\n" << kmer << "\n";
+		}
+		ofstream kmers(kmerfile);
+		kmers << ">kmers\n" << kmer << "\n";
+	}
+	for (size_t nr_threads : {1, 4}) {
+		JellyfishCounter counter(readfile, kmerfile, 10, nr_threads, 1000, true);
+		size_t genomic_count = 0;
+		size_t read_count = 0;
+		counter.getGenomicAndReadAbundance(jellyfish::mer_dna(kmer), genomic_count, read_count);
+		REQUIRE(genomic_count == 1);
+		REQUIRE(read_count >= read_count_limit);
+		REQUIRE(read_count < read_count_mask);
+		REQUIRE(counter.getKmerAbundance(kmer) == read_count);
+	}
+	remove(readfile.c_str());
+	remove(kmerfile.c_str());
+}
+
 TEST_CASE("JellyfishReader", "[JellyfishReader]") {
 	JellyfishReader reader ("../tests/data/reads.jf", 10);
 	string read = "ATGCTGTAAAAAAACGGC";
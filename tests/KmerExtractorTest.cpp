@@ -0,0 +1,96 @@
+#include "catch.hpp"
+#include "../src/kmerextractor.hpp"
+#include <vector>
+#include <string>
+#include <random>
+#include <algorithm>
+
+using namespace std;
+
+// encodes kmers base by base
+void naive_kmers(const string& sequence, size_t kmer_size, bool canonical, vector<uint64_t>& kmers, vector<uint32_t>& positions) {
+	string bases = "ACGT";
+	for (size_t start = 0; start + kmer_size <= sequence.size(); ++start) {
+		uint64_t forward = 0;
+		uint64_t reverse = 0;
+		bool valid = true;
+		for (size_t i = 0; i < kmer_size; ++i) {
+			size_t base = bases.find(toupper(sequence[start + i]));
+			if (base == string::npos) {
+				valid = false;
+				break;
+			}
+			forward = (forward << 2) | base;
+			reverse |= ((uint64_t) (3 - base)) << (2*i);
+		}
+		if (!valid) continue;
+		kmers.push_back(canonical ? min(forward, reverse) : forward);
+		positions.push_back(start);
+	}
+}
+
+TEST_CASE("KmerExtractor encode_bases", "[KmerExtractor encode_bases]") {
+	// all characters, at every offset of a vector block
+	string characters;
+	for (size_t c = 1; c < 256; ++c) characters += (char) c;
+	characters += characters;
+	vector<unsigned char> codes(characters.size());
+	size_t invalid = KmerExtractor::encode_bases(characters.c_str(), characters.size(), codes.data());
+	REQUIRE(invalid == characters.size() - 16);
+	for (size_t i = 0; i < characters.size(); ++i) {
+		char c = toupper(characters[i]);
+		unsigned char expected = (c == 'A') ? 0 : (c == 'C') ? 1 : (c == 'G') ? 2 : (c == 'T') ? 3 : 4;
+		REQUIRE((unsigned int) codes[i] == (unsigned int) expected);
+	}
+	string sequence = "ACGTacgtNACGTTTGCAGGTACAGCATCCGATACGAGCGACTT";
+	REQUIRE(KmerExtractor::encode_bases(sequence.c_str(), sequence.size(), codes.data()) == 1);
+	REQUIRE(KmerExtractor::encode_bases(sequence.c_str(), 8, codes.data()) == 0);
+}
+
+TEST_CASE("KmerExtractor extract", "[KmerExtractor extract]") {
+	REQUIRE_THROWS(KmerExtractor(0));
+	REQUIRE_THROWS(KmerExtractor(33));
+
+	mt19937 generator(7);
+	string alphabet = "ACGTACGTACGTACGTacgtN";
+	uniform_int_distribution<size_t> character(0, alphabet.size() - 1);
+	for (size_t kmer_size : {1, 2, 5, 16, 31, 32}) {
+		for (bool canonical : {true, false}) {
+			KmerExtractor extractor(kmer_size, canonical);
+			REQUIRE(extractor.get_kmer_size() == kmer_size);
+			for (size_t length : {0, 1, 31, 32, 33, 100, 1000}) {
+				string sequence;
+				for (size_t i = 0; i < length; ++i) sequence += alphabet[character(generator)];
+				// with and without undefined bases
+				string defined = sequence;
+				replace(defined.begin(), defined.end(), 'N', 'G');
+				for (const string& s : {sequence, defined}) {
+					vector<uint64_t> expected_kmers;
+					vector<uint32_t> expected_positions;
+					naive_kmers(s, kmer_size, canonical, expected_kmers, expected_positions);
+					vector<uint64_t> kmers = {42};
+					vector<uint32_t> positions = {42};
+					REQUIRE(extractor.extract(s, kmers, &positions) == expected_kmers.size());
+					REQUIRE(kmers.size() == expected_kmers.size() + 1);
+					REQUIRE(kmers[0] == 42);
+					REQUIRE(vector<uint64_t>(kmers.begin() + 1, kmers.end()) == expected_kmers);
+					REQUIRE(vector<uint32_t>(positions.begin() + 1, positions.end()) == expected_positions);
+					vector<uint64_t> without_positions;
+					extractor.extract(s, without_positions);
+					REQUIRE(without_positions == expected_kmers);
+				}
+			}
+		}
+	}
+
+	// canonical codes of a kmer and its reverse complement agree
+	KmerExtractor extractor(5);
+	vector<uint64_t> kmers;
+	extractor.extract("AACGTTTGCA", kmers);
+	extractor.extract("TGCAAACGTT", kmers);
+	REQUIRE(kmers.size() == 12);
+	for (size_t i = 0; i < 6; ++i) {
+		REQUIRE(kmers[i] == kmers[11 - i]);
+	}
+	REQUIRE(kmers[0] == 27);
+}
@@ -0,0 +1,50 @@
+#include "catch.hpp"
+#include "../src/mpmcqueue.hpp"
+#include <vector>
+#include <thread>
+#include <numeric>
+
+using namespace std;
+
+TEST_CASE("MPMCQueue try_push try_pop", "[MPMCQueue try_push try_pop]") {
+	MPMCQueue<int> queue(3);
+	// capacity is rounded up to 4
+	for (int i = 0; i < 4; ++i) {
+		REQUIRE(queue.try_push(i));
+	}
+	REQUIRE(!queue.try_push(4));
+	int value;
+	for (int i = 0; i < 4; ++i) {
+		REQUIRE(queue.try_pop(value));
+		REQUIRE(value == i);
+	}
+	REQUIRE(!queue.try_pop(value));
+}
+
+TEST_CASE("MPMCQueue push pop", "[MPMCQueue push pop]") {
+	// producers block while the queue is full, consumers while it is empty
+	MPMCQueue<int> queue(2);
+	size_t nr_values = 10000;
+	vector<long> sums(3, 0);
+	vector<thread> consumers;
+	for (size_t t = 0; t < sums.size(); ++t) {
+		consumers.push_back(thread([&queue, &sums, t]() {
+			int value;
+			while (queue.pop(value)) sums[t] += value;
+		}));
+	}
+	vector<thread> producers;
+	for (size_t t = 0; t < 2; ++t) {
+		producers.push_back(thread([&queue, nr_values, t]() {
+			for (size_t i = t; i < nr_values; i += 2) queue.push(i);
+		}));
+	}
+	for (auto& producer : producers) producer.join();
+	queue.close();
+	for (auto& consumer : consumers) consumer.join();
+	REQUIRE(accumulate(sums.begin(), sums.end(), 0L) == (long) (nr_values * (nr_values - 1) / 2));
+
+	// closed and empty
+	int value;
+	REQUIRE(!queue.pop(value));
+}
@@ -0,0 +1,84 @@
+#include "catch.hpp"
+#include "utils.hpp"
+#include "../src/panelmerger.hpp"
+#include <vector>
+#include <string>
+#include <fstream>
+
+using namespace std;
+
+void read_lines(string filename, vector<string>& result) {
+	ifstream file(filename);
+	string line;
+	while (getline(file, line)) {
+		if (line.size() == 0) continue;
+		result.push_back(line);
+	}
+}
+
+TEST_CASE("PanelMerger merge", "[PanelMerger merge]") {
+	string reference = "../tests/data/small1.fa";
+	string callset = "../tests/data/panelmerger-callset.vcf";
+	string outfile = "../tests/data/panelmerger-panel.vcf";
+	vector<string> expected;
+	read_lines("../tests/data/panelmerger-expected.vcf", expected);
+
+	// result must not depend on the number of threads
+	for (size_t nr_threads = 1; nr_threads < 5; ++nr_threads) {
+		PanelMerger merger (reference, 2);
+		merger.merge(callset, outfile, nr_threads);
+		vector<string> computed;
+		read_lines(outfile, computed);
+		REQUIRE(computed == expected);
+		REQUIRE(merger.nr_input_alleles() == 10);
+		REQUIRE(merger.nr_written_alleles() == 7);
+	}
+
+	// nor on the size of the blocks read at once, which always end between clusters
+	for (size_t records_per_block = 1; records_per_block < 4; ++records_per_block) {
+		PanelMerger merger (reference, 2, records_per_block);
+		merger.merge(callset, outfile, 2);
+		vector<string> computed;
+		read_lines(outfile, computed);
+		REQUIRE(computed == expected);
+		REQUIRE(merger.nr_input_alleles() == 10);
+		REQUIRE(merger.nr_written_alleles() == 7);
+	}
+}
+
+TEST_CASE("PanelMerger merge_chromosome", "[PanelMerger merge_chromosome]") {
+	PanelMerger merger ("../tests/data/small1.fa", 2);
+	vector<string> records = {
+		"chrA\t3\t.\tTTTT\tT\t.\tPASS\tID=del1\tGT\t1|0\t0|0",
+		"chrA\t5\t.\tT\tG\t.\tPASS\tID=snp1\tGT\t0|1\t0|1",
+		"chrA\t6\t.\tT\tA\t.\tPASS\tID=snp2\tGT\t0|1\t1|.",
+		"chrA\t25\t.\tA\tAGG\t.\tPASS\tID=ins1\tGT\t0|0\t0|0"
+	};
+	string result = "";
+	size_t input_alleles = 0;
+	size_t written_alleles = 0;
+	merger.merge_chromosome(records, result, input_alleles, written_alleles);
+	REQUIRE(result == "chrA\t3\t.\tTTTT\tT,TTGA,TTTA\t.\tPASS\tID=del1,snp1:snp2,snp2\tGT\t1|2\t3|.\n");
+	REQUIRE(input_alleles == 4);
+	REQUIRE(written_alleles == 3);
+
+	// unphased genotypes are not allowed
+	records = {"chrA\t20\t.\tG\tC\t.\tPASS\tID=snp3\tGT\t1/1\t0|0"};
+	REQUIRE_THROWS(merger.merge_chromosome(records, result, input_alleles, written_alleles));
+	// IDs are required
+	records = {"chrA\t20\t.\tG\tC\t.\tPASS\t.\tGT\t1|1\t0|0"};
+	REQUIRE_THROWS(merger.merge_chromosome(records, result, input_alleles, written_alleles));
+}
+
+TEST_CASE("PanelMerger merge chromosomes", "[PanelMerger merge chromosomes]") {
+	string outfile = "../tests/data/panelmerger-panel.vcf";
+	PanelMerger merger ("../tests/data/small1.fa", 2);
+	vector<string> chromosomes = {"chrB"};
+	merger.merge("../tests/data/panelmerger-callset.vcf", outfile, 2, chromosomes);
+	vector<string> computed;
+	read_lines(outfile, computed);
+	REQUIRE(computed.size() == 5);
+	REQUIRE(computed[4] == "chrB\t9\t.\tTTT\tTCT\t.\tPASS\tID=snp5\tGT\t.|0\t0|1");
+	REQUIRE(merger.nr_input_alleles() == 2);
+	REQUIRE(merger.nr_written_alleles() == 1);
+}
@@ -0,0 +1,60 @@
+#include "catch.hpp"
+#include "utils.hpp"
+#include "../src/panelsubsampler.hpp"
+#include <vector>
+#include <string>
+#include <fstream>
+
+using namespace std;
+
+vector<string> read_records(string filename) {
+	vector<string> result;
+	ifstream file(filename);
+	string line;
+	while (getline(file, line)) {
+		if (line.substr(0,2) == "##") continue;
+		result.push_back(line);
+	}
+	return result;
+}
+
+TEST_CASE("PanelSubsampler subsample", "[PanelSubsampler subsample]") {
+	string prefix = "../tests/data/subsample";
+	for (size_t nr_threads = 1; nr_threads < 3; ++nr_threads) {
+		PanelSubsampler subsampler ({"S2", "S1"}, 1, prefix, 0);
+		subsampler.subsample("../tests/data/concordance-baseline.vcf", nr_threads);
+
+		vector<string> selected;
+		subsampler.get_selected_samples("S2", selected);
+		REQUIRE(selected == vector<string>({"S1"}));
+		selected.clear();
+		subsampler.get_selected_samples("S1", selected);
+		REQUIRE(selected == vector<string>({"S2"}));
+
+		// records at which S1 only carries reference alleles are skipped
+		REQUIRE(subsampler.nr_written_records("S2") == 5);
+		REQUIRE(subsampler.nr_skipped_records("S2") == 2);
+		vector<string> panel = read_records(prefix + "_S2_panel.vcf");
+		vector<string> truth = read_records(prefix + "_S2_truth.vcf");
+		REQUIRE(panel.size() == 6);
+		REQUIRE(truth.size() == 6);
+		REQUIRE(panel[0] == "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\tS1");
+		REQUIRE(truth[0] == "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\tS2");
+		REQUIRE(panel[4] == "chr1\t40\t.\tA\tG,T\t.\tPASS\t.\tGT\t1|2");
+		REQUIRE(truth[4] == "chr1\t40\t.\tA\tG,T\t.\tPASS\t.\tGT\t0|0");
+		REQUIRE(panel[5] == "chr2\t5\t.\tG\tC\t.\tPASS\t.\tGT\t1|1");
+		REQUIRE(truth[5] == "chr2\t5\t.\tG\tC\t.\tPASS\t.\tGT\t0|1");
+
+		REQUIRE(subsampler.nr_written_records("S1") == 5);
+		REQUIRE(subsampler.nr_skipped_records("S1") == 2);
+		REQUIRE_THROWS(subsampler.nr_written_records("S3"));
+	}
+}
+
+TEST_CASE("PanelSubsampler errors", "[PanelSubsampler errors]") {
+	REQUIRE_THROWS(PanelSubsampler({}, 1, "../tests/data/subsample"));
+	REQUIRE_THROWS(PanelSubsampler({"S1", "S1"}, 1, "../tests/data/subsample"));
+	// only one sample remains
+	PanelSubsampler subsampler ({"S1"}, 2, "../tests/data/subsample");
+	REQUIRE_THROWS(subsampler.subsample("../tests/data/concordance-baseline.vcf"));
+}
@@ -0,0 +1,98 @@
+#include "catch.hpp"
+#include "utils.hpp"
+#include "../src/readparser.hpp"
+#include <string>
+#include <vector>
+#include <mutex>
+#include <fstream>
+#include <algorithm>
+#include <thread>
+#include <cstdio>
+#include <sys/stat.h>
+
+using namespace std;
+
+vector<string> parse_sequences(string filename, size_t batch_size, size_t nr_threads) {
+	vector<string> result;
+	mutex result_mutex;
+	bool valid_threads = true;
+	ReadParser parser (filename, batch_size);
+	parser.parse(nr_threads, [&](const ReadBatch& batch, size_t thread_index) {
+		lock_guard<mutex> lock(result_mutex);
+		if (thread_index >= nr_threads) valid_threads = false;
+		for (size_t i = 0; i < batch.nr_of_reads(); ++i) {
+			size_t length;
+			const char* sequence = batch.get_sequence(i, length);
+			result.push_back(string(sequence, length));
+		}
+	});
+	REQUIRE(valid_threads);
+	sort(result.begin(), result.end());
+	return result;
+}
+
+vector<string> expected_sequences(string filename, bool fastq) {
+	vector<string> result;
+	ifstream file(filename);
+	string line;
+	size_t nr_lines = 0;
+	while (getline(file, line)) {
+		if (fastq) {
+			if (nr_lines % 4 == 1) result.push_back(line);
+			nr_lines += 1;
+		} else if (line[0] == '>') {
+			result.push_back("");
+		} else {
+			result.back() += line;
+		}
+	}
+	sort(result.begin(), result.end());
+	return result;
+}
+
+TEST_CASE("ReadParser parse", "[ReadParser parse]") {
+	vector<string> fastq = expected_sequences("../tests/data/subsample-reads.fq", true);
+	vector<string> fasta = expected_sequences("../tests/data/subsample-reads.fa", false);
+	REQUIRE(fastq.size() == 100);
+	REQUIRE(fasta.size() == 20);
+	// quality lines starting with '@'
+	vector<string> quality = expected_sequences("../tests/data/parser-reads.fq", true);
+	REQUIRE(quality.size() == 30);
+	// small batches split records and need to be enlarged for records longer than a batch
+	for (size_t batch_size : {64, 500, 1 << 20}) {
+		for (size_t nr_threads : {1, 4}) {
+			REQUIRE(parse_sequences("../tests/data/subsample-reads.fq", batch_size, nr_threads) == fastq);
+			REQUIRE(parse_sequences("../tests/data/subsample-reads.fa", batch_size, nr_threads) == fasta);
+			REQUIRE(parse_sequences("../tests/data/parser-reads.fq", batch_size, nr_threads) == quality);
+		}
+	}
+	ReadParser parser ("../tests/data/subsample-reads.fq");
+	parser.parse(2, [](const ReadBatch&, size_t) {});
+	REQUIRE(parser.bytes_read() == 11190);
+}
+
+TEST_CASE("ReadParser errors", "[ReadParser errors]") {
+	ReadParser missing ("../tests/data/nonexisting.fq");
+	REQUIRE_THROWS(missing.parse(1, [](const ReadBatch&, size_t) {}));
+	ReadParser vcf ("../tests/data/small1.vcf");
+	REQUIRE_THROWS(vcf.parse(1, [](const ReadBatch&, size_t) {}));
+	// exceptions of the worker threads are passed on
+	ReadParser parser ("../tests/data/subsample-reads.fq", 64);
+	REQUIRE_THROWS(parser.parse(2, [](const ReadBatch&, size_t) { throw runtime_error("error"); }));
+}
+
+TEST_CASE("ReadParser pipe", "[ReadParser pipe]") {
+	vector<string> fastq = expected_sequences("../tests/data/subsample-reads.fq", true);
+	string filename = "../tests/data/readparser.fifo";
+	remove(filename.c_str());
+	REQUIRE(mkfifo(filename.c_str(), 0600) == 0);
+	thread writer([&] () {
+		ifstream input("../tests/data/subsample-reads.fq");
+		ofstream file(filename);
+		file << input.rdbuf();
+	});
+	vector<string> result = parse_sequences(filename, 500, 2);
+	writer.join();
+	REQUIRE(result == fastq);
+	remove(filename.c_str());
+}
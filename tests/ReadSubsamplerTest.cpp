@@ -0,0 +1,114 @@
+#include "catch.hpp"
+#include "utils.hpp"
+#include "../src/readsubsampler.hpp"
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdio>
+#include <algorithm>
+
+using namespace std;
+
+vector<string> read_sequences(string filename) {
+	vector<string> result;
+	ifstream file(filename);
+	string line;
+	while (getline(file, line)) {
+		if (!line.empty() && (line[0] != '>')) result.push_back(line);
+	}
+	return result;
+}
+
+TEST_CASE("ReadSubsampler get_estimated_coverage", "[ReadSubsampler get_estimated_coverage]") {
+	// small files are read completely: 100 reads of length 50
+	ReadSubsampler fastq ("../tests/data/subsample-reads.fq", 1000);
+	REQUIRE(doubles_equal(fastq.get_estimated_coverage(), 5.0));
+	REQUIRE(doubles_equal(fastq.get_fraction(0.0), 1.0));
+	REQUIRE(doubles_equal(fastq.get_fraction(10.0), 1.0));
+	REQUIRE(doubles_equal(fastq.get_fraction(2.0), 0.4));
+	// 20 reads of length 100 spanning two lines each
+	ReadSubsampler fasta ("../tests/data/subsample-reads.fa", 100);
+	REQUIRE(doubles_equal(fasta.get_estimated_coverage(), 20.0));
+	REQUIRE_THROWS(ReadSubsampler("../tests/data/nonexisting.fq", 100));
+	REQUIRE_THROWS(ReadSubsampler("../tests/data/subsample-reads.fq", 0));
+}
+
+TEST_CASE("ReadSubsampler write_subsample", "[ReadSubsampler write_subsample]") {
+	string outfile = "../tests/data/subsample-reads-out.fa";
+	ReadSubsampler fastq ("../tests/data/subsample-reads.fq", 1000);
+
+	// all reads are kept if coverage is below the maximum
+	REQUIRE(doubles_equal(fastq.write_subsample(10.0, outfile), 5.0));
+	vector<string> all_reads = read_sequences(outfile);
+	REQUIRE(all_reads.size() == 100);
+
+	double coverage = fastq.write_subsample(2.5, outfile);
+	vector<string> selected = read_sequences(outfile);
+	REQUIRE(selected.size() > 30);
+	REQUIRE(selected.size() < 70);
+	REQUIRE(doubles_equal(coverage, selected.size() * 50.0 / 1000.0));
+	for (auto& sequence : selected) {
+		REQUIRE(ReadSubsampler::keep_read(sequence, 0.5));
+		REQUIRE(find(all_reads.begin(), all_reads.end(), sequence) != all_reads.end());
+	}
+	// selection is deterministic and a smaller fraction selects a subset
+	fastq.write_subsample(2.5, outfile);
+	REQUIRE(read_sequences(outfile) == selected);
+	fastq.write_subsample(1.0, outfile);
+	for (auto& sequence : read_sequences(outfile)) {
+		REQUIRE(find(selected.begin(), selected.end(), sequence) != selected.end());
+	}
+	remove(outfile.c_str());
+}
+
+TEST_CASE("SubsamplePipe", "[SubsamplePipe]") {
+	string pipe_file = "../tests/data/subsample-reads-pipe.fa";
+	string regular_file = "../tests/data/subsample-reads-out.fa";
+	ReadSubsampler fastq ("../tests/data/subsample-reads.fq", 1000);
+	double expected_coverage = fastq.write_subsample(2.5, regular_file);
+	vector<string> expected_reads = read_sequences(regular_file);
+
+	// reads passed through the pipe match those written to a file
+	{
+		SubsamplePipe pipe (fastq, 2.5, pipe_file);
+		REQUIRE(read_sequences(pipe_file) == expected_reads);
+		REQUIRE(doubles_equal(pipe.finish(), expected_coverage));
+	}
+	REQUIRE(!ifstream(pipe_file).good());
+
+	// reader fails before opening the pipe
+	{
+		SubsamplePipe pipe (fastq, 2.5, pipe_file);
+	}
+	REQUIRE(!ifstream(pipe_file).good());
+
+	// reader stops early, while more reads are left than fit into the pipe
+	string large_file = "../tests/data/subsample-reads-large.fq";
+	{
+		ofstream large(large_file);
+		for (size_t i = 0; i < 5000; ++i) {
+			string sequence(50, 'A');
+			for (size_t j = 0; j < 10; ++j) sequence[j] = "ACGT"[(i >> (2*j)) & 3];
+			large << "@" << i << "\n" << sequence << "\n+\n" << string(50, 'I') << "\n";
+		}
+	}
+	ReadSubsampler large (large_file, 1000);
+	{
+		SubsamplePipe pipe (large, 1000.0, pipe_file);
+		ifstream reader(pipe_file);
+		string line;
+		REQUIRE(getline(reader, line));
+	}
+	REQUIRE(!ifstream(pipe_file).good());
+
+	// errors of the writer are reported
+	remove(large_file.c_str());
+	{
+		SubsamplePipe pipe (large, 1000.0, pipe_file);
+		REQUIRE(read_sequences(pipe_file).empty());
+		REQUIRE_THROWS(pipe.finish());
+	}
+	REQUIRE(!ifstream(pipe_file).good());
+	REQUIRE_THROWS(SubsamplePipe(fastq, 2.5, "../tests/data/nonexisting-dir/pipe.fa"));
+	remove(regular_file.c_str());
+}
@@ -0,0 +1,120 @@
+#include "catch.hpp"
+#include "utils.hpp"
+#include "../src/referencekmerindex.hpp"
+#include "../src/variantreader.hpp"
+#include <vector>
+#include <string>
+#include <map>
+#include <fstream>
+#include <cstdio>
+#include <cctype>
+
+using namespace std;
+
+void count_sequence_kmers(string sequence, size_t kmer_size, map<string, size_t>& counts) {
+	if (sequence.size() < kmer_size) return;
+	for (auto& c : sequence) c = toupper(c);
+	for (size_t i = 0; i <= sequence.size() - kmer_size; ++i) {
+		string kmer = sequence.substr(i, kmer_size);
+		if (kmer.find_first_not_of("ACGT") != string::npos) continue;
+		counts[canonical_kmer(kmer)] += 1;
+	}
+}
+
+// counts all canonical kmers (without N) of the sequences in a FASTA file
+void count_fasta_kmers(string filename, size_t kmer_size, map<string, size_t>& counts) {
+	ifstream file(filename);
+	string line;
+	string sequence = "";
+	while (getline(file, line)) {
+		if (!line.empty() && (line[0] == '>')) {
+			count_sequence_kmers(sequence, kmer_size, counts);
+			sequence = "";
+		} else {
+			sequence += line;
+		}
+	}
+	count_sequence_kmers(sequence, kmer_size, counts);
+}
+
+class MapKmerCounter : public KmerCounter {
+public:
+	MapKmerCounter(const map<string, size_t>& counts) :counts(counts) {}
+	size_t getKmerAbundance(string kmer) {
+		auto it = this->counts.find(canonical_kmer(kmer));
+		return (it == this->counts.end()) ? 0 : it->second;
+	}
+	size_t getKmerAbundance(jellyfish::mer_dna jelly_kmer) { return getKmerAbundance(jelly_kmer.to_str()); }
+	size_t computeKmerCoverage(size_t) { return 0; }
+	size_t computeHistogram(size_t, bool, string = "") { return 0; }
+private:
+	map<string, size_t> counts;
+};
+
+TEST_CASE("ReferenceKmerIndex build", "[ReferenceKmerIndex build]") {
+	string fasta = "../tests/data/small1.fa";
+	string index_file = "../tests/data/small1-index.bin";
+	map<string, size_t> reference_counts;
+	count_fasta_kmers(fasta, 10, reference_counts);
+
+	// a small run size makes sure runs are merged
+	for (size_t run_size : {50, 1000000}) {
+		ReferenceKmerIndex::build(fasta, 10, index_file, run_size);
+		ReferenceKmerIndex index (index_file, 10);
+		REQUIRE(index.size() == reference_counts.size());
+		for (auto& kmer : reference_counts) {
+			size_t expected = min(kmer.second, (size_t) 2);
+			REQUIRE(index.getKmerAbundance(kmer.first) == expected);
+			REQUIRE(index.getKmerAbundance(canonical_kmer(kmer.first)) == expected);
+			uint64_t code;
+			REQUIRE(ReferenceKmerIndex::encode_canonical(kmer.first, 0, 10, code));
+			REQUIRE(index.get_reference_multiplicity(code) == expected);
+		}
+		REQUIRE(index.getKmerAbundance(string("NNNNNNNNNN")) == 0);
+		REQUIRE(index.getKmerAbundance(string("ACGT")) == 0);
+		REQUIRE_THROWS(index.computeHistogram(10, true));
+	}
+	REQUIRE_THROWS(ReferenceKmerIndex(index_file, 11));
+
+	// the index can only be used with the reference it was built from
+	FastaReader reference(fasta);
+	FastaReader other_reference("../tests/data/simple-fasta.fa");
+	REQUIRE(ReferenceKmerIndex::reference_fingerprint(reference) != ReferenceKmerIndex::reference_fingerprint(other_reference));
+	REQUIRE_NOTHROW(ReferenceKmerIndex(index_file, 10, nullptr, &reference));
+	REQUIRE_THROWS(ReferenceKmerIndex(index_file, 10, nullptr, &other_reference));
+	remove(index_file.c_str());
+	REQUIRE_THROWS(ReferenceKmerIndex(index_file, 10));
+	REQUIRE_THROWS(ReferenceKmerIndex::build(fasta, 32, index_file));
+}
+
+TEST_CASE("ReferenceKmerIndex allele kmers", "[ReferenceKmerIndex allele kmers]") {
+	string vcf = "../tests/data/small1.vcf";
+	string fasta = "../tests/data/small1.fa";
+	string index_file = "../tests/data/small1-index.bin";
+	VariantReader v (vcf, fasta, 10, true);
+	v.write_path_segments("../tests/data/small1-index-segments.fa");
+	v.write_allele_segments("../tests/data/small1-index-alleles.fa");
+
+	map<string, size_t> segment_counts;
+	map<string, size_t> allele_counts;
+	count_fasta_kmers("../tests/data/small1-index-segments.fa", 10, segment_counts);
+	count_fasta_kmers("../tests/data/small1-index-alleles.fa", 10, allele_counts);
+	MapKmerCounter allele_kmers (allele_counts);
+	ReferenceKmerIndex::build(fasta, 10, index_file);
+	ReferenceKmerIndex index (index_file, 10, &allele_kmers);
+
+	// counts of the path segments are reproduced up to saturation at 2
+	for (auto& kmer : segment_counts) {
+		if (kmer.second < 2) {
+			REQUIRE(index.getKmerAbundance(kmer.first) == kmer.second);
+		} else {
+			REQUIRE(index.getKmerAbundance(kmer.first) >= 2);
+		}
+	}
+	for (auto& kmer : allele_counts) {
+		REQUIRE(segment_counts.find(kmer.first) != segment_counts.end());
+	}
+	remove(index_file.c_str());
+	remove("../tests/data/small1-index-segments.fa");
+	remove("../tests/data/small1-index-alleles.fa");
+}
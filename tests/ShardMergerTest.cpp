@@ -0,0 +1,101 @@
+#include "catch.hpp"
+#include "../src/shardmerger.hpp"
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+
+using namespace std;
+
+string shard_file_content(string filename) {
+	ifstream file(filename);
+	stringstream content;
+	content << file.rdbuf();
+	return content.str();
+}
+
+void write_shard_file(string filename, string content) {
+	ofstream file(filename);
+	file << content;
+}
+
+TEST_CASE("ShardMerger merge_vcfs", "[ShardMerger merge_vcfs]") {
+	string header = "##fileformat=VCFv4.2\n#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\tsample\n";
+	vector<string> shards = {"../tests/data/shardmerger-shard1", "../tests/data/shardmerger-shard2"};
+	// chromosomes are distributed over the shards, records of the last shard are not terminated by a newline
+	write_shard_file(shards[0] + "_genotyping.vcf", "##fileformat=VCFv4.2\n##fileDate=1\n#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\tsample\nchr3\t5\t.\tA\tC\t.\tPASS\t.\tGT\t0/1\nchr3\t9\t.\tA\tC\t.\tPASS\t.\tGT\t1/1\nchr1\t2\t.\tG\tT\t.\tPASS\t.\tGT\t0/0\n");
+	write_shard_file(shards[1] + "_genotyping.vcf", "##fileformat=VCFv4.2\n##fileDate=2\n#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\tsample\nchr2\t7\t.\tT\tG\t.\tPASS\t.\tGT\t0/1\nchr10\t1\t.\tC\tA\t.\tPASS\t.\tGT\t1/1");
+
+	ShardMerger merger(shards);
+	string merged = "../tests/data/shardmerger-merged";
+	REQUIRE(merger.merge_vcfs("_genotyping.vcf", merged + "_genotyping.vcf"));
+	string expected = "##fileformat=VCFv4.2\n##fileDate=1\n#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\tsample\n";
+	expected += "chr1\t2\t.\tG\tT\t.\tPASS\t.\tGT\t0/0\n";
+	expected += "chr10\t1\t.\tC\tA\t.\tPASS\t.\tGT\t1/1\n";
+	expected += "chr2\t7\t.\tT\tG\t.\tPASS\t.\tGT\t0/1\n";
+	expected += "chr3\t5\t.\tA\tC\t.\tPASS\t.\tGT\t0/1\nchr3\t9\t.\tA\tC\t.\tPASS\t.\tGT\t1/1\n";
+	REQUIRE(shard_file_content(merged + "_genotyping.vcf") == expected);
+
+	// files that no shard has are skipped, files only some shards have are an error
+	REQUIRE_FALSE(merger.merge_vcfs("_phasing.vcf", merged + "_phasing.vcf"));
+	REQUIRE_FALSE(ifstream(merged + "_phasing.vcf").good());
+	write_shard_file(shards[0] + "_phasing.vcf", header);
+	REQUIRE_THROWS(merger.merge_vcfs("_phasing.vcf", merged + "_phasing.vcf"));
+
+	// samples must agree
+	write_shard_file(shards[1] + "_phasing.vcf", "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\tother\n");
+	REQUIRE_THROWS(merger.merge_vcfs("_phasing.vcf", merged + "_phasing.vcf"));
+
+	// a chromosome must not be genotyped in several shards
+	write_shard_file(shards[1] + "_phasing.vcf", header + "chr3\t11\t.\tA\tC\t.\tPASS\t.\tGT\t0|1\n");
+	write_shard_file(shards[0] + "_phasing.vcf", header + "chr3\t5\t.\tA\tC\t.\tPASS\t.\tGT\t0|1\n");
+	REQUIRE_THROWS(merger.merge_vcfs("_phasing.vcf", merged + "_phasing.vcf"));
+
+	for (string shard : shards) {
+		remove((shard + "_genotyping.vcf").c_str());
+		remove((shard + "_phasing.vcf").c_str());
+	}
+	remove((merged + "_genotyping.vcf").c_str());
+	remove((merged + "_phasing.vcf").c_str());
+	REQUIRE_THROWS(ShardMerger(vector<string>()));
+}
+
+TEST_CASE("ShardMerger merge_metrics", "[ShardMerger merge_metrics]") {
+	vector<string> shards = {"../tests/data/shardmerger-shard1", "../tests/data/shardmerger-shard2"};
+	ShardMerger::write_metrics({{"chr3", 2, 1.5, 2.0}, {"chr1", 1, 0.5, 1.0}}, shards[0] + "_metrics.tsv");
+	ShardMerger::write_metrics({{"chr2", 4, 0.25, 0.5}}, shards[1] + "_metrics.tsv");
+	vector<ShardMetrics> metrics;
+	ShardMerger::read_metrics(shards[0] + "_metrics.tsv", metrics);
+	REQUIRE(metrics.size() == 2);
+	REQUIRE(metrics[0].chromosome == "chr3");
+	REQUIRE(metrics[0].nr_variants == 2);
+	REQUIRE(metrics[0].time_unique_kmers == 1.5);
+	REQUIRE(metrics[0].time_genotyping == 2.0);
+
+	ShardMerger merger(shards);
+	string merged = "../tests/data/shardmerger-merged_metrics.tsv";
+	merger.merge_metrics(merged);
+	string expected = "chromosome\tvariants\ttime_unique_kmers\ttime_genotyping\n";
+	expected += "chr1\t1\t0.5\t1\nchr2\t4\t0.25\t0.5\nchr3\t2\t1.5\t2\ntotal\t7\t2.25\t3.5\n";
+	REQUIRE(shard_file_content(merged) == expected);
+
+	// all chromosomes of the VCF need to be genotyped exactly once
+	string vcffile = "../tests/data/shardmerger-variants.vcf";
+	write_shard_file(vcffile, "##fileformat=VCFv4.2\n#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\nchr1\t2\t.\tG\tT\t.\tPASS\t.\nchr2\t7\t.\tT\tG\t.\tPASS\t.\nchr3\t5\t.\tA\tC\t.\tPASS\t.\n");
+	REQUIRE_NOTHROW(merger.check_chromosomes(vcffile));
+	ShardMerger::write_metrics({{"chr2", 4, 0.25, 0.5}, {"chr4", 1, 0.0, 0.0}}, shards[1] + "_metrics.tsv");
+	REQUIRE_THROWS(merger.check_chromosomes(vcffile));
+	ShardMerger::write_metrics({}, shards[1] + "_metrics.tsv");
+	REQUIRE_THROWS(merger.check_chromosomes(vcffile));
+	ShardMerger::write_metrics({{"chr2", 4, 0.25, 0.5}, {"chr1", 1, 0.0, 0.0}}, shards[1] + "_metrics.tsv");
+	REQUIRE_THROWS(merger.check_chromosomes(vcffile));
+	REQUIRE_THROWS(merger.merge_metrics(merged));
+
+	write_shard_file(shards[1] + "_metrics.tsv", "chr2\t4\n");
+	REQUIRE_THROWS(ShardMerger::read_metrics(shards[1] + "_metrics.tsv", metrics));
+
+	for (string shard : shards) remove((shard + "_metrics.tsv").c_str());
+	remove(merged.c_str());
+	remove(vcffile.c_str());
+}
@@ -0,0 +1,159 @@
+#include "catch.hpp"
+#include "../src/sortedkmercounter.hpp"
+#include "../src/referencekmerindex.hpp"
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+
+SortedKmerEntry sorted_entry(string kmer, uint32_t read_count, uint32_t genomic_count) {
+	SortedKmerEntry entry;
+	ReferenceKmerIndex::encode_canonical(kmer, 0, kmer.size(), entry.code);
+	entry.read_count = read_count;
+	entry.genomic_count = genomic_count;
+	return entry;
+}
+
+TEST_CASE("SortedKmerCounter resolveQueries", "[SortedKmerCounter resolveQueries]") {
+	jellyfish::mer_dna::k(5);
+	// entries are given unsorted
+	vector<SortedKmerEntry> entries = {sorted_entry("TTTTA", 3, 1), sorted_entry("ACGTA", 7, 2), sorted_entry("CCCCA", 1, 0), sorted_entry("AAAAC", 12, 1)};
+	string filename = "../tests/data/sortedkmercounter.sorted";
+	SortedKmerCounter::write_dump(entries, 5, true, filename);
+
+	REQUIRE_THROWS(SortedKmerCounter(filename, 6));
+	REQUIRE_THROWS(SortedKmerCounter("../tests/data/small1.fa", 5));
+
+	SortedKmerCounter counter(filename, 5);
+	REQUIRE(counter.size() == 4);
+	REQUIRE(counter.resolvesQueriesInBatch());
+	REQUIRE(counter.storesGenomicCounts());
+	REQUIRE_THROWS(counter.getKmerAbundance(string("ACGTA")));
+	REQUIRE_THROWS(counter.computeHistogram(100, true));
+
+	// queries are given in any orientation and may contain duplicates and kmers not in the dump
+	vector<jellyfish::mer_dna> queries = {jellyfish::mer_dna("TACGT"), jellyfish::mer_dna("GTTTT"), jellyfish::mer_dna("ACGTA"), jellyfish::mer_dna("GGGGG"), jellyfish::mer_dna("AAAAC")};
+	counter.resolveQueries(queries);
+	REQUIRE(counter.getKmerAbundance(string("ACGTA")) == 7);
+	REQUIRE(counter.getKmerAbundance(string("TACGT")) == 7);
+	REQUIRE(counter.getKmerAbundance(string("AAAAC")) == 12);
+	REQUIRE(counter.getKmerAbundance(string("GGGGG")) == 0);
+	REQUIRE(counter.getKmerAbundance(jellyfish::mer_dna("GTTTT")) == 12);
+	size_t genomic_count = 0;
+	size_t read_count = 0;
+	counter.getGenomicAndReadAbundance(jellyfish::mer_dna("ACGTA"), genomic_count, read_count);
+	REQUIRE(genomic_count == 2);
+	REQUIRE(read_count == 7);
+
+	// kmers that were not queried cannot be looked up
+	REQUIRE_THROWS(counter.getKmerAbundance(string("CCCCA")));
+
+	// resolving again replaces the queries
+	counter.resolveQueries(vector<jellyfish::mer_dna>({jellyfish::mer_dna("CCCCA")}));
+	REQUIRE(counter.getKmerAbundance(string("TGGGG")) == 1);
+	REQUIRE_THROWS(counter.getKmerAbundance(string("ACGTA")));
+
+	// dump without genomic counts
+	SortedKmerCounter::write_dump(entries, 5, false, filename);
+	SortedKmerCounter reads_only(filename, 5);
+	REQUIRE_FALSE(reads_only.storesGenomicCounts());
+	REQUIRE_THROWS(reads_only.getGenomicAndReadAbundance(jellyfish::mer_dna("ACGTA"), genomic_count, read_count));
+	reads_only.resolveQueries(vector<jellyfish::mer_dna>());
+	REQUIRE_THROWS(reads_only.getKmerAbundance(string("ACGTA")));
+	remove(filename.c_str());
+}
+
+string file_content(string filename) {
+	ifstream file(filename, ios::binary);
+	stringstream content;
+	content << file.rdbuf();
+	return content.str();
+}
+
+TEST_CASE("SortedDumpWriter", "[SortedDumpWriter]") {
+	vector<SortedKmerEntry> entries = {sorted_entry("TTTTA", 3, 1), sorted_entry("ACGTA", 7, 2), sorted_entry("CCCCA", 1, 0), sorted_entry("AAAAC", 12, 1), sorted_entry("GATCA", 5, 3)};
+	string expected_file = "../tests/data/sorteddumpwriter-expected.sorted";
+	string filename = "../tests/data/sorteddumpwriter.sorted";
+	vector<SortedKmerEntry> sorted = entries;
+	SortedKmerCounter::write_dump(sorted, 5, true, expected_file, 20);
+	string expected = file_content(expected_file);
+
+	// small run sizes make sure runs are merged
+	for (size_t run_size : {1, 2, 3, 100}) {
+		SortedDumpWriter writer(filename, 5, true, run_size);
+		for (auto& entry : entries) writer.add(entry);
+		writer.finish(20);
+		REQUIRE(file_content(filename) == expected);
+		// temporary runs are removed
+		REQUIRE(!ifstream(filename + ".run0").good());
+	}
+
+	// no entries
+	SortedDumpWriter empty_writer(filename, 5, false, 2);
+	empty_writer.finish();
+	SortedKmerCounter empty_counter(filename, 5);
+	REQUIRE(empty_counter.size() == 0);
+	remove(filename.c_str());
+	remove(expected_file.c_str());
+}
+
+TEST_CASE("SortedKmerCounter write_query_dump", "[SortedKmerCounter write_query_dump]") {
+	jellyfish::mer_dna::k(5);
+	vector<SortedKmerEntry> entries = {sorted_entry("TTTTA", 3, 1), sorted_entry("ACGTA", 7, 2), sorted_entry("CCCCA", 1, 0), sorted_entry("AAAAC", 12, 1)};
+	string filename = "../tests/data/sortedkmercounter.sorted";
+	string query_filename = "../tests/data/sortedkmercounter-queries.sorted";
+	SortedKmerCounter::write_dump(entries, 5, true, filename);
+	SortedKmerCounter counter(filename, 5);
+	vector<jellyfish::mer_dna> queries = {jellyfish::mer_dna("TACGT"), jellyfish::mer_dna("GTTTT"), jellyfish::mer_dna("ACGTA"), jellyfish::mer_dna("GGGGG")};
+	counter.resolveQueries(queries);
+
+	// genomic counts taken from the read counts
+	vector<string> chromosomes = {"chr1", "chr3"};
+	SortedKmerCounter::write_query_dump(nullptr, &counter, queries, 5, 23, chromosomes, query_filename);
+	{
+		SortedKmerCounter query_counts(query_filename, 5);
+		REQUIRE(query_counts.size() == 3);
+		REQUIRE(query_counts.get_chromosomes() == chromosomes);
+		query_counts.check_chromosomes({"chr3"});
+		REQUIRE_THROWS(query_counts.check_chromosomes({"chr1", "chr2"}));
+		REQUIRE(query_counts.storesGenomicCounts());
+		REQUIRE(query_counts.computeHistogram(10000, true) == 23);
+		query_counts.resolveQueries(queries);
+		size_t genomic_count = 0;
+		size_t read_count = 0;
+		query_counts.getGenomicAndReadAbundance(jellyfish::mer_dna("TACGT"), genomic_count, read_count);
+		REQUIRE(genomic_count == 2);
+		REQUIRE(read_count == 7);
+		query_counts.getGenomicAndReadAbundance(jellyfish::mer_dna("GTTTT"), genomic_count, read_count);
+		REQUIRE(genomic_count == 1);
+		REQUIRE(read_count == 12);
+		REQUIRE(query_counts.getKmerAbundance(string("CCCCC")) == 0);
+	}
+
+	// separate genomic counts
+	SortedKmerCounter::write_query_dump(&counter, &counter, queries, 5, 0, vector<string>(), query_filename);
+	{
+		SortedKmerCounter query_counts(query_filename, 5);
+		// a dump without chromosome list contains all kmers
+		REQUIRE(query_counts.get_chromosomes().empty());
+		query_counts.check_chromosomes({"chr2"});
+		REQUIRE_THROWS(query_counts.computeHistogram(10000, true));
+		query_counts.resolveQueries(queries);
+		size_t genomic_count = 0;
+		size_t read_count = 0;
+		query_counts.getGenomicAndReadAbundance(jellyfish::mer_dna("ACGTA"), genomic_count, read_count);
+		REQUIRE(genomic_count == 7);
+		REQUIRE(read_count == 7);
+	}
+
+	// dumps without genomic counts cannot provide them
+	SortedKmerCounter::write_dump(entries, 5, false, filename);
+	SortedKmerCounter reads_only(filename, 5);
+	reads_only.resolveQueries(queries);
+	REQUIRE_THROWS(SortedKmerCounter::write_query_dump(nullptr, &reads_only, queries, 5, 23, chromosomes, query_filename));
+	remove(filename.c_str());
+	remove(query_filename.c_str());
+}
@@ -0,0 +1,173 @@
+#include "catch.hpp"
+#include "../src/uniquekmercomputer.hpp"
+#include "../src/kmercounter.hpp"
+#include "../src/variantreader.hpp"
+#include "../src/probabilitytable.hpp"
+#include "../src/sortedkmercounter.hpp"
+#include "../src/referencekmerindex.hpp"
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdio>
+
+using namespace std;
+
+// returns the same abundance for every kmer and counts the lookups
+class ConstantKmerCounter : public KmerCounter {
+public:
+	ConstantKmerCounter(size_t abundance) : abundance(abundance), lookups(0) {}
+	size_t getKmerAbundance(string) { this->lookups += 1; return this->abundance; }
+	size_t getKmerAbundance(jellyfish::mer_dna) { this->lookups += 1; return this->abundance; }
+	size_t computeKmerCoverage(size_t) { return this->abundance; }
+	size_t computeHistogram(size_t, bool, string) { return this->abundance; }
+	size_t abundance;
+	size_t lookups;
+};
+
+TEST_CASE("UniqueKmerComputer max_kmers", "[UniqueKmerComputer max_kmers]") {
+	string vcf = "../tests/data/small1.vcf";
+	string fasta = "../tests/data/small1.fa";
+	VariantReader v(vcf, fasta, 10, true);
+	size_t contig_id = v.get_contig_id("chrA");
+	ProbabilityTable probabilities(2, 40, 20, 0.0L);
+
+	ConstantKmerCounter genomic_all(1);
+	ConstantKmerCounter reads_all(10);
+	UniqueKmerComputer all(&genomic_all, &reads_all, &v, contig_id, 10);
+	vector<UniqueKmers*> result_all;
+	all.compute_unique_kmers(&result_all, &probabilities);
+
+	size_t budget = 3;
+	ConstantKmerCounter genomic_budget(1);
+	ConstantKmerCounter reads_budget(10);
+	UniqueKmerComputer budgeted(&genomic_budget, &reads_budget, &v, contig_id, 10, budget);
+	vector<UniqueKmers*> result_budget;
+	budgeted.compute_unique_kmers(&result_budget, &probabilities);
+
+	REQUIRE(result_all.size() == v.size_of(contig_id));
+	REQUIRE(result_budget.size() == result_all.size());
+	bool budget_reached = false;
+	for (size_t i = 0; i < result_all.size(); ++i) {
+		REQUIRE(result_all[i]->size() > 0);
+		REQUIRE(result_budget[i]->size() == min(budget, result_all[i]->size()));
+		REQUIRE(result_budget[i]->get_coverage() == result_all[i]->get_coverage());
+		if (result_all[i]->size() > budget) {
+			budget_reached = true;
+			// kmers should be spread over the alleles instead of taken from a single one
+			size_t alleles_budget = 0;
+			for (auto& c : result_budget[i]->kmers_on_alleles()) {
+				if (c.second > 0) alleles_budget += 1;
+			}
+			REQUIRE(alleles_budget > 1);
+		}
+	}
+	REQUIRE(budget_reached);
+	// abundances of kmers not needed are never looked up
+	REQUIRE(genomic_budget.lookups < genomic_all.lookups);
+	REQUIRE(reads_budget.lookups < reads_all.lookups);
+
+	for (size_t i = 0; i < result_all.size(); ++i) {
+		delete result_all[i];
+		delete result_budget[i];
+	}
+}
+
+// stores genomic and read abundances in one entry
+class CombinedKmerCounter : public ConstantKmerCounter {
+public:
+	CombinedKmerCounter(size_t genomic, size_t abundance) : ConstantKmerCounter(abundance), genomic(genomic) {}
+	bool storesGenomicCounts() const { return true; }
+	void getGenomicAndReadAbundance(jellyfish::mer_dna, size_t& genomic_count, size_t& read_count) {
+		this->lookups += 1;
+		genomic_count = this->genomic;
+		read_count = this->abundance;
+	}
+	size_t genomic;
+};
+
+TEST_CASE("UniqueKmerComputer combined counts", "[UniqueKmerComputer combined counts]") {
+	string vcf = "../tests/data/small1.vcf";
+	string fasta = "../tests/data/small1.fa";
+	VariantReader v(vcf, fasta, 10, true);
+	size_t contig_id = v.get_contig_id("chrA");
+	ProbabilityTable probabilities(2, 40, 20, 0.0L);
+
+	ConstantKmerCounter genomic(1);
+	ConstantKmerCounter reads(10);
+	UniqueKmerComputer separate(&genomic, &reads, &v, contig_id, 10);
+	vector<UniqueKmers*> result_separate;
+	separate.compute_unique_kmers(&result_separate, &probabilities);
+
+	CombinedKmerCounter combined_reads(1, 10);
+	UniqueKmerComputer combined(nullptr, &combined_reads, &v, contig_id, 10);
+	vector<UniqueKmers*> result_combined;
+	combined.compute_unique_kmers(&result_combined, &probabilities);
+
+	REQUIRE(result_combined.size() == result_separate.size());
+	for (size_t i = 0; i < result_separate.size(); ++i) {
+		REQUIRE(result_combined[i]->size() == result_separate[i]->size());
+		REQUIRE(result_combined[i]->get_coverage() == result_separate[i]->get_coverage());
+		REQUIRE(result_combined[i]->kmers_on_alleles() == result_separate[i]->kmers_on_alleles());
+		delete result_separate[i];
+		delete result_combined[i];
+	}
+	// one lookup per kmer instead of one per table
+	REQUIRE(combined_reads.lookups == genomic.lookups);
+	REQUIRE(reads.lookups <= genomic.lookups);
+
+	// genomic counts are needed
+	ConstantKmerCounter plain_reads(10);
+	REQUIRE_THROWS(UniqueKmerComputer(nullptr, &plain_reads, &v, contig_id, 10));
+	REQUIRE_THROWS(reads.getGenomicAndReadAbundance(jellyfish::mer_dna("ATGCTGTAAA"), combined_reads.genomic, combined_reads.abundance));
+}
+
+TEST_CASE("UniqueKmerComputer sorted queries", "[UniqueKmerComputer sorted queries]") {
+	string vcf = "../tests/data/small1.vcf";
+	string fasta = "../tests/data/small1.fa";
+	VariantReader v(vcf, fasta, 10, true);
+	size_t contig_id = v.get_contig_id("chrA");
+	ProbabilityTable probabilities(2, 40, 20, 0.0L);
+
+	ConstantKmerCounter genomic(1);
+	ConstantKmerCounter reads(10);
+	UniqueKmerComputer direct(&genomic, &reads, &v, contig_id, 10);
+	vector<UniqueKmers*> result_direct;
+	direct.compute_unique_kmers(&result_direct, &probabilities);
+
+	// dump the same counts for all kmers that can be queried
+	vector<jellyfish::mer_dna> query_kmers;
+	direct.collect_query_kmers(query_kmers);
+	REQUIRE(query_kmers.size() > 0);
+	vector<SortedKmerEntry> entries;
+	for (auto& kmer : query_kmers) {
+		SortedKmerEntry entry;
+		REQUIRE(ReferenceKmerIndex::encode_canonical(kmer.to_str(), 0, 10, entry.code));
+		entry.read_count = 10;
+		entry.genomic_count = 1;
+		entries.push_back(entry);
+	}
+	sort(entries.begin(), entries.end(), [](const SortedKmerEntry& a, const SortedKmerEntry& b) { return a.code < b.code; });
+	entries.erase(unique(entries.begin(), entries.end(), [](const SortedKmerEntry& a, const SortedKmerEntry& b) { return a.code == b.code; }), entries.end());
+	string dump_file = "../tests/data/small1-kmers.sorted";
+	SortedKmerCounter::write_dump(entries, 10, true, dump_file);
+
+	SortedKmerCounter sorted_reads(dump_file, 10);
+	UniqueKmerComputer sorted(nullptr, &sorted_reads, &v, contig_id, 10);
+	// kmers can only be looked up once the queries are resolved
+	vector<UniqueKmers*> result_sorted;
+	REQUIRE_THROWS(sorted.compute_unique_kmers(&result_sorted, &probabilities));
+	for (auto u : result_sorted) delete u;
+	result_sorted.clear();
+	sorted_reads.resolveQueries(query_kmers);
+	sorted.compute_unique_kmers(&result_sorted, &probabilities);
+
+	REQUIRE(result_sorted.size() == result_direct.size());
+	for (size_t i = 0; i < result_direct.size(); ++i) {
+		REQUIRE(result_sorted[i]->size() == result_direct[i]->size());
+		REQUIRE(result_sorted[i]->get_coverage() == result_direct[i]->get_coverage());
+		REQUIRE(result_sorted[i]->kmers_on_alleles() == result_direct[i]->kmers_on_alleles());
+		delete result_direct[i];
+		delete result_sorted[i];
+	}
+	remove(dump_file.c_str());
+}
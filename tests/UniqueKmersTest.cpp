@@ -201,6 +201,36 @@ TEST_CASE("UniqueKmers kmers_on_alleles3", "[UniqueKmers kmers_on_alleles3]") {
 	REQUIRE(counts[1] == 0);
 }
 
+TEST_CASE("UniqueKmers kmers_on_allele", "[UniqueKmers kmers_on_allele]") {
+	UniqueKmers u(1000);
+	u.insert_empty_allele(0);
+	u.insert_empty_allele(1);
+	u.insert_path(0,0);
+	u.insert_path(1,1);
+	REQUIRE(u.kmers_on_allele(0) == 0);
+	REQUIRE(u.kmers_on_allele(1) == 0);
+	// allele that does not exist
+	REQUIRE(u.kmers_on_allele(5) == 0);
+
+	vector<vector<unsigned char>> alleles = { {0,1}, {1}, {1,1}, {0} };
+	for (size_t i = 0; i < alleles.size(); ++i) {
+		u.insert_kmer(10, alleles[i]);
+	}
+	// duplicate allele ids of a kmer are counted only once
+	REQUIRE(u.kmers_on_allele(0) == 2);
+	REQUIRE(u.kmers_on_allele(1) == 3);
+
+	map<unsigned char, int> counts = u.kmers_on_alleles();
+	REQUIRE(counts.size() == 2);
+	REQUIRE(counts[0] == 2);
+	REQUIRE(counts[1] == 3);
+
+	// re-inserting allele as empty resets its count
+	u.insert_empty_allele(1);
+	REQUIRE(u.kmers_on_allele(1) == 0);
+	REQUIRE(u.kmers_on_allele(0) == 2);
+}
+
 TEST_CASE("UniqueKmers get_path_ids", "[UniqueKmers get_path_ids]") {
 	UniqueKmers u (1000);
 	u.insert_empty_allele(0);
@@ -1,11 +1,17 @@
 #include "catch.hpp"
+#include "utils.hpp"
 #define private public
 #include "../src/variantreader.hpp"
 #include "../src/uniquekmers.hpp"
+#include "../src/fastgenotyper.hpp"
 #include <vector>
 #include <string>
 #include <algorithm> 
 #include <random>
+#include <sstream>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
 
 
 using namespace std;
@@ -331,9 +337,9 @@ TEST_CASE("VariantReader variant_ids1", "[VariantReader variant_ids1]") {
 	for (auto s : sequences_ref) {
 		alleles.push_back(DnaSequence(s));
 	}
-	string chromosome = "chr1";
+	size_t contig_id = v.register_contig("chr1");
 	vector<string> variant_ids = {"var1", "var2", "var3", "var4", "var5:var6"};
-	v.insert_ids(chromosome, alleles, variant_ids, true);
+	v.insert_ids(contig_id, alleles, variant_ids, true);
 
 	for (size_t i = 0; i < 10; ++i) {
 		// shuffle alleles
@@ -346,7 +352,7 @@ TEST_CASE("VariantReader variant_ids1", "[VariantReader variant_ids1]") {
 			expected += sequence_to_id[s];
 			index += 1;
 		}
-		string result = v.get_ids(chromosome, sequences, 0 , false);
+		string result = v.get_ids(contig_id, sequences, 0 , false);
 		REQUIRE(result == expected);
 	}
 }
@@ -400,3 +406,413 @@ TEST_CASE("VariantReader too_many_alleles", "[VariantReader too_many_alleles]")
 }
 
 
+
+TEST_CASE("VariantReader contig_ids", "[VariantReader contig_ids]") {
+	string vcf = "../tests/data/small2.vcf";
+	string fasta = "../tests/data/small1.fa";
+	VariantReader v(vcf, fasta, 10, false);
+
+	REQUIRE(v.nr_of_contigs() == 3);
+	vector<size_t> contig_ids;
+	v.get_contig_ids(&contig_ids);
+	vector<string> chromosomes;
+	v.get_chromosomes(&chromosomes);
+	REQUIRE(contig_ids.size() == chromosomes.size());
+
+	for (size_t i = 0; i < contig_ids.size(); ++i) {
+		size_t contig_id = contig_ids[i];
+		REQUIRE(v.get_contig_name(contig_id) == chromosomes[i]);
+		REQUIRE(v.get_contig_id(chromosomes[i]) == contig_id);
+		REQUIRE(v.size_of(contig_id) == v.size_of(chromosomes[i]));
+		REQUIRE(&v.variants(contig_id) == &v.get_variants_on_chromosome(chromosomes[i]));
+		for (size_t j = 0; j < v.size_of(contig_id); ++j) {
+			REQUIRE(v.get_variant(contig_id, j) == v.get_variant(chromosomes[i], j));
+		}
+	}
+	CHECK_THROWS(v.get_contig_id("chrD"));
+	REQUIRE(v.size_of("chrD") == 0);
+}
+
+TEST_CASE("VariantReader release_sequences", "[VariantReader release_sequences]") {
+	vector<string> vcfs = {"../tests/data/small1.vcf", "../tests/data/small1-ids.vcf"};
+	string fasta = "../tests/data/small1.fa";
+
+	for (auto vcf : vcfs) {
+		VariantReader full(vcf, fasta, 10, true);
+		VariantReader released(vcf, fasta, 10, true);
+
+		for (size_t contig_id = 0; contig_id < full.nr_of_contigs(); ++contig_id) {
+			size_t nr_variants = full.size_of(contig_id);
+			vector<UniqueKmers*> unique_kmers;
+			for (size_t i = 0; i < nr_variants; ++i) {
+				UniqueKmers* u = new UniqueKmers(full.get_variant(contig_id, i).get_start_position());
+				for (size_t a = 0; a < full.get_variant(contig_id, i).nr_of_alleles(); ++a) {
+					u->insert_empty_allele(a);
+				}
+				u->set_coverage(5);
+				unique_kmers.push_back(u);
+			}
+
+			REQUIRE(!released.sequences_released(contig_id));
+			released.release_sequences(contig_id, &unique_kmers);
+			REQUIRE(released.sequences_released(contig_id));
+			REQUIRE(released.size_of(contig_id) == nr_variants);
+			vector<vector<float>> expected_frequencies;
+			vector<vector<float>> computed_frequencies;
+			full.get_allele_frequencies(contig_id, expected_frequencies);
+			released.get_allele_frequencies(contig_id, computed_frequencies);
+			REQUIRE(expected_frequencies == computed_frequencies);
+
+			// records rendered before the release must match those computed from the full sequences
+			size_t counter = 0;
+			for (size_t i = 0; i < nr_variants; ++i) {
+				const Variant& variant = released.get_variant(contig_id, i);
+				REQUIRE(variant.sequences_released());
+				CHECK_THROWS(variant.get_allele_string(0));
+
+				vector<SiteRecord> expected;
+				vector<SiteRecord> computed;
+				full.get_site_records(contig_id, i, counter, unique_kmers[i], expected);
+				released.get_site_records(contig_id, i, counter, unique_kmers[i], computed);
+				REQUIRE(expected.size() == computed.size());
+				REQUIRE(expected.size() == variant.nr_of_singleton_variants());
+				for (size_t j = 0; j < expected.size(); ++j) {
+					REQUIRE(expected[j].site_columns == computed[j].site_columns);
+					REQUIRE(expected[j].start_position == computed[j].start_position);
+					REQUIRE(expected[j].defined_alleles == computed[j].defined_alleles);
+					REQUIRE(expected[j].nr_missing == computed[j].nr_missing);
+					REQUIRE(expected[j].nr_unique_kmers == computed[j].nr_unique_kmers);
+					REQUIRE(expected[j].coverage == computed[j].coverage);
+					REQUIRE(expected[j].variant_id == computed[j].variant_id);
+					REQUIRE(expected[j].allele_ids == computed[j].allele_ids);
+					REQUIRE(expected[j].allele_kmers == computed[j].allele_kmers);
+					REQUIRE(expected[j].undefined_allele_kmers == computed[j].undefined_allele_kmers);
+				}
+
+				// genotypes can still be separated
+				GenotypingResult g;
+				for (size_t a0 = 0; a0 < variant.nr_of_alleles(); ++a0) {
+					for (size_t a1 = a0; a1 < variant.nr_of_alleles(); ++a1) {
+						g.add_to_likelihood(a0, a1, 0.1 * (a0 + 1) + 0.01 * a1);
+					}
+				}
+				g.add_first_haplotype_allele(0);
+				g.add_second_haplotype_allele(variant.nr_of_alleles() - 1);
+				vector<Variant> singletons;
+				vector<GenotypingResult> expected_genotypes;
+				vector<GenotypingResult> computed_genotypes;
+				full.get_variant(contig_id, i).separate_variants(&singletons, &g, &expected_genotypes);
+				variant.separate_genotypes(g, computed_genotypes);
+				REQUIRE(expected_genotypes.size() == computed_genotypes.size());
+				for (size_t j = 0; j < expected_genotypes.size(); ++j) {
+					REQUIRE(expected_genotypes[j].get_haplotype() == computed_genotypes[j].get_haplotype());
+					size_t nr_alleles = singletons[j].nr_of_alleles();
+					REQUIRE(expected_genotypes[j].get_all_likelihoods(nr_alleles) == computed_genotypes[j].get_all_likelihoods(nr_alleles));
+				}
+				counter += expected.size();
+			}
+
+			for (auto u : unique_kmers) {
+				delete u;
+			}
+		}
+	}
+}
+
+TEST_CASE("VariantReader release_sequences footprint", "[VariantReader release_sequences footprint]") {
+	vector<string> vcfs = {"../tests/data/small1.vcf", "../tests/data/small1-ids.vcf"};
+	string fasta = "../tests/data/small1.fa";
+
+	for (auto vcf : vcfs) {
+		VariantReader v(vcf, fasta, 10, true);
+		vector<vector<UniqueKmers*>> unique_kmers(v.nr_of_contigs());
+		for (size_t contig_id = 0; contig_id < v.nr_of_contigs(); ++contig_id) {
+			for (size_t i = 0; i < v.size_of(contig_id); ++i) {
+				UniqueKmers* u = new UniqueKmers(v.get_variant(contig_id, i).get_start_position());
+				for (size_t a = 0; a < v.get_variant(contig_id, i).nr_of_alleles(); ++a) {
+					u->insert_empty_allele(a);
+				}
+				u->set_coverage(5);
+				unique_kmers[contig_id].push_back(u);
+			}
+		}
+
+		// packed records must take less space than the rendered text
+		size_t text_bytes = 0;
+		for (size_t contig_id = 0; contig_id < v.nr_of_contigs(); ++contig_id) {
+			size_t counter = 0;
+			for (size_t i = 0; i < v.size_of(contig_id); ++i) {
+				vector<SiteRecord> records;
+				v.get_site_records(contig_id, i, counter, unique_kmers[contig_id][i], records);
+				for (auto& r : records) {
+					text_bytes += r.site_columns.size() + r.variant_id.size();
+					for (auto& id : r.allele_ids) text_bytes += id.size();
+				}
+				counter += records.size();
+			}
+		}
+
+#if defined(__GLIBC__) && ((__GLIBC__ > 2) || (__GLIBC_MINOR__ >= 33))
+		size_t heap_before = mallinfo2().uordblks;
+#endif
+		for (size_t contig_id = 0; contig_id < v.nr_of_contigs(); ++contig_id) {
+			v.release_sequences(contig_id, &unique_kmers[contig_id]);
+		}
+#if defined(__GLIBC__) && ((__GLIBC__ > 2) || (__GLIBC_MINOR__ >= 33))
+		// releasing must reduce the memory in use
+		size_t heap_after = mallinfo2().uordblks;
+		REQUIRE(heap_after < heap_before);
+#endif
+
+		size_t packed_bytes = 0;
+		for (size_t contig_id = 0; contig_id < v.nr_of_contigs(); ++contig_id) {
+			packed_bytes += v.packed_sites[contig_id].data.size();
+		}
+		REQUIRE(packed_bytes < text_bytes);
+
+		for (auto& contig : unique_kmers) {
+			for (auto u : contig) {
+				delete u;
+			}
+		}
+	}
+}
+
+TEST_CASE("VariantReader release_sequences allele frequencies", "[VariantReader release_sequences allele frequencies]") {
+	// fast genotyping (-f) must use the same priors in low memory mode (-l)
+	string vcf = "../tests/data/small1.vcf";
+	string fasta = "../tests/data/small1.fa";
+	VariantReader full(vcf, fasta, 10, true);
+	VariantReader released(vcf, fasta, 10, true);
+	ProbabilityTable probs(5, 10, 30, 0.0L);
+
+	for (size_t contig_id = 0; contig_id < full.nr_of_contigs(); ++contig_id) {
+		// without kmers, the genotype likelihoods only reflect the priors
+		vector<UniqueKmers*> unique_kmers;
+		for (size_t i = 0; i < full.size_of(contig_id); ++i) {
+			UniqueKmers* u = new UniqueKmers(full.get_variant(contig_id, i).get_start_position());
+			for (size_t a = 0; a < full.get_variant(contig_id, i).nr_of_alleles(); ++a) {
+				u->insert_empty_allele(a);
+			}
+			u->set_coverage(5);
+			unique_kmers.push_back(u);
+		}
+		vector<vector<float>> expected_frequencies;
+		full.get_allele_frequencies(contig_id, expected_frequencies);
+		released.release_sequences(contig_id, &unique_kmers);
+		CHECK_THROWS(released.get_variant(contig_id, 0).allele_frequency(0, true));
+		vector<vector<float>> computed_frequencies;
+		released.get_allele_frequencies(contig_id, computed_frequencies);
+		REQUIRE(computed_frequencies == expected_frequencies);
+
+		// the panel frequencies are not uniform
+		bool non_uniform = false;
+		for (auto& frequencies : computed_frequencies) {
+			if (frequencies.at(0) != frequencies.at(1)) non_uniform = true;
+		}
+		REQUIRE(non_uniform);
+
+		FastGenotyper expected_genotyper(&unique_kmers, &probs, &expected_frequencies);
+		FastGenotyper computed_genotyper(&unique_kmers, &probs, &computed_frequencies);
+		vector<GenotypingResult> expected = expected_genotyper.get_genotyping_result();
+		vector<GenotypingResult> computed = computed_genotyper.get_genotyping_result();
+		for (size_t i = 0; i < expected.size(); ++i) {
+			size_t nr_alleles = full.get_variant(contig_id, i).nr_of_alleles();
+			REQUIRE(expected[i].get_all_likelihoods(nr_alleles) == computed[i].get_all_likelihoods(nr_alleles));
+		}
+
+		for (auto u : unique_kmers) {
+			delete u;
+		}
+	}
+}
+
+TEST_CASE("VariantReader pack_site_fields", "[VariantReader pack_site_fields]") {
+	VariantReader v("../tests/data/small1-ids.vcf", "../tests/data/small1.fa", 10, true);
+	SiteFields fields;
+	fields.start_position = 3000000000;
+	fields.variant_id = "var1";
+	fields.alleles = {"ACGTTGCA", "A", "", "ACNNT", "GGGGGGGGGGGGGGGGGGGGGGGGGGGGGGGGGT"};
+	fields.defined_alleles = {0, 1, 2, 4, 5};
+	fields.allele_frequencies = {0.5, 0.25, 0.0, 1.0/3.0};
+	fields.allele_ids = {"var1", "var2", "var3", "var1"};
+	fields.nr_missing = 2;
+	fields.nr_unique_kmers = 300;
+	fields.coverage = 65535;
+	fields.kmer_counts = {0, 5, -1, 1000, 2, 7};
+
+	vector<unsigned char> data;
+	v.pack_site_fields(fields, data);
+	// each ID is stored once
+	REQUIRE(v.site_ids.size() == 3);
+
+	SiteFields computed;
+	v.unpack_site_fields(data.data(), computed);
+	REQUIRE(computed.start_position == fields.start_position);
+	REQUIRE(computed.variant_id == fields.variant_id);
+	REQUIRE(computed.alleles == fields.alleles);
+	REQUIRE(computed.defined_alleles == fields.defined_alleles);
+	REQUIRE(computed.allele_frequencies == fields.allele_frequencies);
+	REQUIRE(computed.allele_ids == fields.allele_ids);
+	REQUIRE(computed.nr_missing == fields.nr_missing);
+	REQUIRE(computed.nr_unique_kmers == fields.nr_unique_kmers);
+	REQUIRE(computed.coverage == fields.coverage);
+	REQUIRE(computed.kmer_counts == fields.kmer_counts);
+}
+
+TEST_CASE("VariantReader write_biallelic", "[VariantReader write_biallelic]") {
+	string vcf = "../tests/data/small1-ids.vcf";
+	string fasta = "../tests/data/small1.fa";
+	string panel = "../tests/data/small1-ids-biallelic.vcf";
+	string outfile = "../tests/data/small1-ids-biallelic-genotypes.vcf";
+	VariantReader v(vcf, fasta, 10, true, "HG0");
+
+	vector<GenotypingResult> genotypes(2);
+	genotypes[0].add_to_likelihood(0, 0, 0.05);
+	genotypes[0].add_to_likelihood(1, 2, 0.9);
+	genotypes[0].add_to_likelihood(3, 3, 0.05);
+	genotypes[1].add_to_likelihood(0, 1, 0.1);
+	genotypes[1].add_to_likelihood(1, 1, 0.9);
+	vector<UniqueKmers*> u = { new UniqueKmers(0), new UniqueKmers(1) };
+
+	CHECK_THROWS(v.open_biallelic_outfile(outfile, "../tests/data/nonexistent.vcf"));
+
+	// one record per variant ID, sorted by position
+	vector<string> expected = {
+		"chrA\t151\t.\tC\tG\t.\tPASS\tID=var1;UK=0;MA=0\tGT:GQ\t1/0:10",
+		"chrA\t151\t.\tC\tCGGG\t.\tPASS\tID=var2;UK=0;MA=0\tGT:GQ\t1/0:10",
+		"chrA\t151\t.\tC\tA\t.\tPASS\tID=var3;UK=0;MA=0\tGT:GQ\t0/1:10",
+		"chrA\t151\t.\tC\tT\t.\tPASS\tID=var4;UK=0;MA=0\tGT:GQ\t0/0:10",
+		"chrA\t158\t.\tA\tAT\t.\tPASS\tID=var6;UK=0;MA=0\tGT:GQ\t1/1:10",
+		"chrA\t161\t.\tG\tT\t.\tPASS\tID=var5;UK=0;MA=0\tGT:GQ\t1/1:10"
+	};
+
+	// the result does not depend on the number of threads used for formatting
+	for (size_t nr_threads : {1, 4}) {
+		v.open_genotyping_outfile("../tests/data/small1-ids-multiallelic-genotypes.vcf");
+		v.open_biallelic_outfile(outfile, panel);
+		v.write_genotypes_of("chrA", genotypes, &u, false, nr_threads);
+		v.close_genotyping_outfile();
+		v.close_biallelic_outfile();
+
+		ifstream result(outfile);
+		string line;
+		vector<string> records;
+		while (getline(result, line)) {
+			if (line[0] == '#') continue;
+			records.push_back(line);
+		}
+		REQUIRE(records == expected);
+	}
+	delete u[0];
+	delete u[1];
+}
+
+TEST_CASE("VariantReader write_multisample_genotypes_of", "[VariantReader write_multisample_genotypes_of]") {
+	string vcf = "../tests/data/small1.vcf";
+	string fasta = "../tests/data/small1.fa";
+	vector<string> samples = {"HG0", "HG1"};
+	vector<string> chromosomes = {"chrA", "chrB"};
+
+	// generate different genotype likelihoods and unique kmers for each sample
+	vector<vector<vector<GenotypingResult>>> genotypes(2);
+	vector<vector<vector<UniqueKmers*>>> kmers(2);
+	VariantReader v(vcf, fasta, 10, false);
+	for (size_t s = 0; s < samples.size(); ++s) {
+		for (auto& chromosome : chromosomes) {
+			vector<GenotypingResult> g;
+			vector<UniqueKmers*> u;
+			for (size_t i = 0; i < v.size_of(chromosome); ++i) {
+				const Variant& variant = v.get_variant(chromosome, i);
+				GenotypingResult r;
+				for (size_t a0 = 0; a0 < variant.nr_of_alleles(); ++a0) {
+					for (size_t a1 = a0; a1 < variant.nr_of_alleles(); ++a1) {
+						r.add_to_likelihood(a0, a1, 0.1 * (a0 + 1) + 0.3 * a1 * s + 0.01 * i);
+					}
+				}
+				r.normalize();
+				g.push_back(r);
+				UniqueKmers* k = new UniqueKmers(variant.get_start_position());
+				for (size_t a = 0; a < variant.nr_of_alleles(); ++a) {
+					k->insert_empty_allele(a);
+				}
+				vector<unsigned char> allele_ids = {(unsigned char) (s % variant.nr_of_alleles())};
+				for (size_t n = 0; n < i + s; ++n) k->insert_kmer(10 + n, allele_ids);
+				k->set_coverage(5 + s);
+				u.push_back(k);
+			}
+			genotypes[s].push_back(g);
+			kmers[s].push_back(u);
+		}
+	}
+
+	// write each sample separately
+	vector<vector<string>> single_records(samples.size());
+	for (size_t s = 0; s < samples.size(); ++s) {
+		VariantReader single(vcf, fasta, 10, false, samples[s]);
+		single.open_genotyping_outfile("../tests/data/small1-multisample-single.vcf");
+		for (size_t c = 0; c < chromosomes.size(); ++c) {
+			single.write_genotypes_of(chromosomes[c], genotypes[s][c], &kmers[s][c]);
+		}
+		single.close_genotyping_outfile();
+		ifstream result("../tests/data/small1-multisample-single.vcf");
+		string line;
+		while (getline(result, line)) {
+			if (line[0] == '#') continue;
+			single_records[s].push_back(line);
+		}
+	}
+
+	for (size_t nr_threads = 1; nr_threads < 3; ++nr_threads) {
+		VariantReader multi(vcf, fasta, 10, false);
+		multi.open_multisample_genotyping_outfile("../tests/data/small1-multisample.vcf", samples);
+		for (size_t c = 0; c < chromosomes.size(); ++c) {
+			vector<const vector<GenotypingResult>*> g = {&genotypes[0][c], &genotypes[1][c]};
+			vector<vector<UniqueKmers*>*> u = {&kmers[0][c], &kmers[1][c]};
+			multi.write_multisample_genotypes_of(chromosomes[c], g, u, false, nr_threads);
+		}
+		multi.close_multisample_genotyping_outfile();
+
+		ifstream result("../tests/data/small1-multisample.vcf");
+		string line;
+		vector<string> records;
+		while (getline(result, line)) {
+			if (line.substr(0,2) == "##") continue;
+			if (line[0] == '#') {
+				REQUIRE(line == "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\tHG0\tHG1");
+				continue;
+			}
+			records.push_back(line);
+		}
+		REQUIRE(records.size() == single_records[0].size());
+
+		// site columns are written once, sample columns match the single-sample output
+		for (size_t r = 0; r < records.size(); ++r) {
+			vector<string> fields = split_line(records[r], '\t');
+			REQUIRE(fields.size() == 11);
+			REQUIRE(fields[8] == "GT:GQ:GL:KC:UK:AK");
+			for (size_t s = 0; s < samples.size(); ++s) {
+				vector<string> single_fields = split_line(single_records[s][r], '\t');
+				for (size_t f = 0; f < 7; ++f) {
+					REQUIRE(fields[f] == single_fields[f]);
+				}
+				vector<string> info = split_line(single_fields[7], ';');
+				REQUIRE(fields[7] == info[0] + ";" + info[3]);
+				REQUIRE(fields[9 + s] == single_fields[9] + ":" + info[1].substr(3) + ":" + info[2].substr(3));
+			}
+		}
+	}
+
+	CHECK_THROWS(v.open_multisample_genotyping_outfile("../tests/data/small1-multisample.vcf", {}));
+	v.open_multisample_genotyping_outfile("../tests/data/small1-multisample.vcf", samples);
+	vector<const vector<GenotypingResult>*> g = {&genotypes[0][0]};
+	vector<vector<UniqueKmers*>*> u = {&kmers[0][0]};
+	CHECK_THROWS(v.write_multisample_genotypes_of("chrA", g, u));
+	v.close_multisample_genotyping_outfile();
+
+	for (auto& sample_kmers : kmers) {
+		for (auto& chromosome_kmers : sample_kmers) {
+			for (auto k : chromosome_kmers) delete k;
+		}
+	}
+}
@@ -1,5 +1,7 @@
 #include "utils.hpp"
 #include <math.h>
+#include <sstream>
+#include <algorithm>
 
 bool doubles_equal(double a, double b) {
 	return std::abs(a - b) < 0.0000001;
@@ -13,3 +15,24 @@ bool compare_vectors (std::vector<double>& v1, std::vector<double>& v2) {
 	}
 	return true;
 }
+
+std::vector<std::string> split_line(const std::string& line, char sep) {
+	std::vector<std::string> result;
+	std::stringstream ss(line);
+	std::string field;
+	while (getline(ss, field, sep)) result.push_back(field);
+	return result;
+}
+
+std::string reverse_complement_kmer(const std::string& kmer) {
+	std::string reverse = kmer;
+	for (size_t i = 0; i < kmer.size(); ++i) {
+		char c = kmer[kmer.size() - 1 - i];
+		reverse[i] = (c == 'A') ? 'T' : (c == 'C') ? 'G' : (c == 'G') ? 'C' : 'A';
+	}
+	return reverse;
+}
+
+std::string canonical_kmer(const std::string& kmer) {
+	return std::min(kmer, reverse_complement_kmer(kmer));
+}
@@ -1,5 +1,15 @@
 #include <vector>
+#include <string>
 
 bool doubles_equal(double a, double b);
 
 bool compare_vectors (std::vector<double>& v1, std::vector<double>& v2);
+
+/** split a line at the given separator **/
+std::vector<std::string> split_line(const std::string& line, char sep);
+
+/** reverse complement of a kmer consisting of A, C, G and T **/
+std::string reverse_complement_kmer(const std::string& kmer);
+
+/** lexicographically smaller of a kmer and its reverse complement **/
+std::string canonical_kmer(const std::string& kmer);